@@ -479,22 +479,10 @@ uint8_t* rcheevos_patch_address(unsigned address)
 
 static unsigned rcheevos_peek(unsigned address, unsigned num_bytes, void* ud)
 {
-   uint8_t* data = rcheevos_memory_find(&rcheevos_locals.memory, address);
-   if (data)
-   {
-      switch (num_bytes)
-      {
-         case 4:
-            return (data[3] << 24) | (data[2] << 16) | 
-                   (data[1] <<  8) | (data[0]);
-         case 3:
-            return (data[2] << 16) | (data[1] << 8) | (data[0]);
-         case 2:
-            return (data[1] << 8)  | (data[0]);
-         case 1:
-            return data[0];
-      }
-   }
+   unsigned value;
+
+   if (rcheevos_memory_read(&rcheevos_locals.memory, address, num_bytes, &value))
+      return value;
 
    rcheevos_invalidate_address(address);
    return 0;
@@ -22,12 +22,18 @@
 
 #include "../deps/rcheevos/include/rcheevos.h"
 
+#include <retro_endianness.h>
+
 #include <stdio.h>
 
 uint8_t* rcheevos_memory_find(
       const rcheevos_memory_regions_t* regions, unsigned address)
 {
    unsigned i;
+   const size_t page = address >> RCHEEVOS_MEMORY_PAGE_SHIFT;
+
+   if (page < regions->page_count && regions->pages[page])
+      return regions->pages[page] + (address & (RCHEEVOS_MEMORY_PAGE_SIZE - 1));
 
    for (i = 0; i < regions->count; ++i)
    {
@@ -46,6 +52,70 @@ uint8_t* rcheevos_memory_find(
    return NULL;
 }
 
+bool rcheevos_memory_read(const rcheevos_memory_regions_t* regions,
+      unsigned address, unsigned num_bytes, unsigned* value)
+{
+   unsigned i;
+   const uint8_t* data;
+   const size_t page     = address >> RCHEEVOS_MEMORY_PAGE_SHIFT;
+   const unsigned offset = address & (RCHEEVOS_MEMORY_PAGE_SIZE - 1);
+
+   /* fast path - the whole value lies within the first region
+    * (usually all of system RAM) or within one translated page.
+    * The bounds are checked without summing address and num_bytes,
+    * which could wrap around for addresses near UINT_MAX */
+   if (     address   <  regions->size[0]
+         && num_bytes <= regions->size[0] - address
+         && regions->data[0])
+      data = regions->data[0] + address;
+   else if (page < regions->page_count
+         && offset + num_bytes <= RCHEEVOS_MEMORY_PAGE_SIZE
+         && regions->pages[page])
+      data = regions->pages[page] + offset;
+   else
+      data = NULL;
+
+   if (data)
+   {
+      switch (num_bytes)
+      {
+         case 4:
+         {
+            uint32_t val;
+            memcpy(&val, data, sizeof(val));
+            *value = swap_if_big32(val);
+            return true;
+         }
+         case 3:
+            *value = data[0] | (data[1] << 8) | (data[2] << 16);
+            return true;
+         case 2:
+         {
+            uint16_t val;
+            memcpy(&val, data, sizeof(val));
+            *value = swap_if_big16(val);
+            return true;
+         }
+         case 1:
+            *value = data[0];
+            return true;
+      }
+   }
+
+   if (!(data = rcheevos_memory_find(regions, address)))
+      return false;
+
+   *value = data[0];
+
+   for (i = 1; i < num_bytes; i++)
+   {
+      if ((data = rcheevos_memory_find(regions, address + i)))
+         *value |= (unsigned)data[0] << (i * 8);
+   }
+
+   return true;
+}
+
 static const char* rcheevos_memory_type(int type)
 {
    switch (type)
@@ -307,8 +377,42 @@ static void rcheevos_memory_init_from_unmapped_memory(rcheevos_memory_regions_t*
    }
 }
 
+static void rcheevos_memory_build_pages(rcheevos_memory_regions_t* regions)
+{
+   unsigned i;
+   size_t offset = 0;
+
+   regions->page_count = (regions->total_size + RCHEEVOS_MEMORY_PAGE_SIZE - 1)
+         >> RCHEEVOS_MEMORY_PAGE_SHIFT;
+   regions->pages      = (uint8_t**)calloc(regions->page_count, sizeof(uint8_t*));
+
+   if (!regions->pages)
+   {
+      regions->page_count = 0;
+      return;
+   }
+
+   for (i = 0; i < regions->count; ++i)
+   {
+      const size_t size = regions->size[i];
+
+      if (regions->data[i])
+      {
+         /* only pages that lie entirely within this region */
+         size_t page      = (offset + RCHEEVOS_MEMORY_PAGE_SIZE - 1) >> RCHEEVOS_MEMORY_PAGE_SHIFT;
+         const size_t end = (offset + size) >> RCHEEVOS_MEMORY_PAGE_SHIFT;
+
+         for (; page < end; page++)
+            regions->pages[page] = regions->data[i] + ((page << RCHEEVOS_MEMORY_PAGE_SHIFT) - offset);
+      }
+
+      offset += size;
+   }
+}
+
 void rcheevos_memory_destroy(rcheevos_memory_regions_t* regions)
 {
+   free(regions->pages);
    memset(regions, 0, sizeof(*regions));
 }
 
@@ -347,6 +451,10 @@ bool rcheevos_memory_init(rcheevos_memory_regions_t* regions, int console)
       }
    }
 
+   if (has_valid_region)
+      rcheevos_memory_build_pages(&new_regions);
+
+   free(regions->pages);
    memcpy(regions, &new_regions, sizeof(*regions));
    return has_valid_region;
 }
@@ -25,11 +25,19 @@ RETRO_BEGIN_DECLS
 
 #define MAX_MEMORY_REGIONS 32
 
+/* Granularity of the address translation table. Pages that
+ * straddle two regions (or a region and a null filler) have
+ * no entry and are resolved by walking the region list. */
+#define RCHEEVOS_MEMORY_PAGE_SHIFT 10
+#define RCHEEVOS_MEMORY_PAGE_SIZE  (1 << RCHEEVOS_MEMORY_PAGE_SHIFT)
+
 typedef struct
 {
    uint8_t* data[MAX_MEMORY_REGIONS];
    size_t size[MAX_MEMORY_REGIONS];
    size_t total_size;
+   uint8_t** pages;
+   size_t page_count;
    unsigned count;
 } rcheevos_memory_regions_t;
 
@@ -39,6 +47,12 @@ void rcheevos_memory_destroy(rcheevos_memory_regions_t* regions);
 uint8_t* rcheevos_memory_find(const rcheevos_memory_regions_t* regions,
       unsigned address);
 
+/* Reads a little-endian value of 1 to 4 bytes. Returns false
+ * if the first byte is not backed by memory; bytes after the
+ * first that are not backed by memory read as 0. */
+bool rcheevos_memory_read(const rcheevos_memory_regions_t* regions,
+      unsigned address, unsigned num_bytes, unsigned* value);
+
 RETRO_END_DECLS
 
 #endif
@@ -198,6 +198,10 @@ enum event_command
    CMD_EVENT_STREAMING_TOGGLE,
    CMD_EVENT_RUNAHEAD_TOGGLE,
    CMD_EVENT_AI_SERVICE_TOGGLE,
+   /* Starts or stops frame tracing to match the setting */
+   CMD_EVENT_FRAME_TRACE_INIT,
+   /* Saves the frame trace recorded so far */
+   CMD_EVENT_FRAME_TRACE_SAVE,
    CMD_EVENT_BSV_RECORDING_TOGGLE,
    CMD_EVENT_SHADER_NEXT,
    CMD_EVENT_SHADER_PREV,
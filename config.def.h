@@ -274,6 +274,11 @@
  */
 #define DEFAULT_FRAME_DELAY 0
 
+/* Pick the frame delay automatically from measured frame
+ * times. 'Frame Delay' then acts as the upper limit
+ * (0 = no limit). */
+#define DEFAULT_FRAME_DELAY_AUTO false
+
 /* Inserts black frame(s) inbetween frames.
  * Useful for Higher Hz monitors (set to multiples of 60 Hz) who want to play 60 Hz 
  * material with eliminated  ghosting. video_refresh_rate should still be configured
@@ -717,6 +722,10 @@ static const unsigned input_backtouch_toggle       = false;
 
 #define DEFAULT_LOG_TO_FILE_TIMESTAMP false
 
+/* Record per-thread frame traces, exported as Chrome
+ * trace JSON on the 'Save Frame Trace' hotkey and on exit */
+#define DEFAULT_FRAME_TRACE_ENABLE false
+
 /* Crop overscanned frames. */
 #define DEFAULT_CROP_OVERSCAN true
 
@@ -1061,6 +1070,19 @@ static const bool savestate_thumbnail_enable = false;
 /* Maximum fast forward ratio. */
 #define DEFAULT_FASTFORWARD_RATIO 0.0
 
+/* Microseconds the frame limiter (and frame delay) busy-wait
+ * before a deadline, after sleeping for the rest. Where the
+ * OS can only sleep in whole milliseconds this has to cover
+ * one timer tick; handhelds and consoles don't spin to save
+ * power. */
+#if defined(__linux__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
+#define DEFAULT_FRAME_LIMIT_SPIN_USEC 200
+#elif (defined(_WIN32) && !defined(_XBOX)) || defined(__MACH__)
+#define DEFAULT_FRAME_LIMIT_SPIN_USEC 1000
+#else
+#define DEFAULT_FRAME_LIMIT_SPIN_USEC 0
+#endif
+
 /* Enable runloop for variable refresh rate screens. Force x1 speed while handling fast forward too. */
 #define DEFAULT_VRR_RUNLOOP_ENABLE false
 
@@ -1070,6 +1092,15 @@ static const bool savestate_thumbnail_enable = false;
 /* When using the Run Ahead feature, use a secondary instance of the core. */
 #define DEFAULT_RUN_AHEAD_SECONDARY_INSTANCE true
 
+/* Run the secondary Run Ahead instance on its own thread, in
+ * parallel with the main instance (software rendered cores only). */
+#define DEFAULT_RUN_AHEAD_SECONDARY_THREADED false
+
+/* Replace Run Ahead with Preemptive Frames: keep a ring of
+ * the last Run Ahead frames' savestates and only roll back
+ * and replay them when input changes. */
+#define DEFAULT_PREEMPT_ENABLE false
+
 /* Hide warning messages when using the Run Ahead feature. */
 #define DEFAULT_RUN_AHEAD_HIDE_WARNINGS false
 
@@ -1083,6 +1114,12 @@ static const uint16_t network_remote_base_port = 55400;
 #define DEFAULT_NETWORK_BUILDBOT_AUTO_EXTRACT_ARCHIVE true
 #define DEFAULT_NETWORK_BUILDBOT_SHOW_EXPERIMENTAL_CORES false
 
+/* Maximum number of HTTP transfers (thumbnails, cores,
+ * assets...) that run at the same time; further
+ * transfers wait for one of them to finish.
+ * 0 means no limit. */
+#define DEFAULT_NETWORK_HTTP_MAX_TRANSFERS 4
+
 /* Automatically create a backup whenever a core is
  * updated via the online updater
  * > Enable by default on all modern platforms with
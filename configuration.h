@@ -173,6 +173,7 @@ typedef struct settings
       unsigned savestate_max_keep;
       unsigned network_cmd_port;
       unsigned network_remote_base_port;
+      unsigned network_http_max_transfers;
       unsigned keymapper_port;
       unsigned video_window_opacity;
       unsigned crt_switch_resolution;
@@ -185,6 +186,7 @@ typedef struct settings
       unsigned video_swap_interval;
       unsigned video_hard_sync_frames;
       unsigned video_frame_delay;
+      unsigned frame_limit_spin_usec;
       unsigned video_viwidth;
       unsigned video_aspect_ratio_idx;
       unsigned video_rotation;
@@ -386,6 +388,7 @@ typedef struct settings
       char netplay_server[255];
       char network_buildbot_url[255];
       char network_buildbot_assets_url[255];
+      char network_cmd_unix_path[108];
 
       char browse_url[4096];
 
@@ -456,6 +459,7 @@ typedef struct settings
       bool video_fullscreen;
       bool video_windowed_fullscreen;
       bool video_vsync;
+      bool video_frame_delay_auto;
       bool video_adaptive_vsync;
       bool video_hard_sync;
       bool video_vfilter;
@@ -736,6 +740,8 @@ typedef struct settings
       bool apply_cheats_after_load;
       bool run_ahead_enabled;
       bool run_ahead_secondary_instance;
+      bool run_ahead_secondary_threaded;
+      bool preemptive_frames_enable;
       bool run_ahead_hide_warnings;
       bool pause_nonactive;
       bool block_sram_overwrite;
@@ -803,6 +809,7 @@ typedef struct settings
 
       bool log_to_file;
       bool log_to_file_timestamp;
+      bool frame_trace_enable;
 
       bool scan_without_core_match;
 
@@ -113,31 +113,49 @@ static bool gl1_raster_font_upload_atlas(gl1_raster_t *font)
 }
 #endif
 
-static bool gl1_raster_font_upload_atlas(gl1_raster_t *font)
+/* Uploads the atlas to the bound texture. If 'update'
+ * is set, the texture already exists and only the rows
+ * modified since the last upload are sent */
+static bool gl1_raster_font_upload_atlas(gl1_raster_t *font, bool update)
 {
    unsigned i, j;
+   unsigned rows;
+   unsigned y                           = 0;
+   unsigned height                      = font->tex_height;
    GLint  gl_internal                   = GL_LUMINANCE_ALPHA;
    GLenum gl_format                     = GL_LUMINANCE_ALPHA;
    size_t ncomponents                   = 2;
    uint8_t       *tmp                   = NULL;
 
-   tmp = (uint8_t*)calloc(font->tex_height, font->tex_width * ncomponents);
+   if (     update
+         && font->atlas->dirty_y_end > font->atlas->dirty_y_start)
+   {
+      y      = font->atlas->dirty_y_start;
+      height = font->atlas->dirty_y_end - y;
+   }
+
+   rows = (y + height > font->atlas->height)
+      ? font->atlas->height - y : height;
+   tmp  = (uint8_t*)calloc(height, font->tex_width * ncomponents);
+
+   if (!tmp)
+      return false;
 
    switch (ncomponents)
    {
       case 1:
-         for (i = 0; i < font->atlas->height; ++i)
+         for (i = 0; i < rows; ++i)
          {
-            const uint8_t *src = &font->atlas->buffer[i * font->atlas->width];
+            const uint8_t *src = &font->atlas->buffer[(y + i) * font->atlas->width];
             uint8_t       *dst = &tmp[i * font->tex_width * ncomponents];
 
             memcpy(dst, src, font->atlas->width);
          }
          break;
       case 2:
-         for (i = 0; i < font->atlas->height; ++i)
+         for (i = 0; i < rows; ++i)
          {
-            const uint8_t *src = &font->atlas->buffer[i * font->atlas->width];
+            const uint8_t *src = &font->atlas->buffer[(y + i) * font->atlas->width];
             uint8_t       *dst = &tmp[i * font->tex_width * ncomponents];
 
             for (j = 0; j < font->atlas->width; ++j)
@@ -149,8 +167,12 @@ static bool gl1_raster_font_upload_atlas(gl1_raster_t *font)
          break;
    }
 
-   glTexImage2D(GL_TEXTURE_2D, 0, gl_internal, font->tex_width, font->tex_height,
-         0, gl_format, GL_UNSIGNED_BYTE, tmp);
+   if (update)
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y, font->tex_width, height,
+            gl_format, GL_UNSIGNED_BYTE, tmp);
+   else
+      glTexImage2D(GL_TEXTURE_2D, 0, gl_internal, font->tex_width, font->tex_height,
+            0, gl_format, GL_UNSIGNED_BYTE, tmp);
 
    free(tmp);
 
@@ -194,7 +216,7 @@ static void *gl1_raster_font_init_font(void *data,
    font->tex_width  = next_pow2(font->atlas->width);
    font->tex_height = next_pow2(font->atlas->height);
 
-   if (!gl1_raster_font_upload_atlas(font))
+   if (!gl1_raster_font_upload_atlas(font, false))
       goto error;
 
    font->atlas->dirty = false;
@@ -250,7 +272,7 @@ static void gl1_raster_font_draw_vertices(gl1_raster_t *font,
 
    if (font->atlas->dirty)
    {
-      gl1_raster_font_upload_atlas(font);
+      gl1_raster_font_upload_atlas(font, true);
       font->atlas->dirty   = false;
    }
 
@@ -97,6 +97,30 @@ static bool gl_core_raster_font_upload_atlas(gl_core_raster_t *font)
    return true;
 }
 
+/* Sends the atlas rows modified since the last
+ * upload to the existing texture */
+static void gl_core_raster_font_update_atlas(gl_core_raster_t *font)
+{
+   unsigned y      = 0;
+   unsigned height = font->atlas->height;
+
+   if (font->atlas->dirty_y_end > font->atlas->dirty_y_start)
+   {
+      y      = font->atlas->dirty_y_start;
+      height = font->atlas->dirty_y_end - y;
+   }
+
+   glBindTexture(GL_TEXTURE_2D, font->tex);
+
+   glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+   glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+   glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+   glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y,
+                   font->atlas->width, height, GL_RED, GL_UNSIGNED_BYTE,
+                   font->atlas->buffer + y * font->atlas->width);
+   glBindTexture(GL_TEXTURE_2D, 0);
+}
+
 static void *gl_core_raster_font_init_font(void *data,
       const char *font_path, float font_size,
       bool is_threaded)
@@ -172,7 +196,7 @@ static void gl_core_raster_font_draw_vertices(gl_core_raster_t *font,
 {
    if (font->atlas->dirty)
    {
-      gl_core_raster_font_upload_atlas(font);
+      gl_core_raster_font_update_atlas(font);
       font->atlas->dirty   = false;
    }
 
@@ -34,16 +34,31 @@
 #include FT_FREETYPE_H
 #include "../font_driver.h"
 
+/* The atlas is made up of one or more 'pages'
+ * of FT_ATLAS_ROWS x FT_ATLAS_COLS glyph slots,
+ * stacked vertically. Additional pages are used
+ * when the resultant texture remains within
+ * FT_ATLAS_MAX_HEIGHT - this greatly reduces
+ * glyph thrashing when displaying CJK text */
 #define FT_ATLAS_ROWS 16
 #define FT_ATLAS_COLS 16
-#define FT_ATLAS_SIZE (FT_ATLAS_ROWS * FT_ATLAS_COLS)
+#define FT_ATLAS_PAGE_SIZE (FT_ATLAS_ROWS * FT_ATLAS_COLS)
+#define FT_ATLAS_MAX_PAGES 4
+#define FT_ATLAS_MAX_HEIGHT 2048
+
+/* Number of glyph hash map buckets
+ * (must be a power of 2) */
+#define FT_ATLAS_MAP_SIZE 0x400
 
 typedef struct freetype_atlas_slot
 {
-   struct freetype_atlas_slot* next;   /* ptr alignment */
-   struct font_glyph glyph;            /* unsigned alignment */
+   struct freetype_atlas_slot* next;      /* ptr alignment */
+   /* Least recently used list */
+   struct freetype_atlas_slot* lru_prev;  /* ptr alignment */
+   struct freetype_atlas_slot* lru_next;  /* ptr alignment */
+   struct font_glyph glyph;               /* unsigned alignment */
    unsigned charcode;
-   unsigned last_used;
+   bool mapped;
 }freetype_atlas_slot_t;
 
 typedef struct freetype_renderer
@@ -51,9 +66,11 @@ typedef struct freetype_renderer
    FT_Library lib;                                   /* ptr alignment   */
    FT_Face face;                                     /* ptr alignment   */
    struct font_atlas atlas;                          /* ptr alignment   */
-   freetype_atlas_slot_t atlas_slots[FT_ATLAS_SIZE]; /* ptr alignment   */
-   freetype_atlas_slot_t* uc_map[0x100];             /* ptr alignment   */
-   unsigned usage_counter;
+   freetype_atlas_slot_t *atlas_slots;               /* ptr alignment   */
+   freetype_atlas_slot_t *lru_head;                  /* ptr alignment   */
+   freetype_atlas_slot_t *lru_tail;                  /* ptr alignment   */
+   freetype_atlas_slot_t* uc_map[FT_ATLAS_MAP_SIZE]; /* ptr alignment   */
+   unsigned num_slots;
    struct font_line_metrics line_metrics;            /* float alignment */
 } ft_font_renderer_t;
 
@@ -72,6 +89,7 @@ static void font_renderer_ft_free(void *data)
       return;
 
    free(handle->atlas.buffer);
+   free(handle->atlas_slots);
 
    if (handle->face)
       FT_Done_Face(handle->face);
@@ -80,29 +98,54 @@ static void font_renderer_ft_free(void *data)
    free(handle);
 }
 
-static freetype_atlas_slot_t* font_renderer_get_slot(ft_font_renderer_t *handle)
+/* Moves specified slot to the front
+ * of the least recently used list */
+static void font_renderer_ft_touch_slot(ft_font_renderer_t *handle,
+      freetype_atlas_slot_t *slot)
 {
-   int i, map_id;
-   unsigned oldest = 0;
+   if (handle->lru_head == slot)
+      return;
+
+   /* Unlink */
+   if (slot->lru_prev)
+      slot->lru_prev->lru_next = slot->lru_next;
+   if (slot->lru_next)
+      slot->lru_next->lru_prev = slot->lru_prev;
+   if (handle->lru_tail == slot)
+      handle->lru_tail = slot->lru_prev;
+
+   /* Insert at head */
+   slot->lru_prev           = NULL;
+   slot->lru_next           = handle->lru_head;
+   if (handle->lru_head)
+      handle->lru_head->lru_prev = slot;
+   handle->lru_head         = slot;
+   if (!handle->lru_tail)
+      handle->lru_tail      = slot;
+}
 
-   for (i = 1; i < FT_ATLAS_SIZE; i++)
-      if ((handle->usage_counter - handle->atlas_slots[i].last_used) >
-         (handle->usage_counter - handle->atlas_slots[oldest].last_used))
-         oldest = i;
+static freetype_atlas_slot_t* font_renderer_get_slot(ft_font_renderer_t *handle)
+{
+   freetype_atlas_slot_t *oldest = handle->lru_tail;
 
    /* remove from map */
-   map_id = handle->atlas_slots[oldest].charcode & 0xFF;
-   if (handle->uc_map[map_id] == &handle->atlas_slots[oldest])
-      handle->uc_map[map_id] = handle->atlas_slots[oldest].next;
-   else if (handle->uc_map[map_id])
+   if (oldest->mapped)
    {
-      freetype_atlas_slot_t* ptr = handle->uc_map[map_id];
-      while (ptr->next && ptr->next != &handle->atlas_slots[oldest])
-         ptr = ptr->next;
-      ptr->next = handle->atlas_slots[oldest].next;
+      freetype_atlas_slot_t **ptr = &handle->uc_map[
+            oldest->charcode & (FT_ATLAS_MAP_SIZE - 1)];
+
+      while (*ptr && *ptr != oldest)
+         ptr = &(*ptr)->next;
+      if (*ptr)
+         *ptr = oldest->next;
+
+      oldest->next   = NULL;
+      oldest->mapped = false;
    }
 
-   return &handle->atlas_slots[oldest];
+   font_renderer_ft_touch_slot(handle, oldest);
+
+   return oldest;
 }
 
 static const struct font_glyph *font_renderer_ft_get_glyph(
@@ -117,14 +160,14 @@ static const struct font_glyph *font_renderer_ft_get_glyph(
    if (!handle)
       return NULL;
 
-   map_id     = charcode & 0xFF;
+   map_id     = charcode & (FT_ATLAS_MAP_SIZE - 1);
    atlas_slot = handle->uc_map[map_id];
 
    while (atlas_slot)
    {
       if (atlas_slot->charcode == charcode)
       {
-         atlas_slot->last_used = handle->usage_counter++;
+         font_renderer_ft_touch_slot(handle, atlas_slot);
          return &atlas_slot->glyph;
       }
       atlas_slot = atlas_slot->next;
@@ -138,6 +181,7 @@ static const struct font_glyph *font_renderer_ft_get_glyph(
 
    atlas_slot             = font_renderer_get_slot(handle);
    atlas_slot->charcode   = charcode;
+   atlas_slot->mapped     = true;
    atlas_slot->next       = handle->uc_map[map_id];
    handle->uc_map[map_id] = atlas_slot;
 
@@ -163,8 +207,8 @@ static const struct font_glyph *font_renderer_ft_get_glyph(
             dst[c] = src[c];
    }
 
-   handle->atlas.dirty = true;
-   atlas_slot->last_used = handle->usage_counter++;
+   font_atlas_set_dirty_rows(&handle->atlas,
+         atlas_slot->glyph.atlas_offset_y, atlas_slot->glyph.height);
    return &atlas_slot->glyph;
 }
 
@@ -177,21 +221,40 @@ static bool font_renderer_create_atlas(ft_font_renderer_t *handle, float font_si
    unsigned max_height = round((handle->face->bbox.yMax - handle->face->bbox.yMin) * font_size / handle->face->units_per_EM);
 
    unsigned atlas_width        = max_width  * FT_ATLAS_COLS;
+   unsigned num_pages          = 1;
+   unsigned atlas_height       = 0;
+   uint8_t *atlas_buffer       = NULL;
 
-   unsigned atlas_height       = max_height * FT_ATLAS_ROWS;
+   /* Use as many pages as possible without
+    * exceeding the maximum texture height */
+   while ((num_pages < FT_ATLAS_MAX_PAGES) &&
+          ((num_pages + 1) * max_height * FT_ATLAS_ROWS <= FT_ATLAS_MAX_HEIGHT))
+      num_pages++;
 
-   uint8_t *atlas_buffer       = (uint8_t*)
+   atlas_height                = max_height * FT_ATLAS_ROWS * num_pages;
+
+   atlas_buffer                = (uint8_t*)
       calloc(atlas_width * atlas_height, 1);
 
    if (!atlas_buffer)
       return false;
 
+   handle->atlas_slots         = (freetype_atlas_slot_t*)
+      calloc(num_pages * FT_ATLAS_PAGE_SIZE, sizeof(freetype_atlas_slot_t));
+
+   if (!handle->atlas_slots)
+   {
+      free(atlas_buffer);
+      return false;
+   }
+
+   handle->num_slots           = num_pages * FT_ATLAS_PAGE_SIZE;
    handle->atlas.buffer        = atlas_buffer;
    handle->atlas.width         = atlas_width;
    handle->atlas.height        = atlas_height;
    slot                        = handle->atlas_slots;
 
-   for (y = 0; y < FT_ATLAS_ROWS; y++)
+   for (y = 0; y < FT_ATLAS_ROWS * num_pages; y++)
    {
       for (x = 0; x < FT_ATLAS_COLS; x++)
       {
@@ -201,6 +264,18 @@ static bool font_renderer_create_atlas(ft_font_renderer_t *handle, float font_si
       }
    }
 
+   /* Initialise least recently used list */
+   for (i = 0; i < handle->num_slots; i++)
+   {
+      slot           = &handle->atlas_slots[i];
+      slot->lru_prev = (i > 0) ? &handle->atlas_slots[i - 1] : NULL;
+      slot->lru_next = (i < handle->num_slots - 1) ?
+            &handle->atlas_slots[i + 1] : NULL;
+   }
+
+   handle->lru_head = &handle->atlas_slots[0];
+   handle->lru_tail = &handle->atlas_slots[handle->num_slots - 1];
+
    for (i = 0; i < 256; i++)
       font_renderer_ft_get_glyph(handle, i);
 
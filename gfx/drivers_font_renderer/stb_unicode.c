@@ -39,28 +39,45 @@
 #undef STATIC
 #endif
 
+/* The atlas is made up of one or more 'pages'
+ * of STB_UNICODE_ATLAS_ROWS x STB_UNICODE_ATLAS_COLS
+ * glyph slots, stacked vertically. Additional pages
+ * are used when the resultant texture remains within
+ * STB_UNICODE_ATLAS_MAX_HEIGHT - this greatly reduces
+ * glyph thrashing when displaying CJK text */
 #define STB_UNICODE_ATLAS_ROWS 16
 #define STB_UNICODE_ATLAS_COLS 16
-#define STB_UNICODE_ATLAS_SIZE (STB_UNICODE_ATLAS_ROWS * STB_UNICODE_ATLAS_COLS)
+#define STB_UNICODE_ATLAS_PAGE_SIZE (STB_UNICODE_ATLAS_ROWS * STB_UNICODE_ATLAS_COLS)
+#define STB_UNICODE_ATLAS_MAX_PAGES 4
+#define STB_UNICODE_ATLAS_MAX_HEIGHT 2048
+
+/* Number of glyph hash map buckets
+ * (must be a power of 2) */
+#define STB_UNICODE_ATLAS_MAP_SIZE 0x400
 
 typedef struct stb_unicode_atlas_slot
 {
    struct stb_unicode_atlas_slot* next;
+   /* Least recently used list */
+   struct stb_unicode_atlas_slot* lru_prev;
+   struct stb_unicode_atlas_slot* lru_next;
    struct font_glyph glyph;      /* unsigned alignment */
    unsigned charcode;
-   unsigned last_used;
+   bool mapped;
 }stb_unicode_atlas_slot_t;
 
 typedef struct
 {
    uint8_t *font_data;
    struct font_atlas atlas;               /* ptr alignment */
-   stb_unicode_atlas_slot_t* uc_map[0x100];
-   stb_unicode_atlas_slot_t atlas_slots[STB_UNICODE_ATLAS_SIZE];
+   stb_unicode_atlas_slot_t* uc_map[STB_UNICODE_ATLAS_MAP_SIZE];
+   stb_unicode_atlas_slot_t *atlas_slots;
+   stb_unicode_atlas_slot_t *lru_head;
+   stb_unicode_atlas_slot_t *lru_tail;
    stbtt_fontinfo info;                   /* ptr alignment */
    int max_glyph_width;
    int max_glyph_height;
-   unsigned usage_counter;
+   unsigned num_slots;
    float scale_factor;
    struct font_line_metrics line_metrics; /* float alignment */
 } stb_unicode_font_renderer_t;
@@ -76,33 +93,60 @@ static void font_renderer_stb_unicode_free(void *data)
    stb_unicode_font_renderer_t *self = (stb_unicode_font_renderer_t*)data;
 
    free(self->atlas.buffer);
+   free(self->atlas_slots);
    free(self->font_data);
    free(self);
 }
 
-static stb_unicode_atlas_slot_t* font_renderer_stb_unicode_get_slot(stb_unicode_font_renderer_t *handle)
+/* Moves specified slot to the front
+ * of the least recently used list */
+static void font_renderer_stb_unicode_touch_slot(
+      stb_unicode_font_renderer_t *handle,
+      stb_unicode_atlas_slot_t *slot)
 {
-   int i, map_id;
-   unsigned oldest = 0;
+   if (handle->lru_head == slot)
+      return;
+
+   /* Unlink */
+   if (slot->lru_prev)
+      slot->lru_prev->lru_next = slot->lru_next;
+   if (slot->lru_next)
+      slot->lru_next->lru_prev = slot->lru_prev;
+   if (handle->lru_tail == slot)
+      handle->lru_tail = slot->lru_prev;
+
+   /* Insert at head */
+   slot->lru_prev           = NULL;
+   slot->lru_next           = handle->lru_head;
+   if (handle->lru_head)
+      handle->lru_head->lru_prev = slot;
+   handle->lru_head         = slot;
+   if (!handle->lru_tail)
+      handle->lru_tail      = slot;
+}
 
-   for (i = 1; i < STB_UNICODE_ATLAS_SIZE; i++)
-      if ((handle->usage_counter - handle->atlas_slots[i].last_used) >
-         (handle->usage_counter - handle->atlas_slots[oldest].last_used))
-         oldest = i;
+static stb_unicode_atlas_slot_t* font_renderer_stb_unicode_get_slot(stb_unicode_font_renderer_t *handle)
+{
+   stb_unicode_atlas_slot_t *oldest = handle->lru_tail;
 
    /* remove from map */
-   map_id = handle->atlas_slots[oldest].charcode & 0xFF;
-   if (handle->uc_map[map_id] == &handle->atlas_slots[oldest])
-      handle->uc_map[map_id] = handle->atlas_slots[oldest].next;
-   else if (handle->uc_map[map_id])
+   if (oldest->mapped)
    {
-      stb_unicode_atlas_slot_t* ptr = handle->uc_map[map_id];
-      while (ptr->next && ptr->next != &handle->atlas_slots[oldest])
-         ptr = ptr->next;
-      ptr->next = handle->atlas_slots[oldest].next;
+      stb_unicode_atlas_slot_t **ptr = &handle->uc_map[
+            oldest->charcode & (STB_UNICODE_ATLAS_MAP_SIZE - 1)];
+
+      while (*ptr && *ptr != oldest)
+         ptr = &(*ptr)->next;
+      if (*ptr)
+         *ptr = oldest->next;
+
+      oldest->next   = NULL;
+      oldest->mapped = false;
    }
 
-   return &handle->atlas_slots[oldest];
+   font_renderer_stb_unicode_touch_slot(handle, oldest);
+
+   return oldest;
 }
 
 static const struct font_glyph *font_renderer_stb_unicode_get_glyph(
@@ -123,14 +167,14 @@ static const struct font_glyph *font_renderer_stb_unicode_get_glyph(
    if (!self)
       return NULL;
 
-   map_id                               = charcode & 0xFF;
+   map_id                               = charcode & (STB_UNICODE_ATLAS_MAP_SIZE - 1);
    atlas_slot                           = self->uc_map[map_id];
 
    while (atlas_slot)
    {
       if (atlas_slot->charcode == charcode)
       {
-         atlas_slot->last_used = self->usage_counter++;
+         font_renderer_stb_unicode_touch_slot(self, atlas_slot);
          return &atlas_slot->glyph;
       }
       atlas_slot = atlas_slot->next;
@@ -138,6 +182,7 @@ static const struct font_glyph *font_renderer_stb_unicode_get_glyph(
 
    atlas_slot             = font_renderer_stb_unicode_get_slot(self);
    atlas_slot->charcode   = charcode;
+   atlas_slot->mapped     = true;
    atlas_slot->next       = self->uc_map[map_id];
    self->uc_map[map_id]   = atlas_slot;
 
@@ -181,8 +226,8 @@ static const struct font_glyph *font_renderer_stb_unicode_get_glyph(
    atlas_slot->glyph.draw_offset_y  = (int)((glyph_draw_offset_y < 0.0f) ?
          floor((double)glyph_draw_offset_y) : ceil((double)glyph_draw_offset_y));
 
-   self->atlas.dirty = true;
-   atlas_slot->last_used = self->usage_counter++;
+   font_atlas_set_dirty_rows(&self->atlas,
+         atlas_slot->glyph.atlas_offset_y, self->max_glyph_height);
    return &atlas_slot->glyph;
 }
 
@@ -191,12 +236,20 @@ static bool font_renderer_stb_unicode_create_atlas(
 {
    unsigned i, x, y;
    stb_unicode_atlas_slot_t* slot = NULL;
+   unsigned num_pages             = 1;
 
    self->max_glyph_width  = font_size < 0 ? -font_size : font_size;
    self->max_glyph_height = font_size < 0 ? -font_size : font_size;
 
+   /* Use as many pages as possible without
+    * exceeding the maximum texture height */
+   while ((num_pages < STB_UNICODE_ATLAS_MAX_PAGES) &&
+          ((num_pages + 1) * self->max_glyph_height * STB_UNICODE_ATLAS_ROWS
+               <= STB_UNICODE_ATLAS_MAX_HEIGHT))
+      num_pages++;
+
    self->atlas.width      = self->max_glyph_width  * STB_UNICODE_ATLAS_COLS;
-   self->atlas.height     = self->max_glyph_height * STB_UNICODE_ATLAS_ROWS;
+   self->atlas.height     = self->max_glyph_height * STB_UNICODE_ATLAS_ROWS * num_pages;
 
    self->atlas.buffer     = (uint8_t*)
       calloc(self->atlas.width * self->atlas.height, sizeof(uint8_t));
@@ -204,9 +257,17 @@ static bool font_renderer_stb_unicode_create_atlas(
    if (!self->atlas.buffer)
       return false;
 
-   slot = self->atlas_slots;
+   self->atlas_slots      = (stb_unicode_atlas_slot_t*)
+      calloc(num_pages * STB_UNICODE_ATLAS_PAGE_SIZE,
+            sizeof(stb_unicode_atlas_slot_t));
+
+   if (!self->atlas_slots)
+      return false;
+
+   self->num_slots        = num_pages * STB_UNICODE_ATLAS_PAGE_SIZE;
+   slot                   = self->atlas_slots;
 
-   for (y = 0; y < STB_UNICODE_ATLAS_ROWS; y++)
+   for (y = 0; y < STB_UNICODE_ATLAS_ROWS * num_pages; y++)
    {
       for (x = 0; x < STB_UNICODE_ATLAS_COLS; x++)
       {
@@ -216,6 +277,18 @@ static bool font_renderer_stb_unicode_create_atlas(
       }
    }
 
+   /* Initialise least recently used list */
+   for (i = 0; i < self->num_slots; i++)
+   {
+      slot           = &self->atlas_slots[i];
+      slot->lru_prev = (i > 0) ? &self->atlas_slots[i - 1] : NULL;
+      slot->lru_next = (i < self->num_slots - 1) ?
+            &self->atlas_slots[i + 1] : NULL;
+   }
+
+   self->lru_head = &self->atlas_slots[0];
+   self->lru_tail = &self->atlas_slots[self->num_slots - 1];
+
    for (i = 0; i < 256; i++)
       font_renderer_stb_unicode_get_glyph(self, i);
 
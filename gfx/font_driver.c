@@ -17,11 +17,15 @@
 #include <stdlib.h>
 #include <math.h>
 
+#include <lrc_hash.h>
+#include <string/stdstring.h>
+
 #ifdef HAVE_CONFIG_H
 #include "../config.h"
 #endif
 
 #include "font_driver.h"
+#include "gfx_display.h"
 #include "video_thread_wrapper.h"
 
 #include "../retroarch.h"
@@ -1039,18 +1043,20 @@ static INLINE unsigned font_get_replacement(const char* src, const char* start)
    return 0;
 }
 
-static char* font_driver_reshape_msg(const char* msg, unsigned char *buffer, size_t buffer_size)
+/* Returns a newly allocated copy of msg with
+ * RTL text reordered and Arabic glyphs shaped */
+static char* font_driver_reshape_msg(const char* msg)
 {
-   unsigned char*       dst_buffer = buffer;
    const unsigned char* src     = (const unsigned char*)msg;
+   unsigned char*       dst_buffer;
    unsigned char*       dst;
    bool                 reverse = false;
+   /* worst case transformations are 2 bytes to 4 bytes -- aliaspider */
    size_t              msg_size = (strlen(msg) * 2) + 1;
 
-   /* fallback to heap allocated buffer if the buffer is too small */
-   /* worst case transformations are 2 bytes to 4 bytes -- aliaspider */
-   if (buffer_size < msg_size)
-      dst_buffer = (unsigned char*)malloc(msg_size);
+   dst_buffer = (unsigned char*)malloc(msg_size);
+   if (!dst_buffer)
+      return NULL;
 
    dst = (unsigned char*)dst_buffer;
 
@@ -1128,6 +1134,118 @@ static char* font_driver_reshape_msg(const char* msg, unsigned char *buffer, siz
 
    return (char*)dst_buffer;
 }
+
+/* Shaped message cache
+ * > Menus redraw the same strings every frame, so
+ *   the results of font_driver_reshape_msg() are
+ *   cached. Reshaping depends only on the source
+ *   text (not on font face or size), so this is
+ *   the cache key
+ * > Font rendering only takes place on the video
+ *   thread, so no locking is required */
+#define FONT_SHAPE_CACHE_SIZE 64
+
+typedef struct
+{
+   char *src;
+   char *shaped;
+   uint32_t hash;
+   unsigned last_used;
+} font_shape_cache_entry_t;
+
+static font_shape_cache_entry_t font_shape_cache[FONT_SHAPE_CACHE_SIZE];
+static unsigned font_shape_cache_counter = 0;
+
+static void font_driver_shape_cache_free(void)
+{
+   unsigned i;
+
+   for (i = 0; i < FONT_SHAPE_CACHE_SIZE; i++)
+   {
+      font_shape_cache_entry_t *entry = &font_shape_cache[i];
+
+      if (entry->src)
+         free(entry->src);
+      if (entry->shaped)
+         free(entry->shaped);
+
+      entry->src       = NULL;
+      entry->shaped    = NULL;
+      entry->hash      = 0;
+      entry->last_used = 0;
+   }
+
+   font_shape_cache_counter = 0;
+}
+
+/* Returns a version of msg suitable for rendering.
+ * Returned string is either msg itself or is owned
+ * by the shaped message cache, and remains valid
+ * until the next call of this function */
+static const char *font_driver_get_shaped_msg(const char *msg)
+{
+   unsigned i;
+   uint32_t hash;
+   char *shaped                    = NULL;
+   char *src                       = NULL;
+   const unsigned char *ptr        = (const unsigned char*)msg;
+   font_shape_cache_entry_t *entry = NULL;
+
+   /* Strings without RTL characters are
+    * unaffected by reshaping */
+   while (*ptr && !IS_RTL(ptr))
+      ptr++;
+
+   if (!*ptr)
+      return msg;
+
+   hash = djb2_calculate(msg);
+
+   /* Search cache, keeping track of least
+    * recently used entry */
+   for (i = 0; i < FONT_SHAPE_CACHE_SIZE; i++)
+   {
+      font_shape_cache_entry_t *cur = &font_shape_cache[i];
+
+      if (   cur->src
+          && (cur->hash == hash)
+          && string_is_equal(cur->src, msg))
+      {
+         cur->last_used = ++font_shape_cache_counter;
+         return cur->shaped;
+      }
+
+      if (!entry || !cur->src ||
+            (entry->src && (cur->last_used < entry->last_used)))
+         entry = cur;
+   }
+
+   /* Cache miss - reshape and replace least
+    * recently used entry */
+   shaped = font_driver_reshape_msg(msg);
+   src    = strdup(msg);
+
+   if (!shaped || !src)
+   {
+      if (shaped)
+         free(shaped);
+      if (src)
+         free(src);
+      return msg;
+   }
+
+   if (entry->src)
+      free(entry->src);
+   if (entry->shaped)
+      free(entry->shaped);
+
+   entry->src       = src;
+   entry->shaped    = shaped;
+   entry->hash      = hash;
+   entry->last_used = ++font_shape_cache_counter;
+
+   return entry->shaped;
+}
 #endif
 
 void font_driver_render_msg(
@@ -1143,17 +1261,18 @@ void font_driver_render_msg(
    if (msg && *msg && font && font->renderer && font->renderer->render_msg)
    {
 #ifdef HAVE_LANGEXTRA
-      unsigned char tmp_buffer[64];
-      char *new_msg = font_driver_reshape_msg(msg, tmp_buffer, sizeof(tmp_buffer));
+      const char *new_msg = font_driver_get_shaped_msg(msg);
 #else
-      char *new_msg = (char*)msg;
+      const char *new_msg = msg;
 #endif
+      /* Text is drawn immediately unless a raster
+       * block is bound - pending batched display
+       * draws must be submitted first */
+      if (!font->block)
+         gfx_display_batch_flush();
+
       font->renderer->render_msg(data,
             font->renderer_data, new_msg, params);
-#ifdef HAVE_LANGEXTRA
-      if (new_msg != (char*)tmp_buffer)
-         free(new_msg);
-#endif
    }
 }
 
@@ -1162,14 +1281,20 @@ void font_driver_bind_block(void *font_data, void *block)
    font_data_t *font = (font_data_t*)(font_data ? font_data : video_font_driver);
 
    if (font && font->renderer && font->renderer->bind_block)
+   {
       font->renderer->bind_block(font->renderer_data, block);
+      font->block = block;
+   }
 }
 
 void font_driver_flush(unsigned width, unsigned height, void *font_data)
 {
    font_data_t *font = (font_data_t*)(font_data ? font_data : video_font_driver);
    if (font && font->renderer && font->renderer->flush)
+   {
+      gfx_display_batch_flush();
       font->renderer->flush(width, height, font->renderer_data);
+   }
 }
 
 int font_driver_get_message_width(void *font_data,
@@ -1296,6 +1421,7 @@ font_data_t *font_driver_init_first(
       font_data_t *font   = (font_data_t*)malloc(sizeof(*font));
       font->renderer      = (const font_renderer_t*)font_driver;
       font->renderer_data = font_handle;
+      font->block         = NULL;
       font->size          = font_size;
       return font;
    }
@@ -1328,4 +1454,8 @@ void font_driver_free_osd(void)
       font_driver_free(video_font_driver);
 
    video_font_driver = NULL;
+
+#ifdef HAVE_LANGEXTRA
+   font_driver_shape_cache_free();
+#endif
 }
@@ -60,9 +60,44 @@ struct font_atlas
    uint8_t *buffer; /* Alpha channel. */
    unsigned width;
    unsigned height;
+   /* Rows [dirty_y_start, dirty_y_end) modified since
+    * dirty was last cleared, as recorded by
+    * font_atlas_set_dirty_rows(). If dirty_y_end is zero,
+    * the whole atlas must be treated as modified.
+    * The gl, gl1 and glcore font drivers upload only
+    * these rows; all other drivers transfer the whole
+    * atlas texture (every page) whenever a glyph is
+    * added */
+   unsigned dirty_y_start;
+   unsigned dirty_y_end;
    bool dirty;
 };
 
+/* Marks rows [y, y + height) of the atlas as modified */
+static INLINE void font_atlas_set_dirty_rows(struct font_atlas *atlas,
+      unsigned y, unsigned height)
+{
+   unsigned y_end = y + height;
+
+   if (y_end > atlas->height)
+      y_end = atlas->height;
+
+   if (!atlas->dirty)
+   {
+      atlas->dirty_y_start = y;
+      atlas->dirty_y_end   = y_end;
+   }
+   else if (atlas->dirty_y_end)
+   {
+      if (y < atlas->dirty_y_start)
+         atlas->dirty_y_start = y;
+      if (y_end > atlas->dirty_y_end)
+         atlas->dirty_y_end   = y_end;
+   }
+
+   atlas->dirty = true;
+}
+
 struct font_params
 {
    /* Drop shadow offset.
@@ -132,6 +167,7 @@ typedef struct
 {
    const font_renderer_t *renderer;
    void *renderer_data;
+   void *block;
    float size;
 } font_data_t;
 
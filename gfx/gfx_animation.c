@@ -19,6 +19,7 @@
 
 #include <compat/strl.h>
 #include <encodings/utf.h>
+#include <retro_inline.h>
 #include <retro_math.h>
 #include <retro_miscellaneous.h>
 #include <string/stdstring.h>
@@ -268,6 +269,236 @@ static float easing_out_in_bounce(float t, float b, float c, float d)
    return easing_in_bounce((t * 2) - d, b + c / 2, c / 2, d);
 }
 
+/* Indexed by enum gfx_animation_easing_type */
+static const easing_cb gfx_animation_easings[EASING_LAST] = {
+   /* Linear */
+   easing_linear,
+   /* Quad */
+   easing_in_quad,
+   easing_out_quad,
+   easing_in_out_quad,
+   easing_out_in_quad,
+   /* Cubic */
+   easing_in_cubic,
+   easing_out_cubic,
+   easing_in_out_cubic,
+   easing_out_in_cubic,
+   /* Quart */
+   easing_in_quart,
+   easing_out_quart,
+   easing_in_out_quart,
+   easing_out_in_quart,
+   /* Quint */
+   easing_in_quint,
+   easing_out_quint,
+   easing_in_out_quint,
+   easing_out_in_quint,
+   /* Sine */
+   easing_in_sine,
+   easing_out_sine,
+   easing_in_out_sine,
+   easing_out_in_sine,
+   /* Expo */
+   easing_in_expo,
+   easing_out_expo,
+   easing_in_out_expo,
+   easing_out_in_expo,
+   /* Circ */
+   easing_in_circ,
+   easing_out_circ,
+   easing_in_out_circ,
+   easing_out_in_circ,
+   /* Bounce */
+   easing_in_bounce,
+   easing_out_bounce,
+   easing_in_out_bounce,
+   easing_out_in_bounce
+};
+
+static INLINE unsigned gfx_animation_tag_hash(uintptr_t tag, unsigned bits)
+{
+   /* Tags are mostly pointers: fold the upper half in,
+    * then keep the top bits of a multiplicative hash */
+   uint64_t key = (uint64_t)tag;
+   uint32_t h   = (uint32_t)(key ^ (key >> 32)) * 0x9E3779B1u;
+   return (unsigned)(h >> (32 - bits));
+}
+
+static void gfx_animation_tweens_rehash(struct gfx_animation_tweens *tweens)
+{
+   size_t i;
+   size_t num_buckets = (size_t)1 << tweens->tag_bits;
+
+   for (i = 0; i < num_buckets; i++)
+      tweens->tag_buckets[i] = -1;
+
+   for (i = 0; i < tweens->size; i++)
+   {
+      unsigned h            = gfx_animation_tag_hash(
+            tweens->tag[i], tweens->tag_bits);
+      tweens->tag_next[i]   = tweens->tag_buckets[h];
+      tweens->tag_buckets[h] = (int)i;
+   }
+}
+
+/* Removes deleted slots while preserving the order
+ * of the remaining tweens (completion callbacks fire
+ * in push order) */
+static void gfx_animation_tweens_compact(struct gfx_animation_tweens *tweens)
+{
+   size_t i;
+   size_t j = 0;
+
+   for (i = 0; i < tweens->size; i++)
+   {
+      if (tweens->deleted[i])
+         continue;
+
+      if (i != j)
+      {
+         tweens->running_since[j] = tweens->running_since[i];
+         tweens->initial_value[j] = tweens->initial_value[i];
+         tweens->target_value[j]  = tweens->target_value[i];
+         tweens->duration[j]      = tweens->duration[i];
+         tweens->subject[j]       = tweens->subject[i];
+         tweens->tag[j]           = tweens->tag[i];
+         tweens->cb[j]            = tweens->cb[i];
+         tweens->userdata[j]      = tweens->userdata[i];
+         tweens->easing_enum[j]   = tweens->easing_enum[i];
+         tweens->deleted[j]       = 0;
+      }
+      j++;
+   }
+
+   if (j != tweens->size)
+   {
+      tweens->size        = j;
+      tweens->order_dirty = true;
+      gfx_animation_tweens_rehash(tweens);
+   }
+}
+
+static void gfx_animation_tweens_sort(struct gfx_animation_tweens *tweens)
+{
+   size_t i;
+   unsigned e;
+   size_t num_live = 0;
+   size_t offsets[EASING_LAST];
+
+   memset(tweens->order_counts, 0, sizeof(tweens->order_counts));
+   for (i = 0; i < tweens->size; i++)
+      if (!tweens->deleted[i])
+         tweens->order_counts[tweens->easing_enum[i]]++;
+
+   for (e = 0; e < EASING_LAST; e++)
+   {
+      offsets[e] = num_live;
+      num_live  += tweens->order_counts[e];
+   }
+
+   for (i = 0; i < tweens->size; i++)
+      if (!tweens->deleted[i])
+         tweens->order[offsets[tweens->easing_enum[i]]++] = (unsigned)i;
+
+   tweens->order_dirty = false;
+}
+
+#define GFX_ANIMATION_TWEENS_GROW(arr, cap) \
+{ \
+   void *tmp = realloc((arr), (cap) * sizeof(*(arr))); \
+   if (!tmp) \
+      return false; \
+   (arr) = tmp; \
+}
+
+static bool gfx_animation_tweens_reserve(
+      struct gfx_animation_tweens *tweens, size_t min_capacity)
+{
+   size_t capacity;
+   unsigned tag_bits;
+
+   if (min_capacity <= tweens->capacity)
+      return true;
+
+   capacity = tweens->capacity ? tweens->capacity : 32;
+   while (capacity < min_capacity)
+      capacity *= 2;
+
+   /* Keep the tag table at least twice the slot count */
+   tag_bits = tweens->tag_bits ? tweens->tag_bits : 6;
+   while (((size_t)1 << tag_bits) < capacity * 2)
+      tag_bits++;
+
+   GFX_ANIMATION_TWEENS_GROW(tweens->running_since, capacity);
+   GFX_ANIMATION_TWEENS_GROW(tweens->initial_value, capacity);
+   GFX_ANIMATION_TWEENS_GROW(tweens->target_value,  capacity);
+   GFX_ANIMATION_TWEENS_GROW(tweens->duration,      capacity);
+   GFX_ANIMATION_TWEENS_GROW(tweens->subject,       capacity);
+   GFX_ANIMATION_TWEENS_GROW(tweens->tag,           capacity);
+   GFX_ANIMATION_TWEENS_GROW(tweens->cb,            capacity);
+   GFX_ANIMATION_TWEENS_GROW(tweens->userdata,      capacity);
+   GFX_ANIMATION_TWEENS_GROW(tweens->tag_next,      capacity);
+   GFX_ANIMATION_TWEENS_GROW(tweens->order,         capacity);
+   GFX_ANIMATION_TWEENS_GROW(tweens->easing_enum,   capacity);
+   GFX_ANIMATION_TWEENS_GROW(tweens->deleted,       capacity);
+   GFX_ANIMATION_TWEENS_GROW(tweens->tag_buckets,
+         (size_t)1 << tag_bits);
+
+   tweens->capacity = capacity;
+   tweens->tag_bits = tag_bits;
+   gfx_animation_tweens_rehash(tweens);
+
+   return true;
+}
+
+static bool gfx_animation_tweens_append(
+      struct gfx_animation_tweens *tweens, const struct tween *t)
+{
+   unsigned h;
+   size_t slot = tweens->size;
+
+   if (!gfx_animation_tweens_reserve(tweens, slot + 1))
+      return false;
+
+   tweens->running_since[slot] = 0.0f;
+   tweens->initial_value[slot] = t->initial_value;
+   tweens->target_value[slot]  = t->target_value;
+   tweens->duration[slot]      = t->duration;
+   tweens->subject[slot]       = t->subject;
+   tweens->tag[slot]           = t->tag;
+   tweens->cb[slot]            = t->cb;
+   tweens->userdata[slot]      = t->userdata;
+   tweens->easing_enum[slot]   = t->easing_enum;
+   tweens->deleted[slot]       = 0;
+
+   h                           = gfx_animation_tag_hash(
+         t->tag, tweens->tag_bits);
+   tweens->tag_next[slot]      = tweens->tag_buckets[h];
+   tweens->tag_buckets[h]      = (int)slot;
+   tweens->size                = slot + 1;
+   tweens->order_dirty         = true;
+
+   return true;
+}
+
+static void gfx_animation_tweens_free(struct gfx_animation_tweens *tweens)
+{
+   free(tweens->running_since);
+   free(tweens->initial_value);
+   free(tweens->target_value);
+   free(tweens->duration);
+   free(tweens->subject);
+   free(tweens->tag);
+   free(tweens->cb);
+   free(tweens->userdata);
+   free(tweens->tag_next);
+   free(tweens->tag_buckets);
+   free(tweens->order);
+   free(tweens->easing_enum);
+   free(tweens->deleted);
+   memset(tweens, 0, sizeof(*tweens));
+}
+
 static size_t gfx_animation_ticker_generic(uint64_t idx,
       size_t max_width, size_t *width)
 {
@@ -1004,142 +1235,52 @@ bool gfx_animation_push(gfx_animation_ctx_entry_t *entry)
    struct tween t;
    gfx_animation_t *p_anim = anim_get_ptr();
 
+   /* ignore born dead tweens */
+   if (     (unsigned)entry->easing_enum >= EASING_LAST
+         || entry->duration == 0
+         || *entry->subject == entry->target_value)
+      return false;
+
    t.duration           = entry->duration;
-   t.running_since      = 0;
    t.initial_value      = *entry->subject;
    t.target_value       = entry->target_value;
    t.subject            = entry->subject;
    t.tag                = entry->tag;
    t.cb                 = entry->cb;
    t.userdata           = entry->userdata;
-   t.easing             = NULL;
-   t.deleted            = false;
+   t.easing_enum        = (uint8_t)entry->easing_enum;
 
-   switch (entry->easing_enum)
+   if (p_anim->in_update)
    {
-      case EASING_LINEAR:
-         t.easing       = &easing_linear;
-         break;
-         /* Quad */
-      case EASING_IN_QUAD:
-         t.easing       = &easing_in_quad;
-         break;
-      case EASING_OUT_QUAD:
-         t.easing       = &easing_out_quad;
-         break;
-      case EASING_IN_OUT_QUAD:
-         t.easing       = &easing_in_out_quad;
-         break;
-      case EASING_OUT_IN_QUAD:
-         t.easing       = &easing_out_in_quad;
-         break;
-         /* Cubic */
-      case EASING_IN_CUBIC:
-         t.easing       = &easing_in_cubic;
-         break;
-      case EASING_OUT_CUBIC:
-         t.easing       = &easing_out_cubic;
-         break;
-      case EASING_IN_OUT_CUBIC:
-         t.easing       = &easing_in_out_cubic;
-         break;
-      case EASING_OUT_IN_CUBIC:
-         t.easing       = &easing_out_in_cubic;
-         break;
-         /* Quart */
-      case EASING_IN_QUART:
-         t.easing       = &easing_in_quart;
-         break;
-      case EASING_OUT_QUART:
-         t.easing       = &easing_out_quart;
-         break;
-      case EASING_IN_OUT_QUART:
-         t.easing       = &easing_in_out_quart;
-         break;
-      case EASING_OUT_IN_QUART:
-         t.easing       = &easing_out_in_quart;
-         break;
-         /* Quint */
-      case EASING_IN_QUINT:
-         t.easing       = &easing_in_quint;
-         break;
-      case EASING_OUT_QUINT:
-         t.easing       = &easing_out_quint;
-         break;
-      case EASING_IN_OUT_QUINT:
-         t.easing       = &easing_in_out_quint;
-         break;
-      case EASING_OUT_IN_QUINT:
-         t.easing       = &easing_out_in_quint;
-         break;
-         /* Sine */
-      case EASING_IN_SINE:
-         t.easing       = &easing_in_sine;
-         break;
-      case EASING_OUT_SINE:
-         t.easing       = &easing_out_sine;
-         break;
-      case EASING_IN_OUT_SINE:
-         t.easing       = &easing_in_out_sine;
-         break;
-      case EASING_OUT_IN_SINE:
-         t.easing       = &easing_out_in_sine;
-         break;
-         /* Expo */
-      case EASING_IN_EXPO:
-         t.easing       = &easing_in_expo;
-         break;
-      case EASING_OUT_EXPO:
-         t.easing       = &easing_out_expo;
-         break;
-      case EASING_IN_OUT_EXPO:
-         t.easing       = &easing_in_out_expo;
-         break;
-      case EASING_OUT_IN_EXPO:
-         t.easing       = &easing_out_in_expo;
-         break;
-         /* Circ */
-      case EASING_IN_CIRC:
-         t.easing       = &easing_in_circ;
-         break;
-      case EASING_OUT_CIRC:
-         t.easing       = &easing_out_circ;
-         break;
-      case EASING_IN_OUT_CIRC:
-         t.easing       = &easing_in_out_circ;
-         break;
-      case EASING_OUT_IN_CIRC:
-         t.easing       = &easing_out_in_circ;
-         break;
-         /* Bounce */
-      case EASING_IN_BOUNCE:
-         t.easing       = &easing_in_bounce;
-         break;
-      case EASING_OUT_BOUNCE:
-         t.easing       = &easing_out_bounce;
-         break;
-      case EASING_IN_OUT_BOUNCE:
-         t.easing       = &easing_in_out_bounce;
-         break;
-      case EASING_OUT_IN_BOUNCE:
-         t.easing       = &easing_out_in_bounce;
-         break;
-      default:
-         break;
+      RBUF_PUSH(p_anim->pending, t);
+      return true;
    }
 
-   /* ignore born dead tweens */
-   if (!t.easing || t.duration == 0 || t.initial_value == t.target_value)
-      return false;
-
-   if (p_anim->in_update)
-      RBUF_PUSH(p_anim->pending, t);
-   else
-      RBUF_PUSH(p_anim->list, t);
+   /* Reclaim slots freed by gfx_animation_kill_by_tag()
+    * before growing the arrays */
+   if (     p_anim->pending_deletes
+         && p_anim->tweens.size == p_anim->tweens.capacity)
+   {
+      gfx_animation_tweens_compact(&p_anim->tweens);
+      p_anim->pending_deletes = false;
+   }
 
-   return true;
+   return gfx_animation_tweens_append(&p_anim->tweens, &t);
 }
 
+/* Evaluates one easing-type run [j, end) of the sorted slots */
+#define GFX_ANIMATION_EASE_RUN(easing) \
+   for (; j < end; j++) \
+   { \
+      unsigned slot  = tweens->order[j]; \
+      float initial  = tweens->initial_value[slot]; \
+      *tweens->subject[slot] = easing( \
+            tweens->running_since[slot], \
+            initial, \
+            tweens->target_value[slot] - initial, \
+            tweens->duration[slot]); \
+   }
+
 bool gfx_animation_update(
       gfx_animation_t *p_anim,
       retro_time_t current_time,
@@ -1148,7 +1289,9 @@ bool gfx_animation_update(
       unsigned video_width,
       unsigned video_height)
 {
-   unsigned i;
+   size_t i, j;
+   unsigned e;
+   struct gfx_animation_tweens *tweens         = &p_anim->tweens;
    const bool ticker_is_active                 = p_anim->ticker_is_active;
 
    static retro_time_t last_clock_update       = 0;
@@ -1253,62 +1396,128 @@ bool gfx_animation_update(
       }
    }
 
-   p_anim->in_update       = true;
-   p_anim->pending_deletes = false;
-
-   for (i = 0; i < RBUF_LEN(p_anim->list); i++)
+   if (tweens->size > 0)
    {
-      struct tween *tween   = &p_anim->list[i];
+      bool any_finished    = false;
+      float delta_time     = p_anim->delta_time;
 
-      if (tween->deleted)
-         continue;
+      p_anim->in_update    = true;
 
-      tween->running_since += p_anim->delta_time;
+      /* > Group live slots by easing type, so that each
+       *   easing function is applied over a contiguous run
+       *   instead of being dispatched per tween. Only has
+       *   to be redone when tweens are added or removed */
+      if (tweens->order_dirty)
+         gfx_animation_tweens_sort(tweens);
 
-      *tween->subject       = tween->easing(
-            tween->running_since,
-            tween->initial_value,
-            tween->target_value - tween->initial_value,
-            tween->duration);
+      /* > Advance all clocks in one pass */
+      for (i = 0; i < tweens->size; i++)
+      {
+         tweens->running_since[i] += delta_time;
+         any_finished |= (tweens->running_since[i] >= tweens->duration[i]);
+      }
 
-      if (tween->running_since >= tween->duration)
+      for (e = 0, j = 0; e < EASING_LAST; e++)
       {
-         *tween->subject = tween->target_value;
+         size_t end = j + tweens->order_counts[e];
 
-         if (tween->cb)
-            tween->cb(tween->userdata);
+         if (j == end)
+            continue;
 
-         RBUF_REMOVE(p_anim->list, i);
-         i--;
+         /* Direct calls, so each run gets its easing inlined */
+         switch (e)
+         {
+            case EASING_LINEAR:
+               GFX_ANIMATION_EASE_RUN(easing_linear);
+               break;
+            case EASING_IN_QUAD:
+               GFX_ANIMATION_EASE_RUN(easing_in_quad);
+               break;
+            case EASING_OUT_QUAD:
+               GFX_ANIMATION_EASE_RUN(easing_out_quad);
+               break;
+            case EASING_IN_OUT_QUAD:
+               GFX_ANIMATION_EASE_RUN(easing_in_out_quad);
+               break;
+            case EASING_OUT_IN_QUAD:
+               GFX_ANIMATION_EASE_RUN(easing_out_in_quad);
+               break;
+            case EASING_IN_CUBIC:
+               GFX_ANIMATION_EASE_RUN(easing_in_cubic);
+               break;
+            case EASING_OUT_CUBIC:
+               GFX_ANIMATION_EASE_RUN(easing_out_cubic);
+               break;
+            case EASING_IN_OUT_CUBIC:
+               GFX_ANIMATION_EASE_RUN(easing_in_out_cubic);
+               break;
+            case EASING_OUT_IN_CUBIC:
+               GFX_ANIMATION_EASE_RUN(easing_out_in_cubic);
+               break;
+            default:
+               {
+                  /* Rarely used curves go through the table */
+                  easing_cb easing = gfx_animation_easings[e];
+                  GFX_ANIMATION_EASE_RUN(easing);
+               }
+               break;
+         }
       }
-   }
 
-   if (p_anim->pending_deletes)
-   {
-      for (i = 0; i < RBUF_LEN(p_anim->list); i++)
+      /* > Retire finished tweens in push order. Callbacks
+       *   may push (-> pending) or kill (-> deleted flag),
+       *   but never reallocate the slot arrays */
+      if (any_finished)
       {
-         struct tween *tween = &p_anim->list[i];
-         if (tween->deleted)
+         for (i = 0; i < tweens->size; i++)
          {
-            RBUF_REMOVE(p_anim->list, i);
-            i--;
+            if (     tweens->deleted[i]
+                  || tweens->running_since[i] < tweens->duration[i])
+               continue;
+
+            *tweens->subject[i]     = tweens->target_value[i];
+            tweens->deleted[i]      = 1;
+            p_anim->pending_deletes = true;
+
+            if (tweens->cb[i])
+               tweens->cb[i](tweens->userdata[i]);
          }
       }
+
+      p_anim->in_update    = false;
+   }
+
+   if (p_anim->pending_deletes)
+   {
+      gfx_animation_tweens_compact(tweens);
       p_anim->pending_deletes = false;
    }
 
    if (RBUF_LEN(p_anim->pending) > 0)
    {
-      size_t list_len    = RBUF_LEN(p_anim->list);
       size_t pending_len = RBUF_LEN(p_anim->pending);
-      RBUF_RESIZE(p_anim->list, list_len + pending_len);
-      memcpy(p_anim->list + list_len, p_anim->pending,
-            sizeof(*p_anim->pending) * pending_len);
-      RBUF_CLEAR(p_anim->pending);
+
+      /* If the tween arrays cannot grow, stop merging: the
+       * remaining tweens (and their callbacks) stay pending
+       * and are retried on the next update */
+      for (i = 0; i < pending_len; i++)
+      {
+         if (!gfx_animation_tweens_append(tweens, &p_anim->pending[i]))
+            break;
+      }
+
+      if (i < pending_len)
+      {
+         memmove(p_anim->pending, p_anim->pending + i,
+               (pending_len - i) * sizeof(*p_anim->pending));
+         RBUF_RESIZE(p_anim->pending, pending_len - i);
+      }
+      else
+         RBUF_CLEAR(p_anim->pending);
    }
 
-   p_anim->in_update           = false;
-   p_anim->animation_is_active = RBUF_LEN(p_anim->list) > 0;
+   p_anim->animation_is_active =
+         (tweens->size > 0) || (RBUF_LEN(p_anim->pending) > 0);
 
    return p_anim->animation_is_active;
 }
@@ -2122,34 +2331,30 @@ end:
 bool gfx_animation_kill_by_tag(uintptr_t *tag)
 {
    unsigned i;
-   gfx_animation_t *p_anim = anim_get_ptr();
+   int slot;
+   gfx_animation_t *p_anim             = anim_get_ptr();
+   struct gfx_animation_tweens *tweens = &p_anim->tweens;
 
    if (!tag || *tag == (uintptr_t)-1)
       return false;
 
-   /* Scan animation list */
-   for (i = 0; i < RBUF_LEN(p_anim->list); ++i)
+   /* Walk the tag bucket only. Slots are never moved here:
+    * they are flagged and reclaimed by the next compaction,
+    * which also keeps this safe to call from inside the
+    * gfx_animation_update() loop */
+   if (tweens->size > 0)
    {
-      struct tween *t = &p_anim->list[i];
-
-      if (t->tag != *tag)
-         continue;
-
-      /* If we are currently inside gfx_animation_update(),
-       * we are already looping over p_anim->list entries
-       * > Cannot modify p_anim->list now, so schedule a
-       *   delete for when the gfx_animation_update() loop
-       *   is complete */
-      if (p_anim->in_update)
+      for (slot = tweens->tag_buckets[
+               gfx_animation_tag_hash(*tag, tweens->tag_bits)];
+            slot >= 0; slot = tweens->tag_next[slot])
       {
-         t->deleted              = true;
+         if (tweens->tag[slot] != *tag || tweens->deleted[slot])
+            continue;
+
+         tweens->deleted[slot]   = 1;
+         tweens->order_dirty     = true;
          p_anim->pending_deletes = true;
       }
-      else
-      {
-         RBUF_REMOVE(p_anim->list, i);
-         --i;
-      }
    }
 
    /* If we are currently inside gfx_animation_update(),
@@ -2178,7 +2383,7 @@ void gfx_animation_deinit(gfx_animation_t *p_anim)
 {
    if (!p_anim)
       return;
-   RBUF_FREE(p_anim->list);
+   gfx_animation_tweens_free(&p_anim->tweens);
    RBUF_FREE(p_anim->pending);
    if (p_anim->updatetime_cb)
       p_anim->updatetime_cb = NULL;
@@ -197,18 +197,46 @@ typedef struct gfx_delayed_animation
 
 typedef float (*easing_cb) (float, float, float, float);
 
+/* Tweens pushed while gfx_animation_update() is running
+ * are parked here until the update loop has finished */
 struct tween
 {
-   easing_cb   easing;
    tween_cb    cb;
    void        *userdata;
    uintptr_t   tag;
    float       duration;
-   float       running_since;
    float       initial_value;
    float       target_value;
    float       *subject;
-   bool        deleted;
+   uint8_t     easing_enum;
+};
+
+/* Active tweens are held as a structure of arrays:
+ * the per-frame update only streams through the 'hot'
+ * float arrays, while callbacks/userdata are touched
+ * on completion only. Slots are additionally chained
+ * by tag hash so that gfx_animation_kill_by_tag() does
+ * not have to scan every running tween */
+struct gfx_animation_tweens
+{
+   float       *running_since;
+   float       *initial_value;
+   float       *target_value;
+   float       *duration;
+   float       **subject;
+   uintptr_t   *tag;
+   tween_cb    *cb;
+   void        **userdata;
+   int         *tag_next;     /* Next slot in tag bucket, -1 terminated */
+   int         *tag_buckets;  /* Tag hash -> first slot, -1 if empty */
+   unsigned    *order;        /* Live slots grouped by easing type */
+   uint8_t     *easing_enum;
+   uint8_t     *deleted;
+   size_t      size;
+   size_t      capacity;
+   size_t      order_counts[EASING_LAST];
+   unsigned    tag_bits;      /* log2 of tag bucket count */
+   bool        order_dirty;   /* Slot set changed, rebuild 'order' */
 };
 
 struct gfx_animation
@@ -221,7 +249,7 @@ struct gfx_animation
    retro_time_t old_time;
    update_time_cb updatetime_cb;   /* ptr alignment */
                                    /* By default, this should be a NOOP */
-   struct tween* list;
+   struct gfx_animation_tweens tweens;
    struct tween* pending;
 
    float delta_time;
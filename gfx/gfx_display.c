@@ -130,6 +130,321 @@ static gfx_display_ctx_driver_t *gfx_display_ctx_drivers[] = {
    NULL,
 };
 
+/* Draw call batching
+ * > All display driver calls are routed through a
+ *   proxy driver (gfx_display_ctx_batch), which
+ *   counts the number of draw calls actually
+ *   submitted to the backend
+ * > On backends where each draw maps normalised
+ *   vertices onto its own viewport using the default
+ *   MVP (glcore, vulkan), consecutive untransformed
+ *   quads sharing the same texture and blend state
+ *   are converted to full viewport coordinates and
+ *   accumulated in a single coord array, which is
+ *   then rendered with one draw call
+ * > Any other operation (pipeline draws, scissoring,
+ *   immediate text rendering, end of menu/widget frame)
+ *   flushes the batch first, so draw order is always
+ *   preserved */
+static gfx_display_ctx_driver_t gfx_display_ctx_batch;
+
+static const float gfx_display_batch_colors[] = {
+   1.0f, 1.0f, 1.0f, 1.0f,
+   1.0f, 1.0f, 1.0f, 1.0f,
+   1.0f, 1.0f, 1.0f, 1.0f,
+   1.0f, 1.0f, 1.0f, 1.0f,
+};
+
+static bool gfx_display_batch_supported(
+      enum gfx_display_driver_type type)
+{
+   switch (type)
+   {
+      case GFX_VIDEO_DRIVER_OPENGL_CORE:
+      case GFX_VIDEO_DRIVER_VULKAN:
+         return true;
+      default:
+         break;
+   }
+
+   return false;
+}
+
+void gfx_display_batch_flush(void)
+{
+   gfx_display_ctx_draw_t draw;
+   struct video_coords coords;
+   gfx_display_t            *p_disp  = disp_get_ptr();
+   gfx_display_ctx_driver_t *backend = p_disp->dispctx_backend;
+   video_coord_array_t      *ca      = &p_disp->batch_ca;
+   void                     *data    = p_disp->batch_userdata;
+
+   if (ca->coords.vertices == 0)
+      return;
+
+   if (!backend || !backend->draw)
+   {
+      ca->coords.vertices = 0;
+      return;
+   }
+
+   coords.vertex             = ca->coords.vertex;
+   coords.color              = ca->coords.color;
+   coords.tex_coord          = ca->coords.tex_coord;
+   coords.lut_tex_coord      = ca->coords.lut_tex_coord;
+   coords.index              = NULL;
+   coords.vertices           = ca->coords.vertices;
+   coords.indexes            = 0;
+
+   draw.color                = NULL;
+   draw.vertex               = NULL;
+   draw.tex_coord            = NULL;
+   draw.backend_data         = NULL;
+   draw.coords               = &coords;
+   draw.matrix_data          = NULL;
+   draw.texture              = p_disp->batch_texture;
+   draw.vertex_count         = coords.vertices;
+   draw.backend_data_size    = 0;
+   draw.width                = p_disp->batch_video_width;
+   draw.height               = p_disp->batch_video_height;
+   draw.pipeline_id          = 0;
+   draw.x                    = 0.0f;
+   draw.y                    = 0.0f;
+   draw.rotation             = 0.0f;
+   draw.scale_factor         = 1.0f;
+   draw.prim_type            = GFX_DISPLAY_PRIM_TRIANGLES;
+   draw.pipeline_active      = false;
+
+   /* Reset batch *before* drawing, in case the
+    * backend calls back into gfx_display */
+   ca->coords.vertices       = 0;
+
+   if (p_disp->batch_blend && backend->blend_begin)
+      backend->blend_begin(data);
+   backend->draw(&draw, data,
+         p_disp->batch_video_width, p_disp->batch_video_height);
+   if (p_disp->batch_blend && backend->blend_end)
+      backend->blend_end(data);
+
+   p_disp->draw_calls++;
+}
+
+/* Attempts to add specified draw to the current batch.
+ * Returns false if draw cannot be batched */
+static bool gfx_display_batch_append(gfx_display_t *p_disp,
+      gfx_display_ctx_draw_t *draw, void *data,
+      unsigned video_width, unsigned video_height)
+{
+   unsigned i;
+   float vertex[8];
+   video_coords_t coords;
+   unsigned vertices_prev;
+   const float *src_vertex           = NULL;
+   const float *src_tex_coord        = NULL;
+   const float *src_color            = NULL;
+   gfx_display_ctx_driver_t *backend = p_disp->dispctx_backend;
+   video_coord_array_t      *ca      = &p_disp->batch_ca;
+
+   /* Only plain quads can be batched */
+   if (  (draw->pipeline_id != 0)
+       || draw->pipeline_active
+       || (draw->prim_type  != GFX_DISPLAY_PRIM_TRIANGLESTRIP)
+       || !draw->coords
+       || (draw->coords->vertices != 4)
+       || (video_width  == 0)
+       || (video_height == 0))
+      return false;
+
+   /* Only the default MVP can be folded into
+    * vertex positions */
+   if (draw->matrix_data &&
+         (!backend->get_default_mvp ||
+          (draw->matrix_data != backend->get_default_mvp(data))))
+      return false;
+
+   if (draw->coords->vertex)
+      src_vertex = draw->coords->vertex;
+   else if (backend->get_default_vertices)
+      src_vertex = backend->get_default_vertices();
+   else
+      return false;
+
+   if (draw->coords->tex_coord)
+      src_tex_coord = draw->coords->tex_coord;
+   else if (backend->get_default_tex_coords)
+      src_tex_coord = backend->get_default_tex_coords();
+   else
+      return false;
+
+   src_color = draw->coords->color
+      ? draw->coords->color : gfx_display_batch_colors;
+
+   /* Geometry outside the draw viewport is clipped
+    * by the backend, which cannot be reproduced
+    * when drawing to the full viewport */
+   for (i = 0; i < 8; i++)
+      if ((src_vertex[i] < 0.0f) || (src_vertex[i] > 1.0f))
+         return false;
+
+   /* Flush existing batch if state has changed */
+   if (ca->coords.vertices > 0 &&
+         (  (draw->texture         != p_disp->batch_texture)
+         || (p_disp->blend_active  != p_disp->batch_blend)
+         || (data                  != p_disp->batch_userdata)
+         || (video_width           != p_disp->batch_video_width)
+         || (video_height          != p_disp->batch_video_height)))
+      gfx_display_batch_flush();
+
+   p_disp->batch_texture      = draw->texture;
+   p_disp->batch_blend        = p_disp->blend_active;
+   p_disp->batch_userdata     = data;
+   p_disp->batch_video_width  = video_width;
+   p_disp->batch_video_height = video_height;
+
+   /* Convert quad to full viewport coordinates */
+   for (i = 0; i < 4; i++)
+   {
+      vertex[(i << 1)]     = (draw->x + src_vertex[(i << 1)]
+            * (float)draw->width)  / (float)video_width;
+      vertex[(i << 1) + 1] = (draw->y + src_vertex[(i << 1) + 1]
+            * (float)draw->height) / (float)video_height;
+   }
+
+   coords.vertex        = vertex;
+   coords.color         = src_color;
+   coords.tex_coord     = src_tex_coord;
+   coords.lut_tex_coord = src_tex_coord;
+   coords.index         = NULL;
+   coords.vertices      = 3;
+   coords.indexes       = 0;
+
+   /* Triangle strip -> two triangles */
+   vertices_prev        = ca->coords.vertices;
+
+   if (!video_coord_array_append(ca, &coords, 3))
+      goto error;
+
+   coords.vertex        += 2;
+   coords.color         += 4;
+   coords.tex_coord     += 2;
+   coords.lut_tex_coord += 2;
+
+   if (!video_coord_array_append(ca, &coords, 3))
+      goto error;
+
+   return true;
+
+error:
+   ca->coords.vertices = vertices_prev;
+   return false;
+}
+
+static void gfx_display_batch_draw(gfx_display_ctx_draw_t *draw,
+      void *data, unsigned video_width, unsigned video_height)
+{
+   gfx_display_t            *p_disp  = disp_get_ptr();
+   gfx_display_ctx_driver_t *backend = p_disp->dispctx_backend;
+   bool apply_blend                  = false;
+
+   if (!draw || !backend || !backend->draw)
+      return;
+
+   if (p_disp->batch_enable)
+   {
+      if (gfx_display_batch_append(p_disp, draw, data,
+               video_width, video_height))
+         return;
+
+      gfx_display_batch_flush();
+
+      /* When batching, blend state is applied
+       * at submission time */
+      apply_blend = p_disp->blend_active;
+   }
+
+   if (apply_blend && backend->blend_begin)
+      backend->blend_begin(data);
+   backend->draw(draw, data, video_width, video_height);
+   if (apply_blend && backend->blend_end)
+      backend->blend_end(data);
+
+   p_disp->draw_calls++;
+}
+
+static void gfx_display_batch_draw_pipeline(gfx_display_ctx_draw_t *draw,
+      void *data, unsigned video_width, unsigned video_height)
+{
+   gfx_display_t            *p_disp  = disp_get_ptr();
+   gfx_display_ctx_driver_t *backend = p_disp->dispctx_backend;
+
+   gfx_display_batch_flush();
+
+   if (backend && backend->draw_pipeline)
+      backend->draw_pipeline(draw, data, video_width, video_height);
+}
+
+static void gfx_display_batch_blend_begin(void *data)
+{
+   gfx_display_t            *p_disp  = disp_get_ptr();
+   gfx_display_ctx_driver_t *backend = p_disp->dispctx_backend;
+
+   p_disp->blend_active = true;
+
+   if (!p_disp->batch_enable && backend && backend->blend_begin)
+      backend->blend_begin(data);
+}
+
+static void gfx_display_batch_blend_end(void *data)
+{
+   gfx_display_t            *p_disp  = disp_get_ptr();
+   gfx_display_ctx_driver_t *backend = p_disp->dispctx_backend;
+
+   p_disp->blend_active = false;
+
+   if (!p_disp->batch_enable && backend && backend->blend_end)
+      backend->blend_end(data);
+}
+
+static void gfx_display_batch_scissor_begin(void *data,
+      unsigned video_width, unsigned video_height,
+      int x, int y, unsigned width, unsigned height)
+{
+   gfx_display_t            *p_disp  = disp_get_ptr();
+   gfx_display_ctx_driver_t *backend = p_disp->dispctx_backend;
+
+   gfx_display_batch_flush();
+
+   if (backend && backend->scissor_begin)
+      backend->scissor_begin(data, video_width, video_height,
+            x, y, width, height);
+}
+
+static void gfx_display_batch_scissor_end(void *data,
+      unsigned video_width, unsigned video_height)
+{
+   gfx_display_t            *p_disp  = disp_get_ptr();
+   gfx_display_ctx_driver_t *backend = p_disp->dispctx_backend;
+
+   gfx_display_batch_flush();
+
+   if (backend && backend->scissor_end)
+      backend->scissor_end(data, video_width, video_height);
+}
+
+void gfx_display_frame_end(void)
+{
+   gfx_display_t *p_disp         = disp_get_ptr();
+
+   p_disp->draw_calls_last_frame = p_disp->draw_calls;
+   p_disp->draw_calls            = 0;
+}
+
+unsigned gfx_display_get_draw_calls(void)
+{
+   gfx_display_t *p_disp = disp_get_ptr();
+   return p_disp->draw_calls_last_frame;
+}
+
 static float gfx_display_get_adjusted_scale_internal(
       gfx_display_t *p_disp,
       float base_scale, float scale_factor, unsigned width)
@@ -1532,6 +1847,7 @@ void gfx_display_free(void)
 {
    gfx_display_t           *p_disp   = disp_get_ptr();
    video_coord_array_free(&p_disp->dispca);
+   video_coord_array_free(&p_disp->batch_ca);
 
    p_disp->msg_force           = false;
    p_disp->header_height       = 0;
@@ -1540,6 +1856,9 @@ void gfx_display_free(void)
    p_disp->framebuf_pitch      = 0;
    p_disp->has_windowed        = false;
    p_disp->dispctx             = NULL;
+   p_disp->dispctx_backend     = NULL;
+   p_disp->batch_enable        = false;
+   p_disp->blend_active        = false;
 }
 
 void gfx_display_init(void)
@@ -1577,7 +1896,22 @@ bool gfx_display_init_first_driver(bool video_is_threaded)
 
       RARCH_LOG("[Display]: Found display driver: \"%s\".\n",
             gfx_display_ctx_drivers[i]->ident);
-      p_disp->dispctx = gfx_display_ctx_drivers[i];
+
+      /* Wrap driver in batching proxy */
+      gfx_display_ctx_batch               = *gfx_display_ctx_drivers[i];
+      gfx_display_ctx_batch.draw          = gfx_display_batch_draw;
+      gfx_display_ctx_batch.draw_pipeline = gfx_display_batch_draw_pipeline;
+      gfx_display_ctx_batch.blend_begin   = gfx_display_batch_blend_begin;
+      gfx_display_ctx_batch.blend_end     = gfx_display_batch_blend_end;
+      gfx_display_ctx_batch.scissor_begin = gfx_display_batch_scissor_begin;
+      gfx_display_ctx_batch.scissor_end   = gfx_display_batch_scissor_end;
+
+      p_disp->batch_ca.coords.vertices    = 0;
+      p_disp->blend_active                = false;
+      p_disp->batch_enable                = gfx_display_batch_supported(
+            gfx_display_ctx_drivers[i]->type);
+      p_disp->dispctx_backend             = gfx_display_ctx_drivers[i];
+      p_disp->dispctx                     = &gfx_display_ctx_batch;
       return true;
    }
    return false;
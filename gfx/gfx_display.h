@@ -198,7 +198,14 @@ typedef struct gfx_display_ctx_powerstate
 struct gfx_display
 {
    gfx_display_ctx_driver_t *dispctx;
+   /* Actual display driver, wrapped by dispctx
+    * (see gfx_display_batch_flush()) */
+   gfx_display_ctx_driver_t *dispctx_backend;
    video_coord_array_t dispca; /* ptr alignment */
+   video_coord_array_t batch_ca; /* ptr alignment */
+
+   void *batch_userdata;
+   uintptr_t batch_texture;
 
    /* Width, height and pitch of the display framebuffer */
    size_t   framebuf_pitch;
@@ -208,11 +215,22 @@ struct gfx_display
    /* Height of the display header */
    unsigned header_height;
 
+   unsigned batch_video_width;
+   unsigned batch_video_height;
+
+   /* Number of backend draw calls issued
+    * during the current/previous frame */
+   unsigned draw_calls;
+   unsigned draw_calls_last_frame;
+
    enum menu_driver_id_type menu_driver_id;
 
    bool has_windowed;
    bool msg_force;
    bool framebuf_dirty;
+   bool batch_enable;
+   bool batch_blend;
+   bool blend_active;
 };
 
 typedef struct gfx_display gfx_display_t;
@@ -221,6 +239,16 @@ void gfx_display_free(void);
 
 void gfx_display_init(void);
 
+/* Submits all pending batched draws to the
+ * display driver */
+void gfx_display_batch_flush(void);
+
+/* Updates draw call statistics at the end
+ * of each video frame */
+void gfx_display_frame_end(void);
+
+unsigned gfx_display_get_draw_calls(void);
+
 void gfx_display_push_quad(
       unsigned width, unsigned height,
       const float *colors, int x1, int y1,
@@ -1672,6 +1672,9 @@ void gfx_widgets_frame(void *data)
    gfx_widgets_flush_text(video_width, video_height,
          &p_dispwidget->gfx_widget_fonts.msg_queue);
 
+   /* Submit any remaining batched draws */
+   gfx_display_batch_flush();
+
    /* Unbind fonts */
    gfx_widgets_font_unbind(&p_dispwidget->gfx_widget_fonts.regular);
    gfx_widgets_font_unbind(&p_dispwidget->gfx_widget_fonts.bold);
@@ -22,6 +22,7 @@
 #include <compat/strl.h>
 #include <features/features_cpu.h>
 #include <string/stdstring.h>
+#include <time/rtrace.h>
 
 #include "video_thread_wrapper.h"
 #include "font_driver.h"
@@ -424,11 +425,16 @@ static void video_thread_loop(void *data)
              * rid of this */
             video_driver_build_info(&video_info);
 
+            if (rtrace_active)
+               rtrace_thread_name("video");
+
+            RTRACE_BEGIN("video_thread_frame");
             ret = thr->driver->frame(thr->driver_data,
                   thr->frame.buffer, thr->frame.width, thr->frame.height,
                   thr->frame.count,
                   thr->frame.pitch, *thr->frame.msg ? thr->frame.msg : NULL,
                   &video_info);
+            RTRACE_END("video_thread_frame");
          }
 
          slock_unlock(thr->frame.lock);
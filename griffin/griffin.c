@@ -145,6 +145,7 @@ COMPRESSION
 #ifdef HAVE_ZLIB
 #include "../libretro-common/streams/trans_stream_zlib.c"
 #include "../libretro-common/streams/rzip_stream.c"
+#include "../libretro-common/streams/zip_stream.c"
 #endif
 
 /*============================================================
@@ -1697,6 +1698,8 @@ MISC FILE FORMATS
 TIME
 ============================================================ */
 #include "../libretro-common/time/rtime.c"
+#include "../libretro-common/time/rsleep.c"
+#include "../libretro-common/time/rtrace.c"
 
 /*============================================================
 ANDROID PLAY FEATURE DELIVERY
@@ -1166,6 +1166,10 @@ MSG_HASH(
    MENU_ENUM_LABEL_FASTFORWARD_RATIO,
    "fastforward_ratio"
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_FRAME_LIMIT_SPIN_USEC,
+   "frame_limit_spin_usec"
+   )
 MSG_HASH(
    MENU_ENUM_LABEL_FILE_BROWSER_CORE,
    "file_browser_core"
@@ -2114,6 +2118,10 @@ MSG_HASH(
    MENU_ENUM_LABEL_PERFCNT_ENABLE,
    "perfcnt_enable"
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_FRAME_TRACE_ENABLE,
+   "frame_trace_enable"
+   )
 MSG_HASH(
    MENU_ENUM_LABEL_PLAYLISTS_TAB,
    "playlists_tab"
@@ -2728,6 +2736,14 @@ MSG_HASH(
    MENU_ENUM_LABEL_RUN_AHEAD_SECONDARY_INSTANCE,
    "run_ahead_secondary_instance"
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_RUN_AHEAD_SECONDARY_THREADED,
+   "run_ahead_secondary_threaded"
+   )
+MSG_HASH(
+   MENU_ENUM_LABEL_PREEMPT_ENABLE,
+   "preemptive_frames_enable"
+   )
 MSG_HASH(
    MENU_ENUM_LABEL_RUN_AHEAD_HIDE_WARNINGS,
    "run_ahead_hide_warnings"
@@ -3108,6 +3124,10 @@ MSG_HASH(
    MENU_ENUM_LABEL_VIDEO_FRAME_DELAY,
    "video_frame_delay"
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_VIDEO_FRAME_DELAY_AUTO,
+   "video_frame_delay_auto"
+   )
 MSG_HASH(
    MENU_ENUM_LABEL_VIDEO_SHADER_DELAY,
    "video_shader_delay"
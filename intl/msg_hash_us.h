@@ -1694,6 +1694,14 @@ MSG_HASH(
    MENU_ENUM_SUBLABEL_VIDEO_FRAME_DELAY,
    "Reduces latency at the cost of a higher risk of video stuttering. Adds a delay after V-Sync (in ms)."
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_VIDEO_FRAME_DELAY_AUTO,
+   "Automatic Frame Delay"
+   )
+MSG_HASH(
+   MENU_ENUM_SUBLABEL_VIDEO_FRAME_DELAY_AUTO,
+   "Adjust the frame delay continuously from measured frame times, backing off when frames are missed. 'Frame Delay' becomes the upper limit (0 = no limit)."
+   )
 MSG_HASH(
    MENU_ENUM_LABEL_VALUE_VIDEO_HARD_SYNC,
    "Hard GPU Sync"
@@ -2591,6 +2599,14 @@ MSG_HASH(
    MENU_ENUM_SUBLABEL_INPUT_META_AI_SERVICE,
    "Captures an image of the current content then translates and/or reads aloud any on-screen text. Note: 'AI Service' Must be enabled and configured."
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_INPUT_META_FRAME_TRACE_SAVE,
+   "Save Frame Trace"
+   )
+MSG_HASH(
+   MENU_ENUM_SUBLABEL_INPUT_META_FRAME_TRACE_SAVE,
+   "Saves the frames recorded so far to a Chrome trace JSON file in the log directory. 'Frame Tracing' must be enabled."
+   )
 
 /* Settings > Input > Port # Binds */
 
@@ -2793,6 +2809,22 @@ MSG_HASH(
    MENU_ENUM_SUBLABEL_RUN_AHEAD_SECONDARY_INSTANCE,
    "Use a second instance of the RetroArch core to run-ahead. Prevents audio problems due to loading state."
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_RUN_AHEAD_SECONDARY_THREADED,
+   "Run Second Instance on a Separate Thread"
+   )
+MSG_HASH(
+   MENU_ENUM_SUBLABEL_RUN_AHEAD_SECONDARY_THREADED,
+   "Run the second instance in parallel with the main one. Frames only wait for it when input changes. Reduces frame time on multi-core systems. Software rendered cores only."
+   )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_PREEMPT_ENABLE,
+   "Preemptive Frames"
+   )
+MSG_HASH(
+   MENU_ENUM_SUBLABEL_PREEMPT_ENABLE,
+   "Use Preemptive Frames instead of Run-Ahead. Keeps a save state for each of the last frames and only rolls back and replays them when input changes. Much cheaper than Run-Ahead while input is held steady."
+   )
 MSG_HASH(
    MENU_ENUM_LABEL_VALUE_RUN_AHEAD_HIDE_WARNINGS,
    "Hide Run-Ahead Warnings"
@@ -3111,6 +3143,14 @@ MSG_HASH(
    MENU_ENUM_SUBLABEL_PERFCNT_ENABLE,
    "Performance counters for RetroArch and cores. Counter data can help determine system bottlenecks and fine-tune performance."
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_FRAME_TRACE_ENABLE,
+   "Frame Tracing"
+   )
+MSG_HASH(
+   MENU_ENUM_SUBLABEL_FRAME_TRACE_ENABLE,
+   "Records a timeline of the most recent frames (core, video, audio, input, tasks and core performance counters) on every thread. The trace is saved to the log directory as a Chrome trace JSON file with the 'Save Frame Trace' hotkey and on exit, and can be opened in chrome://tracing or Perfetto."
+   )
 
 /* Settings > File Browser */
 
@@ -3165,6 +3205,14 @@ MSG_HASH(
    MENU_ENUM_SUBLABEL_FASTFORWARD_RATIO,
    "The maximum rate at which content will be run when using fast-forward (e.g., 5.0x for 60 fps content = 300 fps cap). If set to 0.0x, fast-forward ratio is unlimited (no FPS cap)."
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_FRAME_LIMIT_SPIN_USEC,
+   "Frame Limiter Spin Time"
+   )
+MSG_HASH(
+   MENU_ENUM_SUBLABEL_FRAME_LIMIT_SPIN_USEC,
+   "Microseconds the frame limiter and frame delay busy-wait before their deadline instead of sleeping. Higher values pace frames more precisely at the cost of CPU time. 0 only sleeps."
+   )
 MSG_HASH(
    MENU_ENUM_LABEL_VALUE_SLOWMOTION_RATIO,
    "Slow-Motion Rate"
@@ -11375,6 +11423,18 @@ MSG_HASH(
    MSG_RUNAHEAD_DISABLED,
    "Run-Ahead disabled."
    )
+MSG_HASH(
+   MSG_FRAME_TRACE_SAVED,
+   "Frame trace saved to"
+   )
+MSG_HASH(
+   MSG_FRAME_TRACE_SAVE_FAILED,
+   "Failed to save frame trace to"
+   )
+MSG_HASH(
+   MSG_FRAME_TRACE_DISABLED,
+   "Frame Tracing is disabled."
+   )
 MSG_HASH(
    MSG_RUNAHEAD_CORE_DOES_NOT_SUPPORT_SAVESTATES,
    "Run-Ahead has been disabled because this core does not support save states."
@@ -694,6 +694,8 @@ uint32_t file_archive_get_file_crc32(const char *path)
    struct archive_extract_userdata userdata        = {0};
    bool returnerr                                  = false;
    const char *archive_path                        = NULL;
+   const struct file_archive_file_backend *backend =
+      file_archive_get_file_backend(path);
    bool contains_compressed = path_contains_compressed_file(path);
 
    if (contains_compressed)
@@ -705,6 +707,20 @@ uint32_t file_archive_get_file_crc32(const char *path)
          archive_path += 1;
    }
 
+   /* Backends that index the archive look the file up
+    * directly instead of walking the archive up to it */
+   if (backend && backend->compressed_file_crc32)
+   {
+      char archive_file[PATH_MAX_LENGTH];
+
+      strlcpy(archive_file, path, sizeof(archive_file));
+      if (archive_path && (size_t)(archive_path - 1 - path)
+            < sizeof(archive_file))
+         archive_file[archive_path - 1 - path] = '\0';
+
+      return backend->compressed_file_crc32(archive_file, archive_path);
+   }
+
    state.type              = ARCHIVE_TRANSFER_INIT;
    state.archive_file      = NULL;
 #ifdef HAVE_MMAP
@@ -28,7 +28,11 @@
 #include <streams/trans_stream.h>
 #include <retro_inline.h>
 #include <retro_miscellaneous.h>
+#include <string/stdstring.h>
 #include <encodings/crc32.h>
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
 
 /* Only for MAX_WBITS */
 #include <zlib.h>
@@ -220,159 +224,16 @@ static uint32_t zlib_stream_crc32_calculate(uint32_t crc,
    return encoding_crc32(crc, data, length);
 }
 
-static bool zip_file_decompressed_handle(
-      file_archive_transfer_t *transfer,
-      file_archive_file_handle_t* handle,
-      const uint8_t *cdata, unsigned cmode, uint32_t csize,
-      uint32_t size, uint32_t crc32)
-{
-   int ret   = 0;
-
-   transfer->backend = &zlib_backend;
-
-   if (!transfer->backend->stream_decompress_data_to_file_init(
-            transfer->context, handle, cdata, cmode, csize, size))
-      return false;
-
-   do
-   {
-      ret = transfer->backend->stream_decompress_data_to_file_iterate(
-            transfer->context, handle);
-   }while (ret == 0);
-
-#if 0
-   handle->real_checksum = transfer->backend->stream_crc_calculate(0,
-         handle->data, size);
-
-   if (handle->real_checksum != crc32)
-   {
-      if (handle->data)
-         free(handle->data);
-
-      handle->data   = NULL;
-      return false;
-   }
-#endif
-
-   return true;
-}
-
-typedef struct
-{
-   char *opt_file;
-   char *needle;
-   void **buf;
-   size_t size;
-   bool found;
-} decomp_state_t;
-
-/* Extract the relative path (needle) from a
- * ZIP archive (path) and allocate a buffer for it to write it in.
- *
- * optional_outfile if not NULL will be used to extract the file to.
- * buf will be 0 then.
- */
-
-static int zip_file_decompressed(
-      const char *name, const char *valid_exts,
-      const uint8_t *cdata, unsigned cmode,
-      uint32_t csize, uint32_t size,
-      uint32_t crc32, struct archive_extract_userdata *userdata)
-{
-   decomp_state_t* decomp_state = (decomp_state_t*)userdata->cb_data;
-   char last_char = name[strlen(name) - 1];
-   /* Ignore directories. */
-   if (last_char == '/' || last_char == '\\')
-      return 1;
-
-   if (strstr(name, decomp_state->needle))
-   {
-      file_archive_file_handle_t handle = {0};
-
-      if (zip_file_decompressed_handle(userdata->transfer,
-               &handle, cdata, cmode, csize, size, crc32))
-      {
-         if (decomp_state->opt_file != 0)
-         {
-            /* Called in case core has need_fullpath enabled. */
-            bool success = filestream_write_file(decomp_state->opt_file, handle.data, size);
-
-            free(handle.data);
-            handle.data = NULL;
-
-            decomp_state->size = 0;
-
-            if (!success)
-               return -1;
-         }
-         else
-         {
-            /* Called in case core has need_fullpath disabled.
-             * Will move decompressed content directly into
-             * RetroArch's ROM buffer. */
-            *decomp_state->buf = handle.data;
-            handle.data = NULL;
-
-            decomp_state->size = size;
-         }
-      }
-
-      decomp_state->found = true;
-   }
-
-   return 1;
-}
-
-static int64_t zip_file_read(
-      const char *path,
-      const char *needle, void **buf,
-      const char *optional_outfile)
-{
-   file_archive_transfer_t state            = {ARCHIVE_TRANSFER_INIT};
-   decomp_state_t decomp                    = {0};
-   struct archive_extract_userdata userdata = {0};
-   bool returnerr                           = true;
-   int ret                                  = 0;
-
-   if (needle)
-      decomp.needle          = strdup(needle);
-   if (optional_outfile)
-      decomp.opt_file        = strdup(optional_outfile);
-
-   userdata.transfer = &state;
-   userdata.cb_data = &decomp;
-   decomp.buf                = buf;
-
-   do
-   {
-      ret = file_archive_parse_file_iterate(&state, &returnerr, path,
-            "", zip_file_decompressed, &userdata);
-      if (!returnerr)
-         break;
-   }while (ret == 0 && !decomp.found);
-
-   file_archive_parse_file_iterate_stop(&state);
-
-   if (decomp.opt_file)
-      free(decomp.opt_file);
-   if (decomp.needle)
-      free(decomp.needle);
-
-   if (!decomp.found)
-      return -1;
-
-   return (int64_t)decomp.size;
-}
-
-static int zip_parse_file_init(file_archive_transfer_t *state,
-      const char *file)
+/* Finds the end of central directory record of the archive
+ * and copies it to 'record' (22 bytes). Returns its offset,
+ * or -1 if the file is not a ZIP archive */
+static int64_t zip_find_end_of_central_dir(RFILE *file,
+      int64_t archive_size, uint8_t *record)
 {
    uint8_t footer_buf[1024];
    uint8_t *footer = footer_buf;
-   int64_t read_pos = state->archive_size;
+   int64_t read_pos = archive_size;
    int64_t read_block = MIN(read_pos, sizeof(footer_buf));
-   int64_t directory_size, directory_offset;
-   zip_context_t *zip_context = NULL;
 
    /* Minimal ZIP file size is 22 bytes */
    if (read_block < 22)
@@ -389,14 +250,14 @@ static int zip_parse_file_init(file_archive_transfer_t *state,
             return -1; /* reached beginning of file */
 
          /* Read 21 bytes of overlaps except on the first block. */
-         if (read_pos == state->archive_size)
+         if (read_pos == archive_size)
             read_pos = read_pos - read_block;
          else
             read_pos = MAX(read_pos - read_block + 21, 0);
 
          /* Seek to read_pos and read read_block bytes. */
-         filestream_seek(state->archive_file, read_pos, RETRO_VFS_SEEK_POSITION_START);
-         if (filestream_read(state->archive_file, footer_buf, read_block) != read_block)
+         filestream_seek(file, read_pos, RETRO_VFS_SEEK_POSITION_START);
+         if (filestream_read(file, footer_buf, read_block) != read_block)
             return -1;
 
          footer = footer_buf + read_block - 22;
@@ -404,11 +265,26 @@ static int zip_parse_file_init(file_archive_transfer_t *state,
       if (read_le(footer, 4) == END_OF_CENTRAL_DIR_SIGNATURE)
       {
          unsigned comment_len = read_le(footer + 20, 2);
-         if (read_pos + (footer - footer_buf) + 22 + comment_len == state->archive_size)
+         if (read_pos + (footer - footer_buf) + 22 + comment_len == archive_size)
             break; /* found it! */
       }
    }
 
+   memcpy(record, footer, 22);
+   return read_pos + (footer - footer_buf);
+}
+
+static int zip_parse_file_init(file_archive_transfer_t *state,
+      const char *file)
+{
+   uint8_t footer[22];
+   int64_t directory_size, directory_offset;
+   zip_context_t *zip_context = NULL;
+
+   if (zip_find_end_of_central_dir(state->archive_file,
+            state->archive_size, footer) < 0)
+      return -1;
+
    /* Read directory info and do basic sanity checks. */
    directory_size   = read_le(footer + 12, 4);
    directory_offset = read_le(footer + 16, 4);
@@ -517,6 +393,764 @@ static void zip_parse_file_free(void *context)
    free(zip_context);
 }
 
+/* Central directory index */
+
+#ifndef LOCAL_FILE_HEADER_SIGNATURE
+#define LOCAL_FILE_HEADER_SIGNATURE 0x04034b50
+#endif
+
+/* Number of archive indexes kept by the index cache */
+#define ZIP_INDEX_CACHE_SIZE 4
+
+/* Size of the buffer compressed data is read into */
+#define ZIP_READER_BUFFER_SIZE 65536
+
+struct file_archive_zip_index
+{
+   char *path;
+   char *names;
+   file_archive_zip_member_t *members;
+   uint32_t *hash_table;  /* member index + 1, 0 if unused */
+   int64_t archive_size;
+   int64_t record_offset;
+   size_t count;
+   size_t hash_size;      /* power of two */
+   unsigned refs;
+   uint8_t record[22];    /* end of central directory record */
+};
+
+struct file_archive_zip_reader
+{
+   RFILE *file;
+   void *stream;          /* NULL for stored members */
+   uint8_t *in_buf;
+   int64_t data_offset;
+   uint32_t in_avail;     /* bytes of in_buf not inflated yet */
+   uint32_t in_read;      /* compressed bytes read so far */
+   uint32_t csize;
+   uint32_t size;
+   uint32_t pos;
+   uint32_t crc32;
+   uint32_t crc;
+   unsigned cmode;
+   bool crc_valid;        /* false once bytes were skipped */
+};
+
+/* Most recently used first */
+static file_archive_zip_index_t *zip_index_cache[ZIP_INDEX_CACHE_SIZE];
+static bool zip_index_cache_active   = false;
+#ifdef HAVE_THREADS
+static slock_t *zip_index_cache_lock = NULL;
+#endif
+
+static uint32_t zip_index_hash(const char *name)
+{
+   uint32_t hash = 5381;
+
+   while (*name)
+      hash = (hash << 5) + hash + (uint8_t)*name++;
+
+   return hash;
+}
+
+static void zip_index_free(file_archive_zip_index_t *index)
+{
+   free(index->path);
+   free(index->names);
+   free(index->members);
+   free(index->hash_table);
+   free(index);
+}
+
+static file_archive_zip_index_t *zip_index_new(const char *path)
+{
+   size_t i;
+   size_t names_size                = 0;
+   size_t names_pos                 = 0;
+   uint8_t *directory               = NULL;
+   uint8_t *entry                   = NULL;
+   uint8_t *directory_end           = NULL;
+   int64_t directory_size, directory_offset;
+   file_archive_zip_index_t *index  = NULL;
+   RFILE *file                      = filestream_open(path,
+         RETRO_VFS_FILE_ACCESS_READ, RETRO_VFS_FILE_ACCESS_HINT_NONE);
+
+   if (!file)
+      return NULL;
+
+   if (!(index = (file_archive_zip_index_t*)calloc(1, sizeof(*index))))
+      goto error;
+
+   index->archive_size  = filestream_get_size(file);
+   index->record_offset = zip_find_end_of_central_dir(file,
+         index->archive_size, index->record);
+
+   if (index->record_offset < 0)
+      goto error;
+
+   directory_size   = read_le(index->record + 12, 4);
+   directory_offset = read_le(index->record + 16, 4);
+   if (directory_offset + directory_size > index->record_offset)
+      goto error;
+
+   if (!(directory = (uint8_t*)malloc((size_t)directory_size + 1)))
+      goto error;
+
+   filestream_seek(file, directory_offset, RETRO_VFS_SEEK_POSITION_START);
+   if (filestream_read(file, directory, directory_size) != directory_size)
+      goto error;
+
+   /* Count the members and the size of their names first */
+   directory_end = directory + (size_t)directory_size;
+   for (entry = directory; entry + 46 <= directory_end; index->count++)
+   {
+      uint32_t namelength;
+
+      if (read_le(entry, 4) != CENTRAL_FILE_HEADER_SIGNATURE)
+         break;
+
+      namelength  = read_le(entry + 28, 2);
+      names_size += namelength + 1;
+      entry      += 46 + namelength
+         + read_le(entry + 30, 2) + read_le(entry + 32, 2);
+   }
+
+   /* The last entry must end within the directory */
+   if (entry > directory_end)
+      goto error;
+
+   for (index->hash_size = 16;
+         index->hash_size < index->count * 2; index->hash_size *= 2) { }
+
+   index->members    = (file_archive_zip_member_t*)malloc(
+         (index->count + 1) * sizeof(*index->members));
+   index->names      = (char*)malloc(names_size + 1);
+   index->hash_table = (uint32_t*)calloc(index->hash_size, sizeof(uint32_t));
+   index->path       = strdup(path);
+
+   if (!index->members || !index->names || !index->hash_table || !index->path)
+      goto error;
+
+   entry = directory;
+   for (i = 0; i < index->count; i++)
+   {
+      file_archive_zip_member_t *member = &index->members[i];
+      uint32_t namelength               = read_le(entry + 28, 2);
+      size_t mask                       = index->hash_size - 1;
+      size_t slot;
+
+      memcpy(index->names + names_pos, entry + 46, namelength);
+      index->names[names_pos + namelength] = '\0';
+
+      member->name   = index->names + names_pos;
+      member->cmode  = read_le(entry + 10, 2);
+      member->crc32  = read_le(entry + 16, 4);
+      member->csize  = read_le(entry + 20, 4);
+      member->size   = read_le(entry + 24, 4);
+      member->offset = read_le(entry + 42, 4);
+
+      /* Keep the first of several members with the same
+       * name, which is the one walking the archive finds */
+      for (slot = zip_index_hash(member->name) & mask;
+            index->hash_table[slot]; slot = (slot + 1) & mask)
+         if (string_is_equal(
+                  index->members[index->hash_table[slot] - 1].name,
+                  member->name))
+            break;
+
+      if (!index->hash_table[slot])
+         index->hash_table[slot] = (uint32_t)(i + 1);
+
+      names_pos += namelength + 1;
+      entry     += 46 + namelength
+         + read_le(entry + 30, 2) + read_le(entry + 32, 2);
+   }
+
+   free(directory);
+   filestream_close(file);
+   return index;
+
+error:
+   free(directory);
+   if (index)
+      zip_index_free(index);
+   filestream_close(file);
+   return NULL;
+}
+
+/* An archive that was rewritten since its index
+ * was read has a different end of central directory
+ * record (or size), so the index no longer applies */
+static bool zip_index_is_current(file_archive_zip_index_t *index)
+{
+   uint8_t record[22];
+   bool current = false;
+   RFILE *file  = filestream_open(index->path,
+         RETRO_VFS_FILE_ACCESS_READ, RETRO_VFS_FILE_ACCESS_HINT_NONE);
+
+   if (!file)
+      return false;
+
+   if (     filestream_get_size(file) == index->archive_size
+         && filestream_seek(file, index->record_offset,
+            RETRO_VFS_SEEK_POSITION_START) == 0
+         && filestream_read(file, record, sizeof(record)) == sizeof(record))
+      current = !memcmp(record, index->record, sizeof(record));
+
+   filestream_close(file);
+   return current;
+}
+
+static void zip_index_cache_lock_acquire(void)
+{
+#ifdef HAVE_THREADS
+   if (zip_index_cache_lock)
+      slock_lock(zip_index_cache_lock);
+#endif
+}
+
+static void zip_index_cache_lock_release(void)
+{
+#ifdef HAVE_THREADS
+   if (zip_index_cache_lock)
+      slock_unlock(zip_index_cache_lock);
+#endif
+}
+
+/* Takes the cached index of the archive out of the
+ * cache, or returns NULL. Must be called with the
+ * lock held */
+static file_archive_zip_index_t *zip_index_cache_take(const char *path)
+{
+   unsigned i;
+
+   for (i = 0; i < ZIP_INDEX_CACHE_SIZE && zip_index_cache[i]; i++)
+   {
+      file_archive_zip_index_t *index = zip_index_cache[i];
+
+      if (!string_is_equal(index->path, path))
+         continue;
+
+      for (; i + 1 < ZIP_INDEX_CACHE_SIZE; i++)
+         zip_index_cache[i] = zip_index_cache[i + 1];
+      zip_index_cache[ZIP_INDEX_CACHE_SIZE - 1] = NULL;
+
+      return index;
+   }
+
+   return NULL;
+}
+
+/* Puts the index first in the cache, dropping the least
+ * recently used index if the cache is full. The cache
+ * holds one reference. Must be called with the lock held */
+static void zip_index_cache_put(file_archive_zip_index_t *index)
+{
+   unsigned i;
+   file_archive_zip_index_t *dropped =
+      zip_index_cache[ZIP_INDEX_CACHE_SIZE - 1];
+
+   if (dropped && !--dropped->refs)
+      zip_index_free(dropped);
+
+   for (i = ZIP_INDEX_CACHE_SIZE - 1; i > 0; i--)
+      zip_index_cache[i] = zip_index_cache[i - 1];
+
+   zip_index_cache[0] = index;
+   index->refs++;
+}
+
+void file_archive_zip_index_cache_init(void)
+{
+   file_archive_zip_index_cache_deinit();
+#ifdef HAVE_THREADS
+   if (!zip_index_cache_lock)
+      zip_index_cache_lock = slock_new();
+#endif
+   zip_index_cache_active = true;
+}
+
+void file_archive_zip_index_cache_deinit(void)
+{
+   unsigned i;
+
+   zip_index_cache_lock_acquire();
+
+   for (i = 0; i < ZIP_INDEX_CACHE_SIZE; i++)
+   {
+      file_archive_zip_index_t *index = zip_index_cache[i];
+
+      if (index && !--index->refs)
+         zip_index_free(index);
+      zip_index_cache[i] = NULL;
+   }
+
+   zip_index_cache_active = false;
+
+   zip_index_cache_lock_release();
+
+#ifdef HAVE_THREADS
+   if (zip_index_cache_lock)
+   {
+      slock_free(zip_index_cache_lock);
+      zip_index_cache_lock = NULL;
+   }
+#endif
+}
+
+file_archive_zip_index_t *file_archive_zip_index_open(const char *path)
+{
+   file_archive_zip_index_t *index = NULL;
+
+   if (string_is_empty(path))
+      return NULL;
+
+   if (zip_index_cache_active)
+   {
+      zip_index_cache_lock_acquire();
+      if ((index = zip_index_cache_take(path)))
+      {
+         if (zip_index_is_current(index))
+         {
+            zip_index_cache_put(index);
+            zip_index_cache_lock_release();
+            return index;
+         }
+
+         /* Drop the reference of the cache */
+         if (!--index->refs)
+            zip_index_free(index);
+      }
+      zip_index_cache_lock_release();
+   }
+
+   if (!(index = zip_index_new(path)))
+      return NULL;
+
+   index->refs = 1;
+
+   if (zip_index_cache_active)
+   {
+      zip_index_cache_lock_acquire();
+      zip_index_cache_put(index);
+      zip_index_cache_lock_release();
+   }
+
+   return index;
+}
+
+void file_archive_zip_index_close(file_archive_zip_index_t *index)
+{
+   bool unused;
+
+   if (!index)
+      return;
+
+   zip_index_cache_lock_acquire();
+   unused = !--index->refs;
+   zip_index_cache_lock_release();
+
+   if (unused)
+      zip_index_free(index);
+}
+
+size_t file_archive_zip_index_size(file_archive_zip_index_t *index)
+{
+   return index ? index->count : 0;
+}
+
+const file_archive_zip_member_t *file_archive_zip_index_get(
+      file_archive_zip_index_t *index, size_t idx)
+{
+   if (!index || idx >= index->count)
+      return NULL;
+   return &index->members[idx];
+}
+
+const file_archive_zip_member_t *file_archive_zip_index_find(
+      file_archive_zip_index_t *index, const char *name)
+{
+   size_t slot, mask;
+
+   if (!index || !name)
+      return NULL;
+
+   mask = index->hash_size - 1;
+
+   for (slot = zip_index_hash(name) & mask;
+         index->hash_table[slot]; slot = (slot + 1) & mask)
+   {
+      const file_archive_zip_member_t *member =
+         &index->members[index->hash_table[slot] - 1];
+
+      if (string_is_equal(member->name, name))
+         return member;
+   }
+
+   return NULL;
+}
+
+/* Member reader */
+
+static bool zip_reader_new_stream(file_archive_zip_reader_t *reader)
+{
+   if (reader->stream)
+      zlib_inflate_backend.stream_free(reader->stream);
+
+   if (!(reader->stream = zlib_inflate_backend.stream_new()))
+      return false;
+
+   if (zlib_inflate_backend.define)
+      zlib_inflate_backend.define(reader->stream,
+            "window_bits", (uint32_t)-MAX_WBITS);
+
+   return true;
+}
+
+file_archive_zip_reader_t *file_archive_zip_reader_open(const char *path,
+      const file_archive_zip_member_t *member)
+{
+   uint8_t header[30];
+   file_archive_zip_reader_t *reader = NULL;
+
+   if (!member || (member->cmode != ZIP_MODE_STORED
+            && member->cmode != ZIP_MODE_DEFLATED))
+      return NULL;
+
+   /* Stored members are not compressed */
+   if (member->cmode == ZIP_MODE_STORED && member->csize != member->size)
+      return NULL;
+
+   if (!(reader = (file_archive_zip_reader_t*)calloc(1, sizeof(*reader))))
+      return NULL;
+
+   reader->csize     = member->csize;
+   reader->size      = member->size;
+   reader->crc32     = member->crc32;
+   reader->cmode     = member->cmode;
+   reader->crc_valid = true;
+
+   if (!(reader->file = filestream_open(path,
+               RETRO_VFS_FILE_ACCESS_READ, RETRO_VFS_FILE_ACCESS_HINT_NONE)))
+      goto error;
+
+   /* The local file header has its own name and extra
+    * field lengths, so the data offset can only be
+    * found by reading it */
+   filestream_seek(reader->file, member->offset,
+         RETRO_VFS_SEEK_POSITION_START);
+   if (     filestream_read(reader->file, header, sizeof(header))
+         != sizeof(header)
+         || read_le(header, 4) != LOCAL_FILE_HEADER_SIGNATURE)
+      goto error;
+
+   reader->data_offset = (int64_t)member->offset + sizeof(header)
+      + read_le(header + 26, 2) + read_le(header + 28, 2);
+
+   if (reader->data_offset + reader->csize
+         > filestream_get_size(reader->file))
+      goto error;
+
+   if (reader->cmode == ZIP_MODE_DEFLATED)
+   {
+      if (!(reader->in_buf = (uint8_t*)malloc(ZIP_READER_BUFFER_SIZE)))
+         goto error;
+      if (!zip_reader_new_stream(reader))
+         goto error;
+   }
+
+   filestream_seek(reader->file, reader->data_offset,
+         RETRO_VFS_SEEK_POSITION_START);
+
+   return reader;
+
+error:
+   file_archive_zip_reader_close(reader);
+   return NULL;
+}
+
+static int64_t zip_reader_inflate(file_archive_zip_reader_t *reader,
+      uint8_t *data, uint32_t len)
+{
+   uint32_t total = 0;
+
+   while (total < len)
+   {
+      uint32_t rd, wn;
+      enum trans_stream_error terror;
+      bool zstatus;
+
+      if (!reader->in_avail && reader->in_read < reader->csize)
+      {
+         uint32_t chunk = MIN(ZIP_READER_BUFFER_SIZE,
+               reader->csize - reader->in_read);
+
+         if (filestream_read(reader->file, reader->in_buf, chunk) != chunk)
+            return -1;
+
+         zlib_inflate_backend.set_in(reader->stream, reader->in_buf, chunk);
+         reader->in_avail  = chunk;
+         reader->in_read  += chunk;
+      }
+
+      zlib_inflate_backend.set_out(reader->stream, data + total, len - total);
+      zstatus = zlib_inflate_backend.trans(reader->stream, false,
+            &rd, &wn, &terror);
+
+      if (!zstatus && terror != TRANS_STREAM_ERROR_BUFFER_FULL)
+         return -1;
+
+      reader->in_avail -= rd;
+      total            += wn;
+
+      if (zstatus && terror == TRANS_STREAM_ERROR_NONE)
+         break; /* end of the deflate stream */
+   }
+
+   return total;
+}
+
+int64_t file_archive_zip_reader_read(file_archive_zip_reader_t *reader,
+      void *data, uint64_t len)
+{
+   int64_t ret;
+
+   if (!reader || !data)
+      return -1;
+
+   if (len > reader->size - reader->pos)
+      len = reader->size - reader->pos;
+
+   if (!len)
+      return 0;
+
+   if (reader->cmode == ZIP_MODE_DEFLATED)
+      ret = zip_reader_inflate(reader, (uint8_t*)data, (uint32_t)len);
+   else
+      ret = filestream_read(reader->file, data, len);
+
+   if (ret < 0)
+      return -1;
+
+   reader->pos += (uint32_t)ret;
+
+   if (reader->crc_valid)
+   {
+      reader->crc = encoding_crc32(reader->crc, (const uint8_t*)data,
+            (size_t)ret);
+
+      if (reader->pos == reader->size && reader->crc != reader->crc32)
+         return -1;
+   }
+
+   /* A deflate stream that ends early is corrupt */
+   if ((uint64_t)ret < len)
+      return -1;
+
+   return ret;
+}
+
+int64_t file_archive_zip_reader_seek(file_archive_zip_reader_t *reader,
+      int64_t offset)
+{
+   uint8_t skip_buf[4096];
+
+   if (!reader || offset < 0 || offset > reader->size)
+      return -1;
+
+   if (reader->cmode == ZIP_MODE_STORED)
+   {
+      if (filestream_seek(reader->file, reader->data_offset + offset,
+               RETRO_VFS_SEEK_POSITION_START) != 0)
+         return -1;
+
+      if (offset != reader->pos)
+         reader->crc_valid = !offset;
+      if (!offset)
+         reader->crc     = 0;
+      reader->pos        = (uint32_t)offset;
+      return offset;
+   }
+
+   /* Deflate streams can only be read forwards */
+   if (offset < reader->pos)
+   {
+      if (!zip_reader_new_stream(reader))
+         return -1;
+
+      filestream_seek(reader->file, reader->data_offset,
+            RETRO_VFS_SEEK_POSITION_START);
+
+      reader->in_avail  = 0;
+      reader->in_read   = 0;
+      reader->pos       = 0;
+      reader->crc       = 0;
+      reader->crc_valid = true;
+   }
+
+   while (reader->pos < offset)
+   {
+      uint32_t chunk = (uint32_t)MIN(sizeof(skip_buf), offset - reader->pos);
+
+      if (file_archive_zip_reader_read(reader, skip_buf, chunk) != chunk)
+         return -1;
+   }
+
+   return offset;
+}
+
+int64_t file_archive_zip_reader_tell(file_archive_zip_reader_t *reader)
+{
+   return reader ? reader->pos : -1;
+}
+
+int64_t file_archive_zip_reader_get_size(file_archive_zip_reader_t *reader)
+{
+   return reader ? reader->size : -1;
+}
+
+void file_archive_zip_reader_close(file_archive_zip_reader_t *reader)
+{
+   if (!reader)
+      return;
+
+   if (reader->stream)
+      zlib_inflate_backend.stream_free(reader->stream);
+   if (reader->file)
+      filestream_close(reader->file);
+   free(reader->in_buf);
+   free(reader);
+}
+
+/* Finds the member content loading refers to: the one
+ * named 'needle' or, as when walking the archive, the
+ * first file whose name contains 'needle' */
+static const file_archive_zip_member_t *zip_index_find_needle(
+      file_archive_zip_index_t *index, const char *needle)
+{
+   size_t i;
+   const file_archive_zip_member_t *member =
+      file_archive_zip_index_find(index, needle);
+
+   if (member)
+      return member;
+
+   for (i = 0; i < index->count; i++)
+   {
+      const char *name = index->members[i].name;
+      size_t len       = strlen(name);
+
+      /* Ignore directories. */
+      if (!len || name[len - 1] == '/' || name[len - 1] == '\\')
+         continue;
+
+      if (strstr(name, needle))
+         return &index->members[i];
+   }
+
+   return NULL;
+}
+
+/* Extract the relative path (needle) from a
+ * ZIP archive (path) and allocate a buffer for it to write it in.
+ *
+ * optional_outfile if not NULL will be used to extract the file to.
+ * buf will be 0 then.
+ */
+static int64_t zip_file_read(
+      const char *path,
+      const char *needle, void **buf,
+      const char *optional_outfile)
+{
+   uint8_t *data                           = NULL;
+   int64_t size                            = -1;
+   file_archive_zip_reader_t *reader       = NULL;
+   const file_archive_zip_member_t *member = NULL;
+   file_archive_zip_index_t *index         = NULL;
+
+   if (!needle || !(index = file_archive_zip_index_open(path)))
+      return -1;
+
+   if ((member = zip_index_find_needle(index, needle)))
+      reader = file_archive_zip_reader_open(path, member);
+
+   file_archive_zip_index_close(index);
+
+   if (!reader)
+      return -1;
+
+   if (optional_outfile)
+   {
+      /* Called in case core has need_fullpath enabled.
+       * The member is written as it is inflated. */
+      RFILE *file = filestream_open(optional_outfile,
+            RETRO_VFS_FILE_ACCESS_WRITE, RETRO_VFS_FILE_ACCESS_HINT_NONE);
+
+      if (file && (data = (uint8_t*)malloc(ZIP_READER_BUFFER_SIZE)))
+      {
+         int64_t len;
+
+         while ((len = file_archive_zip_reader_read(reader, data,
+                     ZIP_READER_BUFFER_SIZE)) > 0)
+            if (filestream_write(file, data, len) != len)
+               break;
+
+         if (!len && file_archive_zip_reader_tell(reader)
+               == file_archive_zip_reader_get_size(reader))
+            size = 0;
+      }
+
+      free(data);
+      if (file && filestream_close(file) != 0)
+         size = -1;
+      if (file && size < 0)
+         filestream_delete(optional_outfile);
+   }
+   else
+   {
+      /* Called in case core has need_fullpath disabled.
+       * Will move decompressed content directly into
+       * RetroArch's ROM buffer. */
+      int64_t len = file_archive_zip_reader_get_size(reader);
+
+      if ((data = (uint8_t*)malloc((size_t)len + 1)))
+      {
+         if (file_archive_zip_reader_read(reader, data, len) == len)
+         {
+            data[len] = '\0';
+            *buf      = data;
+            size      = len;
+         }
+         else
+            free(data);
+      }
+   }
+
+   file_archive_zip_reader_close(reader);
+   return size;
+}
+
+static uint32_t zip_file_crc32(const char *path, const char *needle)
+{
+   uint32_t crc                            = 0;
+   const file_archive_zip_member_t *member = NULL;
+   file_archive_zip_index_t *index         = file_archive_zip_index_open(path);
+
+   if (!index)
+      return 0;
+
+   if (needle)
+      member = file_archive_zip_index_find(index, needle);
+   else
+      member = file_archive_zip_index_get(index, 0);
+
+   if (member)
+      crc = member->crc32;
+
+   file_archive_zip_index_close(index);
+   return crc;
+}
+
 const struct file_archive_file_backend zlib_backend = {
    zip_parse_file_init,
    zip_parse_file_iterate_step,
@@ -525,5 +1159,6 @@ const struct file_archive_file_backend zlib_backend = {
    zlib_stream_decompress_data_to_file_iterate,
    zlib_stream_crc32_calculate,
    zip_file_read,
+   zip_file_crc32,
    "zlib"
 };
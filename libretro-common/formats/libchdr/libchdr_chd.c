@@ -62,6 +62,10 @@
 #include <retro_inline.h>
 #include <streams/file_stream.h>
 
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
 #define TRUE 1
 #define FALSE 0
 
@@ -190,6 +194,15 @@ struct _metadata_entry
 	UINT8					flags;			/* flag bits */
 };
 
+/* a decompressed hunk held in the chd_file LRU cache */
+typedef struct _hunk_cache_entry hunk_cache_entry;
+struct _hunk_cache_entry
+{
+	UINT8 *					data;			/* hunkbytes of decompressed data */
+	UINT32					hunknum;		/* cached hunk, ~0 if the slot is free */
+	UINT32					stamp;			/* last use, for LRU eviction */
+};
+
 /* internal representation of an open CHD file */
 struct _chd_file
 {
@@ -229,6 +242,23 @@ struct _chd_file
 	UINT32					maxhunk;		/* maximum hunk accessed */
 #endif
    UINT8 *              file_cache; /* cache of underlying file */
+
+	hunk_cache_entry *		hcache;			/* LRU cache of decompressed hunks */
+	UINT32					hcache_count;	/* number of cache slots */
+	UINT32					hcache_stamp;	/* LRU clock */
+	UINT32					lasthunk;		/* last hunk passed to chd_read() */
+
+#ifdef HAVE_THREADS
+	slock_t *				io_lock;		/* serialises file access and codecs */
+	slock_t *				cache_lock;		/* guards hcache and the read-ahead window */
+	scond_t *				readahead_cond;	/* wakes up the read-ahead thread */
+	sthread_t *				readahead_thread;
+	UINT8 *					readahead_buf;	/* spare hunk, swapped into the cache */
+	UINT32					readahead_hunks;	/* window size, 0 if disabled */
+	UINT32					readahead_next;	/* next hunk for the read-ahead thread */
+	UINT32					readahead_end;	/* end of the read-ahead window */
+	UINT8					readahead_quit;
+#endif
 };
 
 /***************************************************************************
@@ -255,6 +285,17 @@ static chd_error hunk_read_into_memory(chd_file *chd, UINT32 hunknum, UINT8 *des
 /* internal map access */
 static chd_error map_read(chd_file *chd);
 
+/* internal hunk cache */
+static int hunk_cache_probe(chd_file *chd, UINT32 hunknum);
+static int hunk_cache_lookup(chd_file *chd, UINT32 hunknum, UINT8 *dest);
+static hunk_cache_entry *hunk_cache_victim(chd_file *chd, UINT32 hunknum);
+static void hunk_cache_advance(chd_file *chd, UINT32 hunknum);
+static void hunk_cache_free(chd_file *chd);
+#ifdef HAVE_THREADS
+static void readahead_thread_entry(void *data);
+static void readahead_stop(chd_file *chd);
+#endif
+
 /* metadata management */
 static chd_error metadata_find_entry(chd_file *chd, UINT32 metatag, UINT32 metaindex, metadata_entry *metaentry);
 
@@ -787,6 +828,14 @@ chd_error chd_open_file(RFILE *file, int mode, chd_file *parent, chd_file **chd)
 	newchd->cookie = COOKIE_VALUE;
 	newchd->parent = parent;
 	newchd->file = file;
+	newchd->lasthunk = ~0;
+
+#ifdef HAVE_THREADS
+	newchd->io_lock = slock_new();
+	newchd->cache_lock = slock_new();
+	if (newchd->io_lock == NULL || newchd->cache_lock == NULL)
+		EARLY_EXIT(err = CHDERR_OUT_OF_MEMORY);
+#endif
 
 	/* now attempt to read the header */
 	err = header_read(newchd, &newchd->header);
@@ -954,7 +1003,7 @@ cleanup:
     memory
 -------------------------------------------------*/
 
-chd_error chd_precache(chd_file *chd)
+static chd_error precache_file(chd_file *chd)
 {
 	int64_t size, count;
 
@@ -980,6 +1029,20 @@ chd_error chd_precache(chd_file *chd)
 	return CHDERR_NONE;
 }
 
+chd_error chd_precache(chd_file *chd)
+{
+	chd_error err;
+
+#ifdef HAVE_THREADS
+	slock_lock(chd->io_lock);
+#endif
+	err = precache_file(chd);
+#ifdef HAVE_THREADS
+	slock_unlock(chd->io_lock);
+#endif
+
+	return err;
+}
 
 /*-------------------------------------------------
     chd_open - open a CHD file by
@@ -1037,6 +1100,12 @@ void chd_close(chd_file *chd)
 	if (chd == NULL || chd->cookie != COOKIE_VALUE)
 		return;
 
+	/* stop reading ahead before tearing down the codecs */
+#ifdef HAVE_THREADS
+	readahead_stop(chd);
+#endif
+	hunk_cache_free(chd);
+
 	/* deinit the codec */
 	if (chd->header.version < 5)
 	{
@@ -1117,6 +1186,11 @@ void chd_close(chd_file *chd)
    if (chd->file_cache)
       free(chd->file_cache);
 
+#ifdef HAVE_THREADS
+	slock_free(chd->io_lock);
+	slock_free(chd->cache_lock);
+#endif
+
 	/* free our memory */
 	free(chd);
 }
@@ -1201,12 +1275,165 @@ const chd_header *chd_get_header(chd_file *chd)
 
 chd_error chd_read(chd_file *chd, UINT32 hunknum, void *buffer)
 {
+	chd_error err;
+
 	/* punt if NULL or invalid */
 	if (chd == NULL || chd->cookie != COOKIE_VALUE)
 		return CHDERR_INVALID_PARAMETER;
 
+	/* no cache: perform the read directly */
+	if (chd->hcache_count == 0)
+	{
+#ifdef HAVE_THREADS
+		slock_lock(chd->io_lock);
+#endif
+		err = hunk_read_into_memory(chd, hunknum, (UINT8 *)buffer);
+#ifdef HAVE_THREADS
+		slock_unlock(chd->io_lock);
+#endif
+		return err;
+	}
+
+#ifdef HAVE_THREADS
+	slock_lock(chd->cache_lock);
+#endif
+	if (hunk_cache_lookup(chd, hunknum, (UINT8 *)buffer))
+	{
+		hunk_cache_advance(chd, hunknum);
+#ifdef HAVE_THREADS
+		slock_unlock(chd->cache_lock);
+#endif
+		return CHDERR_NONE;
+	}
+#ifdef HAVE_THREADS
+	slock_unlock(chd->cache_lock);
+
+	/* the read-ahead thread may have been decompressing this
+	   very hunk; check again once it has let go of the codecs */
+	slock_lock(chd->io_lock);
+	slock_lock(chd->cache_lock);
+	if (hunk_cache_lookup(chd, hunknum, (UINT8 *)buffer))
+	{
+		hunk_cache_advance(chd, hunknum);
+		slock_unlock(chd->cache_lock);
+		slock_unlock(chd->io_lock);
+		return CHDERR_NONE;
+	}
+	slock_unlock(chd->cache_lock);
+#endif
+
 	/* perform the read */
-	return hunk_read_into_memory(chd, hunknum, (UINT8 *)buffer);
+	err = hunk_read_into_memory(chd, hunknum, (UINT8 *)buffer);
+
+#ifdef HAVE_THREADS
+	slock_lock(chd->cache_lock);
+#endif
+	if (err == CHDERR_NONE)
+		memcpy(hunk_cache_victim(chd, hunknum)->data, buffer, chd->header.hunkbytes);
+	hunk_cache_advance(chd, hunknum);
+#ifdef HAVE_THREADS
+	slock_unlock(chd->cache_lock);
+	slock_unlock(chd->io_lock);
+#endif
+
+	return err;
+}
+
+/*-------------------------------------------------
+    chd_set_hunk_cache - resize the LRU cache of
+    decompressed hunks
+-------------------------------------------------*/
+
+chd_error chd_set_hunk_cache(chd_file *chd, UINT32 hunks)
+{
+	UINT32 i;
+#ifdef HAVE_THREADS
+	UINT32 readahead_hunks;
+#endif
+
+	/* punt if NULL or invalid */
+	if (chd == NULL || chd->cookie != COOKIE_VALUE)
+		return CHDERR_INVALID_PARAMETER;
+
+	/* the read-ahead thread owns cache slots; restart it afterwards */
+#ifdef HAVE_THREADS
+	readahead_hunks = chd->readahead_hunks;
+	readahead_stop(chd);
+#endif
+	hunk_cache_free(chd);
+
+	if (hunks > 0)
+	{
+		chd->hcache = (hunk_cache_entry *)calloc(hunks, sizeof(*chd->hcache));
+		if (chd->hcache == NULL)
+			return CHDERR_OUT_OF_MEMORY;
+		chd->hcache_count = hunks;
+
+		for (i = 0; i < hunks; i++)
+		{
+			chd->hcache[i].hunknum = ~0;
+			chd->hcache[i].data = (UINT8 *)malloc(chd->header.hunkbytes);
+			if (chd->hcache[i].data == NULL)
+			{
+				hunk_cache_free(chd);
+				return CHDERR_OUT_OF_MEMORY;
+			}
+		}
+	}
+
+#ifdef HAVE_THREADS
+	if (readahead_hunks > 0 && hunks > 0)
+		return chd_set_read_ahead(chd, readahead_hunks);
+#endif
+	return CHDERR_NONE;
+}
+
+/*-------------------------------------------------
+    chd_set_read_ahead - start or stop decompressing
+    hunks ahead of sequential reads
+-------------------------------------------------*/
+
+chd_error chd_set_read_ahead(chd_file *chd, UINT32 hunks)
+{
+	/* punt if NULL or invalid */
+	if (chd == NULL || chd->cookie != COOKIE_VALUE)
+		return CHDERR_INVALID_PARAMETER;
+
+#ifdef HAVE_THREADS
+	readahead_stop(chd);
+
+	if (hunks == 0)
+		return CHDERR_NONE;
+
+	/* prefetched hunks must not evict the one being read */
+	if (chd->hcache_count < 2)
+		return CHDERR_INVALID_PARAMETER;
+	if (hunks > chd->hcache_count / 2)
+		hunks = chd->hcache_count / 2;
+
+	chd->readahead_buf = (UINT8 *)malloc(chd->header.hunkbytes);
+	chd->readahead_cond = scond_new();
+	if (chd->readahead_buf == NULL || chd->readahead_cond == NULL)
+	{
+		readahead_stop(chd);
+		return CHDERR_OUT_OF_MEMORY;
+	}
+
+	chd->readahead_hunks = hunks;
+	chd->readahead_next = 0;
+	chd->readahead_end = 0;
+	chd->readahead_quit = FALSE;
+	chd->readahead_thread = sthread_create(readahead_thread_entry, chd);
+	if (chd->readahead_thread == NULL)
+	{
+		readahead_stop(chd);
+		return CHDERR_OUT_OF_MEMORY;
+	}
+	return CHDERR_NONE;
+#else
+	/* no threads, plain LRU caching only */
+	return (hunks == 0) ? CHDERR_NONE : CHDERR_UNSUPPORTED_FORMAT;
+#endif
 }
 
 /***************************************************************************
@@ -1218,7 +1445,7 @@ chd_error chd_read(chd_file *chd, UINT32 hunknum, void *buffer)
     of the given type
 -------------------------------------------------*/
 
-chd_error chd_get_metadata(chd_file *chd, UINT32 searchtag, UINT32 searchindex, void *output, UINT32 outputlen, UINT32 *resultlen, UINT32 *resulttag, UINT8 *resultflags)
+static chd_error metadata_read(chd_file *chd, UINT32 searchtag, UINT32 searchindex, void *output, UINT32 outputlen, UINT32 *resultlen, UINT32 *resulttag, UINT8 *resultflags)
 {
 	metadata_entry metaentry;
 	chd_error err;
@@ -1268,6 +1495,22 @@ chd_error chd_get_metadata(chd_file *chd, UINT32 searchtag, UINT32 searchindex,
 	return CHDERR_NONE;
 }
 
+chd_error chd_get_metadata(chd_file *chd, UINT32 searchtag, UINT32 searchindex, void *output, UINT32 outputlen, UINT32 *resultlen, UINT32 *resulttag, UINT8 *resultflags)
+{
+	chd_error err;
+
+	/* the read-ahead thread may be using the file */
+#ifdef HAVE_THREADS
+	slock_lock(chd->io_lock);
+#endif
+	err = metadata_read(chd, searchtag, searchindex, output, outputlen, resultlen, resulttag, resultflags);
+#ifdef HAVE_THREADS
+	slock_unlock(chd->io_lock);
+#endif
+
+	return err;
+}
+
 /***************************************************************************
     CODEC INTERFACES
 ***************************************************************************/
@@ -1553,6 +1796,189 @@ static chd_error hunk_read_into_cache(chd_file *chd, UINT32 hunknum)
 }
 #endif
 
+/*-------------------------------------------------
+    hunk_cache_probe - check whether a hunk is
+    cached (cache_lock held)
+-------------------------------------------------*/
+
+static int hunk_cache_probe(chd_file *chd, UINT32 hunknum)
+{
+	UINT32 i;
+
+	for (i = 0; i < chd->hcache_count; i++)
+		if (chd->hcache[i].hunknum == hunknum)
+			return TRUE;
+	return FALSE;
+}
+
+/*-------------------------------------------------
+    hunk_cache_lookup - copy a hunk out of the
+    LRU cache if present (cache_lock held)
+-------------------------------------------------*/
+
+static int hunk_cache_lookup(chd_file *chd, UINT32 hunknum, UINT8 *dest)
+{
+	UINT32 i;
+
+	for (i = 0; i < chd->hcache_count; i++)
+	{
+		hunk_cache_entry *entry = &chd->hcache[i];
+		if (entry->hunknum != hunknum)
+			continue;
+		entry->stamp = ++chd->hcache_stamp;
+		memcpy(dest, entry->data, chd->header.hunkbytes);
+		return TRUE;
+	}
+	return FALSE;
+}
+
+/*-------------------------------------------------
+    hunk_cache_victim - claim the least recently
+    used slot for a hunk (cache_lock held)
+-------------------------------------------------*/
+
+static hunk_cache_entry *hunk_cache_victim(chd_file *chd, UINT32 hunknum)
+{
+	UINT32 i;
+	hunk_cache_entry *victim = &chd->hcache[0];
+
+	for (i = 1; i < chd->hcache_count; i++)
+	{
+		hunk_cache_entry *entry = &chd->hcache[i];
+		if (entry->hunknum == ~0U)
+		{
+			victim = entry;
+			break;
+		}
+		/* wrap-safe comparison of the LRU clock */
+		if ((INT32)(entry->stamp - victim->stamp) < 0)
+			victim = entry;
+	}
+
+	victim->hunknum = hunknum;
+	victim->stamp = ++chd->hcache_stamp;
+	return victim;
+}
+
+/*-------------------------------------------------
+    hunk_cache_advance - record an access and move
+    the read-ahead window on sequential reads
+    (cache_lock held)
+-------------------------------------------------*/
+
+static void hunk_cache_advance(chd_file *chd, UINT32 hunknum)
+{
+#ifdef HAVE_THREADS
+	if (chd->readahead_hunks > 0)
+	{
+		if (hunknum == chd->lasthunk + 1 || hunknum == chd->lasthunk)
+		{
+			chd->readahead_next = hunknum + 1;
+			chd->readahead_end = MIN(chd->header.totalhunks, hunknum + 1 + chd->readahead_hunks);
+			scond_signal(chd->readahead_cond);
+		}
+		else
+		{
+			/* random access, stop prefetching */
+			chd->readahead_next = chd->readahead_end;
+		}
+	}
+#endif
+	chd->lasthunk = hunknum;
+}
+
+/*-------------------------------------------------
+    hunk_cache_free - release all cache slots
+-------------------------------------------------*/
+
+static void hunk_cache_free(chd_file *chd)
+{
+	UINT32 i;
+
+	if (chd->hcache == NULL)
+		return;
+
+	for (i = 0; i < chd->hcache_count; i++)
+		free(chd->hcache[i].data);
+	free(chd->hcache);
+	chd->hcache = NULL;
+	chd->hcache_count = 0;
+}
+
+#ifdef HAVE_THREADS
+/*-------------------------------------------------
+    readahead_thread_entry - decompress the hunks
+    following a sequential read into the cache
+-------------------------------------------------*/
+
+static void readahead_thread_entry(void *data)
+{
+	chd_file *chd = (chd_file *)data;
+
+	slock_lock(chd->cache_lock);
+	while (!chd->readahead_quit)
+	{
+		UINT32 hunknum;
+		chd_error err;
+
+		if (chd->readahead_next >= chd->readahead_end)
+		{
+			scond_wait(chd->readahead_cond, chd->cache_lock);
+			continue;
+		}
+
+		/* skip hunks that are already cached */
+		hunknum = chd->readahead_next++;
+		if (hunk_cache_probe(chd, hunknum))
+			continue;
+		slock_unlock(chd->cache_lock);
+
+		/* lock order is io_lock -> cache_lock, as in chd_read() */
+		slock_lock(chd->io_lock);
+		err = hunk_read_into_memory(chd, hunknum, chd->readahead_buf);
+		slock_lock(chd->cache_lock);
+		if (err == CHDERR_NONE && !hunk_cache_probe(chd, hunknum))
+		{
+			/* swap buffers instead of copying */
+			hunk_cache_entry *entry = hunk_cache_victim(chd, hunknum);
+			UINT8 *spare = entry->data;
+			entry->data = chd->readahead_buf;
+			chd->readahead_buf = spare;
+		}
+		slock_unlock(chd->io_lock);
+	}
+	slock_unlock(chd->cache_lock);
+}
+
+/*-------------------------------------------------
+    readahead_stop - join the read-ahead thread
+    and release its resources
+-------------------------------------------------*/
+
+static void readahead_stop(chd_file *chd)
+{
+	if (chd->readahead_thread != NULL)
+	{
+		slock_lock(chd->cache_lock);
+		chd->readahead_quit = TRUE;
+		scond_signal(chd->readahead_cond);
+		slock_unlock(chd->cache_lock);
+		sthread_join(chd->readahead_thread);
+		chd->readahead_thread = NULL;
+	}
+
+	if (chd->readahead_cond != NULL)
+		scond_free(chd->readahead_cond);
+	chd->readahead_cond = NULL;
+
+	if (chd->readahead_buf != NULL)
+		free(chd->readahead_buf);
+	chd->readahead_buf = NULL;
+
+	chd->readahead_hunks = 0;
+}
+#endif
+
 /*-------------------------------------------------
     hunk_read_compressed - read a compressed
     hunk
@@ -1666,7 +2092,8 @@ static chd_error hunk_read_into_memory(chd_file *chd, UINT32 hunknum, UINT8 *des
 
 			/* parent-referenced data */
 			case V34_MAP_ENTRY_TYPE_PARENT_HUNK:
-				err = hunk_read_into_memory(chd->parent, (UINT32)entry->offset, dest);
+				/* go through chd_read() so the parent's own locks are taken */
+				err = chd_read(chd->parent, (UINT32)entry->offset, dest);
 				if (err != CHDERR_NONE)
 					return err;
 				break;
@@ -22,6 +22,7 @@
 
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 #ifdef _WIN32
 #include <io.h>
 #else
@@ -31,6 +32,7 @@
 #include <retro_miscellaneous.h>
 #include <retro_endianness.h>
 #include <streams/file_stream.h>
+#include <encodings/crc32.h>
 
 #define LSL32(x, n) ((uint32_t)(x) << (n))
 #define LSR32(x, n) ((uint32_t)(x) >> (n))
@@ -497,15 +499,23 @@ static void SHA1Input(struct sha1_context *context,
       return;
    }
 
-   while (length-- && !context->Corrupted)
+   /* Copy up to a whole message block at a time */
+   while (length && !context->Corrupted)
    {
-      context->Message_Block[context->Message_Block_Index++] =
-         (*message_array & 0xFF);
+      unsigned chunk      = 64 - context->Message_Block_Index;
+      unsigned length_low = context->Length_Low;
 
-      context->Length_Low += 8;
+      if (chunk > length)
+         chunk = length;
+
+      memcpy(context->Message_Block + context->Message_Block_Index,
+            message_array, chunk);
+      context->Message_Block_Index += chunk;
+
+      context->Length_Low += chunk << 3;
       /* Force it to 32 bits */
       context->Length_Low &= 0xFFFFFFFF;
-      if (context->Length_Low == 0)
+      if (context->Length_Low < length_low)
       {
          context->Length_High++;
          /* Force it to 32 bits */
@@ -517,51 +527,166 @@ static void SHA1Input(struct sha1_context *context,
       if (context->Message_Block_Index == 64)
          SHA1ProcessMessageBlock(context);
 
-      message_array++;
+      message_array += chunk;
+      length        -= chunk;
    }
 }
 
-int sha1_calculate(const char *path, char *result)
+/* Streaming hashes */
+
+/* Slice of the data handed to each algorithm in turn:
+ * small enough to still be in L1 cache for the next one */
+#define LRC_HASH_SLICE_SIZE 8192
+
+/* Size of the reads done by lrc_hash_file() */
+#define LRC_HASH_FILE_BUFFER_SIZE 65536
+
+struct lrc_hash
 {
-   struct sha1_context sha;
-   unsigned char buff[4096];
-   int rv    = 1;
-   RFILE *fd = filestream_open(path,
-         RETRO_VFS_FILE_ACCESS_READ,
-         RETRO_VFS_FILE_ACCESS_HINT_NONE);
+   MD5_CTX md5;
+   struct sha1_context sha1;
+   uint32_t crc32;
+   unsigned algorithms;
+};
 
-   if (!fd)
-      goto error;
+lrc_hash_t *lrc_hash_new(unsigned algorithms)
+{
+   lrc_hash_t *hash = (lrc_hash_t*)calloc(1, sizeof(*hash));
+
+   if (!hash)
+      return NULL;
 
-   buff[0] = '\0';
+   hash->algorithms = algorithms;
 
-   SHA1Reset(&sha);
+   if (algorithms & LRC_HASH_MD5)
+      MD5_Init(&hash->md5);
+   if (algorithms & LRC_HASH_SHA1)
+      SHA1Reset(&hash->sha1);
+
+   return hash;
+}
+
+void lrc_hash_update(lrc_hash_t *hash, const void *data, size_t len)
+{
+   const uint8_t *buf = (const uint8_t*)data;
 
-   do
+   if (!hash)
+      return;
+
+   /* A single algorithm gains nothing from slicing */
+   if (hash->algorithms == LRC_HASH_CRC32)
+   {
+      hash->crc32 = encoding_crc32(hash->crc32, buf, len);
+      return;
+   }
+
+   while (len)
    {
-      rv = (int)filestream_read(fd, buff, 4096);
-      if (rv < 0)
-         goto error;
+      size_t slice = (len < LRC_HASH_SLICE_SIZE) ? len : LRC_HASH_SLICE_SIZE;
 
-      SHA1Input(&sha, buff, rv);
-   } while (rv);
+      if (hash->algorithms & LRC_HASH_CRC32)
+         hash->crc32 = encoding_crc32(hash->crc32, buf, slice);
+      if (hash->algorithms & LRC_HASH_MD5)
+         MD5_Update(&hash->md5, buf, (unsigned long)slice);
+      if (hash->algorithms & LRC_HASH_SHA1)
+         SHA1Input(&hash->sha1, buf, (unsigned)slice);
 
-   if (!SHA1Result(&sha))
-      goto error;
+      buf += slice;
+      len -= slice;
+   }
+}
+
+bool lrc_hash_finish(lrc_hash_t *hash, lrc_hash_result_t *result)
+{
+   if (!hash || !result)
+      return false;
 
-   sprintf(result, "%08X%08X%08X%08X%08X",
-         sha.Message_Digest[0],
-         sha.Message_Digest[1],
-         sha.Message_Digest[2],
-         sha.Message_Digest[3], sha.Message_Digest[4]);
+   memset(result, 0, sizeof(*result));
 
+   if (hash->algorithms & LRC_HASH_CRC32)
+      result->crc32 = hash->crc32;
+
+   if (hash->algorithms & LRC_HASH_MD5)
+      MD5_Final(result->md5, &hash->md5);
+
+   if (hash->algorithms & LRC_HASH_SHA1)
+   {
+      unsigned i;
+
+      if (!SHA1Result(&hash->sha1))
+         return false;
+
+      for (i = 0; i < 5; i++)
+      {
+         unsigned word           = hash->sha1.Message_Digest[i];
+         result->sha1[i * 4 + 0] = (uint8_t)(word >> 24);
+         result->sha1[i * 4 + 1] = (uint8_t)(word >> 16);
+         result->sha1[i * 4 + 2] = (uint8_t)(word >>  8);
+         result->sha1[i * 4 + 3] = (uint8_t)(word      );
+      }
+   }
+
+   return true;
+}
+
+void lrc_hash_free(lrc_hash_t *hash)
+{
+   free(hash);
+}
+
+bool lrc_hash_file(const char *path, unsigned algorithms,
+      lrc_hash_result_t *result)
+{
+   int64_t nread;
+   bool ret           = false;
+   RFILE *fd          = NULL;
+   uint8_t *buf       = NULL;
+   lrc_hash_t *hash   = NULL;
+
+   if (!path || !result)
+      return false;
+
+   if (!(fd = filestream_open(path,
+         RETRO_VFS_FILE_ACCESS_READ,
+         RETRO_VFS_FILE_ACCESS_HINT_NONE)))
+      return false;
+
+   if (!(buf = (uint8_t*)malloc(LRC_HASH_FILE_BUFFER_SIZE)))
+      goto end;
+
+   if (!(hash = lrc_hash_new(algorithms)))
+      goto end;
+
+   while ((nread = filestream_read(fd, buf, LRC_HASH_FILE_BUFFER_SIZE)) > 0)
+      lrc_hash_update(hash, buf, (size_t)nread);
+
+   if (nread == 0)
+      ret = lrc_hash_finish(hash, result);
+
+end:
+   lrc_hash_free(hash);
+   free(buf);
    filestream_close(fd);
-   return 0;
+   return ret;
+}
+
+int sha1_calculate(const char *path, char *result)
+{
+   lrc_hash_result_t hash;
 
-error:
-   if (fd)
-      filestream_close(fd);
-   return -1;
+   if (!lrc_hash_file(path, LRC_HASH_SHA1, &hash))
+      return -1;
+
+   sprintf(result,
+         "%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X"
+         "%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X",
+         hash.sha1[0],  hash.sha1[1],  hash.sha1[2],  hash.sha1[3],
+         hash.sha1[4],  hash.sha1[5],  hash.sha1[6],  hash.sha1[7],
+         hash.sha1[8],  hash.sha1[9],  hash.sha1[10], hash.sha1[11],
+         hash.sha1[12], hash.sha1[13], hash.sha1[14], hash.sha1[15],
+         hash.sha1[16], hash.sha1[17], hash.sha1[18], hash.sha1[19]);
+
+   return 0;
 }
 
 uint32_t djb2_calculate(const char *str)
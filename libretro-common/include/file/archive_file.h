@@ -132,6 +132,9 @@ struct file_archive_file_backend
    uint32_t (*stream_crc_calculate)(uint32_t, const uint8_t *, size_t);
    int64_t (*compressed_file_read)(const char *path, const char *needle, void **buf,
          const char *optional_outfile);
+   /* Optional, may be NULL. 'needle' is NULL for
+    * the first file in the archive */
+   uint32_t (*compressed_file_crc32)(const char *path, const char *needle);
    const char *ident;
 };
 
@@ -204,6 +207,77 @@ const struct file_archive_file_backend* file_archive_get_file_backend(const char
  **/
 uint32_t file_archive_get_file_crc32(const char *path);
 
+/* Index of the members of a ZIP archive, read once
+ * from its central directory so that members can be
+ * looked up by name without walking the archive. */
+typedef struct file_archive_zip_member
+{
+   const char *name;
+   uint32_t crc32;
+   uint32_t csize;
+   uint32_t size;
+   uint32_t offset;  /* of the local file header */
+   unsigned cmode;   /* 0 = store, 8 = deflate */
+} file_archive_zip_member_t;
+
+typedef struct file_archive_zip_index file_archive_zip_index_t;
+
+/* Reads the central directory of ZIP archive 'path'.
+ * When the index cache is enabled, an index read
+ * earlier is returned instead, once checked against
+ * the end of central directory record of the archive.
+ * Returns NULL if 'path' is not a valid ZIP archive. */
+file_archive_zip_index_t *file_archive_zip_index_open(const char *path);
+
+void file_archive_zip_index_close(file_archive_zip_index_t *index);
+
+/* Members are numbered in central directory order */
+size_t file_archive_zip_index_size(file_archive_zip_index_t *index);
+
+const file_archive_zip_member_t *file_archive_zip_index_get(
+      file_archive_zip_index_t *index, size_t idx);
+
+/* Returns the member with exactly this name, or NULL */
+const file_archive_zip_member_t *file_archive_zip_index_find(
+      file_archive_zip_index_t *index, const char *name);
+
+/* Keeps the indexes of the most recently opened
+ * archives, so that launching content from a large
+ * archive or scanning its members one by one only
+ * reads its central directory once. Until this is
+ * called, every file_archive_zip_index_open() reads
+ * the central directory. */
+void file_archive_zip_index_cache_init(void);
+
+void file_archive_zip_index_cache_deinit(void);
+
+/* Reads a single member of a ZIP archive, inflating
+ * it as it is read rather than all at once. Seeking
+ * backwards in a deflated member restarts inflating
+ * it from the beginning. */
+typedef struct file_archive_zip_reader file_archive_zip_reader_t;
+
+file_archive_zip_reader_t *file_archive_zip_reader_open(const char *path,
+      const file_archive_zip_member_t *member);
+
+/* Returns the number of bytes read, or -1 on error.
+ * Reading the last byte of a member fails if its
+ * CRC32 does not match, unless the member was not
+ * read from start to end. */
+int64_t file_archive_zip_reader_read(file_archive_zip_reader_t *reader,
+      void *data, uint64_t len);
+
+/* Seeks to 'offset' bytes from the start of the member.
+ * Returns the new position, or -1 on error */
+int64_t file_archive_zip_reader_seek(file_archive_zip_reader_t *reader,
+      int64_t offset);
+
+int64_t file_archive_zip_reader_tell(file_archive_zip_reader_t *reader);
+
+int64_t file_archive_zip_reader_get_size(file_archive_zip_reader_t *reader);
+
+void file_archive_zip_reader_close(file_archive_zip_reader_t *reader);
+
 extern const struct file_archive_file_backend zlib_backend;
 extern const struct file_archive_file_backend sevenzip_backend;
 
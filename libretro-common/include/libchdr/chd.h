@@ -356,6 +356,13 @@ chd_error chd_open(const char *filename, int mode, chd_file *parent, chd_file **
 /* precache underlying file */
 chd_error chd_precache(chd_file *chd);
 
+/* keep up to 'hunks' decompressed hunks in an LRU cache (0 disables it) */
+chd_error chd_set_hunk_cache(chd_file *chd, UINT32 hunks);
+
+/* decompress up to 'hunks' hunks ahead of sequential reads on a
+   background thread (0 disables it); needs a hunk cache */
+chd_error chd_set_read_ahead(chd_file *chd, UINT32 hunks);
+
 /* close a CHD file */
 void chd_close(chd_file *chd);
 
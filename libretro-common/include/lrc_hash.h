@@ -32,6 +32,7 @@
 #endif
 
 #include <retro_inline.h>
+#include <boolean.h>
 
 #include <retro_common_api.h>
 
@@ -90,6 +91,67 @@ void MD5_Init(MD5_CTX *ctx);
 void MD5_Update(MD5_CTX *ctx, const void *data, unsigned long size);
 void MD5_Final(unsigned char *result, MD5_CTX *ctx);
 
+/* Streaming hashes: any combination of these algorithms
+ * is computed in a single pass over the data */
+#define LRC_HASH_CRC32 (1 << 0)
+#define LRC_HASH_MD5   (1 << 1)
+#define LRC_HASH_SHA1  (1 << 2)
+
+typedef struct lrc_hash lrc_hash_t;
+
+/* Only the requested hashes are filled in */
+typedef struct
+{
+   uint32_t crc32;
+   uint8_t md5[16];
+   uint8_t sha1[20];
+} lrc_hash_result_t;
+
+/**
+ * lrc_hash_new:
+ * @algorithms        : LRC_HASH_* flags of the hashes to compute.
+ *
+ * Returns: new hash state, to be freed with lrc_hash_free(),
+ * or NULL on allocation failure.
+ **/
+lrc_hash_t *lrc_hash_new(unsigned algorithms);
+
+/**
+ * lrc_hash_update:
+ * @hash              : Hash state.
+ * @data              : Data to hash.
+ * @len               : Size of @data.
+ *
+ * Feeds @data to every requested hash. Large buffers are
+ * processed in slices small enough to stay in cache while
+ * each algorithm reads them in turn.
+ **/
+void lrc_hash_update(lrc_hash_t *hash, const void *data, size_t len);
+
+/**
+ * lrc_hash_finish:
+ * @hash              : Hash state.
+ * @result            : Hashes of all data fed to @hash.
+ *
+ * Computes the final hashes. @hash cannot be updated afterwards.
+ *
+ * Returns: false if the data was too long to be hashed.
+ **/
+bool lrc_hash_finish(lrc_hash_t *hash, lrc_hash_result_t *result);
+
+void lrc_hash_free(lrc_hash_t *hash);
+
+/**
+ * lrc_hash_file:
+ * @path              : File to hash.
+ * @algorithms        : LRC_HASH_* flags of the hashes to compute.
+ * @result            : Hashes of the whole file.
+ *
+ * Returns: true on success.
+ **/
+bool lrc_hash_file(const char *path, unsigned algorithms,
+      lrc_hash_result_t *result);
+
 RETRO_END_DECLS
 
 #endif
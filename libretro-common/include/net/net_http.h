@@ -67,9 +67,27 @@ bool net_http_error(struct http_t *state);
  * If the status is not 20x and accept_error is false, it returns NULL. */
 uint8_t* net_http_data(struct http_t *state, size_t* len, bool accept_error);
 
-/* Cleans up all memory. */
+/* Returns the part of the body received so far, so that it
+ * can be used while the transfer is still running. The
+ * returned buffer is owned by the HTTP handler; it's only
+ * valid until the next net_http_update.
+ *
+ * If the status is not 20x, it returns NULL. */
+uint8_t* net_http_data_received(struct http_t *state, size_t* len);
+
+/* Cleans up all memory. Once the whole response has been
+ * read, the connection is kept open in the connection pool
+ * for the next request to the same host instead. */
 void net_http_delete(struct http_t *state);
 
+/* Enables the keep-alive connection pool. Until this is
+ * called, every request closes its connection. */
+void net_http_pool_init(void);
+
+/* Closes all pooled connections and disables the pool.
+ * Must not be called while requests are running. */
+void net_http_pool_deinit(void);
+
 /* URL Encode a string */
 void net_http_urlencode(char **dest, const char *source);
 
@@ -97,6 +97,12 @@ int filestream_error(RFILE *stream);
 
 int filestream_flush(RFILE *stream);
 
+/* Flushes the stream and waits until its data has reached
+ * the storage device, where the platform allows. Streams
+ * opened through a VFS interface are only flushed, since
+ * the interface has no such call. */
+int filestream_sync(RFILE *stream);
+
 int filestream_delete(const char *path);
 
 int filestream_rename(const char *old_path, const char *new_path);
@@ -37,7 +37,8 @@ enum intfstream_type
    INTFSTREAM_FILE = 0,
    INTFSTREAM_MEMORY,
    INTFSTREAM_CHD,
-   INTFSTREAM_RZIP
+   INTFSTREAM_RZIP,
+   INTFSTREAM_ZIP
 };
 
 typedef struct intfstream_internal intfstream_internal_t, intfstream_t;
@@ -125,6 +126,12 @@ intfstream_t *intfstream_open_chd_track(const char *path,
 intfstream_t *intfstream_open_rzip_file(const char *path,
       unsigned mode);
 
+/* Opens member 'b' of ZIP archive 'a' given path 'a#b'
+ * for reading, without inflating it all at once.
+ * Seeking backwards in a deflated member is slow. */
+intfstream_t *intfstream_open_zip_member(const char *path,
+      unsigned mode);
+
 RETRO_END_DECLS
 
 #endif
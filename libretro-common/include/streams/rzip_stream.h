@@ -112,6 +112,8 @@ char* rzipstream_gets(rzipstream_t *stream, char *s, size_t len);
  * copies it to 'buf'.
  * - 'buf' will be allocated and must be free()'d manually.
  * - Allocated 'buf' size is equal to 'len'.
+ * - Chunks are decompressed straight into 'buf',
+ *   in parallel where threads are available.
  * Returns false in the event of an error */
 bool rzipstream_read_file(const char *path, void **buf, int64_t *len);
 
@@ -141,6 +143,8 @@ int rzipstream_printf(rzipstream_t *stream, const char* format, ...);
 
 /* Writes contents of 'data' buffer to file
  * specified by 'path'.
+ * - Chunks are compressed straight from 'data',
+ *   in parallel where threads are available.
  * Returns false in the event of an error */
 bool rzipstream_write_file(const char *path, const void *data, int64_t len);
 
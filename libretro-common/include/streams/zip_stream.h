@@ -0,0 +1,80 @@
+/* Copyright  (C) 2010-2020 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (zip_stream.h).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _LIBRETRO_SDK_FILE_ZIP_STREAM_H
+#define _LIBRETRO_SDK_FILE_ZIP_STREAM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <boolean.h>
+#include <retro_common_api.h>
+
+RETRO_BEGIN_DECLS
+
+/* Extracts a zip archive while its data arrives
+ * (e.g. while it is being downloaded), without
+ * the archive ever being stored.
+ *
+ * The archive is read front to back using the
+ * local file headers, so the central directory
+ * at the end of the archive is not needed:
+ * extraction is complete once it is reached.
+ * Each file is written next to its destination
+ * and only replaces it once its size and CRC32
+ * have been checked.
+ *
+ * Archives this cannot extract (encrypted files,
+ * compression methods other than store and deflate,
+ * ZIP64, stored files without sizes in their local
+ * header) make the stream fail, so that the caller
+ * can fall back to extracting the complete archive
+ * with the regular file_archive functions. */
+
+/* Prevent direct access to zipstream_t members */
+typedef struct zipstream zipstream_t;
+
+/* Creates a stream that extracts files into
+ * directory 'dir'. Nothing is written until
+ * the first file in the archive is reached.
+ * Returns NULL if arguments are invalid or
+ * memory allocation fails */
+zipstream_t *zipstream_new(const char *dir);
+
+/* Extracts the next 'len' bytes of the archive.
+ * Returns false if the archive cannot be extracted
+ * (invalid or unsupported data, or an IO error);
+ * the stream then ignores any further data */
+bool zipstream_write(zipstream_t *stream, const void *data, size_t len);
+
+/* Returns true once the end of the archive has
+ * been reached, with every file in it extracted */
+bool zipstream_is_done(zipstream_t *stream);
+
+/* Closes the stream. A file that is only partially
+ * extracted is removed; files already extracted
+ * are kept */
+void zipstream_free(zipstream_t *stream);
+
+RETRO_END_DECLS
+
+#endif
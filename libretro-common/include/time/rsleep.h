@@ -0,0 +1,84 @@
+/* Copyright  (C) 2010-2020 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (rsleep.h).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __LIBRETRO_SDK_RSLEEP_H__
+#define __LIBRETRO_SDK_RSLEEP_H__
+
+#include <retro_common_api.h>
+
+#include <stdint.h>
+#include <stddef.h>
+
+RETRO_BEGIN_DECLS
+
+/* Number of buckets in a jitter histogram. Bucket 0 counts
+ * wake-ups less than 1 usec away from the deadline, bucket n
+ * those between 2^(n-1) and 2^n - 1 usec away, and the last
+ * bucket everything further than that. */
+#define RSLEEP_JITTER_BUCKETS 16
+
+typedef struct rsleep_jitter
+{
+   uint64_t buckets[RSLEEP_JITTER_BUCKETS];
+   uint64_t count;
+   int64_t total_usec;
+   int64_t max_usec;
+} rsleep_jitter_t;
+
+/**
+ * rsleep_until:
+ * @deadline          : time to wake up at, in microseconds, in
+ *                      the time base of cpu_features_get_time_usec().
+ * @spin_usec         : how long before @deadline to stop sleeping
+ *                      and start busy-waiting. 0 only sleeps.
+ * @jitter            : if not NULL, how far from @deadline the
+ *                      wake-up was is recorded in this histogram.
+ *
+ * Sleeps until @deadline. Where clock_nanosleep() is available,
+ * the bulk of the wait is an absolute CLOCK_MONOTONIC sleep;
+ * elsewhere it falls back to whole milliseconds of retro_sleep().
+ * The last @spin_usec are spent spinning, which absorbs the OS
+ * timer's wake-up latency at the cost of some CPU time.
+ **/
+void rsleep_until(int64_t deadline, unsigned spin_usec,
+      rsleep_jitter_t *jitter);
+
+/* Records a wake-up that happened @late_usec after its deadline
+ * (negative if it happened before) */
+void rsleep_jitter_add(rsleep_jitter_t *jitter, int64_t late_usec);
+
+void rsleep_jitter_reset(rsleep_jitter_t *jitter);
+
+/**
+ * rsleep_jitter_to_string:
+ *
+ * Writes a one line per bucket text dump of @jitter to @s,
+ * skipping empty buckets.
+ *
+ * Returns: number of characters written.
+ **/
+size_t rsleep_jitter_to_string(const rsleep_jitter_t *jitter,
+      char *s, size_t len);
+
+RETRO_END_DECLS
+
+#endif
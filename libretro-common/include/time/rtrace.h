@@ -0,0 +1,149 @@
+/* Copyright  (C) 2010-2020 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (rtrace.h).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __LIBRETRO_SDK_RTRACE_H__
+#define __LIBRETRO_SDK_RTRACE_H__
+
+#include <retro_common_api.h>
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <boolean.h>
+
+RETRO_BEGIN_DECLS
+
+/* Events kept per thread when rtrace_init() is given 0.
+ * Older events are overwritten once a thread's ring is full. */
+#define RTRACE_DEFAULT_EVENTS (1 << 16)
+
+/* Maximum number of threads that can record events */
+#define RTRACE_MAX_THREADS    64
+
+/* Longest event or thread name kept; longer names
+ * are truncated in exported traces */
+#define RTRACE_MAX_NAME       30
+
+/* Set while recording; read without locking by the
+ * RTRACE_* macros so that disabled tracing costs a
+ * single branch */
+extern volatile bool rtrace_active;
+
+#define RTRACE_BEGIN(name) \
+   do { if (rtrace_active) rtrace_begin(name); } while (0)
+
+#define RTRACE_END(name) \
+   do { if (rtrace_active) rtrace_end(name); } while (0)
+
+#define RTRACE_INSTANT(name) \
+   do { if (rtrace_active) rtrace_instant(name); } while (0)
+
+/**
+ * rtrace_init:
+ * @events_per_thread : size of each thread's event ring, rounded up
+ *                      to a power of two. 0 selects RTRACE_DEFAULT_EVENTS.
+ *
+ * Starts recording. Each thread that records an event gets its own
+ * ring buffer the first time it does so; recording never takes a
+ * lock after that. Does nothing if already initialized.
+ *
+ * Returns: true on success.
+ **/
+bool rtrace_init(size_t events_per_thread);
+
+/**
+ * rtrace_deinit:
+ *
+ * Stops recording and frees every ring buffer. Waits for threads
+ * that are in the middle of recording an event; events recorded
+ * afterwards are ignored.
+ **/
+void rtrace_deinit(void);
+
+/**
+ * rtrace_set_paused:
+ * @paused            : true to stop recording, false to resume.
+ *
+ * Stops or resumes recording without discarding the rings.
+ * Does nothing unless rtrace_init() succeeded.
+ **/
+void rtrace_set_paused(bool paused);
+
+/**
+ * rtrace_is_initialized:
+ *
+ * Returns: true between rtrace_init() and rtrace_deinit().
+ **/
+bool rtrace_is_initialized(void);
+
+/**
+ * rtrace_thread_name:
+ * @name              : name shown for the calling thread. Copied,
+ *                      so it only needs to stay valid for the call.
+ *
+ * Names the calling thread in exported traces.
+ **/
+void rtrace_thread_name(const char *name);
+
+/**
+ * rtrace_begin:
+ * @name              : name of the slice. Copied into the event,
+ *                      up to RTRACE_MAX_NAME characters.
+ *
+ * Opens a slice on the calling thread. Use RTRACE_BEGIN() instead
+ * of calling this directly.
+ **/
+void rtrace_begin(const char *name);
+
+/**
+ * rtrace_end:
+ * @name              : same name as the matching rtrace_begin().
+ *
+ * Closes the calling thread's innermost open slice.
+ **/
+void rtrace_end(const char *name);
+
+/**
+ * rtrace_instant:
+ * @name              : name of the event.
+ *
+ * Records a zero-length event on the calling thread.
+ **/
+void rtrace_instant(const char *name);
+
+/**
+ * rtrace_dump:
+ * @path              : file to write.
+ *
+ * Writes the events currently held in every thread's ring as a
+ * Chrome trace event JSON file, which chrome://tracing and the
+ * Perfetto UI can open. Safe to call while other threads keep
+ * recording: events they overwrite during the dump are dropped
+ * rather than written half-updated.
+ *
+ * Returns: true if the file was written.
+ **/
+bool rtrace_dump(const char *path);
+
+RETRO_END_DECLS
+
+#endif
@@ -51,6 +51,8 @@ int64_t retro_vfs_file_write_impl(libretro_vfs_implementation_file *stream, cons
 
 int retro_vfs_file_flush_impl(libretro_vfs_implementation_file *stream);
 
+int retro_vfs_file_sync_impl(libretro_vfs_implementation_file *stream);
+
 int retro_vfs_file_remove_impl(const char *path);
 
 int retro_vfs_file_rename_impl(const char *old_path, const char *new_path);
@@ -23,6 +23,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <ctype.h>
+#include <time.h>
 
 #include <net/net_http.h>
 #include <net/net_compat.h>
@@ -35,6 +36,17 @@
 #include <string.h>
 #include <retro_common_api.h>
 #include <retro_miscellaneous.h>
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
+/* Maximum number of idle connections kept open
+ * for reuse by later requests to the same host */
+#define NET_HTTP_POOL_SIZE 16
+
+/* Idle connections are closed after this many seconds,
+ * before common servers time them out on their side */
+#define NET_HTTP_POOL_TIMEOUT 4
 
 enum
 {
@@ -63,14 +75,19 @@ struct http_socket_state_t
 struct http_t
 {
    char *data;
+   char *request;
+   char *domain;
    struct http_socket_state_t sock_state; /* ptr alignment */
    size_t pos;
    size_t len;
    size_t buflen;
    int status;
+   int port;
    char part;
    char bodytype;
    bool error;
+   bool keep_alive;
+   bool reused;
 };
 
 struct http_connection_t
@@ -87,6 +104,21 @@ struct http_connection_t
    int port;
 };
 
+struct http_pool_entry
+{
+   char *domain;
+   struct http_socket_state_t sock_state; /* ptr alignment */
+   time_t idle_since;
+   int port;
+};
+
+static struct http_pool_entry net_http_pool[NET_HTTP_POOL_SIZE];
+static unsigned net_http_pool_count = 0;
+static bool net_http_pool_active    = false;
+#ifdef HAVE_THREADS
+static slock_t *net_http_pool_lock  = NULL;
+#endif
+
 /* URL Encode a string
    caller is responsible for deleting the destination buffer */
 void net_http_urlencode(char **dest, const char *source)
@@ -412,16 +444,17 @@ void net_http_urlencode_full(char *dest,
    free (tmp);
 }
 
-static int net_http_new_socket(struct http_connection_t *conn)
+static int net_http_new_socket(struct http_socket_state_t *sock_state,
+      const char *domain, int port)
 {
    int ret;
    struct addrinfo *addr = NULL, *next_addr = NULL;
    int fd                = socket_init(
-         (void**)&addr, conn->port, conn->domain, SOCKET_TYPE_STREAM);
+         (void**)&addr, port, domain, SOCKET_TYPE_STREAM);
 #ifdef HAVE_SSL
-   if (conn->sock_state.ssl)
+   if (sock_state->ssl)
    {
-      if (!(conn->sock_state.ssl_ctx = ssl_socket_init(fd, conn->domain)))
+      if (!(sock_state->ssl_ctx = ssl_socket_init(fd, domain)))
          return -1;
    }
 #endif
@@ -431,15 +464,15 @@ static int net_http_new_socket(struct http_connection_t *conn)
    while (fd >= 0)
    {
 #ifdef HAVE_SSL
-      if (conn->sock_state.ssl)
+      if (sock_state->ssl)
       {
-         ret = ssl_socket_connect(conn->sock_state.ssl_ctx,
+         ret = ssl_socket_connect(sock_state->ssl_ctx,
                (void*)next_addr, true, true);
 
          if (ret >= 0)
             break;
 
-         ssl_socket_close(conn->sock_state.ssl_ctx);
+         ssl_socket_close(sock_state->ssl_ctx);
       }
       else
 #endif
@@ -458,11 +491,181 @@ static int net_http_new_socket(struct http_connection_t *conn)
    if (addr)
       freeaddrinfo_retro(addr);
 
-   conn->sock_state.fd = fd;
+   sock_state->fd = fd;
 
    return fd;
 }
 
+static void net_http_close_socket(struct http_socket_state_t *sock_state)
+{
+   if (sock_state->fd >= 0)
+      socket_close(sock_state->fd);
+#ifdef HAVE_SSL
+   if (sock_state->ssl && sock_state->ssl_ctx)
+      ssl_socket_free(sock_state->ssl_ctx);
+   sock_state->ssl_ctx = NULL;
+#endif
+   sock_state->fd      = -1;
+}
+
+/* An idle connection has nothing to read; if it is
+ * readable, the server has closed it (or sent data
+ * it should not have), so it cannot be reused */
+static bool net_http_socket_is_idle(int fd)
+{
+   fd_set fds;
+   struct timeval tv = {0};
+
+   FD_ZERO(&fds);
+   FD_SET(fd, &fds);
+
+   return socket_select(fd + 1, &fds, NULL, NULL, &tv) == 0;
+}
+
+/* Keeps connections that ended with a complete response
+ * open for the next request to the same host, so that
+ * downloading many small files does not pay for a new
+ * TCP (and TLS) handshake each time. The pool is only
+ * used once net_http_pool_init() has been called;
+ * until then every request closes its connection. */
+void net_http_pool_init(void)
+{
+   net_http_pool_deinit();
+#ifdef HAVE_THREADS
+   if (!net_http_pool_lock)
+      net_http_pool_lock = slock_new();
+#endif
+   net_http_pool_active = true;
+}
+
+void net_http_pool_deinit(void)
+{
+   unsigned i;
+
+#ifdef HAVE_THREADS
+   if (net_http_pool_lock)
+      slock_lock(net_http_pool_lock);
+#endif
+
+   for (i = 0; i < net_http_pool_count; i++)
+   {
+      net_http_close_socket(&net_http_pool[i].sock_state);
+      free(net_http_pool[i].domain);
+   }
+
+   net_http_pool_count  = 0;
+   net_http_pool_active = false;
+
+#ifdef HAVE_THREADS
+   if (net_http_pool_lock)
+   {
+      slock_unlock(net_http_pool_lock);
+      slock_free(net_http_pool_lock);
+      net_http_pool_lock = NULL;
+   }
+#endif
+}
+
+/* Takes an idle connection to the given host out of
+ * the pool, closing any connection that has been
+ * idle for too long on the way */
+static bool net_http_pool_take(const char *domain, int port,
+      struct http_socket_state_t *sock_state)
+{
+   bool found = false;
+   time_t now = time(NULL);
+
+#ifdef HAVE_THREADS
+   if (!net_http_pool_lock)
+      return false;
+#endif
+
+   while (!found)
+   {
+      unsigned i = 0;
+      bool taken = false;
+
+#ifdef HAVE_THREADS
+      slock_lock(net_http_pool_lock);
+#endif
+      while (i < net_http_pool_count)
+      {
+         struct http_pool_entry *entry = &net_http_pool[i];
+
+         if (     now < entry->idle_since
+               || now - entry->idle_since >= NET_HTTP_POOL_TIMEOUT)
+            net_http_close_socket(&entry->sock_state);
+         else if (   !taken
+                   && entry->port           == port
+                   && entry->sock_state.ssl == sock_state->ssl
+                   && string_is_equal(entry->domain, domain))
+         {
+            *sock_state = entry->sock_state;
+            taken       = true;
+         }
+         else
+         {
+            i++;
+            continue;
+         }
+
+         free(entry->domain);
+         *entry = net_http_pool[--net_http_pool_count];
+      }
+#ifdef HAVE_THREADS
+      slock_unlock(net_http_pool_lock);
+#endif
+
+      if (!taken)
+         break;
+
+      if (!(found = net_http_socket_is_idle(sock_state->fd)))
+         net_http_close_socket(sock_state);
+   }
+
+   return found;
+}
+
+/* Puts a connection that is done with its response
+ * back into the pool. Returns false if the pool is
+ * full or inactive; the caller then closes it */
+static bool net_http_pool_put(const char *domain, int port,
+      const struct http_socket_state_t *sock_state)
+{
+   bool added        = false;
+   char *domain_copy = strdup(domain);
+
+   if (!domain_copy)
+      return false;
+
+#ifdef HAVE_THREADS
+   if (!net_http_pool_lock)
+   {
+      free(domain_copy);
+      return false;
+   }
+   slock_lock(net_http_pool_lock);
+#endif
+   if (net_http_pool_active && net_http_pool_count < NET_HTTP_POOL_SIZE)
+   {
+      struct http_pool_entry *entry = &net_http_pool[net_http_pool_count++];
+
+      entry->domain     = domain_copy;
+      entry->sock_state = *sock_state;
+      entry->idle_since = time(NULL);
+      entry->port       = port;
+      added             = true;
+   }
+#ifdef HAVE_THREADS
+   slock_unlock(net_http_pool_lock);
+#endif
+
+   if (!added)
+      free(domain_copy);
+
+   return added;
+}
+
 static void net_http_send_str(
       struct http_socket_state_t *sock_state, bool *error, const char *text)
 {
@@ -682,38 +885,53 @@ const char *net_http_connection_url(struct http_connection_t *conn)
    return conn->urlcopy;
 }
 
-struct http_t *net_http_new(struct http_connection_t *conn)
+static bool net_http_header_is(const char *header,
+      const char *name, size_t len)
 {
-   bool error            = false;
-   int fd                = -1;
-   struct http_t *state  = NULL;
+   size_t i;
 
-   if (!conn)
-      goto error;
-
-   fd = net_http_new_socket(conn);
+   for (i = 0; i < len; i++)
+      if (tolower((unsigned char)header[i]) != tolower((unsigned char)name[i]))
+         return false;
 
-   if (fd < 0)
-      goto error;
+   return true;
+}
 
-   error = false;
+/* Builds the whole request, so that it can be sent
+ * with a single write (and sent again if needed) */
+static char *net_http_new_request(struct http_connection_t *conn,
+      bool keep_alive)
+{
+   char *request = NULL;
+   bool post     = conn->methodcopy
+      && string_is_equal(conn->methodcopy, "POST");
+   size_t size   = 256 + strlen(conn->domain) + strlen(conn->location);
 
-   /* This is a bit lazy, but it works. */
    if (conn->methodcopy)
+      size += strlen(conn->methodcopy);
+   if (conn->contenttypecopy)
+      size += strlen(conn->contenttypecopy);
+   if (conn->useragentcopy)
+      size += strlen(conn->useragentcopy);
+
+   if (post)
    {
-      net_http_send_str(&conn->sock_state, &error, conn->methodcopy);
-      net_http_send_str(&conn->sock_state, &error, " /");
-   }
-   else
-   {
-      net_http_send_str(&conn->sock_state, &error, "GET /");
+      if (!conn->postdatacopy)
+         return NULL;
+      size += strlen(conn->postdatacopy);
    }
 
-   net_http_send_str(&conn->sock_state, &error, conn->location);
-   net_http_send_str(&conn->sock_state, &error, " HTTP/1.1\r\n");
+   if (!(request = (char*)malloc(size)))
+      return NULL;
+
+   /* This is a bit lazy, but it works. */
+   strlcpy(request, conn->methodcopy ? conn->methodcopy : "GET", size);
+   strlcat(request, " /", size);
+   strlcat(request, conn->location, size);
+   strlcat(request, " HTTP/1.1\r\n", size);
 
-   net_http_send_str(&conn->sock_state, &error, "Host: ");
-   net_http_send_str(&conn->sock_state, &error, conn->domain);
+   strlcat(request, "Host: ", size);
+   strlcat(request, conn->domain, size);
 
    if (!conn->port)
    {
@@ -722,110 +940,118 @@ struct http_t *net_http_new(struct http_connection_t *conn)
       portstr[0] = '\0';
 
       snprintf(portstr, sizeof(portstr), ":%i", conn->port);
-      net_http_send_str(&conn->sock_state, &error, portstr);
+      strlcat(request, portstr, size);
    }
 
-   net_http_send_str(&conn->sock_state, &error, "\r\n");
+   strlcat(request, "\r\n", size);
 
    /* This is not being set anywhere yet */
    if (conn->contenttypecopy)
    {
-      net_http_send_str(&conn->sock_state, &error, "Content-Type: ");
-      net_http_send_str(&conn->sock_state, &error, conn->contenttypecopy);
-      net_http_send_str(&conn->sock_state, &error, "\r\n");
+      strlcat(request, "Content-Type: ", size);
+      strlcat(request, conn->contenttypecopy, size);
+      strlcat(request, "\r\n", size);
    }
 
-   if (conn->methodcopy && (string_is_equal(conn->methodcopy, "POST")))
+   if (post)
    {
-      size_t post_len, len;
-      char *len_str        = NULL;
-
-      if (!conn->postdatacopy)
-         goto error;
+      char len_str[64];
 
       if (!conn->contenttypecopy)
-         net_http_send_str(&conn->sock_state, &error,
-               "Content-Type: application/x-www-form-urlencoded\r\n");
+         strlcat(request,
+               "Content-Type: application/x-www-form-urlencoded\r\n", size);
 
-      net_http_send_str(&conn->sock_state, &error, "Content-Length: ");
-
-      post_len = strlen(conn->postdatacopy);
 #ifdef _WIN32
-      len     = snprintf(NULL, 0, "%" PRIuPTR, post_len);
-      len_str = (char*)malloc(len + 1);
-      snprintf(len_str, len + 1, "%" PRIuPTR, post_len);
+      snprintf(len_str, sizeof(len_str), "Content-Length: %" PRIuPTR "\r\n",
+            strlen(conn->postdatacopy));
 #else
-      len     = snprintf(NULL, 0, "%llu", (long long unsigned)post_len);
-      len_str = (char*)malloc(len + 1);
-      snprintf(len_str, len + 1, "%llu", (long long unsigned)post_len);
+      snprintf(len_str, sizeof(len_str), "Content-Length: %llu\r\n",
+            (long long unsigned)strlen(conn->postdatacopy));
 #endif
+      strlcat(request, len_str, size);
+   }
 
-      len_str[len] = '\0';
+   strlcat(request, "User-Agent: ", size);
+   strlcat(request, conn->useragentcopy ? conn->useragentcopy : "libretro",
+         size);
+   strlcat(request, "\r\n", size);
 
-      net_http_send_str(&conn->sock_state, &error, len_str);
-      net_http_send_str(&conn->sock_state, &error, "\r\n");
+   /* HTTP/1.1 connections are persistent by default */
+   if (!keep_alive)
+      strlcat(request, "Connection: close\r\n", size);
+   strlcat(request, "\r\n", size);
 
-      free(len_str);
-   }
-
-   net_http_send_str(&conn->sock_state, &error, "User-Agent: ");
-   if (conn->useragentcopy)
-      net_http_send_str(&conn->sock_state, &error, conn->useragentcopy);
-   else
-      net_http_send_str(&conn->sock_state, &error, "libretro");
-   net_http_send_str(&conn->sock_state, &error, "\r\n");
+   if (post)
+      strlcat(request, conn->postdatacopy, size);
 
-   net_http_send_str(&conn->sock_state, &error, "Connection: close\r\n");
-   net_http_send_str(&conn->sock_state, &error, "\r\n");
+   return request;
+}
 
-   if (conn->methodcopy && (string_is_equal(conn->methodcopy, "POST")))
-      net_http_send_str(&conn->sock_state, &error, conn->postdatacopy);
+/* Sends the request over an idle connection to the host
+ * from the pool if 'reuse' is set and there is one, or
+ * else over a new connection */
+static bool net_http_send_request(struct http_t *state, bool reuse)
+{
+   bool error    = false;
 
-   if (error)
-      goto error;
+   state->reused = reuse
+      && net_http_pool_take(state->domain, state->port, &state->sock_state);
 
-   state             = (struct http_t*)malloc(sizeof(struct http_t));
-   state->sock_state = conn->sock_state;
-   state->status     = -1;
-   state->data       = NULL;
-   state->part       = P_HEADER_TOP;
-   state->bodytype   = T_FULL;
-   state->error      = false;
-   state->pos        = 0;
-   state->len        = 0;
-   state->buflen     = 512;
-   state->data       = (char*)malloc(state->buflen);
-
-   if (!state->data)
-      goto error;
+   if (    !state->reused
+         && net_http_new_socket(&state->sock_state,
+            state->domain, state->port) < 0)
+      return false;
 
-   return state;
+   net_http_send_str(&state->sock_state, &error, state->request);
 
-error:
-   if (conn)
+   if (error && state->reused)
    {
-      if (conn->methodcopy)
-         free(conn->methodcopy);
-      if (conn->contenttypecopy)
-         free(conn->contenttypecopy);
-      conn->methodcopy = NULL;
-      conn->contenttypecopy = NULL;
-      conn->postdatacopy = NULL;
+      net_http_close_socket(&state->sock_state);
+      return net_http_send_request(state, false);
    }
-#ifdef HAVE_SSL
-   if (conn && conn->sock_state.ssl && conn->sock_state.ssl_ctx && fd >= 0)
+
+   return !error;
+}
+
+struct http_t *net_http_new(struct http_connection_t *conn)
+{
+   bool reuse            = false;
+   struct http_t *state  = NULL;
+
+   if (!conn)
+      return NULL;
+
+   if (!(state = (struct http_t*)calloc(1, sizeof(struct http_t))))
+      return NULL;
+
+   state->sock_state     = conn->sock_state;
+   state->sock_state.fd  = -1;
+   state->port           = conn->port;
+   state->status         = -1;
+   state->part           = P_HEADER_TOP;
+   state->bodytype       = T_FULL;
+   state->keep_alive     = net_http_pool_active;
+   state->buflen         = 512;
+
+   /* Only requests without side effects are sent over
+    * pooled connections, as they are sent again when
+    * the server has closed the connection meanwhile */
+   reuse                 = state->keep_alive
+      && (!conn->methodcopy || string_is_equal(conn->methodcopy, "GET"));
+
+   if (     !(state->domain  = strdup(conn->domain))
+         || !(state->request = net_http_new_request(conn, state->keep_alive))
+         || !(state->data    = (char*)malloc(state->buflen))
+         || !net_http_send_request(state, reuse))
    {
-      ssl_socket_close(conn->sock_state.ssl_ctx);
-      ssl_socket_free(conn->sock_state.ssl_ctx);
-      conn->sock_state.ssl_ctx = NULL;
+      free(state->data);
+      state->data       = NULL;
+      state->keep_alive = false;
+      net_http_delete(state);
+      return NULL;
    }
-#else
-   if (fd >= 0)
-      socket_close(fd);
-#endif
-   if (state)
-      free(state);
-   return NULL;
+
+   return state;
 }
 
 int net_http_fd(struct http_t *state)
@@ -861,7 +1087,21 @@ bool net_http_update(struct http_t *state, size_t* progress, size_t* total)
       }
 
       if (newlen < 0)
+      {
+         /* The server may have closed a pooled connection
+          * just as the request was sent over it; send the
+          * request again over a new connection then */
+         if (     state->reused
+               && state->part == P_HEADER_TOP
+               && !state->pos)
+         {
+            net_http_close_socket(&state->sock_state);
+            state->error = false;
+            if (net_http_send_request(state, false))
+               return false;
+         }
          goto fail;
+      }
 
       if (state->pos + newlen >= state->buflen - 64)
       {
@@ -887,21 +1127,32 @@ bool net_http_update(struct http_t *state, size_t* progress, size_t* total)
          {
             if (strncmp(state->data, "HTTP/1.", STRLEN_CONST("HTTP/1."))!=0)
                goto fail;
+            /* HTTP/1.0 servers close the connection
+             * after each response */
+            if (strncmp(state->data, "HTTP/1.1", STRLEN_CONST("HTTP/1.1")))
+               state->keep_alive = false;
             state->status = (int)strtoul(state->data 
                   + STRLEN_CONST("HTTP/1.1 "), NULL, 10);
             state->part   = P_HEADER;
          }
          else
          {
-            if (!strncmp(state->data, "Content-Length: ",
+            /* Header names are case-insensitive. The length
+             * of the body must be known to reuse the connection,
+             * as the server does not close it at the end */
+            if (net_http_header_is(state->data, "Content-Length: ",
                      STRLEN_CONST("Content-Length: ")))
             {
                state->bodytype = T_LEN;
                state->len = strtol(state->data +
                      STRLEN_CONST("Content-Length: "), NULL, 10);
             }
-            if (string_is_equal(state->data, "Transfer-Encoding: chunked"))
+            if (string_is_equal_case_insensitive(state->data,
+                     "Transfer-Encoding: chunked"))
                state->bodytype = T_CHUNK;
+            if (string_is_equal_case_insensitive(state->data,
+                     "Connection: close"))
+               state->keep_alive = false;
 
             /* TODO: save headers somewhere */
             if (state->data[0]=='\0')
@@ -909,6 +1160,13 @@ bool net_http_update(struct http_t *state, size_t* progress, size_t* total)
                state->part = P_BODY;
                if (state->bodytype == T_CHUNK)
                   state->part = P_BODY_CHUNKLEN;
+               /* These responses never have a body */
+               else if (state->status == 204 || state->status == 304)
+               {
+                  state->part     = P_DONE;
+                  state->bodytype = T_LEN;
+                  state->len      = 0;
+               }
             }
          }
 
@@ -1090,22 +1348,54 @@ uint8_t* net_http_data(struct http_t *state, size_t* len, bool accept_error)
    return (uint8_t*)state->data;
 }
 
+uint8_t* net_http_data_received(struct http_t *state, size_t* len)
+{
+   size_t received = 0;
+
+   if (!state || net_http_error(state))
+   {
+      if (len)
+         *len=0;
+      return NULL;
+   }
+
+   switch (state->part)
+   {
+      case P_BODY:
+         received = state->pos;
+         break;
+      case P_BODY_CHUNKLEN:
+         /* len=start of the next chunk header */
+      case P_DONE:
+         received = state->len;
+         break;
+      default:
+         break;
+   }
+
+   if (len)
+      *len=received;
+
+   return (uint8_t*)state->data;
+}
+
 void net_http_delete(struct http_t *state)
 {
    if (!state)
       return;
 
-   if (state->sock_state.fd >= 0)
-   {
-      socket_close(state->sock_state.fd);
-#ifdef HAVE_SSL
-      if (state->sock_state.ssl && state->sock_state.ssl_ctx)
-      {
-         ssl_socket_free(state->sock_state.ssl_ctx);
-         state->sock_state.ssl_ctx = NULL;
-      }
-#endif
-   }
+   /* The connection can only be reused once the
+    * whole response has been read from it */
+   if (     !state->keep_alive
+         || state->error
+         || state->part     != P_DONE
+         || state->bodytype == T_FULL
+         || !net_http_pool_put(state->domain, state->port,
+            &state->sock_state))
+      net_http_close_socket(&state->sock_state);
+
+   free(state->request);
+   free(state->domain);
    free(state);
 }
 
@@ -27,6 +27,7 @@
 #include <queues/task_queue.h>
 
 #include <features/features_cpu.h>
+#include <time/rtrace.h>
 
 #ifdef HAVE_THREADS
 #include <rthreads/rthreads.h>
@@ -219,7 +220,9 @@ static void retro_task_regular_gather(void)
 
       if (!task->when || task->when < cpu_features_get_time_usec())
       {
+         RTRACE_BEGIN("task_handler");
          task->handler(task);
+         RTRACE_END("task_handler");
 
          task_queue_push_progress(task);
       }
@@ -504,7 +507,12 @@ static void threaded_worker(void *userdata)
 
       slock_unlock(running_lock);
 
+      if (rtrace_active)
+         rtrace_thread_name("tasks");
+
+      RTRACE_BEGIN("task_handler");
       task->handler(task);
+      RTRACE_END("task_handler");
 
       slock_lock(property_lock);
       finished = task->finished;
@@ -0,0 +1,85 @@
+#!/bin/sh
+# Builds fixture archives and checks zip_index_test
+# against the files Python's zipfile extracts from
+# them, and that a member whose data does not match
+# its CRC fails to read.
+#
+# Requires python3. Usage: ./test.sh
+
+TEST=$(cd "$(dirname "$0")" && pwd)/zip_index_test
+WORK=$(mktemp -d)
+FAILED=0
+
+trap 'rm -rf "$WORK"' EXIT
+
+cd "$WORK" || exit 1
+
+python3 - <<'PYEOF'
+import random, zipfile
+
+random.seed(1)
+def data(size):
+    words = [bytes(random.randrange(256) for _ in range(16)) for _ in range(64)]
+    return b''.join(random.choice(words) for _ in range(size // 16 + 1))[:size]
+
+# A large romset, like the ones the scanner goes through
+with zipfile.ZipFile('many.zip', 'w', zipfile.ZIP_DEFLATED) as z:
+    for i in range(5000):
+        z.writestr('game%04u.bin' % i, data(random.randrange(4096)))
+
+with zipfile.ZipFile('mixed.zip', 'w') as z:
+    z.writestr('dir/', b'')
+    z.writestr('empty.bin', b'', zipfile.ZIP_STORED)
+    z.writestr('stored.bin', data(300000), zipfile.ZIP_STORED)
+    z.writestr('deflated.bin', data(1000000), zipfile.ZIP_DEFLATED)
+    z.writestr('readme.txt', b'line\n' * 20000, zipfile.ZIP_DEFLATED)
+    z.comment = b'archive comment'
+
+with zipfile.ZipFile('bad_crc.zip', 'w', zipfile.ZIP_STORED) as z:
+    z.writestr('bad_crc.bin', data(1000))
+buf = bytearray(open('bad_crc.zip', 'rb').read())
+buf[100] ^= 0xFF
+open('bad_crc.zip', 'wb').write(buf)
+PYEOF
+
+check()
+{
+   if [ "$1" -ne 0 ]; then
+      echo "[FAILED]: $2"
+      FAILED=1
+   fi
+}
+
+for name in many mixed bad_crc; do
+   python3 -c "import sys, zipfile; zipfile.ZipFile(sys.argv[1]).extractall(sys.argv[2])" \
+      "$name.zip" "expected_$name" 2>/dev/null
+done
+
+# zipfile refuses to extract the corrupt member
+mkdir -p expected_bad_crc
+python3 - <<'PYEOF'
+import zipfile
+z = zipfile.ZipFile('bad_crc.zip')
+i = z.infolist()[0]
+buf = open('bad_crc.zip', 'rb').read()
+start = i.header_offset + 30 + len(i.filename) + len(i.extra)
+open('expected_bad_crc/bad_crc.bin', 'wb').write(buf[start:start + i.file_size])
+PYEOF
+
+# Members are only found after the last slash of
+# the archive path
+for name in many mixed; do
+   "$TEST" "$WORK/$name.zip" "expected_$name"
+   check $? "$name.zip"
+done
+
+"$TEST" "$WORK/bad_crc.zip" expected_bad_crc >/dev/null
+[ $? -ne 0 ]
+check $? "bad_crc.zip: read"
+
+if [ $FAILED -ne 0 ]; then
+   echo "[ERROR]: Some checks failed"
+   exit 1
+fi
+
+echo "[SUCCESS]: All checks passed"
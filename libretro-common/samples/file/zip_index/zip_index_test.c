@@ -0,0 +1,239 @@
+/* Copyright  (C) 2010-2020 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (zip_index_test.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Checks the members of a ZIP archive against the
+ * same files extracted to a directory: their CRCs as
+ * the scanner looks them up (with and without the
+ * index cache, reporting the time taken), their
+ * content read through intfstream with random seeks,
+ * and their content as content loading extracts it.
+ * test.sh runs this against a set of fixture archives. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <file/archive_file.h>
+#include <file/file_path.h>
+#include <streams/file_stream.h>
+#include <streams/interface_stream.h>
+#include <encodings/crc32.h>
+
+static uint64_t get_time_usec(void)
+{
+#if defined(CLOCK_MONOTONIC)
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#else
+   return (uint64_t)clock() * 1000000 / CLOCKS_PER_SEC;
+#endif
+}
+
+static void *read_expected(const char *dir, const char *name, int64_t *len)
+{
+   char path[PATH_MAX_LENGTH];
+   void *data = NULL;
+
+   fill_pathname_join(path, dir, name, sizeof(path));
+
+   if (!filestream_read_file(path, &data, len))
+      return NULL;
+
+   return data;
+}
+
+/* Looks up the CRC of every member by path, as
+ * the scanner does, and returns the number of
+ * mismatches */
+static unsigned check_crcs(const char *archive,
+      file_archive_zip_index_t *index, const char *label)
+{
+   size_t i;
+   unsigned failed = 0;
+   uint64_t start  = get_time_usec();
+   size_t count    = file_archive_zip_index_size(index);
+
+   for (i = 0; i < count; i++)
+   {
+      char path[PATH_MAX_LENGTH];
+      const file_archive_zip_member_t *member =
+         file_archive_zip_index_get(index, i);
+
+      snprintf(path, sizeof(path), "%s#%s", archive, member->name);
+
+      if (file_archive_get_file_crc32(path) != member->crc32)
+      {
+         printf("[ERROR]: Wrong CRC of %s\n", member->name);
+         failed++;
+      }
+   }
+
+   printf("%u CRC lookups, %s: %.2f ms\n", (unsigned)count, label,
+         (get_time_usec() - start) / 1000.0);
+
+   return failed;
+}
+
+/* Reads the member through intfstream, whole and then
+ * in pieces at random offsets */
+static bool check_stream(const char *archive, const char *name,
+      const uint8_t *expected, int64_t len)
+{
+   unsigned i;
+   char path[PATH_MAX_LENGTH];
+   uint8_t *data     = (uint8_t*)malloc((size_t)len + 1);
+   intfstream_t *fd  = NULL;
+   bool ok           = false;
+
+   snprintf(path, sizeof(path), "%s#%s", archive, name);
+
+   if (!data || !(fd = intfstream_open_zip_member(path,
+               RETRO_VFS_FILE_ACCESS_READ)))
+      goto end;
+
+   if (     intfstream_get_size(fd) != len
+         || intfstream_read(fd, data, len) != len
+         || memcmp(data, expected, (size_t)len)
+         || !intfstream_eof(fd))
+      goto end;
+
+   for (i = 0; i < 20 && len; i++)
+   {
+      int64_t offset = rand() % len;
+      int64_t piece  = 1 + rand() % (len - offset);
+
+      if (     intfstream_seek(fd, offset, SEEK_SET) != 0
+            || intfstream_tell(fd) != offset
+            || intfstream_read(fd, data, piece) != piece
+            || memcmp(data, expected + offset, (size_t)piece))
+         goto end;
+   }
+
+   ok = true;
+
+end:
+   if (fd)
+   {
+      intfstream_close(fd);
+      free(fd);
+   }
+   free(data);
+   return ok;
+}
+
+/* Extracts the member to memory, as content loading does */
+static bool check_read(const char *archive, const char *name,
+      const uint8_t *expected, int64_t len)
+{
+   char path[PATH_MAX_LENGTH];
+   void *data   = NULL;
+   int64_t size = 0;
+   bool ok      = false;
+
+   snprintf(path, sizeof(path), "%s#%s", archive, name);
+
+   if (file_archive_compressed_read(path, &data, NULL, &size))
+      ok = size == len && !memcmp(data, expected, (size_t)len);
+
+   free(data);
+   return ok;
+}
+
+int main(int argc, char *argv[])
+{
+   size_t i, count;
+   file_archive_zip_index_t *index = NULL;
+   unsigned failed                 = 0;
+   unsigned checked                = 0;
+
+   if (argc < 3)
+   {
+      printf("Usage: %s <archive> <extracted directory>\n", argv[0]);
+      return 1;
+   }
+
+   if (!(index = file_archive_zip_index_open(argv[1])))
+   {
+      printf("[ERROR]: Failed to read the central directory of %s\n",
+            argv[1]);
+      return 1;
+   }
+
+   count   = file_archive_zip_index_size(index);
+
+   failed += check_crcs(argv[1], index, "no index cache");
+   file_archive_zip_index_cache_init();
+   failed += check_crcs(argv[1], index, "index cache");
+
+   srand(1);
+
+   for (i = 0; i < count; i++)
+   {
+      int64_t len                             = 0;
+      uint8_t *expected                       = NULL;
+      const file_archive_zip_member_t *member =
+         file_archive_zip_index_get(index, i);
+      size_t name_len                         = strlen(member->name);
+
+      /* Directories have no content */
+      if (name_len && member->name[name_len - 1] == '/')
+         continue;
+
+      /* Reading all members of the larger archives
+       * takes too long */
+      if (count > 100 && i % (count / 100))
+         continue;
+
+      if (!(expected = (uint8_t*)read_expected(argv[2],
+                  member->name, &len)))
+      {
+         printf("[ERROR]: Missing extracted file %s\n", member->name);
+         failed++;
+         continue;
+      }
+
+      if (     encoding_crc32(0, expected, (size_t)len) != member->crc32
+            || !check_stream(argv[1], member->name, expected, len)
+            || !check_read(argv[1], member->name, expected, len))
+      {
+         printf("[ERROR]: Wrong content of %s\n", member->name);
+         failed++;
+      }
+
+      checked++;
+      free(expected);
+   }
+
+   file_archive_zip_index_close(index);
+   file_archive_zip_index_cache_deinit();
+
+   if (failed)
+   {
+      printf("[ERROR]: %u checks failed\n", failed);
+      return 1;
+   }
+
+   printf("[SUCCESS]: %u members, %u read\n", (unsigned)count, checked);
+   return 0;
+}
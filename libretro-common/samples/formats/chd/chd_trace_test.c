@@ -0,0 +1,260 @@
+/* Copyright  (C) 2010-2020 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (chd_trace_test.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Replays a recorded sector access trace against a CHD
+ * file, once with hunk caching disabled and once with the
+ * LRU cache + read-ahead thread enabled, then reports the
+ * time taken by each pass and checks both produced the
+ * same data.
+ *
+ * Trace files contain one unit (sector) number per line;
+ * lines starting with '#' are ignored. When no trace is
+ * given, a synthetic one is generated: a sequential read
+ * of the start of the image followed by short bursts at
+ * random and recently visited positions. */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <boolean.h>
+#include <libchdr/chd.h>
+
+#define SYNTHETIC_SEQUENTIAL_UNITS 20000
+#define SYNTHETIC_BURSTS           2000
+#define SYNTHETIC_BURST_UNITS      16
+
+static uint64_t get_time_usec(void)
+{
+#if defined(CLOCK_MONOTONIC)
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#else
+   return (uint64_t)clock() * 1000000 / CLOCKS_PER_SEC;
+#endif
+}
+
+/* Stands in for whatever the core does with the sector
+ * (e.g. audio mixing), which read-ahead can overlap */
+static void simulate_work(unsigned usec)
+{
+   uint64_t end;
+
+   if (!usec)
+      return;
+
+   end = get_time_usec() + usec;
+   while (get_time_usec() < end);
+}
+
+static uint32_t *trace_load(const char *path, size_t *count)
+{
+   char line[64];
+   size_t cap       = 1024;
+   uint32_t *units  = (uint32_t*)malloc(cap * sizeof(*units));
+   FILE *fp         = fopen(path, "r");
+
+   *count           = 0;
+
+   if (!fp || !units)
+   {
+      if (fp)
+         fclose(fp);
+      free(units);
+      return NULL;
+   }
+
+   while (fgets(line, sizeof(line), fp))
+   {
+      if (line[0] == '#' || line[0] == '\n')
+         continue;
+
+      if (*count == cap)
+      {
+         uint32_t *tmp = (uint32_t*)realloc(units, cap * 2 * sizeof(*units));
+         if (!tmp)
+            break;
+         units = tmp;
+         cap  *= 2;
+      }
+
+      units[(*count)++] = (uint32_t)strtoul(line, NULL, 10);
+   }
+
+   fclose(fp);
+   return units;
+}
+
+static uint32_t *trace_synthesize(uint32_t total_units, size_t *count)
+{
+   size_t i, j;
+   uint32_t seq     = total_units < SYNTHETIC_SEQUENTIAL_UNITS
+      ? total_units : SYNTHETIC_SEQUENTIAL_UNITS;
+   uint32_t *units  = (uint32_t*)malloc(
+         (seq + SYNTHETIC_BURSTS * SYNTHETIC_BURST_UNITS) * sizeof(*units));
+   uint32_t last    = 0;
+
+   if (!units)
+      return NULL;
+
+   *count = 0;
+
+   for (i = 0; i < seq; i++)
+      units[(*count)++] = (uint32_t)i;
+
+   srand(1);
+
+   for (i = 0; i < SYNTHETIC_BURSTS; i++)
+   {
+      /* Half of the bursts go back to where we just were */
+      uint32_t start = (rand() & 1)
+         ? last
+         : (uint32_t)(((uint64_t)rand() * total_units) / ((uint64_t)RAND_MAX + 1));
+
+      for (j = 0; j < SYNTHETIC_BURST_UNITS; j++)
+         units[(*count)++] = (start + (uint32_t)j) % total_units;
+
+      last = start;
+   }
+
+   return units;
+}
+
+static bool trace_replay(chd_file *chd, const uint32_t *units, size_t count,
+      unsigned work_usec, uint64_t *checksum, uint64_t *elapsed_usec)
+{
+   size_t i;
+   const chd_header *hd = chd_get_header(chd);
+   uint32_t per_hunk    = hd->hunkbytes / hd->unitbytes;
+   uint8_t *hunk        = (uint8_t*)malloc(hd->hunkbytes);
+   uint64_t start       = get_time_usec();
+   uint64_t hash        = 14695981039346656037ULL;
+
+   if (!hunk)
+      return false;
+
+   for (i = 0; i < count; i++)
+   {
+      uint32_t j;
+      uint32_t unit         = units[i];
+      const uint8_t *sector = hunk + (unit % per_hunk) * hd->unitbytes;
+
+      if (chd_read(chd, unit / per_hunk, hunk) != CHDERR_NONE)
+      {
+         printf("[ERROR]: Failed to read unit %u\n", (unsigned)unit);
+         free(hunk);
+         return false;
+      }
+
+      for (j = 0; j + 8 <= hd->unitbytes; j += 8)
+      {
+         uint64_t word;
+         memcpy(&word, sector + j, sizeof(word));
+         hash = (hash ^ word) * 1099511628211ULL;
+      }
+
+      simulate_work(work_usec);
+   }
+
+   *elapsed_usec = get_time_usec() - start;
+   *checksum     = hash;
+
+   free(hunk);
+   return true;
+}
+
+int main(int argc, char *argv[])
+{
+   size_t count;
+   uint64_t sum_direct, sum_cached;
+   uint64_t time_direct, time_cached;
+   const chd_header *hd  = NULL;
+   uint32_t *units       = NULL;
+   chd_file *chd         = NULL;
+   const char *trace     = (argc > 2 && strcmp(argv[2], "-")) ? argv[2] : NULL;
+   unsigned cache_hunks  = (argc > 3) ? (unsigned)atoi(argv[3]) : 16;
+   unsigned ahead_hunks  = (argc > 4) ? (unsigned)atoi(argv[4]) : 4;
+   unsigned work_usec    = (argc > 5) ? (unsigned)atoi(argv[5]) : 0;
+   int ret               = 1;
+
+   if (argc < 2)
+   {
+      printf("Usage: %s <file.chd> [trace.txt|-] [cache hunks] [read-ahead hunks] [work usec per read]\n", argv[0]);
+      return 1;
+   }
+
+   if (chd_open(argv[1], CHD_OPEN_READ, NULL, &chd) != CHDERR_NONE)
+   {
+      printf("[ERROR]: Failed to open %s\n", argv[1]);
+      return 1;
+   }
+
+   hd    = chd_get_header(chd);
+   units = trace
+      ? trace_load(trace, &count)
+      : trace_synthesize((uint32_t)hd->unitcount, &count);
+
+   if (!units || !count)
+   {
+      printf("[ERROR]: No trace to replay\n");
+      goto end;
+   }
+
+   printf("Hunk size: %u bytes, %u units per hunk, %u hunks\n",
+         (unsigned)hd->hunkbytes, (unsigned)(hd->hunkbytes / hd->unitbytes),
+         (unsigned)hd->totalhunks);
+   printf("Replaying %u reads (%s)\n", (unsigned)count,
+         trace ? trace : "synthetic trace");
+
+   if (!trace_replay(chd, units, count, work_usec, &sum_direct, &time_direct))
+      goto end;
+   printf("No cache:                           %8.2f ms\n",
+         time_direct / 1000.0);
+
+   if (     chd_set_hunk_cache(chd, cache_hunks)   != CHDERR_NONE
+         || chd_set_read_ahead(chd, ahead_hunks) != CHDERR_NONE)
+   {
+      printf("[ERROR]: Failed to configure hunk cache\n");
+      goto end;
+   }
+
+   if (!trace_replay(chd, units, count, work_usec, &sum_cached, &time_cached))
+      goto end;
+   printf("Cache %3u hunks, read-ahead %3u:    %8.2f ms\n",
+         cache_hunks, ahead_hunks, time_cached / 1000.0);
+
+   if (sum_direct != sum_cached)
+      printf("[ERROR]: Cached reads returned different data\n");
+   else
+   {
+      printf("[SUCCESS]: Data matches\n");
+      ret = 0;
+   }
+
+end:
+   free(units);
+   chd_close(chd);
+   return ret;
+}
@@ -0,0 +1,239 @@
+/* Copyright  (C) 2010-2020 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (hash_bench.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/* Compares the throughput of encoding_crc32() with the
+ * byte-at-a-time table lookup it used to do, for several
+ * buffer sizes, then times computing CRC32, MD5 and SHA1
+ * of one buffer in separate passes and in a single pass
+ * with lrc_hash_update(). Every result is checked against
+ * the reference implementation or known test vectors. */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <encodings/crc32.h>
+#include <lrc_hash.h>
+
+/* Bytes hashed for each buffer size */
+#define BENCH_TOTAL_SIZE (256 << 20)
+#define MULTI_SIZE       (64 << 20)
+
+static uint32_t reference_table[256];
+static unsigned errors;
+
+static uint64_t get_time_usec(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void reference_init(void)
+{
+   uint32_t i, j;
+
+   for (i = 0; i < 256; i++)
+   {
+      uint32_t c = i;
+      for (j = 0; j < 8; j++)
+         c = (c & 1) ? (c >> 1) ^ 0xedb88320 : (c >> 1);
+      reference_table[i] = c;
+   }
+}
+
+/* What encoding_crc32() used to do */
+static uint32_t reference_crc32(uint32_t crc, const uint8_t *buf, size_t len)
+{
+   crc = crc ^ 0xffffffff;
+
+   while (len--)
+      crc = reference_table[(crc ^ (*buf++)) & 0xff] ^ (crc >> 8);
+
+   return crc ^ 0xffffffff;
+}
+
+static void check(int condition, const char *what)
+{
+   if (condition)
+      return;
+
+   errors++;
+   printf("[ERROR]: %s\n", what);
+}
+
+static void check_hex(const uint8_t *hash, size_t len,
+      const char *expected, const char *what)
+{
+   size_t i;
+   char hex[64];
+
+   for (i = 0; i < len; i++)
+      sprintf(hex + i * 2, "%02x", hash[i]);
+
+   check(!strcmp(hex, expected), what);
+}
+
+static void check_vectors(void)
+{
+   lrc_hash_result_t result;
+   const char *abc  = "abc";
+   lrc_hash_t *hash = lrc_hash_new(
+         LRC_HASH_CRC32 | LRC_HASH_MD5 | LRC_HASH_SHA1);
+
+   check(encoding_crc32(0, (const uint8_t*)"123456789", 9) == 0xcbf43926,
+         "CRC32 of \"123456789\"");
+
+   lrc_hash_update(hash, abc, 3);
+   lrc_hash_finish(hash, &result);
+   lrc_hash_free(hash);
+
+   check(result.crc32 == 0x352441c2, "CRC32 of \"abc\"");
+   check_hex(result.md5, 16,
+         "900150983cd24fb0d6963f7d28e17f72", "MD5 of \"abc\"");
+   check_hex(result.sha1, 20,
+         "a9993e364706816aba3e25717850c26c9cd0d89d", "SHA1 of \"abc\"");
+}
+
+static void bench_crc32(const uint8_t *data, size_t size)
+{
+   size_t i;
+   uint64_t start, ref_usec, new_usec;
+   uint32_t ref_crc    = 0;
+   uint32_t new_crc    = 0;
+   size_t iterations   = BENCH_TOTAL_SIZE / size;
+
+   start = get_time_usec();
+   for (i = 0; i < iterations; i++)
+      ref_crc = reference_crc32(ref_crc, data, size);
+   ref_usec = get_time_usec() - start;
+
+   start = get_time_usec();
+   for (i = 0; i < iterations; i++)
+      new_crc = encoding_crc32(new_crc, data, size);
+   new_usec = get_time_usec() - start;
+
+   printf("%10u bytes %10.1f MB/s %10.1f MB/s %8.1fx\n",
+         (unsigned)size,
+         (double)BENCH_TOTAL_SIZE / (ref_usec ? ref_usec : 1),
+         (double)BENCH_TOTAL_SIZE / (new_usec ? new_usec : 1),
+         (double)ref_usec / (new_usec ? new_usec : 1));
+
+   check(ref_crc == new_crc, "CRC32 differs from reference");
+}
+
+static void bench_multi(const uint8_t *data, size_t size)
+{
+   unsigned i;
+   uint64_t start, separate_usec, single_usec;
+   lrc_hash_result_t separate, single, part;
+   static const unsigned algorithms[3] =
+   { LRC_HASH_CRC32, LRC_HASH_MD5, LRC_HASH_SHA1 };
+   lrc_hash_t *hash = NULL;
+
+   memset(&separate, 0, sizeof(separate));
+
+   start = get_time_usec();
+   for (i = 0; i < 3; i++)
+   {
+      hash = lrc_hash_new(algorithms[i]);
+      lrc_hash_update(hash, data, size);
+      lrc_hash_finish(hash, &part);
+      lrc_hash_free(hash);
+
+      if (i == 0)
+         separate.crc32 = part.crc32;
+      else if (i == 1)
+         memcpy(separate.md5, part.md5, sizeof(part.md5));
+      else
+         memcpy(separate.sha1, part.sha1, sizeof(part.sha1));
+   }
+   separate_usec = get_time_usec() - start;
+
+   start = get_time_usec();
+   hash  = lrc_hash_new(LRC_HASH_CRC32 | LRC_HASH_MD5 | LRC_HASH_SHA1);
+   lrc_hash_update(hash, data, size);
+   lrc_hash_finish(hash, &single);
+   lrc_hash_free(hash);
+   single_usec = get_time_usec() - start;
+
+   printf("CRC32+MD5+SHA1 of %u MB: separate passes %.1f ms, "
+         "single pass %.1f ms\n", (unsigned)(size >> 20),
+         separate_usec / 1000.0, single_usec / 1000.0);
+
+   check(single.crc32 == reference_crc32(0, data, size),
+         "Single pass CRC32 differs from reference");
+   check(!memcmp(&single, &separate, sizeof(single)),
+         "Single pass hashes differ from separate passes");
+}
+
+int main(void)
+{
+   size_t i;
+   static const size_t sizes[] =
+   { 16, 64, 256, 1024, 16384, 1 << 20, 16 << 20 };
+   uint8_t *data = (uint8_t*)malloc(MULTI_SIZE);
+
+   if (!data)
+      return 1;
+
+   reference_init();
+   srand(1);
+   for (i = 0; i < MULTI_SIZE; i++)
+      data[i] = (uint8_t)rand();
+
+   check_vectors();
+
+   /* Odd lengths and alignments take every path */
+   for (i = 0; i < 4096; i++)
+   {
+      size_t offset = (size_t)rand() % 64;
+      size_t len    = (size_t)rand() % 2048;
+      uint32_t seed = (uint32_t)rand();
+
+      if (encoding_crc32(seed, data + offset, len)
+            != reference_crc32(seed, data + offset, len))
+      {
+         check(0, "CRC32 of unaligned buffer differs from reference");
+         break;
+      }
+   }
+
+   printf("%16s %16s %16s\n", "CRC32 buffer", "byte table", "encoding_crc32");
+   for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+      bench_crc32(data, sizes[i]);
+
+   bench_multi(data, MULTI_SIZE);
+
+   free(data);
+
+   if (errors)
+   {
+      printf("[ERROR]: %u checks failed\n", errors);
+      return 1;
+   }
+
+   printf("[SUCCESS]: All checks passed\n");
+   return 0;
+}
@@ -0,0 +1,127 @@
+#!/bin/sh
+# Serves small files from a local HTTP/1.1 keep-alive server
+# and checks that http_pool_test downloads all of them with
+# and without the connection pool, that the pool reuses
+# connections, and that it recovers from connections the
+# server closes (idle timeout, 'Connection: close',
+# HTTP/1.0 and chunked responses).
+#
+# Requires python3. Usage: ./http_pool_test.sh [files] [port]
+
+FILES=${1:-2000}
+PORT=${2:-8766}
+TEST=$(cd "$(dirname "$0")" && pwd)/http_pool_test
+WORK=$(mktemp -d)
+FAILED=0
+
+trap 'kill $SERVER 2>/dev/null; rm -rf "$WORK"' EXIT
+
+cd "$WORK" || exit 1
+
+cat > server.py <<'EOF'
+import http.server, os, sys
+
+class Handler(http.server.BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'
+    # Headers and body are written separately
+    disable_nagle_algorithm = True
+    # Idle connections are closed after one second
+    timeout = 1
+
+    def setup(self):
+        super().setup()
+        self.server.connections += 1
+        with open('connections', 'w') as f:
+            f.write(str(self.server.connections))
+
+    def do_GET(self):
+        parts = self.path.strip('/').split('/')
+        idx = int(parts[-1].split('.')[0])
+        body = ('file %u\n' % idx).encode() * (idx % 50 + 1)
+        mode = parts[0] if len(parts) > 1 else ''
+        if mode == 'http10':
+            self.protocol_version = 'HTTP/1.0'
+        self.send_response(200)
+        if mode == 'chunked':
+            self.send_header('Transfer-Encoding', 'chunked')
+            self.end_headers()
+            for i in range(0, len(body), 100):
+                chunk = body[i:i + 100]
+                self.wfile.write(b'%x\r\n%s\r\n' % (len(chunk), chunk))
+            self.wfile.write(b'0\r\n\r\n')
+            return
+        self.send_header('content-length', str(len(body)))
+        if mode == 'close':
+            self.send_header('Connection', 'close')
+        self.end_headers()
+        self.wfile.write(body)
+
+    def log_message(self, *args):
+        pass
+
+server = http.server.ThreadingHTTPServer(('127.0.0.1', int(sys.argv[1])), Handler)
+server.connections = 0
+server.serve_forever()
+EOF
+
+python3 server.py "$PORT" &
+SERVER=$!
+sleep 1
+
+BASE="http://127.0.0.1:$PORT"
+
+check()
+{
+   if [ "$1" -ne 0 ]; then
+      echo "[FAILED]: $2"
+      FAILED=1
+   fi
+}
+
+# Runs the test, then prints the number of connections
+# the server accepted meanwhile
+run()
+{
+   before=$(cat connections 2>/dev/null || echo 0)
+   "$TEST" "$@" >&2
+   check $? "$*"
+   after=$(cat connections 2>/dev/null || echo 0)
+   echo $((after - before))
+}
+
+conns=$(run "$BASE" "$FILES" 1 0 nopool)
+[ "$conns" -eq "$FILES" ]
+check $? "$conns connections for $FILES files without the pool"
+
+conns=$(run "$BASE" "$FILES" 1)
+[ "$conns" -eq 1 ]
+check $? "$conns connections for $FILES files one at a time"
+
+conns=$(run "$BASE" "$FILES" 8)
+[ "$conns" -le 16 ]
+check $? "$conns connections for $FILES files eight at a time"
+
+conns=$(run "$BASE/chunked" 200 4)
+[ "$conns" -le 8 ]
+check $? "$conns connections for chunked responses"
+
+# Connections the server closes cannot be reused
+conns=$(run "$BASE/close" 50 1)
+[ "$conns" -eq 50 ]
+check $? "$conns connections for 'Connection: close' responses"
+
+conns=$(run "$BASE/http10" 50 1)
+[ "$conns" -eq 50 ]
+check $? "$conns connections for HTTP/1.0 responses"
+
+# The server closes idle connections before the pool does
+conns=$(run "$BASE" 4 1 1500)
+[ "$conns" -eq 4 ]
+check $? "$conns connections after idle timeouts"
+
+if [ $FAILED -ne 0 ]; then
+   echo "[ERROR]: Some checks failed"
+   exit 1
+fi
+
+echo "[SUCCESS]: All checks passed"
@@ -0,0 +1,223 @@
+/* Copyright  (C) 2010-2020 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (net_http_pool_test.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Downloads <base URL>/0.txt ... <base URL>/<n-1>.txt with
+ * up to the given number of transfers running at a time,
+ * checks the content of each file and reports the time
+ * taken. http_pool_test.sh runs this against a local
+ * HTTP/1.1 server, with and without the connection pool. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <compat/strl.h>
+#include <string/stdstring.h>
+#include <net/net_http.h>
+#include <net/net_compat.h>
+#include <net/net_socket.h>
+#include <retro_timers.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#endif
+
+#define MAX_PARALLEL 64
+
+struct transfer
+{
+   struct http_t *http;
+   unsigned idx;
+};
+
+static uint64_t get_time_usec(void)
+{
+#if defined(CLOCK_MONOTONIC)
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#else
+   return (uint64_t)clock() * 1000000 / CLOCKS_PER_SEC;
+#endif
+}
+
+/* File i holds the line "file <i>" repeated (i % 50) + 1
+ * times; http_pool_test.sh writes the same files */
+static bool check_data(unsigned idx, const char *data, size_t len)
+{
+   unsigned i;
+   char line[32];
+   size_t line_len = snprintf(line, sizeof(line), "file %u\n", idx);
+
+   if (len != line_len * (idx % 50 + 1))
+      return false;
+
+   for (i = 0; i < idx % 50 + 1; i++)
+      if (memcmp(data + i * line_len, line, line_len))
+         return false;
+
+   return true;
+}
+
+static struct http_t *start_transfer(const char *base_url, unsigned idx)
+{
+   char url[1024];
+   struct http_connection_t *conn = NULL;
+   struct http_t *http            = NULL;
+
+   snprintf(url, sizeof(url), "%s/%u.txt", base_url, idx);
+
+   if (!(conn = net_http_connection_new(url, "GET", NULL)))
+      return NULL;
+
+   while (!net_http_connection_iterate(conn)) {}
+
+   if (net_http_connection_done(conn))
+      http = net_http_new(conn);
+
+   net_http_connection_free(conn);
+   return http;
+}
+
+/* Returns false if the transfer failed */
+static bool end_transfer(struct transfer *transfer)
+{
+   size_t len = 0;
+   char *data = (char*)net_http_data(transfer->http, &len, true);
+   bool ok    = !net_http_error(transfer->http)
+      && data && check_data(transfer->idx, data, len);
+
+   if (!ok)
+      printf("[ERROR]: Download of file %u failed (status %d)\n",
+            transfer->idx, net_http_status(transfer->http));
+
+   free(data);
+   net_http_delete(transfer->http);
+   transfer->http = NULL;
+
+   return ok;
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned i;
+   uint64_t start;
+   struct transfer transfers[MAX_PARALLEL];
+   unsigned next     = 0;
+   unsigned running  = 0;
+   unsigned failed   = 0;
+   unsigned files    = (argc > 2) ? (unsigned)atoi(argv[2]) : 0;
+   unsigned parallel = (argc > 3) ? (unsigned)atoi(argv[3]) : 1;
+   unsigned delay_ms = (argc > 4) ? (unsigned)atoi(argv[4]) : 0;
+   bool pool         = !(argc > 5 && string_is_equal(argv[5], "nopool"));
+
+   if (!files || !parallel || parallel > MAX_PARALLEL)
+   {
+      printf("Usage: %s <base URL> <files> [parallel] [delay ms] [nopool]\n",
+            argv[0]);
+      return 1;
+   }
+
+   if (!network_init())
+      return 1;
+
+   if (pool)
+      net_http_pool_init();
+
+   memset(transfers, 0, sizeof(transfers));
+   start = get_time_usec();
+
+   while (next < files || running)
+   {
+      fd_set fds;
+      struct timeval tv;
+      int max_fd = -1;
+
+      for (i = 0; i < parallel; i++)
+      {
+         struct transfer *transfer = &transfers[i];
+
+         if (!transfer->http && next < files)
+         {
+            /* Lets pooled connections go idle for a while */
+            if (delay_ms && next)
+               retro_sleep(delay_ms);
+
+            transfer->idx = next++;
+
+            if (!(transfer->http = start_transfer(argv[1], transfer->idx)))
+            {
+               printf("[ERROR]: Failed to request file %u\n", transfer->idx);
+               failed++;
+               continue;
+            }
+            running++;
+         }
+
+         if (transfer->http && net_http_update(transfer->http, NULL, NULL))
+         {
+            if (!end_transfer(transfer))
+               failed++;
+            running--;
+         }
+      }
+
+      /* Wait for any running transfer to receive data */
+      FD_ZERO(&fds);
+      for (i = 0; i < parallel; i++)
+      {
+         int fd;
+
+         if (!transfers[i].http)
+            continue;
+
+         fd = net_http_fd(transfers[i].http);
+         FD_SET(fd, &fds);
+         if (fd > max_fd)
+            max_fd = fd;
+      }
+
+      if (max_fd >= 0)
+      {
+         tv.tv_sec  = 0;
+         tv.tv_usec = 10000;
+         socket_select(max_fd + 1, &fds, NULL, NULL, &tv);
+      }
+   }
+
+   printf("%u files, %u at a time, %s: %.2f ms\n", files, parallel,
+         pool ? "connection pool" : "no connection pool",
+         (get_time_usec() - start) / 1000.0);
+
+   net_http_pool_deinit();
+   network_deinit();
+
+   if (failed)
+   {
+      printf("[ERROR]: %u downloads failed\n", failed);
+      return 1;
+   }
+
+   printf("[SUCCESS]: All files downloaded\n");
+   return 0;
+}
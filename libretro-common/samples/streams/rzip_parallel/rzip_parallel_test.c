@@ -0,0 +1,413 @@
+/* Copyright  (C) 2010-2020 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (rzip_parallel_test.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Round-trips generated save data through RZIP files,
+ * both in one go (as SRAM is saved and loaded) and in
+ * small pieces (as the save state task does), checks
+ * that both produce the same file and the same data,
+ * and reports the time taken for a large state. Also
+ * checks that damaged files are rejected. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <retro_miscellaneous.h>
+#include <file/file_path.h>
+#include <streams/file_stream.h>
+#include <streams/rzip_stream.h>
+
+/* Size of the pieces the save state task
+ * reads and writes */
+#define TASK_PIECE_SIZE (4096 * 10)
+
+static uint64_t get_time_usec(void)
+{
+#if defined(CLOCK_MONOTONIC)
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#else
+   return (uint64_t)clock() * 1000000 / CLOCKS_PER_SEC;
+#endif
+}
+
+/* Fills 'data' with something resembling a save state:
+ * runs of zeros, repeated tables and noisy regions */
+static void generate_data(uint8_t *data, size_t len, uint32_t seed)
+{
+   size_t pos = 0;
+
+   while (pos < len)
+   {
+      size_t i;
+      size_t run = 256 + (seed % 65536);
+
+      if (run > len - pos)
+         run = len - pos;
+
+      switch ((seed >> 16) % 3)
+      {
+         case 0:
+            memset(data + pos, 0, run);
+            break;
+         case 1:
+            for (i = 0; i < run; i++)
+               data[pos + i] = (uint8_t)(i * 7 + (i >> 5));
+            break;
+         default:
+            for (i = 0; i < run; i++)
+            {
+               seed ^= seed << 13;
+               seed ^= seed >> 17;
+               seed ^= seed << 5;
+               data[pos + i] = (uint8_t)(seed & 0x3F);
+            }
+            break;
+      }
+
+      pos  += run;
+      seed ^= seed << 13;
+      seed ^= seed >> 17;
+      seed ^= seed << 5;
+   }
+}
+
+/* Writes 'data' in pieces of random size
+ * (or of TASK_PIECE_SIZE if 'task_pieces' is set) */
+static bool write_pieces(const char *path, const uint8_t *data,
+      int64_t len, bool task_pieces)
+{
+   int64_t pos          = 0;
+   rzipstream_t *stream = rzipstream_open(path, RETRO_VFS_FILE_ACCESS_WRITE);
+
+   if (!stream)
+      return false;
+
+   while (pos < len)
+   {
+      int64_t piece = task_pieces ? TASK_PIECE_SIZE : 1 + rand() % 300000;
+
+      if (piece > len - pos)
+         piece = len - pos;
+
+      if (rzipstream_write(stream, data + pos, piece) != piece)
+      {
+         rzipstream_close(stream);
+         return false;
+      }
+
+      pos += piece;
+   }
+
+   return rzipstream_close(stream) == 0;
+}
+
+/* Reads the file in pieces of random size (or of
+ * TASK_PIECE_SIZE if 'task_pieces' is set), going
+ * back to the start once along the way unless
+ * reading task pieces */
+static bool read_pieces(const char *path, const uint8_t *expected,
+      int64_t len, bool task_pieces)
+{
+   uint8_t buf[TASK_PIECE_SIZE];
+   int64_t pos          = 0;
+   int64_t rewind_at    = task_pieces ? -1 : len / 2;
+   bool ok              = false;
+   rzipstream_t *stream = rzipstream_open(path, RETRO_VFS_FILE_ACCESS_READ);
+
+   if (!stream || rzipstream_get_size(stream) != len)
+      goto end;
+
+   while (pos < len)
+   {
+      int64_t piece = task_pieces ? TASK_PIECE_SIZE : 1 + rand() % sizeof(buf);
+
+      if (piece > len - pos)
+         piece = len - pos;
+
+      if (     rzipstream_read(stream, buf, piece) != piece
+            || memcmp(buf, expected + pos, (size_t)piece))
+         goto end;
+
+      pos += piece;
+
+      if (rewind_at >= 0 && pos >= rewind_at)
+      {
+         rzipstream_rewind(stream);
+         rewind_at = -1;
+         pos       = 0;
+      }
+   }
+
+   ok = rzipstream_eof(stream) == EOF
+      && rzipstream_read(stream, buf, 1) == 0;
+
+end:
+   if (stream)
+      rzipstream_close(stream);
+   return ok;
+}
+
+static bool read_whole(const char *path, const uint8_t *expected,
+      int64_t len)
+{
+   void *data   = NULL;
+   int64_t size = 0;
+   bool ok      = false;
+
+   if (rzipstream_read_file(path, &data, &size))
+      ok = size == len && !memcmp(data, expected, (size_t)len)
+         && ((uint8_t*)data)[len] == '\0';
+
+   free(data);
+   return ok;
+}
+
+static bool same_files(const char *path_a, const char *path_b)
+{
+   void *a      = NULL;
+   void *b      = NULL;
+   int64_t len_a = 0;
+   int64_t len_b = 0;
+   bool same    = filestream_read_file(path_a, &a, &len_a)
+      && filestream_read_file(path_b, &b, &len_b)
+      && len_a == len_b && !memcmp(a, b, (size_t)len_a);
+
+   free(a);
+   free(b);
+   return same;
+}
+
+/* Round-trips 'len' bytes of generated data
+ * every way there is */
+static unsigned check_size(const char *dir, int64_t len)
+{
+   char whole_path[PATH_MAX_LENGTH];
+   char pieces_path[PATH_MAX_LENGTH];
+   unsigned failed = 0;
+   uint8_t *data   = (uint8_t*)malloc((size_t)len);
+
+   if (!data)
+      return 1;
+
+   fill_pathname_join(whole_path,  dir, "whole.rzip",  sizeof(whole_path));
+   fill_pathname_join(pieces_path, dir, "pieces.rzip", sizeof(pieces_path));
+
+   generate_data(data, (size_t)len, 2463534242U + (uint32_t)len);
+
+   if (     !rzipstream_write_file(whole_path, data, len)
+         || !write_pieces(pieces_path, data, len, false))
+   {
+      printf("[ERROR]: Failed to write %u bytes\n", (unsigned)len);
+      failed++;
+   }
+   else if (!same_files(whole_path, pieces_path))
+   {
+      printf("[ERROR]: Files of %u bytes differ\n", (unsigned)len);
+      failed++;
+   }
+   else if (!read_whole(whole_path, data, len)
+         || !read_pieces(whole_path, data, len, false))
+   {
+      printf("[ERROR]: Wrong content read from %u bytes\n", (unsigned)len);
+      failed++;
+   }
+
+   free(data);
+   return failed;
+}
+
+/* Damages the file in random places and reads it
+ * back; reading must fail or return data of the
+ * expected size, and must not crash */
+static unsigned check_damage(const char *dir, unsigned rounds)
+{
+   unsigned i;
+   char path[PATH_MAX_LENGTH];
+   char damaged_path[PATH_MAX_LENGTH];
+   void *file         = NULL;
+   int64_t file_len   = 0;
+   int64_t len        = 1000000;
+   unsigned failed    = 0;
+   uint8_t *data      = (uint8_t*)malloc((size_t)len);
+
+   fill_pathname_join(path,         dir, "whole.rzip",   sizeof(path));
+   fill_pathname_join(damaged_path, dir, "damaged.rzip", sizeof(damaged_path));
+
+   generate_data(data, (size_t)len, 88172645U);
+
+   if (     !rzipstream_write_file(path, data, len)
+         || !filestream_read_file(path, &file, &file_len))
+   {
+      free(data);
+      return 1;
+   }
+
+   for (i = 0; i < rounds; i++)
+   {
+      unsigned j;
+      void *out        = NULL;
+      int64_t out_len  = 0;
+      uint8_t *damaged = (uint8_t*)malloc((size_t)file_len);
+
+      memcpy(damaged, file, (size_t)file_len);
+
+      for (j = 0; j < 1 + i % 4; j++)
+         damaged[rand() % file_len] ^= (uint8_t)(1 + rand() % 255);
+
+      filestream_write_file(damaged_path, damaged,
+            (i % 8) ? file_len : rand() % file_len);
+
+      if (rzipstream_read_file(damaged_path, &out, &out_len))
+      {
+         rzipstream_t *stream = rzipstream_open(damaged_path,
+               RETRO_VFS_FILE_ACCESS_READ);
+         int64_t size         = stream ? rzipstream_get_size(stream) : -1;
+
+         if (stream)
+            rzipstream_close(stream);
+
+         if (out_len > size)
+         {
+            printf("[ERROR]: Read %u bytes from damaged file of %u\n",
+                  (unsigned)out_len, (unsigned)size);
+            failed++;
+         }
+      }
+
+      free(out);
+      free(damaged);
+   }
+
+   free(file);
+   free(data);
+   return failed;
+}
+
+/* Saves and loads a state of 'len' bytes as SRAM
+ * and the save state task do, and reports the time
+ * taken */
+static unsigned time_state(const char *dir, int64_t len, unsigned runs)
+{
+   unsigned i;
+   char path[PATH_MAX_LENGTH];
+   uint64_t save_whole  = (uint64_t)-1;
+   uint64_t load_whole  = (uint64_t)-1;
+   uint64_t save_pieces = (uint64_t)-1;
+   uint64_t load_pieces = (uint64_t)-1;
+   unsigned failed      = 0;
+   uint8_t *data        = (uint8_t*)malloc((size_t)len);
+
+   if (!data)
+      return 1;
+
+   fill_pathname_join(path, dir, "state.rzip", sizeof(path));
+   generate_data(data, (size_t)len, 2463534242U);
+
+   for (i = 0; i < runs; i++)
+   {
+      void *out    = NULL;
+      int64_t size = 0;
+      uint64_t t   = get_time_usec();
+
+      if (!rzipstream_write_file(path, data, len))
+         failed++;
+      t = get_time_usec() - t;
+      if (t < save_whole)
+         save_whole = t;
+
+      t = get_time_usec();
+      if (     !rzipstream_read_file(path, &out, &size)
+            || size != len
+            || memcmp(out, data, (size_t)len))
+         failed++;
+      t = get_time_usec() - t;
+      if (t < load_whole)
+         load_whole = t;
+      free(out);
+
+      t = get_time_usec();
+      if (!write_pieces(path, data, len, true))
+         failed++;
+      t = get_time_usec() - t;
+      if (t < save_pieces)
+         save_pieces = t;
+
+      t = get_time_usec();
+      if (!read_pieces(path, data, len, true))
+         failed++;
+      t = get_time_usec() - t;
+      if (t < load_pieces)
+         load_pieces = t;
+   }
+
+   printf("%u MB state, best of %u:\n", (unsigned)(len >> 20), runs);
+   printf("   rzipstream_write_file: %8.2f ms\n", save_whole  / 1000.0);
+   printf("   rzipstream_read_file:  %8.2f ms\n", load_whole  / 1000.0);
+   printf("   %u byte writes:      %8.2f ms\n", TASK_PIECE_SIZE,
+         save_pieces / 1000.0);
+   printf("   %u byte reads:       %8.2f ms\n", TASK_PIECE_SIZE,
+         load_pieces / 1000.0);
+
+   if (failed)
+      printf("[ERROR]: %u round trips of the state failed\n", failed);
+
+   free(data);
+   return failed;
+}
+
+int main(int argc, char *argv[])
+{
+   size_t i;
+   static const int64_t sizes[] = {
+      1, 1000, 131071, 131072, 131073, 262144, 1000000,
+      131072 * 33, 131072 * 33 + 17, 131072 * 100 - 1
+   };
+   unsigned failed = 0;
+   unsigned mb     = (argc > 2) ? (unsigned)atoi(argv[2]) : 64;
+   unsigned runs   = (argc > 3) ? (unsigned)atoi(argv[3]) : 3;
+
+   if (argc < 2 || !mb || !runs)
+   {
+      printf("Usage: %s <work directory> [state MB] [runs]\n", argv[0]);
+      return 1;
+   }
+
+   srand(1);
+
+   for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+      failed += check_size(argv[1], sizes[i]);
+
+   failed += check_damage(argv[1], 200);
+   failed += time_state(argv[1], (int64_t)mb << 20, runs);
+
+   if (failed)
+   {
+      printf("[ERROR]: %u checks failed\n", failed);
+      return 1;
+   }
+
+   printf("[SUCCESS]: All checks passed\n");
+   return 0;
+}
@@ -0,0 +1,115 @@
+#!/bin/sh
+# Builds fixture archives, serves them from a local HTTP
+# server and checks that zip_stream_test extracts each of
+# them (downloaded and from file) exactly like Python's
+# zipfile does, and that corrupt or unsupported archives
+# fail without leaving partial files behind.
+#
+# Requires python3. Usage: ./test.sh [port]
+
+PORT=${1:-8765}
+TEST=$(cd "$(dirname "$0")" && pwd)/zip_stream_test
+WORK=$(mktemp -d)
+FAILED=0
+
+trap 'kill $SERVER 2>/dev/null; rm -rf "$WORK"' EXIT
+
+cd "$WORK" || exit 1
+mkdir fixtures
+
+python3 - <<'EOF'
+import os, random, zipfile
+
+random.seed(1)
+def data(size):
+    words = [bytes(random.randrange(256) for _ in range(16)) for _ in range(64)]
+    return b''.join(random.choice(words) for _ in range(size // 16))[:size]
+
+core = data(3 * 1024 * 1024)
+
+with zipfile.ZipFile('fixtures/core.zip', 'w', zipfile.ZIP_DEFLATED) as z:
+    z.writestr('test_libretro.so', core)
+
+with zipfile.ZipFile('fixtures/assets.zip', 'w') as z:
+    z.writestr('assets/', b'')
+    z.writestr('assets/xmb/empty.png', b'', zipfile.ZIP_STORED)
+    z.writestr('assets/xmb/stored.bin', data(100000), zipfile.ZIP_STORED)
+    z.writestr('assets/xmb/deflated.bin', data(500000), zipfile.ZIP_DEFLATED)
+    z.writestr('assets/readme.txt', b'x' * 70000, zipfile.ZIP_DEFLATED)
+    z.writestr('assets/random.bin', os.urandom(50000), zipfile.ZIP_DEFLATED)
+
+# Written to a pipe, so sizes and CRCs follow the data
+# in data descriptors
+r, w = os.pipe()
+if os.fork() == 0:
+    os.close(r)
+    with os.fdopen(w, 'wb') as f:
+        with zipfile.ZipFile(f, 'w', zipfile.ZIP_DEFLATED) as z:
+            with z.open('streamed/one.bin', 'w') as e:
+                e.write(data(200000))
+            with z.open('streamed/two.bin', 'w') as e:
+                e.write(b'')
+    os._exit(0)
+os.close(w)
+with os.fdopen(r, 'rb') as f:
+    streamed = f.read()
+os.wait()
+open('fixtures/streamed.zip', 'wb').write(streamed)
+
+buf = bytearray(open('fixtures/core.zip', 'rb').read())
+buf[len(buf) // 2] ^= 0xFF
+open('fixtures/bad_data.zip', 'wb').write(buf)
+
+with zipfile.ZipFile('fixtures/bad_crc.zip', 'w', zipfile.ZIP_STORED) as z:
+    z.writestr('bad_crc.bin', data(1000))
+buf = bytearray(open('fixtures/bad_crc.zip', 'rb').read())
+buf[14] ^= 0xFF
+open('fixtures/bad_crc.zip', 'wb').write(buf)
+
+with zipfile.ZipFile('fixtures/bzip2.zip', 'w', zipfile.ZIP_BZIP2) as z:
+    z.writestr('bzip2.bin', data(1000))
+
+with zipfile.ZipFile('fixtures/unsafe.zip', 'w') as z:
+    z.writestr('../unsafe.bin', b'unsafe')
+EOF
+
+python3 -m http.server "$PORT" --bind 127.0.0.1 -d fixtures >/dev/null 2>&1 &
+SERVER=$!
+sleep 1
+
+check()
+{
+   if [ "$1" -ne 0 ]; then
+      echo "[FAILED]: $2"
+      FAILED=1
+   fi
+}
+
+for name in core assets streamed; do
+   python3 -c "import sys, zipfile; zipfile.ZipFile(sys.argv[1]).extractall(sys.argv[2])" \
+      "fixtures/$name.zip" "expected_$name"
+
+   for source in "http://127.0.0.1:$PORT/$name.zip" "fixtures/$name.zip"; do
+      rm -rf out
+      "$TEST" "$source" out
+      check $? "$source"
+      diff -r "expected_$name" out >/dev/null
+      check $? "$source: extracted files differ"
+   done
+done
+
+for name in bad_data bad_crc bzip2 unsafe missing; do
+   rm -rf out
+   "$TEST" "http://127.0.0.1:$PORT/$name.zip" out/dir
+   [ $? -ne 0 ]
+   check $? "$name.zip: extracted"
+   [ -z "$(find out -type f 2>/dev/null)" ] && [ ! -e out/unsafe.bin ]
+   check $? "$name.zip: files left behind"
+done
+
+if [ $FAILED -ne 0 ]; then
+   echo "[ERROR]: Some checks failed"
+   exit 1
+fi
+
+echo "[SUCCESS]: All checks passed"
@@ -0,0 +1,172 @@
+/* Copyright  (C) 2010-2020 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (zip_stream_test.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Extracts a zip archive with zip_stream, either
+ * while downloading it (when given an http:// URL)
+ * or from a file, handing the stream pieces of
+ * random size to exercise headers that are split
+ * across writes. test.sh runs this against a local
+ * HTTP server serving a set of fixture archives. */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include <string/stdstring.h>
+#include <streams/file_stream.h>
+#include <streams/zip_stream.h>
+#include <net/net_http.h>
+#include <net/net_compat.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#endif
+
+static bool extract_download(zipstream_t *stream, const char *url,
+      size_t *total)
+{
+   struct http_connection_t *conn = NULL;
+   struct http_t *http            = NULL;
+   bool extracted                 = true;
+   bool done                      = false;
+   size_t used                    = 0;
+
+   if (!network_init())
+      return false;
+
+   if (!(conn = net_http_connection_new(url, "GET", NULL)))
+      return false;
+
+   while (!net_http_connection_iterate(conn)) {}
+
+   if (!net_http_connection_done(conn))
+   {
+      net_http_connection_free(conn);
+      return false;
+   }
+
+   http = net_http_new(conn);
+   net_http_connection_free(conn);
+
+   if (!http)
+      return false;
+
+   while (!done)
+   {
+      size_t len    = 0;
+      uint8_t *data = NULL;
+
+      done = net_http_update(http, NULL, NULL);
+      data = net_http_data_received(http, &len);
+
+      if (data && len > used)
+      {
+         extracted = zipstream_write(stream, data + used, len - used);
+         used      = len;
+      }
+   }
+
+   if (net_http_error(http))
+   {
+      printf("HTTP status %d\n", net_http_status(http));
+      extracted = false;
+   }
+
+   *total = used;
+
+   /* The body is owned by the caller once the
+    * transfer has ended */
+   free(net_http_data(http, NULL, true));
+   net_http_delete(http);
+   network_deinit();
+
+   return extracted;
+}
+
+static bool extract_file(zipstream_t *stream, const char *path,
+      size_t *total)
+{
+   void *data      = NULL;
+   int64_t len     = 0;
+   int64_t pos     = 0;
+   bool extracted  = true;
+
+   if (!filestream_read_file(path, &data, &len))
+      return false;
+
+   while (pos < len && extracted)
+   {
+      int64_t piece = 1 + rand() % 4096;
+
+      if (piece > len - pos)
+         piece = len - pos;
+
+      extracted = zipstream_write(stream, (uint8_t*)data + pos,
+            (size_t)piece);
+      pos      += piece;
+   }
+
+   *total = (size_t)len;
+
+   free(data);
+   return extracted;
+}
+
+int main(int argc, char *argv[])
+{
+   zipstream_t *stream = NULL;
+   size_t total        = 0;
+   bool extracted      = false;
+
+   if (argc < 3)
+   {
+      printf("Usage: %s <archive or http:// URL> <output directory>\n",
+            argv[0]);
+      return 1;
+   }
+
+   if (!(stream = zipstream_new(argv[2])))
+   {
+      printf("[ERROR]: Failed to create stream\n");
+      return 1;
+   }
+
+   srand(1);
+
+   if (string_starts_with_size(argv[1], "http://", STRLEN_CONST("http://")))
+      extracted = extract_download(stream, argv[1], &total);
+   else
+      extracted = extract_file(stream, argv[1], &total);
+
+   extracted = extracted && zipstream_is_done(stream);
+   zipstream_free(stream);
+
+   if (!extracted)
+   {
+      printf("[ERROR]: Failed to extract %s (%u bytes)\n",
+            argv[1], (unsigned)total);
+      return 1;
+   }
+
+   printf("[SUCCESS]: Extracted %s (%u bytes)\n", argv[1], (unsigned)total);
+   return 0;
+}
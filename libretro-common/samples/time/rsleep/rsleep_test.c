@@ -0,0 +1,92 @@
+/* Copyright  (C) 2010-2020 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (rsleep_test.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Paces a loop at a fixed frame period, the way the frame
+ * limiter does, and prints the wake-up lateness histogram
+ * for millisecond sleeps (the previous limiter behaviour)
+ * and for rsleep_until() with increasing spin times. */
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <retro_timers.h>
+#include <features/features_cpu.h>
+#include <time/rsleep.h>
+
+static void run_ms_sleep(unsigned frames, int64_t period,
+      rsleep_jitter_t *jitter)
+{
+   unsigned i;
+   int64_t deadline = cpu_features_get_time_usec();
+
+   for (i = 0; i < frames; i++)
+   {
+      int64_t to_sleep_ms;
+
+      deadline   += period;
+      to_sleep_ms = (deadline - cpu_features_get_time_usec()) / 1000;
+      if (to_sleep_ms > 0)
+         retro_sleep((unsigned)to_sleep_ms);
+      rsleep_jitter_add(jitter, cpu_features_get_time_usec() - deadline);
+   }
+}
+
+static void run_rsleep(unsigned frames, int64_t period,
+      unsigned spin_usec, rsleep_jitter_t *jitter)
+{
+   unsigned i;
+   int64_t deadline = cpu_features_get_time_usec();
+
+   for (i = 0; i < frames; i++)
+   {
+      deadline += period;
+      rsleep_until(deadline, spin_usec, jitter);
+   }
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned i;
+   char text[1024];
+   rsleep_jitter_t jitter;
+   static const unsigned spins[] = { 0, 100, 200, 500, 1000 };
+   unsigned frames = (argc > 1) ? (unsigned)atoi(argv[1]) : 300;
+   int64_t period  = (argc > 2) ? atoi(argv[2]) : 16667;
+
+   printf("%u frames of %u usec\n\n", frames, (unsigned)period);
+
+   rsleep_jitter_reset(&jitter);
+   run_ms_sleep(frames, period, &jitter);
+   rsleep_jitter_to_string(&jitter, text, sizeof(text));
+   printf("retro_sleep (ms): %s\n", text);
+
+   for (i = 0; i < sizeof(spins) / sizeof(spins[0]); i++)
+   {
+      rsleep_jitter_reset(&jitter);
+      run_rsleep(frames, period, spins[i], &jitter);
+      rsleep_jitter_to_string(&jitter, text, sizeof(text));
+      printf("rsleep_until, spin %4u usec: %s\n", spins[i], text);
+   }
+
+   return 0;
+}
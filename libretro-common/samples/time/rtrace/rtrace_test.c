@@ -0,0 +1,116 @@
+/* Copyright  (C) 2010-2020 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (rtrace_test.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Measures the cost of a begin/end pair with tracing paused
+ * and recording, then has several threads record nested
+ * slices while the main thread dumps their rings, which
+ * exercises the dropping of events overwritten mid-dump.
+ * The resulting JSON files open in chrome://tracing. */
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <features/features_cpu.h>
+#include <retro_timers.h>
+#include <rthreads/rthreads.h>
+#include <time/rtrace.h>
+
+#define THREADS 4
+
+static const char *thread_names[THREADS] = {
+   "worker 0", "worker 1", "worker 2", "worker 3"
+};
+
+static volatile bool quit = false;
+
+static void worker(void *data)
+{
+   const char *name = (const char*)data;
+
+   rtrace_thread_name(name);
+
+   while (!quit)
+   {
+      RTRACE_BEGIN("outer");
+      RTRACE_BEGIN("inner");
+      RTRACE_END("inner");
+      RTRACE_INSTANT("tick");
+      RTRACE_END("outer");
+   }
+}
+
+static double time_pairs(unsigned count)
+{
+   unsigned i;
+   retro_time_t start = cpu_features_get_time_usec();
+
+   for (i = 0; i < count; i++)
+   {
+      RTRACE_BEGIN("pair");
+      RTRACE_END("pair");
+   }
+
+   return (double)(cpu_features_get_time_usec() - start) * 1000.0 / count;
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned i;
+   sthread_t *threads[THREADS];
+   unsigned pairs = (argc > 1) ? (unsigned)atoi(argv[1]) : 1000000;
+
+   if (!rtrace_init(0))
+   {
+      printf("[ERROR]: rtrace_init failed\n");
+      return 1;
+   }
+
+   rtrace_thread_name("main");
+
+   rtrace_set_paused(true);
+   printf("Paused:    %6.2f ns per begin/end pair\n", time_pairs(pairs));
+   rtrace_set_paused(false);
+   printf("Recording: %6.2f ns per begin/end pair\n", time_pairs(pairs));
+
+   for (i = 0; i < THREADS; i++)
+      threads[i] = sthread_create(worker, (void*)thread_names[i]);
+
+   retro_sleep(50);
+
+   if (!rtrace_dump("rtrace_running.json"))
+      printf("[ERROR]: Failed to write rtrace_running.json\n");
+   else
+      printf("Wrote rtrace_running.json while %d threads were recording\n",
+            THREADS);
+
+   quit = true;
+   for (i = 0; i < THREADS; i++)
+      sthread_join(threads[i]);
+
+   if (!rtrace_dump("rtrace_final.json"))
+      printf("[ERROR]: Failed to write rtrace_final.json\n");
+   else
+      printf("Wrote rtrace_final.json\n");
+
+   rtrace_deinit();
+   return 0;
+}
@@ -35,6 +35,13 @@
 #define SUBCODE_SIZE 96
 #define TRACK_PAD 4
 
+/* Decompressed hunks kept around for seeks and
+ * re-reads (a CD hunk is 8 sectors, ~19 KB) */
+#define CHDSTREAM_CACHE_HUNKS 16
+/* Hunks decompressed ahead of sequential reads,
+ * e.g. while streaming audio tracks */
+#define CHDSTREAM_READ_AHEAD_HUNKS 4
+
 struct chdstream
 {
    chd_file *chd;
@@ -259,6 +266,10 @@ chdstream_t *chdstream_open(const char *path, int32_t track)
    if (meta.pgtype[0] != 'V')
       pregap               = meta.pregap;
 
+   /* Caching is an optimisation only, carry on without it */
+   if (chd_set_hunk_cache(chd, CHDSTREAM_CACHE_HUNKS) == CHDERR_NONE)
+      chd_set_read_ahead(chd, CHDSTREAM_READ_AHEAD_HUNKS);
+
    stream->chd             = chd;
    stream->frames_per_hunk = hd->hunkbytes / hd->unitbytes;
    stream->track_frame     = meta.frame_offset;
@@ -21,6 +21,7 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 
 #include <streams/interface_stream.h>
 #include <streams/file_stream.h>
@@ -31,6 +32,11 @@
 #if defined(HAVE_ZLIB)
 #include <streams/rzip_stream.h>
 #endif
+#if defined(HAVE_ZLIB) && defined(HAVE_COMPRESSION)
+#include <retro_miscellaneous.h>
+#include <file/archive_file.h>
+#include <file/file_path.h>
+#endif
 #include <encodings/crc32.h>
 
 struct intfstream_internal
@@ -62,10 +68,49 @@ struct intfstream_internal
    {
       rzipstream_t *fp;
    } rzip;
+#endif
+#if defined(HAVE_ZLIB) && defined(HAVE_COMPRESSION)
+   struct
+   {
+      file_archive_zip_reader_t *fp;
+   } zip;
 #endif
    enum intfstream_type type;
 };
 
+#if defined(HAVE_ZLIB) && defined(HAVE_COMPRESSION)
+/* Opens the member named after the archive
+ * delimiter of 'path' */
+static file_archive_zip_reader_t *intfstream_zip_member_open(
+      const char *path)
+{
+   char archive_path[PATH_MAX_LENGTH];
+   file_archive_zip_reader_t *reader       = NULL;
+   file_archive_zip_index_t *index         = NULL;
+   const char *member_path                 = path_get_archive_delim(path);
+   size_t archive_path_len;
+
+   if (!member_path)
+      return NULL;
+
+   archive_path_len = member_path - path;
+   if (archive_path_len >= sizeof(archive_path))
+      return NULL;
+
+   memcpy(archive_path, path, archive_path_len);
+   archive_path[archive_path_len] = '\0';
+
+   if (!(index = file_archive_zip_index_open(archive_path)))
+      return NULL;
+
+   reader = file_archive_zip_reader_open(archive_path,
+         file_archive_zip_index_find(index, member_path + 1));
+
+   file_archive_zip_index_close(index);
+   return reader;
+}
+#endif
+
 int64_t intfstream_get_size(intfstream_internal_t *intf)
 {
    if (!intf)
@@ -88,6 +133,12 @@ int64_t intfstream_get_size(intfstream_internal_t *intf)
          return rzipstream_get_size(intf->rzip.fp);
 #else
          break;
+#endif
+      case INTFSTREAM_ZIP:
+#if defined(HAVE_ZLIB) && defined(HAVE_COMPRESSION)
+         return file_archive_zip_reader_get_size(intf->zip.fp);
+#else
+         break;
 #endif
    }
 
@@ -115,6 +166,7 @@ bool intfstream_resize(intfstream_internal_t *intf, intfstream_info_t *info)
 #endif
          break;
       case INTFSTREAM_RZIP:
+      case INTFSTREAM_ZIP:
          /* Unsupported */
          return false;
    }
@@ -157,6 +209,17 @@ bool intfstream_open(intfstream_internal_t *intf, const char *path,
          break;
 #else
          return false;
+#endif
+      case INTFSTREAM_ZIP:
+#if defined(HAVE_ZLIB) && defined(HAVE_COMPRESSION)
+         if (mode != RETRO_VFS_FILE_ACCESS_READ)
+            return false;
+         intf->zip.fp = intfstream_zip_member_open(path);
+         if (!intf->zip.fp)
+            return false;
+         break;
+#else
+         return false;
 #endif
    }
 
@@ -175,6 +238,7 @@ int intfstream_flush(intfstream_internal_t *intf)
       case INTFSTREAM_MEMORY:
       case INTFSTREAM_CHD:
       case INTFSTREAM_RZIP:
+      case INTFSTREAM_ZIP:
          /* Should we stub this for these interfaces? */
          break;
    }
@@ -207,6 +271,12 @@ int intfstream_close(intfstream_internal_t *intf)
 #if defined(HAVE_ZLIB)
          if (intf->rzip.fp)
             return rzipstream_close(intf->rzip.fp);
+#endif
+         return 0;
+      case INTFSTREAM_ZIP:
+#if defined(HAVE_ZLIB) && defined(HAVE_COMPRESSION)
+         if (intf->zip.fp)
+            file_archive_zip_reader_close(intf->zip.fp);
 #endif
          return 0;
    }
@@ -238,6 +308,9 @@ void *intfstream_init(intfstream_info_t *info)
 #ifdef HAVE_ZLIB
    intf->rzip.fp         = NULL;
 #endif
+#if defined(HAVE_ZLIB) && defined(HAVE_COMPRESSION)
+   intf->zip.fp          = NULL;
+#endif
 
    switch (intf->type)
    {
@@ -256,6 +329,7 @@ void *intfstream_init(intfstream_info_t *info)
          goto error;
 #endif
       case INTFSTREAM_RZIP:
+      case INTFSTREAM_ZIP:
          break;
    }
 
@@ -304,6 +378,22 @@ int64_t intfstream_seek(
       case INTFSTREAM_RZIP:
          /* Unsupported */
          break;
+      case INTFSTREAM_ZIP:
+#if defined(HAVE_ZLIB) && defined(HAVE_COMPRESSION)
+         switch (whence)
+         {
+            case SEEK_CUR:
+               offset += file_archive_zip_reader_tell(intf->zip.fp);
+               break;
+            case SEEK_END:
+               offset += file_archive_zip_reader_get_size(intf->zip.fp);
+               break;
+         }
+         return file_archive_zip_reader_seek(intf->zip.fp, offset) < 0
+            ? -1 : 0;
+#else
+         break;
+#endif
    }
 
    return -1;
@@ -331,6 +421,12 @@ int64_t intfstream_read(intfstream_internal_t *intf, void *s, uint64_t len)
          return rzipstream_read(intf->rzip.fp, s, len);
 #else
          break;
+#endif
+      case INTFSTREAM_ZIP:
+#if defined(HAVE_ZLIB) && defined(HAVE_COMPRESSION)
+         return file_archive_zip_reader_read(intf->zip.fp, s, len);
+#else
+         break;
 #endif
    }
 
@@ -357,6 +453,8 @@ int64_t intfstream_write(intfstream_internal_t *intf,
 #else
          return -1;
 #endif
+      case INTFSTREAM_ZIP:
+         return -1;
    }
 
    return 0;
@@ -391,6 +489,8 @@ int intfstream_printf(intfstream_internal_t *intf,
 #else
          return -1;
 #endif
+      case INTFSTREAM_ZIP:
+         return -1;
    }
 
    return 0;
@@ -411,6 +511,8 @@ int64_t intfstream_get_ptr(intfstream_internal_t* intf)
          return -1;
       case INTFSTREAM_RZIP:
          return -1;
+      case INTFSTREAM_ZIP:
+         return -1;
    }
 
    return 0;
@@ -441,6 +543,34 @@ char *intfstream_gets(intfstream_internal_t *intf,
          return rzipstream_gets(intf->rzip.fp, buffer, (size_t)len);
 #else
          break;
+#endif
+      case INTFSTREAM_ZIP:
+#if defined(HAVE_ZLIB) && defined(HAVE_COMPRESSION)
+         {
+            uint64_t i = 0;
+
+            if (!buffer || !len)
+               return NULL;
+
+            /* Read until end of line or end of member */
+            while (i + 1 < len)
+            {
+               int c = intfstream_getc(intf);
+
+               if (c == EOF)
+                  break;
+
+               buffer[i++] = (char)c;
+
+               if (c == '\n')
+                  break;
+            }
+
+            buffer[i] = '\0';
+            return i ? buffer : NULL;
+         }
+#else
+         break;
 #endif
    }
 
@@ -469,6 +599,17 @@ int intfstream_getc(intfstream_internal_t *intf)
          return rzipstream_getc(intf->rzip.fp);
 #else
          break;
+#endif
+      case INTFSTREAM_ZIP:
+#if defined(HAVE_ZLIB) && defined(HAVE_COMPRESSION)
+         {
+            uint8_t c = 0;
+            if (file_archive_zip_reader_read(intf->zip.fp, &c, 1) == 1)
+               return c;
+            return EOF;
+         }
+#else
+         break;
 #endif
    }
 
@@ -497,6 +638,12 @@ int64_t intfstream_tell(intfstream_internal_t *intf)
          return (int64_t)rzipstream_tell(intf->rzip.fp);
 #else
          break;
+#endif
+      case INTFSTREAM_ZIP:
+#if defined(HAVE_ZLIB) && defined(HAVE_COMPRESSION)
+         return file_archive_zip_reader_tell(intf->zip.fp);
+#else
+         break;
 #endif
    }
 
@@ -525,6 +672,13 @@ int intfstream_eof(intfstream_internal_t *intf)
          return rzipstream_eof(intf->rzip.fp);
 #else
          break;
+#endif
+      case INTFSTREAM_ZIP:
+#if defined(HAVE_ZLIB) && defined(HAVE_COMPRESSION)
+         return file_archive_zip_reader_tell(intf->zip.fp)
+            >= file_archive_zip_reader_get_size(intf->zip.fp);
+#else
+         break;
 #endif
    }
 
@@ -549,6 +703,11 @@ void intfstream_rewind(intfstream_internal_t *intf)
       case INTFSTREAM_RZIP:
 #if defined(HAVE_ZLIB)
          rzipstream_rewind(intf->rzip.fp);
+#endif
+         break;
+      case INTFSTREAM_ZIP:
+#if defined(HAVE_ZLIB) && defined(HAVE_COMPRESSION)
+         file_archive_zip_reader_seek(intf->zip.fp, 0);
 #endif
          break;
    }
@@ -575,6 +734,8 @@ void intfstream_putc(intfstream_internal_t *intf, int c)
 #else
          break;
 #endif
+      case INTFSTREAM_ZIP:
+         break;
    }
 }
 
@@ -623,26 +784,37 @@ bool intfstream_is_compressed(intfstream_internal_t *intf)
 #else
          break;
 #endif
+      case INTFSTREAM_ZIP:
+         return true;
    }
 
    return false;
 }
 
+/* Large enough for reads to cost less than hashing */
+#define INTFSTREAM_CRC_BUFFER_SIZE 65536
+
 bool intfstream_get_crc(intfstream_internal_t *intf, uint32_t *crc)
 {
    int64_t data_read    = 0;
    uint32_t accumulator = 0;
-   uint8_t buffer[4096];
+   uint8_t *buffer      = NULL;
 
    if (!intf || !crc)
       return false;
 
+   if (!(buffer = (uint8_t*)malloc(INTFSTREAM_CRC_BUFFER_SIZE)))
+      return false;
+
    /* Ensure we start at the beginning of the file */
    intfstream_rewind(intf);
 
-   while ((data_read = intfstream_read(intf, buffer, sizeof(buffer))) > 0)
+   while ((data_read = intfstream_read(intf, buffer,
+               INTFSTREAM_CRC_BUFFER_SIZE)) > 0)
       accumulator = encoding_crc32(accumulator, buffer, (size_t)data_read);
 
+   free(buffer);
+
    if (data_read < 0)
       return false;
 
@@ -766,6 +938,32 @@ error:
    return NULL;
 }
 
+intfstream_t *intfstream_open_zip_member(const char *path,
+      unsigned mode)
+{
+   intfstream_info_t info;
+   intfstream_t *fd = NULL;
+
+   info.type        = INTFSTREAM_ZIP;
+   fd               = (intfstream_t*)intfstream_init(&info);
+
+   if (!fd)
+      return NULL;
+
+   if (!intfstream_open(fd, path, mode, RETRO_VFS_FILE_ACCESS_HINT_NONE))
+      goto error;
+
+   return fd;
+
+error:
+   if (fd)
+   {
+      intfstream_close(fd);
+      free(fd);
+   }
+   return NULL;
+}
+
 intfstream_t* intfstream_open_rzip_file(const char *path,
       unsigned mode)
 {
@@ -20,6 +20,7 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
+#include <retro_miscellaneous.h>
 #include <string/stdstring.h>
 #include <file/file_path.h>
 
@@ -28,6 +29,11 @@
 
 #include <streams/rzip_stream.h>
 
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#include <features/features_cpu.h>
+#endif
+
 /* Current RZIP file format version */
 #define RZIP_VERSION 1
 
@@ -44,6 +50,71 @@
 #define RZIP_HEADER_SIZE 20
 #define RZIP_CHUNK_HEADER_SIZE 4
 
+/* Chunks are independent zlib streams, so a batch
+ * of them can be (de)compressed in parallel
+ * > One thread per CPU core, up to RZIP_MAX_THREADS
+ *   (RZIP_THREADS may be defined to override this)
+ * > Each batch holds RZIP_BATCH_CHUNKS_PER_THREAD
+ *   chunks per thread, up to RZIP_MAX_BATCH_SIZE
+ *   bytes of uncompressed data */
+#define RZIP_MAX_THREADS 8
+#define RZIP_BATCH_CHUNKS_PER_THREAD 4
+#define RZIP_MAX_BATCH_SIZE (8 * 1024 * 1024)
+
+/* A chunk to compress or decompress */
+typedef struct
+{
+   const uint8_t *in;
+   uint8_t *out;
+   uint32_t in_size;
+   uint32_t out_size;
+   uint32_t written;
+} rzip_chunk_t;
+
+/* The chunks of a batch handled by one thread
+ * > Every 'stride'-th chunk, starting at 'first' */
+typedef struct
+{
+   const struct trans_stream_backend *backend;
+   rzip_chunk_t *chunks;
+   unsigned first;
+   unsigned stride;
+   unsigned num_chunks;
+   bool is_deflate;
+   bool ok;
+} rzip_job_t;
+
+#ifdef HAVE_THREADS
+/* Worker threads of a stream, created with its
+ * first parallel batch and kept until it is closed
+ * > Worker 'i' runs jobs[i + 1] of each batch; the
+ *   thread submitting the batch runs jobs[0] */
+typedef struct
+{
+   sthread_t *threads[RZIP_MAX_THREADS - 1];
+   slock_t *lock;
+   scond_t *start_cond;
+   scond_t *done_cond;
+   rzip_job_t *jobs;
+   unsigned num_workers;
+   /* active: Workers that have a job in the
+    * current batch */
+   unsigned active;
+   unsigned pending;
+   /* batch: Incremented for every batch, so that
+    * workers can tell a new one from a spurious
+    * wakeup */
+   unsigned batch;
+   bool quit;
+} rzip_pool_t;
+
+typedef struct
+{
+   rzip_pool_t *pool;
+   unsigned index;
+} rzip_worker_t;
+#endif
+
 /* Holds all metadata for an RZIP file stream */
 struct rzipstream
 {
@@ -53,9 +124,7 @@ struct rzipstream
    uint64_t virtual_ptr;
    RFILE* file;
    const struct trans_stream_backend *deflate_backend;
-   void *deflate_stream;
    const struct trans_stream_backend *inflate_backend;
-   void *inflate_stream;
    uint8_t *in_buf;
    uint8_t *out_buf;
    uint32_t in_buf_size;
@@ -64,10 +133,276 @@ struct rzipstream
    uint32_t out_buf_ptr;
    uint32_t out_buf_occupancy;
    uint32_t chunk_size;
+   /* chunk_bound: Maximum compressed size of
+    * a chunk */
+   uint32_t chunk_bound;
+   /* batch_chunks: Number of chunks that are
+    * (de)compressed together (at most
+    * RZIP_MAX_THREADS * RZIP_BATCH_CHUNKS_PER_THREAD) */
+   unsigned batch_chunks;
+   unsigned num_threads;
+#ifdef HAVE_THREADS
+   rzip_pool_t *pool;
+#endif
    bool is_compressed;
    bool is_writing;
 };
 
+/* Chunk Compression/Decompression */
+
+/* Returns the number of threads used to
+ * (de)compress chunks */
+static unsigned rzipstream_get_num_threads(void)
+{
+#if defined(HAVE_THREADS)
+#if defined(RZIP_THREADS)
+   unsigned num_threads = RZIP_THREADS;
+#else
+   unsigned num_threads = cpu_features_get_core_amount();
+#endif
+   if (num_threads < 1)
+      return 1;
+   return MIN(num_threads, RZIP_MAX_THREADS);
+#else
+   return 1;
+#endif
+}
+
+/* (De)compresses the chunks of a job
+ * > Each chunk must be transformed in its entirety:
+ *   compressed chunks must fit in 'out_size' and
+ *   end the zlib stream, and all input must be
+ *   consumed */
+static void rzipstream_run_job(void *data)
+{
+   unsigned i;
+   rzip_job_t *job = (rzip_job_t*)data;
+   void *trans     = job->backend->stream_new();
+
+   job->ok         = false;
+
+   if (!trans)
+      return;
+
+   if (job->is_deflate &&
+       !job->backend->define(trans, "level", RZIP_COMPRESSION_LEVEL))
+      goto end;
+
+   for (i = job->first; i < job->num_chunks; i += job->stride)
+   {
+      uint32_t rd                 = 0;
+      uint32_t wn                 = 0;
+      enum trans_stream_error err = TRANS_STREAM_ERROR_NONE;
+      rzip_chunk_t *chunk         = &job->chunks[i];
+
+      job->backend->set_in(trans, chunk->in, chunk->in_size);
+      job->backend->set_out(trans, chunk->out, chunk->out_size);
+
+      /* Note 1: We have to set 'flush == true' here,
+       * otherwise we can't guarantee that the entire
+       * chunk will be written to the output buffer
+       * Note 2: A failed transform leaves the stream
+       * mid-way, so it cannot be reused */
+      if (  !job->backend->trans(trans, true, &rd, &wn, &err)
+          || (err != TRANS_STREAM_ERROR_NONE)
+          || (rd  != chunk->in_size)
+          || (wn  == 0)
+          || (wn  >  chunk->out_size))
+         goto end;
+
+      chunk->written = wn;
+   }
+
+   job->ok = true;
+
+end:
+   job->backend->stream_free(trans);
+}
+
+#ifdef HAVE_THREADS
+static void rzipstream_pool_worker(void *data)
+{
+   rzip_worker_t *worker = (rzip_worker_t*)data;
+   rzip_pool_t *pool     = worker->pool;
+   unsigned batch        = 0;
+
+   slock_lock(pool->lock);
+
+   for (;;)
+   {
+      while (!pool->quit && pool->batch == batch)
+         scond_wait(pool->start_cond, pool->lock);
+
+      if (pool->quit)
+         break;
+
+      batch = pool->batch;
+
+      if (worker->index >= pool->active)
+         continue;
+
+      slock_unlock(pool->lock);
+      rzipstream_run_job(&pool->jobs[worker->index + 1]);
+      slock_lock(pool->lock);
+
+      if (--pool->pending == 0)
+         scond_signal(pool->done_cond);
+   }
+
+   slock_unlock(pool->lock);
+   free(worker);
+}
+
+static void rzipstream_pool_free(rzip_pool_t *pool)
+{
+   unsigned i;
+
+   if (!pool)
+      return;
+
+   if (pool->lock)
+   {
+      slock_lock(pool->lock);
+      pool->quit = true;
+      if (pool->start_cond)
+         scond_broadcast(pool->start_cond);
+      slock_unlock(pool->lock);
+   }
+
+   for (i = 0; i < pool->num_workers; i++)
+      sthread_join(pool->threads[i]);
+
+   if (pool->done_cond)
+      scond_free(pool->done_cond);
+   if (pool->start_cond)
+      scond_free(pool->start_cond);
+   if (pool->lock)
+      slock_free(pool->lock);
+   free(pool);
+}
+
+/* Starts up to 'num_workers' worker threads
+ * > Fewer may be started; jobs without a worker
+ *   are run by the submitting thread */
+static rzip_pool_t *rzipstream_pool_new(unsigned num_workers)
+{
+   unsigned i;
+   rzip_pool_t *pool = (rzip_pool_t*)calloc(1, sizeof(*pool));
+
+   if (!pool)
+      return NULL;
+
+   pool->lock       = slock_new();
+   pool->start_cond = scond_new();
+   pool->done_cond  = scond_new();
+
+   if (!pool->lock || !pool->start_cond || !pool->done_cond)
+   {
+      rzipstream_pool_free(pool);
+      return NULL;
+   }
+
+   for (i = 0; i < num_workers; i++)
+   {
+      rzip_worker_t *worker = (rzip_worker_t*)malloc(sizeof(*worker));
+
+      if (!worker)
+         break;
+
+      worker->pool  = pool;
+      worker->index = i;
+
+      if (!(pool->threads[i] = sthread_create(
+                  rzipstream_pool_worker, worker)))
+      {
+         free(worker);
+         break;
+      }
+
+      pool->num_workers++;
+   }
+
+   return pool;
+}
+#endif
+
+/* (De)compresses a batch of chunks, spreading
+ * them over up to 'num_threads' threads
+ * > The calling thread handles its share of the
+ *   chunks as well
+ * Returns false if any chunk fails */
+static bool rzipstream_trans_chunks(rzipstream_t *stream,
+      const struct trans_stream_backend *backend, bool is_deflate,
+      rzip_chunk_t *chunks, unsigned num_chunks)
+{
+   unsigned i;
+   rzip_job_t jobs[RZIP_MAX_THREADS];
+   unsigned num_threads = stream->num_threads;
+   unsigned delegated   = 0;
+   bool ok              = true;
+
+   num_threads = MIN(num_threads, num_chunks);
+   num_threads = MIN(num_threads, RZIP_MAX_THREADS);
+
+   if (num_threads < 1)
+      num_threads = 1;
+
+   for (i = 0; i < num_threads; i++)
+   {
+      jobs[i].backend    = backend;
+      jobs[i].chunks     = chunks;
+      jobs[i].first      = i;
+      jobs[i].stride     = num_threads;
+      jobs[i].num_chunks = num_chunks;
+      jobs[i].is_deflate = is_deflate;
+      jobs[i].ok         = false;
+   }
+
+#ifdef HAVE_THREADS
+   if (num_threads > 1 && !stream->pool)
+      stream->pool = rzipstream_pool_new(stream->num_threads - 1);
+
+   if (num_threads > 1 && stream->pool)
+   {
+      rzip_pool_t *pool = stream->pool;
+
+      delegated         = MIN(num_threads - 1, pool->num_workers);
+
+      slock_lock(pool->lock);
+      pool->jobs        = jobs;
+      pool->active      = delegated;
+      pool->pending     = delegated;
+      pool->batch++;
+      scond_broadcast(pool->start_cond);
+      slock_unlock(pool->lock);
+   }
+#endif
+
+   rzipstream_run_job(&jobs[0]);
+
+   /* Jobs left without a worker */
+   for (i = delegated + 1; i < num_threads; i++)
+      rzipstream_run_job(&jobs[i]);
+
+#ifdef HAVE_THREADS
+   if (delegated)
+   {
+      rzip_pool_t *pool = stream->pool;
+
+      slock_lock(pool->lock);
+      while (pool->pending)
+         scond_wait(pool->done_cond, pool->lock);
+      pool->jobs        = NULL;
+      slock_unlock(pool->lock);
+   }
+#endif
+
+   for (i = 0; i < num_threads; i++)
+      ok = ok && jobs[i].ok;
+
+   return ok;
+}
+
 /* Header Functions */
 
 /* Reads header information from RZIP file
@@ -213,11 +548,12 @@ static bool rzipstream_init_stream(
    /* Ensure stream has valid initial values */
    stream->size              = 0;
    stream->chunk_size        = RZIP_DEFAULT_CHUNK_SIZE;
+   stream->chunk_bound       = 0;
+   stream->batch_chunks      = 1;
+   stream->num_threads       = rzipstream_get_num_threads();
    stream->file              = NULL;
    stream->deflate_backend   = NULL;
-   stream->deflate_stream    = NULL;
    stream->inflate_backend   = NULL;
-   stream->inflate_stream    = NULL;
    stream->in_buf            = NULL;
    stream->in_buf_size       = 0;
    stream->in_buf_ptr        = 0;
@@ -261,8 +597,34 @@ static bool rzipstream_init_stream(
    else if (!rzipstream_read_file_header(stream))
       return false;
 
-   /* Initialise appropriate transform stream
-    * and determine associated buffer sizes */
+   /* Compressed chunks are never larger than
+    * twice the chunk size (plus the minimum zlib
+    * overhead of 11 bytes); this is the output
+    * buffer size RZIP files have always been
+    * written with */
+   if (stream->chunk_size > ((UINT32_MAX - 11) >> 1))
+      return false;
+
+   stream->chunk_bound = (stream->chunk_size * 2) + 11;
+
+   /* Chunks are only batched when they can be
+    * (de)compressed in parallel */
+   if (stream->num_threads > 1)
+   {
+      stream->batch_chunks = stream->num_threads *
+            RZIP_BATCH_CHUNKS_PER_THREAD;
+      stream->batch_chunks = MIN(stream->batch_chunks,
+            RZIP_MAX_BATCH_SIZE / stream->chunk_size);
+
+      if (stream->batch_chunks < 1)
+         stream->batch_chunks = 1;
+   }
+
+   /* Get appropriate transform backend
+    * and determine associated buffer sizes
+    * Note: Buffers initially hold a single chunk,
+    * and only grow to hold a batch of chunks once
+    * more data than that is read or written */
    if (stream->is_writing)
    {
       /* Compression */
@@ -270,26 +632,11 @@ static bool rzipstream_init_stream(
       if (!stream->deflate_backend)
          return false;
 
-      stream->deflate_stream = stream->deflate_backend->stream_new();
-      if (!stream->deflate_stream)
-         return false;
-
-      /* Set compression level */
-      if (!stream->deflate_backend->define(
-            stream->deflate_stream, "level", RZIP_COMPRESSION_LEVEL))
-         return false;
-
       /* Buffers
        * > Input: uncompressed
        * > Output: compressed */
       stream->in_buf_size  = stream->chunk_size;
-      stream->out_buf_size = stream->chunk_size * 2;
-      /* > Account for minimum zlib overhead
-       *   of 11 bytes... */ 
-      stream->out_buf_size =
-            (stream->out_buf_size < (stream->in_buf_size + 11)) ?
-                  stream->out_buf_size + 11 :
-                  stream->out_buf_size;
+      stream->out_buf_size = stream->chunk_bound;
 
       /* Redundant safety check */
       if ((stream->in_buf_size == 0) ||
@@ -297,7 +644,7 @@ static bool rzipstream_init_stream(
          return false;
    }
    /* When reading, don't need an inflate transform
-    * stream (or buffers) if source file is uncompressed */
+    * backend (or buffers) if source file is uncompressed */
    else if (stream->is_compressed)
    {
       /* Decompression */
@@ -305,22 +652,17 @@ static bool rzipstream_init_stream(
       if (!stream->inflate_backend)
          return false;
 
-      stream->inflate_stream = stream->inflate_backend->stream_new();
-      if (!stream->inflate_stream)
-         return false;
-
       /* Buffers
        * > Input: compressed
        * > Output: uncompressed
        * Note 1: Actual compressed chunk sizes are read
        *         from the file - just allocate a sensible
        *         default to minimise memory reallocations
-       * Note 2: If file header is valid, output buffer
-       *         should have a size of exactly stream->chunk_size.
-       *         Allocate some additional space, just for
-       *         redundant safety... */
+       * Note 2: If file header is valid, each chunk
+       *         decompresses to at most stream->chunk_size
+       *         bytes */
       stream->in_buf_size  = stream->chunk_size * 2;
-      stream->out_buf_size = stream->chunk_size + (stream->chunk_size >> 2);
+      stream->out_buf_size = stream->chunk_size;
 
       /* Redundant safety check */
       if ((stream->in_buf_size == 0) ||
@@ -355,19 +697,14 @@ static int rzipstream_free_stream(rzipstream_t *stream)
    if (!stream)
       return -1;
 
-   /* Free transform streams */
-   if (stream->deflate_stream && stream->deflate_backend)
-      stream->deflate_backend->stream_free(stream->deflate_stream);
-
-   stream->deflate_stream  = NULL;
    stream->deflate_backend = NULL;
-
-   if (stream->inflate_stream && stream->inflate_backend)
-      stream->inflate_backend->stream_free(stream->inflate_stream);
-
-   stream->inflate_stream  = NULL;
    stream->inflate_backend = NULL;
 
+#ifdef HAVE_THREADS
+   rzipstream_pool_free(stream->pool);
+   stream->pool            = NULL;
+#endif
+
    /* Free buffers */
    if (stream->in_buf)
       free(stream->in_buf);
@@ -423,12 +760,16 @@ rzipstream_t* rzipstream_open(const char *path, unsigned mode)
    stream->is_writing      = false;
    stream->size            = 0;
    stream->chunk_size      = 0;
+   stream->chunk_bound     = 0;
+   stream->batch_chunks    = 1;
+   stream->num_threads     = 1;
+#ifdef HAVE_THREADS
+   stream->pool            = NULL;
+#endif
    stream->virtual_ptr     = 0;
    stream->file            = NULL;
    stream->deflate_backend = NULL;
-   stream->deflate_stream  = NULL;
    stream->inflate_backend = NULL;
-   stream->inflate_stream  = NULL;
    stream->in_buf          = NULL;
    stream->in_buf_size     = 0;
    stream->in_buf_ptr      = 0;
@@ -451,89 +792,146 @@ rzipstream_t* rzipstream_open(const char *path, unsigned mode)
 
 /* File Read */
 
-/* Reads and decompresses the next chunk of data
- * in the RZIP file */
-static bool rzipstream_read_chunk(rzipstream_t *stream)
+/* Grows a buffer to hold at least 'size' bytes.
+ * Returns false if memory cannot be allocated */
+static bool rzipstream_reserve(uint8_t **buf, uint32_t *buf_size,
+      uint32_t size)
 {
-   unsigned i;
-   int64_t length;
-   uint8_t chunk_header_bytes[RZIP_CHUNK_HEADER_SIZE];
-   uint32_t compressed_chunk_size;
-   uint32_t inflate_read;
-   uint32_t inflate_written;
+   uint8_t *new_buf = NULL;
+
+   if (size <= *buf_size)
+      return true;
 
-   if (!stream || !stream->inflate_backend || !stream->inflate_stream)
+   new_buf = (uint8_t *)realloc(*buf, size);
+   if (!new_buf)
       return false;
 
-   for (i = 0; i < RZIP_CHUNK_HEADER_SIZE; i++)
-      chunk_header_bytes[i] = 0;
+   *buf      = new_buf;
+   *buf_size = size;
 
-   /* Attempt to read chunk header bytes */
-   length = filestream_read(
-         stream->file, chunk_header_bytes, sizeof(chunk_header_bytes));
-   if (length != RZIP_CHUNK_HEADER_SIZE)
-      return false;
+   return true;
+}
 
-   /* Get size of next compressed chunk */
-   compressed_chunk_size = ((uint32_t)chunk_header_bytes[3] << 24) |
-                           ((uint32_t)chunk_header_bytes[2] << 16) |
-                           ((uint32_t)chunk_header_bytes[1] <<  8) |
-                            (uint32_t)chunk_header_bytes[0];
-   if (compressed_chunk_size == 0)
-      return false;
+/* Reads the next chunks of the RZIP file and
+ * decompresses them into 'out', which has room
+ * for 'len' bytes
+ * > Reads as many chunks as it takes to fill 'len'
+ *   (at most stream->batch_chunks), and decompresses
+ *   them in parallel
+ * > 'len' must not exceed the amount of data that
+ *   remains in the file
+ * Returns number of bytes written to 'out', or -1
+ * in the event of an error */
+static int64_t rzipstream_read_chunks(rzipstream_t *stream,
+      uint8_t *out, uint64_t len)
+{
+   unsigned i;
+   rzip_chunk_t chunks[RZIP_MAX_THREADS * RZIP_BATCH_CHUNKS_PER_THREAD];
+   unsigned num_chunks = 0;
+   uint32_t in_len     = 0;
+   uint64_t out_len    = 0;
 
-   /* Resize input buffer, if required */
-   if (compressed_chunk_size > stream->in_buf_size)
-   {
-      free(stream->in_buf);
-      stream->in_buf      = NULL;
+   if (!stream || !stream->inflate_backend || (len == 0))
+      return -1;
 
-      stream->in_buf_size = compressed_chunk_size;
-      stream->in_buf      = (uint8_t *)calloc(stream->in_buf_size, 1);
-      if (!stream->in_buf)
-         return false;
+   num_chunks = (unsigned)MIN(
+         (len + stream->chunk_size - 1) / stream->chunk_size,
+         (uint64_t)stream->batch_chunks);
 
-      /* Note: Uncompressed data size is fixed, and read
-       * from the file header - we therefore don't attempt
-       * to resize the output buffer (if it's too small, then
-       * that's an error condition) */
+   /* Read compressed chunks from file */
+   for (i = 0; i < num_chunks; i++)
+   {
+      int64_t length;
+      uint8_t chunk_header_bytes[RZIP_CHUNK_HEADER_SIZE];
+      uint32_t compressed_chunk_size;
+      uint64_t chunk_offset = (uint64_t)i * stream->chunk_size;
+
+      /* Attempt to read chunk header bytes */
+      length = filestream_read(
+            stream->file, chunk_header_bytes, sizeof(chunk_header_bytes));
+      if (length != RZIP_CHUNK_HEADER_SIZE)
+         return -1;
+
+      /* Get size of next compressed chunk */
+      compressed_chunk_size = ((uint32_t)chunk_header_bytes[3] << 24) |
+                              ((uint32_t)chunk_header_bytes[2] << 16) |
+                              ((uint32_t)chunk_header_bytes[1] <<  8) |
+                               (uint32_t)chunk_header_bytes[0];
+      if ((compressed_chunk_size == 0) ||
+          (compressed_chunk_size > stream->chunk_bound))
+         return -1;
+
+      /* Resize input buffer, if required
+       * Note: Uncompressed data size is fixed, and read
+       * from the file header - we therefore don't allow
+       * a chunk to decompress to more than its share
+       * of the output (if it does, then that's an
+       * error condition) */
+      if (!rzipstream_reserve(&stream->in_buf, &stream->in_buf_size,
+               in_len + compressed_chunk_size))
+         return -1;
+
+      /* Read compressed chunk from file */
+      length = filestream_read(
+            stream->file, stream->in_buf + in_len, compressed_chunk_size);
+      if (length != compressed_chunk_size)
+         return -1;
+
+      /* Input pointers are set once the
+       * buffer has stopped moving */
+      chunks[i].in_size  = compressed_chunk_size;
+      chunks[i].out      = out + chunk_offset;
+      chunks[i].out_size = (uint32_t)MIN(
+            (uint64_t)stream->chunk_size, len - chunk_offset);
+      chunks[i].written  = 0;
+
+      in_len            += compressed_chunk_size;
    }
 
-   /* Read compressed chunk from file */
-   length = filestream_read(
-         stream->file, stream->in_buf, compressed_chunk_size);
-   if (length != compressed_chunk_size)
-      return false;
+   for (i = 0, in_len = 0; i < num_chunks; i++)
+   {
+      chunks[i].in  = stream->in_buf + in_len;
+      in_len       += chunks[i].in_size;
+   }
 
    /* Decompress chunk data */
-   stream->inflate_backend->set_in(
-         stream->inflate_stream,
-         stream->in_buf, compressed_chunk_size);
-
-   stream->inflate_backend->set_out(
-         stream->inflate_stream,
-         stream->out_buf, stream->out_buf_size);
-
-   /* Note: We have to set 'flush == true' here, otherwise we
-    * can't guarantee that the entire chunk will be written
-    * to the output buffer - this is inefficient, but not
-    * much we can do... */
-   if (!stream->inflate_backend->trans(
-         stream->inflate_stream, true,
-         &inflate_read, &inflate_written, NULL))
-      return false;
+   if (!rzipstream_trans_chunks(stream, stream->inflate_backend, false,
+            chunks, num_chunks))
+      return -1;
+
+   /* Chunks written by RZIP are all full-size, apart
+    * from the last one - but close any gaps left
+    * by shorter chunks, just in case */
+   for (i = 0; i < num_chunks; i++)
+   {
+      if (chunks[i].out != out + out_len)
+         memmove(out + out_len, chunks[i].out, chunks[i].written);
+      out_len += chunks[i].written;
+   }
+
+   return (int64_t)out_len;
+}
 
-   /* Error checking */
-   if (inflate_read != compressed_chunk_size)
+/* Reads and decompresses the next batch of chunks
+ * in the RZIP file into the output buffer */
+static bool rzipstream_read_batch(rzipstream_t *stream)
+{
+   int64_t length;
+   uint64_t len = (uint64_t)stream->chunk_size * stream->batch_chunks;
+
+   len = MIN(len, stream->size - stream->virtual_ptr);
+
+   if (!rzipstream_reserve(&stream->out_buf, &stream->out_buf_size,
+            (uint32_t)len))
       return false;
 
-   if ((inflate_written == 0) ||
-       (inflate_written > stream->out_buf_size))
+   length = rzipstream_read_chunks(stream, stream->out_buf, len);
+   if (length <= 0)
       return false;
 
    /* Record current output buffer occupancy
     * and reset pointer */
-   stream->out_buf_occupancy = inflate_written;
+   stream->out_buf_occupancy = (uint32_t)length;
    stream->out_buf_ptr       = 0;
 
    return true;
@@ -567,11 +965,38 @@ int64_t rzipstream_read(rzipstream_t *stream, void *data, int64_t len)
          return data_read;
 
       /* If everything in the output buffer has already
-       * been read, grab and extract the next chunk
+       * been read, grab and extract the next chunks
        * from disk */
       if (stream->out_buf_ptr >= stream->out_buf_occupancy)
-         if (!rzipstream_read_chunk(stream))
+      {
+         uint64_t remaining  = stream->size - stream->virtual_ptr;
+         uint64_t batch_size = (uint64_t)stream->chunk_size *
+               stream->batch_chunks;
+
+         /* If the read buffer has room for a whole
+          * batch (or for the rest of the file),
+          * decompress straight into it */
+         if ((uint64_t)data_len >= MIN(batch_size, remaining))
+         {
+            int64_t length = rzipstream_read_chunks(stream, data_ptr,
+                  MIN((uint64_t)data_len, remaining));
+
+            if (length <= 0)
+               return -1;
+
+            stream->out_buf_occupancy = 0;
+            stream->out_buf_ptr       = 0;
+
+            data_ptr            += length;
+            data_len            -= length;
+            stream->virtual_ptr += length;
+            data_read           += length;
+            continue;
+         }
+
+         if (!rzipstream_read_batch(stream))
             return -1;
+      }
 
       /* Get amount of data to 'read out' this loop
        * > i.e. minimum of remaining output buffer
@@ -740,68 +1165,72 @@ error:
 
 /* File Write */
 
-/* Compresses currently cached data and writes it
- * as the next RZIP file chunk */
-static bool rzipstream_write_chunk(rzipstream_t *stream)
+/* Compresses 'len' bytes of 'data' and writes them
+ * as the next RZIP file chunks
+ * > 'data' is split into chunks of stream->chunk_size
+ *   bytes (at most stream->batch_chunks), which are
+ *   compressed in parallel
+ * > Only the last chunk of the file may be short */
+static bool rzipstream_write_chunks(rzipstream_t *stream,
+      const uint8_t *data, uint32_t len)
 {
    unsigned i;
-   int64_t length;
-   uint8_t chunk_header_bytes[RZIP_CHUNK_HEADER_SIZE];
-   uint32_t deflate_read;
-   uint32_t deflate_written;
+   rzip_chunk_t chunks[RZIP_MAX_THREADS * RZIP_BATCH_CHUNKS_PER_THREAD];
+   unsigned num_chunks = 0;
 
-   if (!stream || !stream->deflate_backend || !stream->deflate_stream)
+   if (!stream || !stream->deflate_backend || (len == 0))
       return false;
 
-   for (i = 0; i < RZIP_CHUNK_HEADER_SIZE; i++)
-      chunk_header_bytes[i] = 0;
-
-   /* Compress data currently held in input buffer */
-   stream->deflate_backend->set_in(
-         stream->deflate_stream,
-         stream->in_buf, stream->in_buf_ptr);
-
-   stream->deflate_backend->set_out(
-         stream->deflate_stream,
-         stream->out_buf, stream->out_buf_size);
-
-   /* Note: We have to set 'flush == true' here, otherwise we
-    * can't guarantee that the entire chunk will be written
-    * to the output buffer - this is inefficient, but not
-    * much we can do... */
-   if (!stream->deflate_backend->trans(
-         stream->deflate_stream, true,
-         &deflate_read, &deflate_written, NULL))
+   num_chunks = (len + stream->chunk_size - 1) / stream->chunk_size;
+   if (num_chunks > stream->batch_chunks)
       return false;
 
-   /* Error checking */
-   if (deflate_read != stream->in_buf_ptr)
+   /* Each chunk gets its own share of the
+    * output buffer */
+   if (!rzipstream_reserve(&stream->out_buf, &stream->out_buf_size,
+            num_chunks * stream->chunk_bound))
       return false;
 
-   if ((deflate_written == 0) ||
-       (deflate_written > stream->out_buf_size))
-      return false;
+   for (i = 0; i < num_chunks; i++)
+   {
+      uint32_t chunk_offset = i * stream->chunk_size;
 
-   /* Write compressed chunk size to file */
-   chunk_header_bytes[3] = (deflate_written >> 24) & 0xFF;
-   chunk_header_bytes[2] = (deflate_written >> 16) & 0xFF;
-   chunk_header_bytes[1] = (deflate_written >>  8) & 0xFF;
-   chunk_header_bytes[0] =  deflate_written        & 0xFF;
+      chunks[i].in       = data + chunk_offset;
+      chunks[i].in_size  = MIN(stream->chunk_size, len - chunk_offset);
+      chunks[i].out      = stream->out_buf + i * stream->chunk_bound;
+      chunks[i].out_size = stream->chunk_bound;
+      chunks[i].written  = 0;
+   }
 
-   length = filestream_write(
-         stream->file, chunk_header_bytes, sizeof(chunk_header_bytes));
-   if (length != RZIP_CHUNK_HEADER_SIZE)
+   /* Compress data */
+   if (!rzipstream_trans_chunks(stream, stream->deflate_backend, true,
+            chunks, num_chunks))
       return false;
 
-   /* Write compressed data to file */
-   length = filestream_write(
-         stream->file, stream->out_buf, deflate_written);
+   for (i = 0; i < num_chunks; i++)
+   {
+      int64_t length;
+      uint8_t chunk_header_bytes[RZIP_CHUNK_HEADER_SIZE];
+      uint32_t deflate_written = chunks[i].written;
+
+      /* Write compressed chunk size to file */
+      chunk_header_bytes[3] = (deflate_written >> 24) & 0xFF;
+      chunk_header_bytes[2] = (deflate_written >> 16) & 0xFF;
+      chunk_header_bytes[1] = (deflate_written >>  8) & 0xFF;
+      chunk_header_bytes[0] =  deflate_written        & 0xFF;
+
+      length = filestream_write(
+            stream->file, chunk_header_bytes, sizeof(chunk_header_bytes));
+      if (length != RZIP_CHUNK_HEADER_SIZE)
+         return false;
 
-   if (length != deflate_written)
-      return false;
+      /* Write compressed data to file */
+      length = filestream_write(
+            stream->file, chunks[i].out, deflate_written);
 
-   /* Reset input buffer pointer */
-   stream->in_buf_ptr = 0;
+      if (length != deflate_written)
+         return false;
+   }
 
    return true;
 }
@@ -813,20 +1242,55 @@ int64_t rzipstream_write(rzipstream_t *stream, const void *data, int64_t len)
 {
    int64_t data_len        = len;
    const uint8_t *data_ptr = (const uint8_t *)data;
+   uint32_t batch_size     = 0;
 
    if (!stream || !stream->is_writing || !data)
       return -1;
 
+   batch_size = stream->chunk_size * stream->batch_chunks;
+
    /* Process input data */
    while (data_len > 0)
    {
       uint32_t cache_size = 0;
 
-      /* If input buffer is full, compress and write to disk */
+      /* If input buffer is full, compress and write to disk
+       * > Files that fit in a single chunk never need
+       *   more than that, so the buffer only grows to
+       *   hold a whole batch once it overflows */
       if (stream->in_buf_ptr >= stream->in_buf_size)
-         if (!rzipstream_write_chunk(stream))
+      {
+         if (stream->in_buf_size < batch_size)
+         {
+            if (!rzipstream_reserve(&stream->in_buf,
+                     &stream->in_buf_size, batch_size))
+               return -1;
+         }
+         else
+         {
+            if (!rzipstream_write_chunks(stream,
+                     stream->in_buf, stream->in_buf_ptr))
+               return -1;
+
+            stream->in_buf_ptr = 0;
+         }
+      }
+
+      /* If nothing is cached, compress whole batches
+       * straight from the write buffer */
+      if ((stream->in_buf_ptr == 0) && (data_len >= batch_size))
+      {
+         if (!rzipstream_write_chunks(stream, data_ptr, batch_size))
             return -1;
 
+         data_ptr            += batch_size;
+         data_len            -= batch_size;
+
+         stream->size        += batch_size;
+         stream->virtual_ptr += batch_size;
+         continue;
+      }
+
       /* Get amount of data to cache during this loop
        * > i.e. minimum of space remaining in input buffer
        *   and remaining 'write data' size */
@@ -847,7 +1311,7 @@ int64_t rzipstream_write(rzipstream_t *stream, const void *data, int64_t len)
    }
 
    /* We always write the specified number of bytes
-    * (unless rzipstream_write_chunk() fails, in
+    * (unless rzipstream_write_chunks() fails, in
     * which we register a complete failure...) */
    return len;
 }
@@ -992,9 +1456,10 @@ void rzipstream_rewind(rzipstream_t *stream)
    else
    {
       /* Check whether first file chunk is currently
-       * buffered in memory */
-      if ((stream->virtual_ptr < stream->chunk_size) &&
-          (stream->out_buf_ptr < stream->out_buf_occupancy))
+       * buffered in memory (i.e. whether the buffered
+       * batch starts at the beginning of the file) */
+      if ((stream->virtual_ptr == stream->out_buf_ptr) &&
+          (stream->out_buf_occupancy > 0))
       {
          /* It is: No file access is therefore required
           * > Just reset pointers */
@@ -1016,18 +1481,18 @@ void rzipstream_rewind(rzipstream_t *stream)
             return;
          }
 
-         /* Read chunk */
-         if (!rzipstream_read_chunk(stream))
+         /* Read chunk (along with the rest of
+          * its batch)
+          * Note: This resets the output buffer pointer */
+         stream->virtual_ptr = 0;
+
+         if (!rzipstream_read_batch(stream))
          {
             fprintf(
                   stderr,
                   "rzipstream_rewind(): Failed to read first chunk of file...\n");
             return;
          }
-
-         /* Reset pointers */
-         stream->virtual_ptr = 0;
-         stream->out_buf_ptr = 0;
       }
    }
 }
@@ -1099,7 +1564,8 @@ int rzipstream_close(rzipstream_t *stream)
    if (stream->is_writing)
    {
       if (stream->in_buf_ptr > 0)
-         if (!rzipstream_write_chunk(stream))
+         if (!rzipstream_write_chunks(stream,
+                  stream->in_buf, stream->in_buf_ptr))
             goto error;
 
       if (!rzipstream_write_file_header(stream))
@@ -0,0 +1,554 @@
+/* Copyright  (C) 2010-2020 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (zip_stream.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <compat/strl.h>
+#include <retro_miscellaneous.h>
+#include <file/file_path.h>
+#include <encodings/crc32.h>
+
+#include <streams/file_stream.h>
+#include <streams/zip_stream.h>
+
+/* The regular zip backend goes through trans_stream,
+ * which reports a stalled inflate (Z_BUF_ERROR) the
+ * same way as corrupt data. Data arrives here in
+ * arbitrary pieces, so inflate is used directly */
+#include <zlib.h>
+
+#define ZIPSTREAM_LOCAL_FILE_SIGNATURE     0x04034b50
+#define ZIPSTREAM_CENTRAL_FILE_SIGNATURE   0x02014b50
+#define ZIPSTREAM_END_OF_CENTRAL_SIGNATURE 0x06054b50
+#define ZIPSTREAM_DESCRIPTOR_SIGNATURE     0x08074b50
+
+/* Header sizes (in bytes) */
+#define ZIPSTREAM_SIGNATURE_SIZE    4
+#define ZIPSTREAM_LOCAL_HEADER_SIZE 30
+#define ZIPSTREAM_DESCRIPTOR_SIZE   12
+
+#define ZIPSTREAM_FLAG_ENCRYPTED  (1 << 0)
+#define ZIPSTREAM_FLAG_DESCRIPTOR (1 << 3)
+
+#define ZIPSTREAM_MODE_STORED   0
+#define ZIPSTREAM_MODE_DEFLATED 8
+
+/* Size of the buffer inflated data is written from */
+#define ZIPSTREAM_OUT_SIZE 0x10000
+
+/* Suffix of a file while it is being extracted */
+#define ZIPSTREAM_PART_EXTENSION ".part"
+
+enum zipstream_state
+{
+   ZIPSTREAM_HEADER = 0,
+   ZIPSTREAM_DATA,
+   ZIPSTREAM_DESCRIPTOR,
+   ZIPSTREAM_DONE,
+   ZIPSTREAM_ERROR
+};
+
+/* Holds all state of an archive being extracted */
+struct zipstream
+{
+   z_stream z;
+   RFILE *file;
+   /* buf: Collects headers that arrive split
+    * across writes, until 'buf_need' bytes
+    * are available */
+   uint8_t *buf;
+   uint8_t *out;
+   size_t buf_size;
+   size_t buf_len;
+   size_t buf_need;
+   /* Current file: values from its local header,
+    * and what was extracted so far */
+   uint32_t crc;
+   uint32_t csize;
+   uint32_t size;
+   uint32_t real_crc;
+   uint32_t real_csize;
+   uint32_t real_size;
+   unsigned flags;
+   unsigned mode;
+   enum zipstream_state state;
+   bool z_inited;
+   char dir[PATH_MAX_LENGTH];
+   char path[PATH_MAX_LENGTH];
+   char part_path[PATH_MAX_LENGTH];
+};
+
+static uint32_t zipstream_read_le(const uint8_t *data, unsigned size)
+{
+   unsigned i;
+   uint32_t val = 0;
+
+   size *= 8;
+   for (i = 0; i < size; i += 8)
+      val |= (uint32_t)*data++ << i;
+
+   return val;
+}
+
+/* Copies data into the header buffer until it holds
+ * 'buf_need' bytes. Returns the number of bytes used */
+static size_t zipstream_fill(zipstream_t *stream,
+      const uint8_t *data, size_t len)
+{
+   size_t wanted = stream->buf_need - stream->buf_len;
+
+   if (stream->buf_need > stream->buf_size)
+   {
+      uint8_t *buf = (uint8_t*)realloc(stream->buf, stream->buf_need);
+
+      if (!buf)
+      {
+         stream->state = ZIPSTREAM_ERROR;
+         return len;
+      }
+
+      stream->buf      = buf;
+      stream->buf_size = stream->buf_need;
+   }
+
+   if (wanted > len)
+      wanted = len;
+
+   memcpy(stream->buf + stream->buf_len, data, wanted);
+   stream->buf_len += wanted;
+
+   return wanted;
+}
+
+static void zipstream_next_header(zipstream_t *stream,
+      enum zipstream_state state, size_t need)
+{
+   stream->state    = state;
+   stream->buf_len  = 0;
+   stream->buf_need = need;
+}
+
+/* Rejects names that would be extracted
+ * outside of the target directory */
+static bool zipstream_name_is_safe(const char *name)
+{
+   const char *s = name;
+
+   if (*s == '/' || *s == '\\' || strchr(name, ':'))
+      return false;
+
+   while (*s)
+   {
+      size_t len = strcspn(s, "/\\");
+
+      if (len == 2 && s[0] == '.' && s[1] == '.')
+         return false;
+
+      s += len;
+      if (*s)
+         s++;
+   }
+
+   return true;
+}
+
+static void zipstream_close_file(zipstream_t *stream, bool keep)
+{
+   if (!stream->file)
+      return;
+
+   filestream_close(stream->file);
+   stream->file = NULL;
+
+   if (!keep)
+      filestream_delete(stream->part_path);
+}
+
+/* Checks the extracted file against the values from
+ * its header (or data descriptor) and moves it to
+ * its destination */
+static bool zipstream_end_file(zipstream_t *stream)
+{
+   if (     stream->real_crc   != stream->crc
+         || stream->real_size  != stream->size
+         || stream->real_csize != stream->csize)
+      return false;
+
+   zipstream_close_file(stream, true);
+
+   /* Renaming does not replace existing files
+    * on every platform */
+   if (path_is_valid(stream->path))
+      filestream_delete(stream->path);
+
+   if (filestream_rename(stream->part_path, stream->path) != 0)
+   {
+      filestream_delete(stream->part_path);
+      return false;
+   }
+
+   zipstream_next_header(stream, ZIPSTREAM_HEADER,
+         ZIPSTREAM_SIGNATURE_SIZE);
+   return true;
+}
+
+static bool zipstream_begin_file(zipstream_t *stream)
+{
+   char name[PATH_MAX_LENGTH];
+   char dir[PATH_MAX_LENGTH];
+   const uint8_t *header = stream->buf;
+   size_t name_len       = zipstream_read_le(header + 26, 2);
+
+   stream->flags      = zipstream_read_le(header + 6,  2);
+   stream->mode       = zipstream_read_le(header + 8,  2);
+   stream->crc        = zipstream_read_le(header + 14, 4);
+   stream->csize      = zipstream_read_le(header + 18, 4);
+   stream->size       = zipstream_read_le(header + 22, 4);
+   stream->real_crc   = 0;
+   stream->real_csize = 0;
+   stream->real_size  = 0;
+
+   if (stream->flags & ZIPSTREAM_FLAG_ENCRYPTED)
+      return false;
+
+   switch (stream->mode)
+   {
+      case ZIPSTREAM_MODE_STORED:
+         /* The end of stored data can only be
+          * found with its size */
+         if (stream->flags & ZIPSTREAM_FLAG_DESCRIPTOR)
+            return false;
+         break;
+      case ZIPSTREAM_MODE_DEFLATED:
+         break;
+      default:
+         return false;
+   }
+
+   /* ZIP64 */
+   if (stream->csize == 0xFFFFFFFF || stream->size == 0xFFFFFFFF)
+      return false;
+
+   if (!name_len || name_len >= sizeof(name))
+      return false;
+
+   memcpy(name, header + ZIPSTREAM_LOCAL_HEADER_SIZE, name_len);
+   name[name_len] = '\0';
+
+   if (strlen(name) != name_len || !zipstream_name_is_safe(name))
+      return false;
+
+   fill_pathname_join(stream->path, stream->dir, name,
+         sizeof(stream->path));
+
+   /* Directory entry */
+   if (name[name_len - 1] == '/' || name[name_len - 1] == '\\')
+   {
+      if (stream->csize || (stream->flags & ZIPSTREAM_FLAG_DESCRIPTOR))
+         return false;
+
+      if (!path_is_directory(stream->path) && !path_mkdir(stream->path))
+         return false;
+
+      zipstream_next_header(stream, ZIPSTREAM_HEADER,
+            ZIPSTREAM_SIGNATURE_SIZE);
+      return true;
+   }
+
+   fill_pathname_basedir(dir, stream->path, sizeof(dir));
+
+   if (!path_is_directory(dir) && !path_mkdir(dir))
+      return false;
+
+   strlcpy(stream->part_path, stream->path, sizeof(stream->part_path));
+   strlcat(stream->part_path, ZIPSTREAM_PART_EXTENSION,
+         sizeof(stream->part_path));
+
+   stream->file = filestream_open(stream->part_path,
+         RETRO_VFS_FILE_ACCESS_WRITE, RETRO_VFS_FILE_ACCESS_HINT_NONE);
+
+   if (!stream->file)
+      return false;
+
+   /* Empty files end with their header */
+   if (stream->mode == ZIPSTREAM_MODE_STORED && !stream->csize)
+      return zipstream_end_file(stream);
+
+   if (stream->mode == ZIPSTREAM_MODE_DEFLATED)
+   {
+      if (stream->z_inited)
+      {
+         if (inflateReset(&stream->z) != Z_OK)
+            return false;
+      }
+      else
+      {
+         if (inflateInit2(&stream->z, -MAX_WBITS) != Z_OK)
+            return false;
+         stream->z_inited = true;
+      }
+   }
+
+   zipstream_next_header(stream, ZIPSTREAM_DATA, 0);
+   return true;
+}
+
+/* Called once all file data has been extracted */
+static bool zipstream_end_data(zipstream_t *stream)
+{
+   /* Read the data descriptor first, if there is one */
+   if (stream->flags & ZIPSTREAM_FLAG_DESCRIPTOR)
+   {
+      zipstream_next_header(stream, ZIPSTREAM_DESCRIPTOR,
+            ZIPSTREAM_DESCRIPTOR_SIZE);
+      return true;
+   }
+
+   return zipstream_end_file(stream);
+}
+
+static bool zipstream_output(zipstream_t *stream,
+      const uint8_t *data, size_t len)
+{
+   if (filestream_write(stream->file, data, len) != (int64_t)len)
+      return false;
+
+   stream->real_crc   = encoding_crc32(stream->real_crc, data, len);
+   stream->real_size += (uint32_t)len;
+   return true;
+}
+
+/* Extracts file data. Returns the number of
+ * bytes used, or -1 in the event of an error */
+static int64_t zipstream_write_data(zipstream_t *stream,
+      const uint8_t *data, size_t len)
+{
+   int zret;
+   size_t used;
+   bool has_size = !(stream->flags & ZIPSTREAM_FLAG_DESCRIPTOR);
+
+   /* Do not read past the end of the file data
+    * if its size is known */
+   if (has_size && len > stream->csize - stream->real_csize)
+      len = stream->csize - stream->real_csize;
+
+   if (stream->mode == ZIPSTREAM_MODE_STORED)
+   {
+      if (!zipstream_output(stream, data, len))
+         return -1;
+
+      stream->real_csize += (uint32_t)len;
+
+      if (     stream->real_csize == stream->csize
+            && !zipstream_end_data(stream))
+         return -1;
+
+      return (int64_t)len;
+   }
+
+   stream->z.next_in  = (Bytef*)data;
+   stream->z.avail_in = (uInt)len;
+
+   do
+   {
+      stream->z.next_out  = stream->out;
+      stream->z.avail_out = ZIPSTREAM_OUT_SIZE;
+
+      zret = inflate(&stream->z, Z_NO_FLUSH);
+
+      if (zret != Z_OK && zret != Z_STREAM_END && zret != Z_BUF_ERROR)
+         return -1;
+
+      if (!zipstream_output(stream, stream->out,
+               ZIPSTREAM_OUT_SIZE - stream->z.avail_out))
+         return -1;
+   } while (zret == Z_OK && !stream->z.avail_out);
+
+   used                = len - stream->z.avail_in;
+   stream->real_csize += (uint32_t)used;
+
+   if (zret == Z_STREAM_END)
+   {
+      if (!zipstream_end_data(stream))
+         return -1;
+   }
+   /* All compressed data was used up, but
+    * the deflate stream has not ended */
+   else if (has_size && stream->real_csize == stream->csize)
+      return -1;
+
+   return (int64_t)used;
+}
+
+/* Handles a complete header (or data descriptor)
+ * in the header buffer */
+static bool zipstream_parse(zipstream_t *stream)
+{
+   const uint8_t *buf = stream->buf;
+
+   if (stream->state == ZIPSTREAM_DESCRIPTOR)
+   {
+      /* The descriptor may or may not begin with
+       * a signature */
+      if (     stream->buf_need == ZIPSTREAM_DESCRIPTOR_SIZE
+            && zipstream_read_le(buf, 4) == ZIPSTREAM_DESCRIPTOR_SIGNATURE)
+      {
+         stream->buf_need += 4;
+         return true;
+      }
+
+      if (stream->buf_need > ZIPSTREAM_DESCRIPTOR_SIZE)
+         buf += 4;
+
+      stream->crc   = zipstream_read_le(buf,     4);
+      stream->csize = zipstream_read_le(buf + 4, 4);
+      stream->size  = zipstream_read_le(buf + 8, 4);
+
+      return zipstream_end_file(stream);
+   }
+
+   if (stream->buf_need == ZIPSTREAM_SIGNATURE_SIZE)
+   {
+      switch (zipstream_read_le(buf, 4))
+      {
+         case ZIPSTREAM_LOCAL_FILE_SIGNATURE:
+            stream->buf_need = ZIPSTREAM_LOCAL_HEADER_SIZE;
+            return true;
+         case ZIPSTREAM_CENTRAL_FILE_SIGNATURE:
+         case ZIPSTREAM_END_OF_CENTRAL_SIGNATURE:
+            /* Every file has been extracted */
+            stream->state = ZIPSTREAM_DONE;
+            return true;
+         default:
+            break;
+      }
+
+      return false;
+   }
+
+   /* Local header: read the file name and
+    * extra field that follow it */
+   if (stream->buf_need == ZIPSTREAM_LOCAL_HEADER_SIZE)
+   {
+      size_t extra = zipstream_read_le(buf + 26, 2)
+                   + zipstream_read_le(buf + 28, 2);
+
+      if (extra)
+      {
+         stream->buf_need += extra;
+         return true;
+      }
+   }
+
+   return zipstream_begin_file(stream);
+}
+
+zipstream_t *zipstream_new(const char *dir)
+{
+   zipstream_t *stream = NULL;
+
+   if (!dir || !*dir)
+      return NULL;
+
+   stream = (zipstream_t*)calloc(1, sizeof(*stream));
+
+   if (!stream)
+      return NULL;
+
+   stream->out = (uint8_t*)malloc(ZIPSTREAM_OUT_SIZE);
+
+   if (!stream->out)
+   {
+      free(stream);
+      return NULL;
+   }
+
+   strlcpy(stream->dir, dir, sizeof(stream->dir));
+   zipstream_next_header(stream, ZIPSTREAM_HEADER,
+         ZIPSTREAM_SIGNATURE_SIZE);
+
+   return stream;
+}
+
+bool zipstream_write(zipstream_t *stream, const void *data, size_t len)
+{
+   const uint8_t *in = (const uint8_t*)data;
+
+   if (!stream)
+      return false;
+
+   while (len && stream->state < ZIPSTREAM_DONE)
+   {
+      size_t used = 0;
+
+      if (stream->state == ZIPSTREAM_DATA)
+      {
+         int64_t ret = zipstream_write_data(stream, in, len);
+
+         if (ret < 0)
+            stream->state = ZIPSTREAM_ERROR;
+         else
+            used = (size_t)ret;
+      }
+      else
+      {
+         used = zipstream_fill(stream, in, len);
+
+         if (     stream->state  != ZIPSTREAM_ERROR
+               && stream->buf_len == stream->buf_need
+               && !zipstream_parse(stream))
+            stream->state = ZIPSTREAM_ERROR;
+      }
+
+      in  += used;
+      len -= used;
+   }
+
+   if (stream->state == ZIPSTREAM_ERROR)
+   {
+      zipstream_close_file(stream, false);
+      return false;
+   }
+
+   return true;
+}
+
+bool zipstream_is_done(zipstream_t *stream)
+{
+   return stream && stream->state == ZIPSTREAM_DONE;
+}
+
+void zipstream_free(zipstream_t *stream)
+{
+   if (!stream)
+      return;
+
+   zipstream_close_file(stream, false);
+
+   if (stream->z_inited)
+      inflateEnd(&stream->z);
+
+   free(stream->buf);
+   free(stream->out);
+   free(stream);
+}
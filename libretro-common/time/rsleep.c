@@ -0,0 +1,142 @@
+/* Copyright  (C) 2010-2020 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (rsleep.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__linux__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
+#include <unistd.h>
+#if defined(_POSIX_MONOTONIC_CLOCK) && defined(_POSIX_TIMERS) && (_POSIX_TIMERS > 0)
+/* Same clock as cpu_features_get_time_usec() on these platforms */
+#define RSLEEP_HAVE_CLOCK_NANOSLEEP
+#include <errno.h>
+#endif
+#endif
+
+#include <retro_timers.h>
+#include <features/features_cpu.h>
+#include <time/rsleep.h>
+
+void rsleep_until(int64_t deadline, unsigned spin_usec,
+      rsleep_jitter_t *jitter)
+{
+   int64_t now         = cpu_features_get_time_usec();
+   int64_t sleep_until = deadline - spin_usec;
+
+   if (sleep_until > now)
+   {
+#ifdef RSLEEP_HAVE_CLOCK_NANOSLEEP
+      struct timespec ts;
+      ts.tv_sec        = (time_t)(sleep_until / 1000000);
+      ts.tv_nsec       = (long)(sleep_until % 1000000) * 1000;
+
+      /* Absolute deadline: restarting after a signal does
+       * not push the wake-up back */
+      while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+               &ts, NULL) == EINTR);
+#else
+      unsigned sleep_ms = (unsigned)((sleep_until - now) / 1000);
+
+      if (sleep_ms > 0)
+         retro_sleep(sleep_ms);
+#endif
+   }
+
+   /* Bounded spin for the remainder; if the OS timer already
+    * overshot the deadline, this does nothing */
+   if (spin_usec)
+      while ((now = cpu_features_get_time_usec()) < deadline);
+   else
+      now = cpu_features_get_time_usec();
+
+   if (jitter)
+      rsleep_jitter_add(jitter, now - deadline);
+}
+
+void rsleep_jitter_add(rsleep_jitter_t *jitter, int64_t late_usec)
+{
+   unsigned bucket = 0;
+
+   /* Waking up early is as bad for pacing as waking up late */
+   if (late_usec < 0)
+      late_usec    = -late_usec;
+
+   while (bucket < RSLEEP_JITTER_BUCKETS - 1
+         && late_usec >= ((int64_t)1 << bucket))
+      bucket++;
+
+   jitter->buckets[bucket]++;
+   jitter->count++;
+   jitter->total_usec += late_usec;
+   if (late_usec > jitter->max_usec)
+      jitter->max_usec  = late_usec;
+}
+
+void rsleep_jitter_reset(rsleep_jitter_t *jitter)
+{
+   memset(jitter, 0, sizeof(*jitter));
+}
+
+size_t rsleep_jitter_to_string(const rsleep_jitter_t *jitter,
+      char *s, size_t len)
+{
+   unsigned i;
+   int n;
+   size_t pos = 0;
+
+   if (!len)
+      return 0;
+
+   n = snprintf(s, len, "%u wake-ups, avg %u usec off, max %u usec\n",
+         (unsigned)jitter->count,
+         jitter->count
+         ? (unsigned)(jitter->total_usec / (int64_t)jitter->count) : 0,
+         (unsigned)jitter->max_usec);
+
+   for (i = 0; n >= 0; i++)
+   {
+      /* Truncated */
+      if ((size_t)n >= len - pos)
+         return len - 1;
+      pos += n;
+
+      /* Skip empty buckets */
+      while (i < RSLEEP_JITTER_BUCKETS && !jitter->buckets[i])
+         i++;
+      if (i >= RSLEEP_JITTER_BUCKETS)
+         break;
+
+      if (i <= 1)
+         n = snprintf(s + pos, len - pos, "  %s usec: %u\n",
+               i ? "1" : "< 1", (unsigned)jitter->buckets[i]);
+      else if (i == RSLEEP_JITTER_BUCKETS - 1)
+         n = snprintf(s + pos, len - pos, "  >= %u usec: %u\n",
+               1u << (i - 1), (unsigned)jitter->buckets[i]);
+      else
+         n = snprintf(s + pos, len - pos, "  %u-%u usec: %u\n",
+               1u << (i - 1), (1u << i) - 1,
+               (unsigned)jitter->buckets[i]);
+   }
+
+   return pos;
+}
@@ -0,0 +1,510 @@
+/* Copyright  (C) 2010-2020 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (rtrace.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <libretro.h>
+#include <retro_timers.h>
+#include <features/features_cpu.h>
+#include <streams/file_stream.h>
+#include <time/rtrace.h>
+
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
+/* Without thread local storage, a thread's ring is found
+ * by looking up its id among the registered rings */
+#if defined(HAVE_THREADS) && defined(HAVE_THREAD_STORAGE)
+#define RTRACE_HAVE_TLS
+#endif
+
+/* Orders the event write before the head update that
+ * publishes it (and the dumper's reads the other way
+ * round). x86 already keeps stores in order, so only
+ * the compiler needs to be held back there. */
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define RTRACE_BARRIER() __asm__ __volatile__("" ::: "memory")
+#elif defined(__GNUC__)
+#define RTRACE_BARRIER() __sync_synchronize()
+#elif defined(_MSC_VER)
+#include <intrin.h>
+#define RTRACE_BARRIER() _ReadWriteBarrier()
+#else
+#define RTRACE_BARRIER()
+#endif
+
+/* Counts the threads inside rtrace_record(), so that
+ * rtrace_deinit() can wait for them before freeing the
+ * rings. Compilers without atomic builtins fall back
+ * to the registration lock. */
+#if defined(HAVE_THREADS)
+#if defined(__GNUC__)
+#define RTRACE_ENTER()   __sync_add_and_fetch(&rtrace_recorders, 1)
+#define RTRACE_LEAVE()   __sync_sub_and_fetch(&rtrace_recorders, 1)
+#define RTRACE_PENDING() __sync_add_and_fetch(&rtrace_recorders, 0)
+#elif defined(_MSC_VER)
+#include <windows.h>
+#define RTRACE_ENTER()   InterlockedIncrement(&rtrace_recorders)
+#define RTRACE_LEAVE()   InterlockedDecrement(&rtrace_recorders)
+#define RTRACE_PENDING() InterlockedCompareExchange(&rtrace_recorders, 0, 0)
+#else
+#define RTRACE_LOCKED_COUNT
+#define RTRACE_ENTER()   rtrace_locked_add(1)
+#define RTRACE_LEAVE()   rtrace_locked_add(-1)
+#define RTRACE_PENDING() rtrace_locked_add(0)
+#endif
+#else
+#define RTRACE_ENTER()
+#define RTRACE_LEAVE()
+#endif
+
+typedef struct rtrace_event
+{
+   retro_perf_tick_t ticks;
+   char phase;                   /* Chrome trace phase: 'B', 'E' or 'i' */
+   /* Copied rather than pointed to: the names of core
+    * performance counters live in the core, which may be
+    * unloaded before the rings are dumped */
+   char name[RTRACE_MAX_NAME + 1];
+} rtrace_event_t;
+
+/* One per recording thread. Only the owning thread
+ * writes to it; 'head' counts the events it has ever
+ * written, so the slot of event n is n & mask */
+typedef struct rtrace_thread
+{
+   rtrace_event_t *events;
+   volatile size_t head;
+#if defined(HAVE_THREADS) && !defined(RTRACE_HAVE_TLS)
+   uintptr_t owner;
+#endif
+   unsigned id;
+   char name[RTRACE_MAX_NAME + 1];
+} rtrace_thread_t;
+
+volatile bool rtrace_active                           = false;
+
+static rtrace_thread_t *rtrace_threads[RTRACE_MAX_THREADS];
+static size_t rtrace_capacity                         = 0;
+static retro_perf_tick_t rtrace_start_ticks           = 0;
+static retro_time_t rtrace_start_usec                 = 0;
+static unsigned rtrace_thread_count                   = 0;
+static bool rtrace_initialized                        = false;
+/* Handed to threads that could not get a ring, so
+ * that they do not try again on every event */
+static rtrace_thread_t rtrace_no_thread;
+#ifdef HAVE_THREADS
+static slock_t *rtrace_lock                           = NULL;
+#if defined(_MSC_VER)
+static volatile LONG rtrace_recorders                 = 0;
+#else
+static volatile int rtrace_recorders                  = 0;
+#endif
+#endif
+#if defined(RTRACE_HAVE_TLS)
+static sthread_tls_t rtrace_tls;
+#elif !defined(HAVE_THREADS)
+static rtrace_thread_t *rtrace_current                = NULL;
+#endif
+
+#ifdef RTRACE_LOCKED_COUNT
+static int rtrace_locked_add(int delta)
+{
+   int recorders;
+   slock_lock(rtrace_lock);
+   recorders = (rtrace_recorders += delta);
+   slock_unlock(rtrace_lock);
+   return recorders;
+}
+#endif
+
+static void rtrace_copy_name(char *dst, const char *src)
+{
+   size_t i = 0;
+
+   if (src)
+      for (; i < RTRACE_MAX_NAME && src[i]; i++)
+         dst[i] = src[i];
+   dst[i] = '\0';
+}
+
+static rtrace_thread_t *rtrace_register_thread(void)
+{
+   rtrace_thread_t *thread = NULL;
+
+#ifdef HAVE_THREADS
+   slock_lock(rtrace_lock);
+#endif
+
+   /* rtrace_deinit() clears the flag under the lock,
+    * after which no ring may be handed out */
+   if (!rtrace_initialized)
+      goto end;
+
+   if (rtrace_thread_count < RTRACE_MAX_THREADS)
+   {
+      thread = (rtrace_thread_t*)calloc(1, sizeof(*thread));
+
+      if (thread)
+      {
+         thread->events = (rtrace_event_t*)malloc(
+               rtrace_capacity * sizeof(*thread->events));
+
+         if (thread->events)
+         {
+#if defined(HAVE_THREADS) && !defined(RTRACE_HAVE_TLS)
+            thread->owner                       = sthread_get_current_thread_id();
+#endif
+            thread->id                          = rtrace_thread_count;
+            rtrace_threads[rtrace_thread_count] = thread;
+            RTRACE_BARRIER();
+            rtrace_thread_count++;
+         }
+         else
+         {
+            free(thread);
+            thread = NULL;
+         }
+      }
+   }
+
+   if (!thread)
+      thread = &rtrace_no_thread;
+
+#if defined(RTRACE_HAVE_TLS)
+   sthread_tls_set(&rtrace_tls, thread);
+#elif !defined(HAVE_THREADS)
+   rtrace_current = thread;
+#endif
+
+end:
+#ifdef HAVE_THREADS
+   slock_unlock(rtrace_lock);
+#endif
+
+   if (!thread)
+      thread = &rtrace_no_thread;
+
+   return thread;
+}
+
+static rtrace_thread_t *rtrace_get_thread(void)
+{
+#if defined(RTRACE_HAVE_TLS)
+   rtrace_thread_t *thread = (rtrace_thread_t*)sthread_tls_get(&rtrace_tls);
+
+   if (thread)
+      return thread;
+#elif defined(HAVE_THREADS)
+   unsigned i;
+   uintptr_t self          = sthread_get_current_thread_id();
+   unsigned count          = rtrace_thread_count;
+
+   RTRACE_BARRIER();
+
+   for (i = 0; i < count; i++)
+      if (rtrace_threads[i]->owner == self)
+         return rtrace_threads[i];
+#else
+   if (rtrace_current)
+      return rtrace_current;
+#endif
+
+   return rtrace_register_thread();
+}
+
+static void rtrace_record(const char *name, char phase)
+{
+   size_t head;
+   rtrace_event_t *event;
+   rtrace_thread_t *thread;
+
+   /* The count is raised before rtrace_active is checked
+    * again, and rtrace_deinit() clears the flag before
+    * waiting on the count, so either this call backs out
+    * or rtrace_deinit() waits for it */
+   RTRACE_ENTER();
+
+   if (!rtrace_active)
+      goto end;
+
+   thread = rtrace_get_thread();
+
+   if (!thread->events)
+      goto end;
+
+   head          = thread->head;
+   event         = &thread->events[head & (rtrace_capacity - 1)];
+   event->ticks  = cpu_features_get_perf_counter();
+   event->phase  = phase;
+   rtrace_copy_name(event->name, name);
+
+   RTRACE_BARRIER();
+   thread->head  = head + 1;
+
+end:
+   RTRACE_LEAVE();
+}
+
+bool rtrace_init(size_t events_per_thread)
+{
+   size_t capacity = 1;
+
+   if (rtrace_initialized)
+      return true;
+
+   if (!events_per_thread)
+      events_per_thread = RTRACE_DEFAULT_EVENTS;
+   while (capacity < events_per_thread)
+      capacity <<= 1;
+
+#ifdef HAVE_THREADS
+   if (!(rtrace_lock = slock_new()))
+      return false;
+#endif
+#if defined(RTRACE_HAVE_TLS)
+   if (!sthread_tls_create(&rtrace_tls))
+   {
+      slock_free(rtrace_lock);
+      rtrace_lock = NULL;
+      return false;
+   }
+#elif !defined(HAVE_THREADS)
+   rtrace_current        = NULL;
+#endif
+
+   rtrace_capacity       = capacity;
+   rtrace_thread_count   = 0;
+   rtrace_start_ticks    = cpu_features_get_perf_counter();
+   rtrace_start_usec     = cpu_features_get_time_usec();
+   rtrace_initialized    = true;
+   rtrace_active         = true;
+
+   return true;
+}
+
+void rtrace_deinit(void)
+{
+   unsigned i;
+
+   if (!rtrace_initialized)
+      return;
+
+#ifdef HAVE_THREADS
+   slock_lock(rtrace_lock);
+#endif
+   rtrace_active      = false;
+   rtrace_initialized = false;
+#ifdef HAVE_THREADS
+   slock_unlock(rtrace_lock);
+
+   /* Let threads already past the rtrace_active check
+    * finish writing to their rings */
+   while (RTRACE_PENDING())
+      retro_sleep(0);
+#endif
+
+   for (i = 0; i < rtrace_thread_count; i++)
+   {
+      free(rtrace_threads[i]->events);
+      free(rtrace_threads[i]);
+      rtrace_threads[i] = NULL;
+   }
+   rtrace_thread_count = 0;
+
+#if defined(RTRACE_HAVE_TLS)
+   sthread_tls_delete(&rtrace_tls);
+#endif
+#ifdef HAVE_THREADS
+   slock_free(rtrace_lock);
+   rtrace_lock         = NULL;
+#else
+   rtrace_current      = NULL;
+#endif
+}
+
+void rtrace_set_paused(bool paused)
+{
+   if (rtrace_initialized)
+      rtrace_active = !paused;
+}
+
+bool rtrace_is_initialized(void)
+{
+   return rtrace_initialized;
+}
+
+void rtrace_thread_name(const char *name)
+{
+   rtrace_thread_t *thread;
+
+   if (!rtrace_initialized)
+      return;
+
+   RTRACE_ENTER();
+
+   if (rtrace_initialized)
+   {
+      thread = rtrace_get_thread();
+      if (thread->events)
+         rtrace_copy_name(thread->name, name);
+   }
+
+   RTRACE_LEAVE();
+}
+
+void rtrace_begin(const char *name)
+{
+   rtrace_record(name, 'B');
+}
+
+void rtrace_end(const char *name)
+{
+   rtrace_record(name, 'E');
+}
+
+void rtrace_instant(const char *name)
+{
+   rtrace_record(name, 'i');
+}
+
+static void rtrace_write_string(RFILE *file, const char *str)
+{
+   filestream_putc(file, '"');
+
+   for (; str && *str; str++)
+   {
+      unsigned char c = (unsigned char)*str;
+
+      if (c == '"' || c == '\\')
+      {
+         filestream_putc(file, '\\');
+         filestream_putc(file, c);
+      }
+      else if (c < 0x20)
+         filestream_printf(file, "\\u%04x", c);
+      else
+         filestream_putc(file, c);
+   }
+
+   filestream_putc(file, '"');
+}
+
+bool rtrace_dump(const char *path)
+{
+   unsigned i, count;
+   RFILE *file                  = NULL;
+   rtrace_event_t *events       = NULL;
+   double usec_per_tick         = 1.0;
+   bool first                   = true;
+   retro_perf_tick_t now_ticks  = cpu_features_get_perf_counter();
+   retro_time_t now_usec        = cpu_features_get_time_usec();
+
+   if (!rtrace_initialized)
+      return false;
+
+   /* The perf counter's unit is platform dependent (TSC
+    * cycles, nanoseconds...), so calibrate it against the
+    * microsecond clock over the whole recording */
+   if (now_ticks > rtrace_start_ticks && now_usec > rtrace_start_usec)
+      usec_per_tick = (double)(now_usec - rtrace_start_usec)
+         / (double)(now_ticks - rtrace_start_ticks);
+
+   if (!(events = (rtrace_event_t*)malloc(
+               rtrace_capacity * sizeof(*events))))
+      return false;
+
+   if (!(file = filestream_open(path,
+               RETRO_VFS_FILE_ACCESS_WRITE,
+               RETRO_VFS_FILE_ACCESS_HINT_NONE)))
+   {
+      free(events);
+      return false;
+   }
+
+   filestream_printf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+#ifdef HAVE_THREADS
+   slock_lock(rtrace_lock);
+#endif
+   count = rtrace_thread_count;
+#ifdef HAVE_THREADS
+   slock_unlock(rtrace_lock);
+#endif
+
+   for (i = 0; i < count; i++)
+   {
+      size_t j, n, start, skip, head_after;
+      rtrace_thread_t *thread = rtrace_threads[i];
+      size_t head             = thread->head;
+
+      RTRACE_BARRIER();
+
+      n     = head < rtrace_capacity ? head : rtrace_capacity;
+      start = head - n;
+
+      for (j = 0; j < n; j++)
+         events[j] = thread->events[(start + j) & (rtrace_capacity - 1)];
+
+      RTRACE_BARRIER();
+      head_after = thread->head;
+
+      /* Slots the owner reused while they were being
+       * copied may hold a mix of old and new data */
+      skip = head_after - start > rtrace_capacity
+         ? head_after - start - rtrace_capacity
+         : 0;
+      if (skip > n)
+         skip = n;
+
+      filestream_printf(file,
+            "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":",
+            first ? "" : ",", thread->id);
+      if (thread->name[0])
+         rtrace_write_string(file, thread->name);
+      else
+         filestream_printf(file, "\"thread %u\"", thread->id);
+      filestream_printf(file, "}}");
+      first = false;
+
+      for (j = skip; j < n; j++)
+      {
+         filestream_printf(file, ",\n{\"name\":");
+         rtrace_write_string(file, events[j].name);
+         filestream_printf(file,
+               ",\"ph\":\"%c\",%s\"ts\":%.3f,\"pid\":1,\"tid\":%u}",
+               events[j].phase,
+               events[j].phase == 'i' ? "\"s\":\"t\"," : "",
+               (double)(int64_t)(events[j].ticks - rtrace_start_ticks)
+                  * usec_per_tick,
+               thread->id);
+      }
+   }
+
+   filestream_printf(file, "\n]}\n");
+   filestream_close(file);
+   free(events);
+
+   return true;
+}
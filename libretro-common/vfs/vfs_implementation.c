@@ -170,6 +170,11 @@
 #endif
 #endif
 
+/* fsync() is an option of POSIX, advertised by this macro */
+#if !defined(_WIN32) && defined(_POSIX_FSYNC) && (_POSIX_FSYNC - 0) > 0
+#define HAVE_FSYNC
+#endif
+
 #define RFILE_HINT_UNBUFFERED (1 << 8)
 
 int64_t retro_vfs_file_seek_internal(
@@ -746,6 +751,41 @@ int retro_vfs_file_flush_impl(libretro_vfs_implementation_file *stream)
 #endif
 }
 
+int retro_vfs_file_sync_impl(libretro_vfs_implementation_file *stream)
+{
+#ifdef ORBIS
+   return stream ? 0 : -1;
+#else
+   int fd;
+
+   if (!stream)
+      return -1;
+
+   if ((stream->hints & RFILE_HINT_UNBUFFERED) == 0)
+   {
+      if (fflush(stream->fp) != 0)
+         return -1;
+#ifdef _WIN32
+      fd = _fileno(stream->fp);
+#else
+      fd = fileno(stream->fp);
+#endif
+   }
+   else
+      fd = stream->fd;
+
+#if defined(_WIN32) && !defined(_XBOX)
+   return _commit(fd) == 0 ? 0 : -1;
+#elif defined(HAVE_FSYNC)
+   return fsync(fd) == 0 ? 0 : -1;
+#else
+   /* Flushing is all this platform offers */
+   (void)fd;
+   return 0;
+#endif
+#endif
+}
+
 int retro_vfs_file_remove_impl(const char *path)
 {
 #if defined(_WIN32) && !defined(_XBOX)
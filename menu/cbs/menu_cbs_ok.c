@@ -78,6 +78,9 @@
 #include "../../manual_content_scan.h"
 
 #include <net/net_http.h>
+#if defined(HAVE_COMPRESSION) && defined(HAVE_ZLIB)
+#include <streams/zip_stream.h>
+#endif
 
 #ifdef HAVE_NETWORKING
 #include "../../network/netplay/netplay.h"
@@ -4408,68 +4411,42 @@ static void cb_generic_dir_download(retro_task_t *task,
    }
 }
 
-/* expects http_transfer_t*, file_transfer_t* */
-void cb_generic_download(retro_task_t *task,
-      void *task_data,
-      void *user_data, const char *err)
+/* Returns the directory downloads of type 'enum_idx'
+ * are stored in, using 's' for directories that are
+ * not taken from the settings. Sets 'extract' to false
+ * if downloaded archives must not be extracted */
+static const char *generic_download_get_dir(
+      enum msg_hash_enums enum_idx, settings_t *settings,
+      char *s, size_t len, bool *extract)
 {
-   char output_path[PATH_MAX_LENGTH];
-   char buf[PATH_MAX_LENGTH];
-#if defined(HAVE_COMPRESSION) && defined(HAVE_ZLIB)
-   bool extract                          = true;
-#endif
-   const char             *dir_path      = NULL;
-   file_transfer_t     *transf           = (file_transfer_t*)user_data;
-   settings_t              *settings     = config_get_ptr();
-   http_transfer_data_t        *data     = (http_transfer_data_t*)task_data;
-
-   if (!data || !data->data || !transf)
-      goto finish;
-
-   output_path[0] = '\0';
-
-   /* we have to determine dir_path at the time of writting or else
-    * we'd run into races when the user changes the setting during an
-    * http transfer. */
-   switch (transf->enum_idx)
+   switch (enum_idx)
    {
       case MENU_ENUM_LABEL_CB_CORE_THUMBNAILS_DOWNLOAD:
-         dir_path = settings->paths.directory_thumbnails;
-         break;
+         return settings->paths.directory_thumbnails;
       case MENU_ENUM_LABEL_CB_CORE_CONTENT_DOWNLOAD:
-         dir_path = settings->paths.directory_core_assets;
-#if defined(HAVE_COMPRESSION) && defined(HAVE_ZLIB)
-         extract  = settings->bools.network_buildbot_auto_extract_archive;
-#endif
-         break;
+         *extract = settings->bools.network_buildbot_auto_extract_archive;
+         return settings->paths.directory_core_assets;
       case MENU_ENUM_LABEL_CB_UPDATE_CORE_INFO_FILES:
-         dir_path = settings->paths.path_libretro_info;
-         break;
+         return settings->paths.path_libretro_info;
       case MENU_ENUM_LABEL_CB_UPDATE_ASSETS:
-         dir_path = settings->paths.directory_assets;
-         break;
+         return settings->paths.directory_assets;
       case MENU_ENUM_LABEL_CB_UPDATE_AUTOCONFIG_PROFILES:
-         dir_path = settings->paths.directory_autoconfig;
-         break;
+         return settings->paths.directory_autoconfig;
       case MENU_ENUM_LABEL_CB_UPDATE_DATABASES:
-         dir_path = settings->paths.path_content_database;
-         break;
+         return settings->paths.path_content_database;
       case MENU_ENUM_LABEL_CB_UPDATE_OVERLAYS:
-         dir_path = settings->paths.directory_overlay;
-         break;
+         return settings->paths.directory_overlay;
       case MENU_ENUM_LABEL_CB_UPDATE_CHEATS:
-         dir_path = settings->paths.path_cheat_database;
-         break;
+         return settings->paths.path_cheat_database;
       case MENU_ENUM_LABEL_CB_UPDATE_SHADERS_CG:
       case MENU_ENUM_LABEL_CB_UPDATE_SHADERS_GLSL:
       case MENU_ENUM_LABEL_CB_UPDATE_SHADERS_SLANG:
 #if defined(HAVE_CG) || defined(HAVE_GLSL) || defined(HAVE_SLANG) || defined(HAVE_HLSL)
          {
-            static char shaderdir[PATH_MAX_LENGTH] = {0};
             const char *dirname                    = NULL;
             const char *dir_video_shader           = settings->paths.directory_video_shader;
 
-            switch (transf->enum_idx)
+            switch (enum_idx)
             {
                case MENU_ENUM_LABEL_CB_UPDATE_SHADERS_CG:
                   dirname                                   = "shaders_cg";
@@ -4484,30 +4461,72 @@ void cb_generic_download(retro_task_t *task,
                   break;
             }
 
-            fill_pathname_join(shaderdir, dir_video_shader,
-                  dirname, sizeof(shaderdir));
+            fill_pathname_join(s, dir_video_shader, dirname, len);
 
-            if (!path_is_directory(shaderdir) && !path_mkdir(shaderdir))
-               goto finish;
+            if (!path_is_directory(s) && !path_mkdir(s))
+               return NULL;
 
-            dir_path = shaderdir;
+            return s;
          }
-#endif
+#else
          break;
+#endif
       case MENU_ENUM_LABEL_CB_LAKKA_DOWNLOAD:
-         dir_path = LAKKA_UPDATE_DIR;
-         break;
+         return LAKKA_UPDATE_DIR;
       case MENU_ENUM_LABEL_CB_DISCORD_AVATAR:
-         fill_pathname_application_special(buf, sizeof(buf),
+         fill_pathname_application_special(s, len,
                APPLICATION_SPECIAL_DIRECTORY_THUMBNAILS_DISCORD_AVATARS);
-         dir_path = buf;
-         break;
+         return s;
       default:
          RARCH_WARN("Unknown transfer type '%s' bailing out.\n",
-               msg_hash_to_str(transf->enum_idx));
+               msg_hash_to_str(enum_idx));
          break;
    }
 
+   return NULL;
+}
+
+/* expects http_transfer_t*, file_transfer_t* */
+void cb_generic_download(retro_task_t *task,
+      void *task_data,
+      void *user_data, const char *err)
+{
+   char output_path[PATH_MAX_LENGTH];
+   char buf[PATH_MAX_LENGTH];
+   bool extract                          = true;
+   const char             *dir_path      = NULL;
+   file_transfer_t     *transf           = (file_transfer_t*)user_data;
+   settings_t              *settings     = config_get_ptr();
+   http_transfer_data_t        *data     = (http_transfer_data_t*)task_data;
+
+   if (!data || !data->data || !transf)
+      goto finish;
+
+   output_path[0] = '\0';
+
+#if defined(HAVE_COMPRESSION) && defined(HAVE_ZLIB)
+   /* If archive was extracted while it downloaded,
+    * only the follow-up of the extraction is left */
+   if (transf->user_data)
+   {
+      if (zipstream_is_done((zipstream_t*)transf->user_data))
+      {
+         if (transf->enum_idx == MENU_ENUM_LABEL_CB_UPDATE_ASSETS)
+            generic_action_ok_command(CMD_EVENT_REINIT);
+         goto finish;
+      }
+
+      RARCH_WARN("Failed to extract '%s' while downloading, "
+            "extracting downloaded file instead\n", transf->path);
+   }
+#endif
+
+   /* we have to determine dir_path at the time of writting or else
+    * we'd run into races when the user changes the setting during an
+    * http transfer. */
+   dir_path = generic_download_get_dir(transf->enum_idx, settings,
+         buf, sizeof(buf), &extract);
+
    if (!string_is_empty(dir_path))
       fill_pathname_join(output_path, dir_path,
             transf->path, sizeof(output_path));
@@ -4590,9 +4609,30 @@ finish:
    }
 
    if (transf)
+   {
+#if defined(HAVE_COMPRESSION) && defined(HAVE_ZLIB)
+      zipstream_free((zipstream_t*)transf->user_data);
+#endif
       free(transf);
+   }
+}
+
+#if defined(HAVE_COMPRESSION) && defined(HAVE_ZLIB)
+/* expects file_transfer_t* */
+static bool cb_generic_download_body(void *user_data,
+      const uint8_t *data, size_t len)
+{
+   file_transfer_t *transf = (file_transfer_t*)user_data;
+
+   /* Archives that cannot be extracted here are extracted
+    * once the transfer ends, so the transfer always continues */
+   if (transf && transf->user_data)
+      zipstream_write((zipstream_t*)transf->user_data, data, len);
+
+   return true;
 }
 #endif
+#endif
 
 static int action_ok_download_generic(const char *path,
       const char *label, const char *menu_label,
@@ -4689,8 +4729,35 @@ static int action_ok_download_generic(const char *path,
    else
       net_http_urlencode_full(s3, s2, sizeof(s3));
 
-   task_push_http_transfer_file(s3, suppress_msg,
-         msg_hash_to_str(enum_idx), cb, transf);
+#if defined(HAVE_COMPRESSION) && defined(HAVE_ZLIB)
+   /* Extract archives while they download, instead of
+    * writing them to disk and extracting them afterwards */
+   if (     cb == cb_generic_download
+         && string_is_equal_noncase(path_get_extension(path), "zip"))
+   {
+      char dir[PATH_MAX_LENGTH];
+      bool extract         = true;
+      const char *dir_path = generic_download_get_dir(enum_idx,
+            settings, dir, sizeof(dir), &extract);
+
+      if (extract && !string_is_empty(dir_path))
+         transf->user_data = zipstream_new(dir_path);
+   }
+
+   if (transf->user_data)
+   {
+      if (!task_push_http_transfer_file_stream(s3, suppress_msg,
+               msg_hash_to_str(enum_idx), cb_generic_download_body,
+               cb, transf))
+      {
+         zipstream_free((zipstream_t*)transf->user_data);
+         free(transf);
+      }
+   }
+   else
+#endif
+      task_push_http_transfer_file(s3, suppress_msg,
+            msg_hash_to_str(enum_idx), cb, transf);
 #endif
    return 0;
 }
@@ -5197,10 +5264,8 @@ static int action_ok_delete_entry(const char *path,
       playlist = g_defaults.content_favorites;
 
    if (playlist)
-   {
-      playlist_delete_index(playlist, menu->rpl_entry_selection_ptr);
-      playlist_write_file(playlist);
-   }
+      command_playlist_delete_write(playlist,
+            menu->rpl_entry_selection_ptr);
 
    new_selection_ptr = menu_navigation_get_selection();
    menu_entries_pop_stack(&new_selection_ptr, 0, 1);
@@ -7061,7 +7126,7 @@ static int action_ok_delete_playlist(const char *path,
 
    path = playlist_get_conf_path(playlist);
 
-   filestream_delete(path);
+   playlist_delete_file(path);
 
    menu_environ.type = MENU_ENVIRON_RESET_HORIZONTAL_LIST;
 
@@ -35,6 +35,12 @@
 #include <retro_inline.h>
 #include <gfx/scaler/scaler.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
 #ifdef HAVE_CONFIG_H
 #include "../../config.h"
 #endif
@@ -593,6 +599,13 @@ typedef struct
 {
    retro_time_t thumbnail_load_trigger_time; /* uint64_t */
 
+   /* Menu state that the framebuffer was last
+    * rendered with (see rgui_render()) */
+   uint64_t last_ticker_idx;
+   uint64_t last_ticker_pixel_idx;
+   size_t last_selection;
+   size_t last_entries_size;
+
    gfx_thumbnail_path_data_t *thumbnail_path_data;
 
    struct
@@ -607,6 +620,7 @@ typedef struct
    frame_buf_t frame_buf;
    frame_buf_t background_buf;
    frame_buf_t upscale_buf;
+   frame_buf_t last_frame_buf;
 
    thumbnail_t fs_thumbnail;
    thumbnail_t mini_thumbnail;
@@ -631,6 +645,11 @@ typedef struct
    unsigned menu_aspect_ratio;
    unsigned menu_aspect_ratio_lock;
    unsigned language;
+   /* Range of framebuffer rows [start, end) that
+    * have changed since the upscaling buffer was
+    * last refreshed */
+   unsigned dirty_y_start;
+   unsigned dirty_y_end;
 
    rgui_term_layout_t term_layout;
 
@@ -666,6 +685,11 @@ typedef struct
    bool thumbnail_load_pending;
    bool show_wallpaper;
    bool aspect_update_pending;
+   /* Set whenever input, navigation or newly loaded
+    * images change what the menu shows; unlike
+    * force_redraw, pending list refreshes are still
+    * honoured */
+   bool redraw_pending;
 #ifdef HAVE_GFX_WIDGETS
    bool widgets_supported;
 #endif
@@ -1110,6 +1134,83 @@ static void rgui_set_pixel_format_function(void)
       argb32_to_pixel_platform_format = argb32_to_rgba4444;
 }
 
+/* Converts a scanline of ARGB8888 pixels (wallpapers,
+ * thumbnails) to the current platform pixel format.
+ * The default RGBA4444 format is converted 8 pixels
+ * at a time with SSE2 or NEON where available */
+static void rgui_convert_scanline(uint16_t *dst,
+      const uint32_t *src, unsigned len)
+{
+   unsigned i = 0;
+
+   if (argb32_to_pixel_platform_format == argb32_to_rgba4444)
+   {
+#if defined(__SSE2__)
+      __m128i r_mask = _mm_set1_epi32(0xF000);
+      __m128i g_mask = _mm_set1_epi32(0x0F00);
+      __m128i b_mask = _mm_set1_epi32(0x00F0);
+
+      for (; i + 8 <= len; i += 8)
+      {
+         __m128i lo = _mm_loadu_si128((const __m128i*)(src + i));
+         __m128i hi = _mm_loadu_si128((const __m128i*)(src + i + 4));
+
+         lo = _mm_or_si128(
+               _mm_or_si128(
+                  _mm_and_si128(_mm_srli_epi32(lo, 8), r_mask),
+                  _mm_and_si128(_mm_srli_epi32(lo, 4), g_mask)),
+               _mm_or_si128(
+                  _mm_and_si128(lo, b_mask),
+                  _mm_srli_epi32(lo, 28)));
+         hi = _mm_or_si128(
+               _mm_or_si128(
+                  _mm_and_si128(_mm_srli_epi32(hi, 8), r_mask),
+                  _mm_and_si128(_mm_srli_epi32(hi, 4), g_mask)),
+               _mm_or_si128(
+                  _mm_and_si128(hi, b_mask),
+                  _mm_srli_epi32(hi, 28)));
+
+         /* Sign extend the low 16 bits so that the
+          * saturating pack leaves them untouched */
+         lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+         hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+
+         _mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi32(lo, hi));
+      }
+#elif defined(__ARM_NEON__)
+      uint32x4_t r_mask = vdupq_n_u32(0xF000);
+      uint32x4_t g_mask = vdupq_n_u32(0x0F00);
+      uint32x4_t b_mask = vdupq_n_u32(0x00F0);
+
+      for (; i + 8 <= len; i += 8)
+      {
+         uint32x4_t lo = vld1q_u32(src + i);
+         uint32x4_t hi = vld1q_u32(src + i + 4);
+
+         lo = vorrq_u32(
+               vorrq_u32(
+                  vandq_u32(vshrq_n_u32(lo, 8), r_mask),
+                  vandq_u32(vshrq_n_u32(lo, 4), g_mask)),
+               vorrq_u32(
+                  vandq_u32(lo, b_mask),
+                  vshrq_n_u32(lo, 28)));
+         hi = vorrq_u32(
+               vorrq_u32(
+                  vandq_u32(vshrq_n_u32(hi, 8), r_mask),
+                  vandq_u32(vshrq_n_u32(hi, 4), g_mask)),
+               vorrq_u32(
+                  vandq_u32(hi, b_mask),
+                  vshrq_n_u32(hi, 28)));
+
+         vst1q_u16(dst + i, vcombine_u16(vmovn_u32(lo), vmovn_u32(hi)));
+      }
+#endif
+   }
+
+   for (; i < len; i++)
+      dst[i] = argb32_to_pixel_platform_format(src[i]);
+}
+
 /* ==============================
  * pixel format conversion END
  * ============================== */
@@ -1252,6 +1353,47 @@ english:
    return true;
 }
 
+/* Fills scanline pixels [x_start, x_end) with a
+ * repeating 4 pixel pattern, such that pixel x is
+ * set to pattern[x & 3]. Used to generate solid
+ * fills (all pattern values identical) and the
+ * 'dithered' chequerboard fills of rgui_fill_rect() */
+static void rgui_fill_scanline(uint16_t *scanline,
+      unsigned x_start, unsigned x_end, const uint16_t *pattern)
+{
+   unsigned x_index = x_start;
+
+   /* Handle leading pixels until we reach a
+    * multiple of 8 (i.e. a 'whole' vector of
+    * pattern repetitions) */
+   for (; (x_index < x_end) && (x_index & 7); x_index++)
+      *(scanline + x_index) = pattern[x_index & 3];
+
+#if defined(__SSE2__)
+   {
+      __m128i pattern_vec = _mm_setr_epi16(
+            (short)pattern[0], (short)pattern[1],
+            (short)pattern[2], (short)pattern[3],
+            (short)pattern[0], (short)pattern[1],
+            (short)pattern[2], (short)pattern[3]);
+
+      for (; x_index + 8 <= x_end; x_index += 8)
+         _mm_storeu_si128((__m128i*)(scanline + x_index), pattern_vec);
+   }
+#elif defined(__ARM_NEON__)
+   {
+      uint16x4_t pattern_half = vld1_u16(pattern);
+      uint16x8_t pattern_vec  = vcombine_u16(pattern_half, pattern_half);
+
+      for (; x_index + 8 <= x_end; x_index += 8)
+         vst1q_u16(scanline + x_index, pattern_vec);
+   }
+#endif
+
+   for (; x_index < x_end; x_index++)
+      *(scanline + x_index) = pattern[x_index & 3];
+}
+
 static void rgui_fill_rect(
       uint16_t *data,
       unsigned fb_width, unsigned fb_height,
@@ -1260,7 +1402,7 @@ static void rgui_fill_rect(
       uint16_t dark_color, uint16_t light_color,
       bool thickness)
 {
-   unsigned x_index, y_index;
+   unsigned y_index;
    unsigned x_start = x <= fb_width  ? x : fb_width;
    unsigned y_start = y <= fb_height ? y : fb_height;
    unsigned x_end   = x + width;
@@ -1289,9 +1431,15 @@ static void rgui_fill_rect(
       uint16_t *src = scanline_even + x_start;
       uint16_t *dst = data + x_start;
 
+      uint16_t pattern[4];
+
+      pattern[0] = dark_color;
+      pattern[1] = dark_color;
+      pattern[2] = dark_color;
+      pattern[3] = dark_color;
+
       /* Populate source array */
-      for (x_index = x_start; x_index < x_end; x_index++)
-         *(scanline_even + x_index) = dark_color;
+      rgui_fill_scanline(scanline_even, x_start, x_end, pattern);
 
       /* Fill destination array */
       for (y_index = y_start; y_index < y_end; y_index++)
@@ -1304,6 +1452,8 @@ static void rgui_fill_rect(
       uint16_t *src_c      = NULL;
       uint16_t *src_d      = NULL;
       uint16_t *dst        = data + x_start;
+      uint16_t pattern_even[4];
+      uint16_t pattern_odd[4];
 
       /* Determine in which order the source arrays
        * should be copied */
@@ -1337,12 +1487,18 @@ static void rgui_fill_rect(
       }
 
       /* Populate source arrays */
-      for (x_index = x_start; x_index < x_end; x_index++)
-      {
-         bool x_is_even = (((x_index >> 1) & 1) == 0);
-         *(scanline_even + x_index) = x_is_even ? dark_color  : light_color;
-         *(scanline_odd  + x_index) = x_is_even ? light_color : dark_color;
-      }
+      pattern_even[0] = dark_color;
+      pattern_even[1] = dark_color;
+      pattern_even[2] = light_color;
+      pattern_even[3] = light_color;
+
+      pattern_odd[0]  = light_color;
+      pattern_odd[1]  = light_color;
+      pattern_odd[2]  = dark_color;
+      pattern_odd[3]  = dark_color;
+
+      rgui_fill_scanline(scanline_even, x_start, x_end, pattern_even);
+      rgui_fill_scanline(scanline_odd,  x_start, x_end, pattern_odd);
 
       /* Fill destination array */
       for (y_index = y_start    ; y_index < y_end; y_index += 4)
@@ -1362,6 +1518,8 @@ static void rgui_fill_rect(
       uint16_t *src_a      = NULL;
       uint16_t *src_b      = NULL;
       uint16_t *dst        = data + x_start;
+      uint16_t pattern_even[4];
+      uint16_t pattern_odd[4];
 
       /* Determine in which order the source arrays
        * should be copied */
@@ -1377,12 +1535,18 @@ static void rgui_fill_rect(
       }
 
       /* Populate source arrays */
-      for (x_index = x_start; x_index < x_end; x_index++)
-      {
-         bool x_is_even = ((x_index & 1) == 0);
-         *(scanline_even + x_index) = x_is_even ? dark_color  : light_color;
-         *(scanline_odd  + x_index) = x_is_even ? light_color : dark_color;
-      }
+      pattern_even[0] = dark_color;
+      pattern_even[1] = light_color;
+      pattern_even[2] = dark_color;
+      pattern_even[3] = light_color;
+
+      pattern_odd[0]  = light_color;
+      pattern_odd[1]  = dark_color;
+      pattern_odd[2]  = light_color;
+      pattern_odd[3]  = dark_color;
+
+      rgui_fill_scanline(scanline_even, x_start, x_end, pattern_even);
+      rgui_fill_scanline(scanline_odd,  x_start, x_end, pattern_odd);
 
       /* Fill destination array */
       for (y_index = y_start    ; y_index < y_end; y_index += 2)
@@ -1400,21 +1564,24 @@ static void rgui_color_rect(
       unsigned width, unsigned height,
       uint16_t color)
 {
-   unsigned x_index, y_index;
+   unsigned y_index;
    unsigned x_start = x <= fb_width  ? x : fb_width;
    unsigned y_start = y <= fb_height ? y : fb_height;
    unsigned x_end   = x + width;
    unsigned y_end   = y + height;
+   uint16_t pattern[4];
 
    x_end = x_end <= fb_width  ? x_end : fb_width;
    y_end = y_end <= fb_height ? y_end : fb_height;
 
+   pattern[0] = color;
+   pattern[1] = color;
+   pattern[2] = color;
+   pattern[3] = color;
+
    for (y_index = y_start; y_index < y_end; y_index++)
-   {
-      uint16_t *data_ptr = data + (y_index * fb_width);
-      for (x_index = x_start; x_index < x_end; x_index++)
-         *(data_ptr + x_index) = color;
-   }
+      rgui_fill_scanline(data + (y_index * fb_width),
+            x_start, x_end, pattern);
 }
 
 static void rgui_render_border(rgui_t *rgui, uint16_t *data,
@@ -1872,7 +2039,7 @@ static void rgui_render_particle_effect(rgui_t *rgui)
 
 static void process_wallpaper(rgui_t *rgui, struct texture_image *image)
 {
-   unsigned x, y;
+   unsigned y;
    unsigned x_crop_offset;
    unsigned y_crop_offset;
    frame_buf_t *background_buf = &rgui->background_buf;
@@ -1899,16 +2066,12 @@ static void process_wallpaper(rgui_t *rgui, struct texture_image *image)
    y_crop_offset = (image->height - background_buf->height) >> 1;
 
    /* Copy image to wallpaper buffer, performing pixel format conversion */
-   for (x = 0; x < background_buf->width; x++)
-   {
-      for (y = 0; y < background_buf->height; y++)
-      {
-         background_buf->data[x + (y * background_buf->width)] =
-               argb32_to_pixel_platform_format(image->pixels[
-                     (x + x_crop_offset) +
-                     ((y + y_crop_offset) * image->width)]);
-      }
-   }
+   for (y = 0; y < background_buf->height; y++)
+      rgui_convert_scanline(
+            background_buf->data + (y * background_buf->width),
+            image->pixels + x_crop_offset +
+                  ((y + y_crop_offset) * image->width),
+            background_buf->width);
 
    rgui->show_wallpaper = true;
 
@@ -2057,7 +2220,7 @@ static bool downscale_thumbnail(rgui_t *rgui,
 
 static void process_thumbnail(rgui_t *rgui, thumbnail_t *thumbnail, uint32_t *queue_size, struct texture_image *image_src)
 {
-   unsigned x, y;
+   unsigned y;
    struct texture_image *image          = NULL;
    struct texture_image image_resampled = {
       NULL,
@@ -2098,14 +2261,11 @@ static void process_thumbnail(rgui_t *rgui, thumbnail_t *thumbnail, uint32_t *qu
    thumbnail->height = image->height;
 
    /* Copy image to thumbnail buffer, performing pixel format conversion */
-   for (x = 0; x < thumbnail->width; x++)
-   {
-      for (y = 0; y < thumbnail->height; y++)
-      {
-         thumbnail->data[x + (y * thumbnail->width)] =
-            argb32_to_pixel_platform_format(image->pixels[x + (y * thumbnail->width)]);
-      }
-   }
+   for (y = 0; y < thumbnail->height; y++)
+      rgui_convert_scanline(
+            thumbnail->data + (y * thumbnail->width),
+            image->pixels + (y * thumbnail->width),
+            thumbnail->width);
 
    thumbnail->is_valid = true;
 
@@ -2127,6 +2287,8 @@ static bool rgui_load_image(void *userdata, void *data, enum menu_image_type typ
    if (!rgui || !settings)
       return false;
 
+   rgui->redraw_pending = true;
+
    if (!data)
    {
       /* This means we have a 'broken' image. There is no
@@ -3764,6 +3926,112 @@ static enum rgui_entry_value_type rgui_get_entry_value_type(
    return value_type;
 }
 
+static void rgui_framebuffer_free(frame_buf_t *framebuffer)
+{
+   if (!framebuffer)
+      return;
+
+   framebuffer->width  = 0;
+   framebuffer->height = 0;
+   
+   if (framebuffer->data)
+      free(framebuffer->data);
+   framebuffer->data   = NULL;
+}
+
+/* Compares the current framebuffer against a copy of
+ * the last rendered frame, updating the copy and
+ * extending the current dirty region to include any
+ * modified rows.
+ * Returns true if framebuffer contents have changed
+ * (i.e. if the menu texture must be re-uploaded) */
+static bool rgui_update_dirty_region(rgui_t *rgui)
+{
+   unsigned y;
+   frame_buf_t *frame_buf      = &rgui->frame_buf;
+   frame_buf_t *last_frame_buf = &rgui->last_frame_buf;
+   size_t row_size             = frame_buf->width * sizeof(uint16_t);
+   unsigned dirty_y_start      = frame_buf->height;
+   unsigned dirty_y_end        = 0;
+
+   /* (Re)allocate copy of last frame, if required.
+    * This always happens on the first frame, and
+    * whenever the framebuffer changes size */
+   if (  !last_frame_buf->data ||
+         (last_frame_buf->width  != frame_buf->width) ||
+         (last_frame_buf->height != frame_buf->height))
+   {
+      rgui_framebuffer_free(last_frame_buf);
+
+      last_frame_buf->data = (uint16_t*)malloc(
+            frame_buf->width * frame_buf->height * sizeof(uint16_t));
+
+      /* If allocation fails, just treat every
+       * frame as dirty */
+      if (!last_frame_buf->data)
+      {
+         rgui->dirty_y_start = 0;
+         rgui->dirty_y_end   = frame_buf->height;
+         return true;
+      }
+
+      last_frame_buf->width  = frame_buf->width;
+      last_frame_buf->height = frame_buf->height;
+
+      memcpy(last_frame_buf->data, frame_buf->data,
+            frame_buf->height * row_size);
+
+      rgui->dirty_y_start = 0;
+      rgui->dirty_y_end   = frame_buf->height;
+      return true;
+   }
+
+   /* Find modified rows */
+   for (y = 0; y < frame_buf->height; y++)
+   {
+      uint16_t *src = frame_buf->data      + (y * frame_buf->width);
+      uint16_t *dst = last_frame_buf->data + (y * frame_buf->width);
+
+      if (memcmp(src, dst, row_size) != 0)
+      {
+         memcpy(dst, src, row_size);
+
+         if (y < dirty_y_start)
+            dirty_y_start = y;
+         dirty_y_end = y + 1;
+      }
+   }
+
+   /* Nothing has changed */
+   if (dirty_y_end == 0)
+      return false;
+
+   /* Merge with existing dirty region */
+   if (rgui->dirty_y_end == 0)
+   {
+      rgui->dirty_y_start = dirty_y_start;
+      rgui->dirty_y_end   = dirty_y_end;
+   }
+   else
+   {
+      if (dirty_y_start < rgui->dirty_y_start)
+         rgui->dirty_y_start = dirty_y_start;
+      if (dirty_y_end > rgui->dirty_y_end)
+         rgui->dirty_y_end   = dirty_y_end;
+   }
+
+   return true;
+}
+
+/* Forces a full texture upload on the next
+ * call of rgui_render() */
+static void rgui_invalidate_dirty_region(rgui_t *rgui)
+{
+   rgui_framebuffer_free(&rgui->last_frame_buf);
+   rgui->dirty_y_start = 0;
+   rgui->dirty_y_end   = rgui->frame_buf.height;
+}
+
 #if defined(GEKKO)
 /* Need to forward declare this for the Wii build
  * (I'm not going to reorder the functions and mess
@@ -3838,6 +4106,29 @@ static void rgui_render(void *data,
             !current_display_cb && 
             (is_idle || !GFX_DISPLAY_GET_UPDATE_PENDING(p_anim, p_disp)))
          return;
+
+      /* The ticker flags the menu as animated for as
+       * long as any label is scrolling, but its indices
+       * only advance every few frames. If no tweens are
+       * running and neither the ticker nor the menu state
+       * has changed since the last frame, the redraw would
+       * produce an identical framebuffer - skip both it
+       * and the texture upload */
+      if (  !rgui->redraw_pending &&
+            !display_kb &&
+            !current_display_cb &&
+            !msg_force &&
+            !rgui->mouse_show &&
+            !p_anim->animation_is_active &&
+            (use_smooth_ticker
+               ? (p_anim->ticker_pixel_idx == rgui->last_ticker_pixel_idx)
+               : (p_anim->ticker_idx       == rgui->last_ticker_idx)) &&
+            (menu_navigation_get_selection() == rgui->last_selection) &&
+            (entries_end                == rgui->last_entries_size))
+      {
+         p_disp->framebuf_dirty = false;
+         return;
+      }
    }
 
    display_kb = current_display_cb;
@@ -3879,6 +4170,12 @@ static void rgui_render(void *data,
    GFX_ANIMATION_CLEAR_ACTIVE(p_anim);
 
    rgui->force_redraw        = false;
+   rgui->redraw_pending      = false;
+
+   rgui->last_ticker_idx       = p_anim->ticker_idx;
+   rgui->last_ticker_pixel_idx = p_anim->ticker_pixel_idx;
+   rgui->last_selection        = menu_navigation_get_selection();
+   rgui->last_entries_size     = entries_end;
 
    /* Get offset of bottommost entry */
    bottom = (int)(entries_end - rgui->term_layout.height);
@@ -4522,19 +4819,12 @@ static void rgui_render(void *data,
       if (cursor_visible)
          rgui_blit_cursor(rgui);
    }
-}
 
-static void rgui_framebuffer_free(frame_buf_t *framebuffer)
-{
-   if (!framebuffer)
-      return;
-
-   framebuffer->width  = 0;
-   framebuffer->height = 0;
-   
-   if (framebuffer->data)
-      free(framebuffer->data);
-   framebuffer->data   = NULL;
+   /* If the framebuffer is unchanged since the last
+    * frame (e.g. animations are active, but produce
+    * no visible difference), skip the texture upload */
+   if (!rgui_update_dirty_region(rgui))
+      p_disp->framebuf_dirty = false;
 }
 
 static void rgui_thumbnail_free(thumbnail_t *thumbnail)
@@ -5206,6 +5496,7 @@ static void rgui_free(void *data)
    rgui_framebuffer_free(&rgui->frame_buf);
    rgui_framebuffer_free(&rgui->background_buf);
    rgui_framebuffer_free(&rgui->upscale_buf);
+   rgui_framebuffer_free(&rgui->last_frame_buf);
 
    rgui_thumbnail_free(&rgui->fs_thumbnail);
    rgui_thumbnail_free(&rgui->mini_thumbnail);
@@ -5240,6 +5531,10 @@ static void rgui_set_texture(void *data)
    {
       video_driver_set_texture_frame(rgui->frame_buf.data,
          false, fb_width, fb_height, 1.0f);
+
+      /* Upscaling buffer (if any) is now stale */
+      rgui->dirty_y_start = 0;
+      rgui->dirty_y_end   = fb_height;
    }
    else
    {
@@ -5254,6 +5549,10 @@ static void rgui_set_texture(void *data)
       {
          video_driver_set_texture_frame(rgui->frame_buf.data,
             false, fb_width, fb_height, 1.0f);
+
+         /* Upscaling buffer (if any) is now stale */
+         rgui->dirty_y_start = 0;
+         rgui->dirty_y_end   = fb_height;
       }
       else
       {
@@ -5293,6 +5592,10 @@ static void rgui_set_texture(void *data)
             
             upscale_buf->data = (uint16_t*)
                   calloc(out_width * out_height, sizeof(uint16_t));
+
+            /* New buffer must be populated in full */
+            rgui->dirty_y_start = 0;
+            rgui->dirty_y_end   = fb_height;
             if (!upscale_buf->data)
             {
                /* Uh oh... This could mean we don't have enough
@@ -5309,13 +5612,20 @@ static void rgui_set_texture(void *data)
          
          /* Perform nearest neighbour upscaling
           * NB: We're duplicating code here, but trying to handle
-          * this with a polymorphic function is too much of a drag... */
+          * this with a polymorphic function is too much of a drag...
+          * > Only rows of the framebuffer that have changed since
+          *   the last upscale operation are processed */
          x_ratio = ((fb_width  << 16) / out_width);
          y_ratio = ((fb_height << 16) / out_height);
 
          for (y_dst = 0; y_dst < out_height; y_dst++)
          {
             y_src = (y_dst * y_ratio) >> 16;
+
+            if ((y_src < rgui->dirty_y_start) ||
+                (y_src >= rgui->dirty_y_end))
+               continue;
+
             for (x_dst = 0; x_dst < out_width; x_dst++)
             {
                x_src = (x_dst * x_ratio) >> 16;
@@ -5323,6 +5633,9 @@ static void rgui_set_texture(void *data)
             }
          }
          
+         rgui->dirty_y_start = 0;
+         rgui->dirty_y_end   = 0;
+
          /* Draw upscaled texture */
          video_driver_set_texture_frame(upscale_buf->data,
             false, out_width, out_height, 1.0f);
@@ -5338,7 +5651,8 @@ static void rgui_navigation_clear(void *data, bool pending_push)
       return;
 
    menu_entries_ctl(MENU_ENTRIES_CTL_SET_START, &start);
-   rgui->scroll_y = 0;
+   rgui->scroll_y       = 0;
+   rgui->redraw_pending = true;
 }
 
 static void rgui_set_thumbnail_system(void *userdata, char *s, size_t len)
@@ -5619,6 +5933,8 @@ static void rgui_navigation_set(void *data, bool scroll)
    if (!rgui)
       return;
 
+   rgui->redraw_pending = true;
+
    rgui_scan_selected_entry_thumbnail(rgui, false);
    rgui_update_menu_sublabel(rgui);
 
@@ -5792,6 +6108,7 @@ static int rgui_pointer_up(void *data,
    if (!rgui)
       return -1;
 
+   rgui->redraw_pending   = true;
 
    switch (gesture)
    {
@@ -6068,6 +6385,8 @@ static void rgui_toggle(void *userdata, bool menu_on)
     * exit, this doesn't get called. */
    if (!rgui || !settings)
       return;
+
+   rgui->redraw_pending = true;
    
    if (aspect_ratio_lock != RGUI_ASPECT_RATIO_LOCK_NONE)
    {
@@ -6108,6 +6427,11 @@ static void rgui_toggle(void *userdata, bool menu_on)
       free(rgui->upscale_buf.data);
       rgui->upscale_buf.data = NULL;
    }
+
+   /* Menu texture may have been overwritten while
+    * content was running - ensure that the next
+    * frame is uploaded in full */
+   rgui_invalidate_dirty_region(rgui);
 }
 
 static void rgui_context_reset(void *data, bool is_threaded)
@@ -6125,6 +6449,10 @@ static void rgui_context_reset(void *data, bool is_threaded)
       gfx_display_init_white_texture(gfx_display_white_texture);
    }
 #endif
+   /* Menu texture must be recreated */
+   rgui_invalidate_dirty_region(rgui);
+   rgui->force_redraw = true;
+
    video_driver_monitor_reset();
 }
 
@@ -6177,6 +6505,9 @@ static int rgui_menu_entry_action(
    /* Process input action */
    enum menu_action new_action = rgui_parse_menu_entry_action(rgui, action);
 
+   if (rgui && (new_action != MENU_ACTION_NOOP))
+      rgui->redraw_pending = true;
+
    /* Call standard generic_menu_entry_action() function */
    return generic_menu_entry_action(userdata, entry, i, new_action);
 }
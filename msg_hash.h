@@ -467,6 +467,9 @@ enum msg_hash_enums
    MSG_RUNAHEAD_ENABLED,
    MSG_RUNAHEAD_ENABLED_WITH_SECOND_INSTANCE,
    MSG_RUNAHEAD_DISABLED,
+   MSG_FRAME_TRACE_SAVED,
+   MSG_FRAME_TRACE_SAVE_FAILED,
+   MSG_FRAME_TRACE_DISABLED,
    MSG_RUNAHEAD_CORE_DOES_NOT_SUPPORT_SAVESTATES,
    MSG_RUNAHEAD_FAILED_TO_SAVE_STATE,
    MSG_RUNAHEAD_FAILED_TO_LOAD_STATE,
@@ -864,6 +867,7 @@ enum msg_hash_enums
    MENU_ENUM_LABEL_VALUE_INPUT_META_STREAMING_TOGGLE,
    MENU_ENUM_LABEL_VALUE_INPUT_META_RUNAHEAD_TOGGLE,
    MENU_ENUM_LABEL_VALUE_INPUT_META_AI_SERVICE,
+   MENU_ENUM_LABEL_VALUE_INPUT_META_FRAME_TRACE_SAVE,
    MENU_ENUM_LABEL_VALUE_INPUT_META_MENU_TOGGLE,
 
    MENU_ENUM_LABEL_VALUE_INPUT_DEVICE_INDEX,
@@ -917,6 +921,7 @@ enum msg_hash_enums
    MENU_ENUM_SUBLABEL_INPUT_META_STREAMING_TOGGLE,
    MENU_ENUM_SUBLABEL_INPUT_META_RUNAHEAD_TOGGLE,
    MENU_ENUM_SUBLABEL_INPUT_META_AI_SERVICE,
+   MENU_ENUM_SUBLABEL_INPUT_META_FRAME_TRACE_SAVE,
    MENU_ENUM_SUBLABEL_INPUT_META_MENU_TOGGLE,
 
    MENU_ENUM_LABEL_INPUT_DESCRIPTION,
@@ -1002,6 +1007,7 @@ enum msg_hash_enums
    MENU_LABEL(VIDEO_GPU_SCREENSHOT),
    MENU_LABEL(VIDEO_BLACK_FRAME_INSERTION),
    MENU_LABEL(VIDEO_FRAME_DELAY),
+   MENU_LABEL(VIDEO_FRAME_DELAY_AUTO),
    MENU_LABEL(VIDEO_SHADER_DELAY),
    MENU_LABEL(VIDEO_VSYNC),
    MENU_LABEL(VIDEO_ADAPTIVE_VSYNC),
@@ -1818,6 +1824,7 @@ enum msg_hash_enums
    MENU_LABEL(NETPLAY_SPECTATE_PASSWORD),
    MENU_LABEL(NETPLAY_MODE),
    MENU_LABEL(PERFCNT_ENABLE),
+   MENU_LABEL(FRAME_TRACE_ENABLE),
    MENU_LABEL(OVERLAY_SCALE_LANDSCAPE),
    MENU_LABEL(OVERLAY_ASPECT_ADJUST_LANDSCAPE),
    MENU_LABEL(OVERLAY_X_SEPARATION_LANDSCAPE),
@@ -1842,6 +1849,7 @@ enum msg_hash_enums
    MENU_LABEL(OVERLAY_CENTER_Y),
 
    MENU_LABEL(FASTFORWARD_RATIO),
+   MENU_LABEL(FRAME_LIMIT_SPIN_USEC),
    MENU_LABEL(VRR_RUNLOOP_ENABLE),
    MENU_LABEL(REWIND_ENABLE),
    MENU_LABEL(CHEAT_APPLY_AFTER_TOGGLE),
@@ -1899,6 +1907,8 @@ enum msg_hash_enums
    MENU_LABEL(SLOWMOTION_RATIO),
    MENU_LABEL(RUN_AHEAD_ENABLED),
    MENU_LABEL(RUN_AHEAD_SECONDARY_INSTANCE),
+   MENU_LABEL(RUN_AHEAD_SECONDARY_THREADED),
+   MENU_LABEL(PREEMPT_ENABLE),
    MENU_LABEL(RUN_AHEAD_HIDE_WARNINGS),
    MENU_LABEL(RUN_AHEAD_FRAMES),
    MENU_LABEL(INPUT_BLOCK_TIMEOUT),
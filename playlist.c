@@ -20,13 +20,26 @@
 #include <string.h>
 #include <ctype.h>
 
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifdef HAVE_MMAP
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 #include <libretro.h>
 #include <boolean.h>
 #include <retro_assert.h>
 #include <retro_miscellaneous.h>
 #include <compat/posix_string.h>
 #include <string/stdstring.h>
+#include <encodings/crc32.h>
 #include <streams/interface_stream.h>
+#include <streams/file_stream.h>
 #include <file/file_path.h>
 #include <lists/string_list.h>
 #include <formats/rjson.h>
@@ -56,6 +69,26 @@
 #define USING_POSIX_FILE_SYSTEM
 #endif
 
+/* Path index slot states */
+#define PLAYLIST_INDEX_EMPTY        0
+#define PLAYLIST_INDEX_USED         1
+#define PLAYLIST_INDEX_DELETED      2
+
+/* Mixed into the hash of the archive part of an
+ * [archive_path][delimiter][rom_file] entry path, so that
+ * it does not collide with the key of the entry path itself */
+#define PLAYLIST_INDEX_ARCHIVE_SEED 0x9E3779B9
+
+#define PLAYLIST_INDEX_MIN_SIZE     64
+
+typedef struct
+{
+   uint32_t hash;
+   /* Entry index, minus index_offset */
+   uint32_t pos;
+   uint8_t state;
+} playlist_index_slot_t;
+
 struct content_playlist
 {
    char *default_core_path;
@@ -64,8 +97,28 @@ struct content_playlist
 
    struct playlist_entry *entries;
 
+   /* Open addressing hash table of entry paths,
+    * see playlist_index_ensure() */
+   playlist_index_slot_t *index;
+   size_t index_size;  /* Power of two */
+   size_t index_used;  /* Used + deleted slots */
+   size_t index_live;  /* Used slots */
+
    playlist_config_t config;  /* size_t alignment */
 
+   /* Added to every stored position, so that pushing
+    * an entry to the top renumbers all others at once */
+   uint32_t index_offset;
+
+   /* Mapped binary copy of the playlist file, see
+    * playlist_bin_read(). Strings of the entries read
+    * from it point into it */
+   uint8_t *bin_data;
+   size_t bin_size;
+
+   /* Records in the journal file, see playlist_journal_append() */
+   unsigned journal_records;
+
    enum playlist_label_display_mode label_display_mode;
    enum playlist_thumbnail_mode right_thumbnail_mode;
    enum playlist_thumbnail_mode left_thumbnail_mode;
@@ -75,6 +128,7 @@ struct content_playlist
    bool old_format;
    bool compressed;
    bool cached_external;
+   bool index_valid;
 };
 
 typedef struct
@@ -352,6 +406,340 @@ static bool playlist_core_path_equal(const char *real_core_path, const char *ent
    return false;
 }
 
+/* Path index
+ *
+ * Without it, looking up, removing or de-duplicating a path
+ * resolves and compares the path of every entry, which makes
+ * each push O(n) filesystem calls. The index maps a hash of
+ * each entry's resolved path to its position, so only the
+ * entries that hash alike are compared - still through
+ * playlist_path_equal(), so matching is unchanged.
+ *
+ * Entries of the form [archive_path][delimiter][rom_file]
+ * are also indexed by [archive_path], for the fuzzy archive
+ * match of playlist_path_equal(). Hashes fold case wherever
+ * paths are compared case insensitively.
+ *
+ * The index is built on first use, kept up to date by the
+ * functions that add, move or remove entries, and dropped
+ * by anything that reorders the whole playlist. */
+
+static uint32_t playlist_index_hash(const char *path, size_t len,
+      uint32_t seed)
+{
+   size_t i;
+   /* FNV-1a */
+   uint32_t hash = 2166136261U ^ seed;
+
+   for (i = 0; i < len; i++)
+   {
+#ifdef _WIN32
+      hash ^= (uint32_t)tolower((unsigned char)path[i]);
+#else
+      hash ^= (uint32_t)(unsigned char)path[i];
+#endif
+      hash *= 16777619U;
+   }
+
+   return hash;
+}
+
+static void playlist_index_free(playlist_t *playlist)
+{
+   free(playlist->index);
+   playlist->index        = NULL;
+   playlist->index_size   = 0;
+   playlist->index_used   = 0;
+   playlist->index_live   = 0;
+   playlist->index_offset = 0;
+   playlist->index_valid  = false;
+}
+
+static bool playlist_index_resize(playlist_t *playlist, size_t size)
+{
+   size_t i;
+   playlist_index_slot_t *slots = (playlist_index_slot_t*)
+      calloc(size, sizeof(*slots));
+
+   if (!slots)
+      return false;
+
+   /* Stored hashes are reused, so no path is resolved again */
+   for (i = 0; i < playlist->index_size; i++)
+   {
+      size_t j;
+      const playlist_index_slot_t *slot = &playlist->index[i];
+
+      if (slot->state != PLAYLIST_INDEX_USED)
+         continue;
+
+      for (j = slot->hash & (size - 1);
+           slots[j].state == PLAYLIST_INDEX_USED;
+           j = (j + 1) & (size - 1));
+
+      slots[j] = *slot;
+   }
+
+   free(playlist->index);
+   playlist->index      = slots;
+   playlist->index_size = size;
+   playlist->index_used = playlist->index_live;
+   return true;
+}
+
+static void playlist_index_insert(playlist_t *playlist,
+      uint32_t hash, size_t idx)
+{
+   size_t i;
+   playlist_index_slot_t *slot = NULL;
+
+   if (!playlist->index_valid)
+      return;
+
+   /* Keep at least half of the slots empty, so
+    * that probe sequences stay short */
+   if ((playlist->index_used + 1) * 2 > playlist->index_size)
+   {
+      size_t size = PLAYLIST_INDEX_MIN_SIZE;
+
+      while (size < (playlist->index_live + 1) * 4)
+         size <<= 1;
+
+      if (!playlist_index_resize(playlist, size))
+      {
+         /* Lookups fall back to comparing every entry */
+         playlist_index_free(playlist);
+         return;
+      }
+   }
+
+   for (i = hash & (playlist->index_size - 1);
+        playlist->index[i].state == PLAYLIST_INDEX_USED;
+        i = (i + 1) & (playlist->index_size - 1));
+
+   slot = &playlist->index[i];
+
+   if (slot->state == PLAYLIST_INDEX_EMPTY)
+      playlist->index_used++;
+   playlist->index_live++;
+
+   slot->hash  = hash;
+   slot->pos   = (uint32_t)idx - playlist->index_offset;
+   slot->state = PLAYLIST_INDEX_USED;
+}
+
+/* Adds the keys of the entry at @idx */
+static void playlist_index_add(playlist_t *playlist, size_t idx)
+{
+   const char *delim;
+   char real_path[PATH_MAX_LENGTH];
+   const char *entry_path = playlist->entries[idx].path;
+
+   if (!playlist->index_valid)
+      return;
+
+   /* Entries without a path only match an empty search path */
+   if (string_is_empty(entry_path))
+   {
+      playlist_index_insert(playlist,
+            playlist_index_hash("", 0, 0), idx);
+      return;
+   }
+
+   /* Must be resolved the same way as in playlist_path_equal() */
+   strlcpy(real_path, entry_path, sizeof(real_path));
+   path_resolve_realpath(real_path, sizeof(real_path), true);
+
+   if (string_is_empty(real_path))
+      return;
+
+   playlist_index_insert(playlist,
+         playlist_index_hash(real_path, strlen(real_path), 0), idx);
+
+   if (!path_is_compressed_file(real_path) &&
+       (delim = path_get_archive_delim(real_path)))
+      playlist_index_insert(playlist,
+            playlist_index_hash(real_path, delim - real_path,
+                  PLAYLIST_INDEX_ARCHIVE_SEED), idx);
+}
+
+/* Removes the keys of the entry at @idx. If @shift is set,
+ * the entry has been removed from the playlist and the
+ * entries that followed it are moved up by one */
+static void playlist_index_remove(playlist_t *playlist,
+      size_t idx, bool shift)
+{
+   size_t i;
+   uint32_t removed = (uint32_t)idx;
+
+   if (!playlist->index_valid)
+      return;
+
+   /* Positions of unused slots are meaningless, so they
+    * are shifted too: this keeps the loop free of
+    * unpredictable branches */
+   for (i = 0; i < playlist->index_size; i++)
+   {
+      playlist_index_slot_t *slot = &playlist->index[i];
+      uint32_t slot_idx           = slot->pos + playlist->index_offset;
+
+      if (slot_idx == removed && slot->state == PLAYLIST_INDEX_USED)
+      {
+         slot->state = PLAYLIST_INDEX_DELETED;
+         playlist->index_live--;
+      }
+
+      if (shift)
+         slot->pos -= (slot_idx > removed);
+   }
+}
+
+/* Moves down the entries in front of the one at @idx,
+ * which moves to the top */
+static void playlist_index_move_to_top(playlist_t *playlist, size_t idx)
+{
+   size_t i;
+   uint32_t moved = (uint32_t)idx;
+
+   if (!playlist->index_valid)
+      return;
+
+   /* As in playlist_index_remove(), unused slots are
+    * updated too */
+   for (i = 0; i < playlist->index_size; i++)
+   {
+      playlist_index_slot_t *slot = &playlist->index[i];
+      uint32_t slot_idx           = slot->pos + playlist->index_offset;
+
+      slot->pos += (slot_idx < moved);
+
+      if (slot_idx == moved)
+         slot->pos = 0 - playlist->index_offset;
+   }
+}
+
+/**
+ * playlist_index_ensure:
+ * @playlist        : Playlist handle.
+ *
+ * Builds the path index if it is not up to date.
+ *
+ * Returns: true if the index can be used.
+ **/
+static bool playlist_index_ensure(playlist_t *playlist)
+{
+   size_t i;
+   size_t len;
+
+   if (playlist->index_valid)
+      return true;
+
+   playlist_index_free(playlist);
+   playlist->index_valid = true;
+
+   for (i = 0, len = RBUF_LEN(playlist->entries);
+        i < len && playlist->index_valid; i++)
+      playlist_index_add(playlist, i);
+
+   return playlist->index_valid;
+}
+
+static bool playlist_entry_path_matches(playlist_t *playlist,
+      const char *real_path, size_t idx)
+{
+   const char *entry_path = playlist->entries[idx].path;
+
+   if (string_is_empty(real_path))
+      return string_is_empty(entry_path);
+
+   return playlist_path_equal(real_path, entry_path, &playlist->config);
+}
+
+static size_t playlist_index_probe(playlist_t *playlist,
+      const char *real_path, uint32_t hash, size_t from, size_t found)
+{
+   size_t i;
+
+   for (i = hash & (playlist->index_size - 1);
+        playlist->index[i].state != PLAYLIST_INDEX_EMPTY;
+        i = (i + 1) & (playlist->index_size - 1))
+   {
+      size_t idx;
+      const playlist_index_slot_t *slot = &playlist->index[i];
+
+      if (slot->state != PLAYLIST_INDEX_USED || slot->hash != hash)
+         continue;
+
+      idx = (uint32_t)(slot->pos + playlist->index_offset);
+
+      if (idx >= from && idx < found &&
+          playlist_entry_path_matches(playlist, real_path, idx))
+         found = idx;
+   }
+
+   return found;
+}
+
+/**
+ * playlist_find_path:
+ * @playlist        : Playlist handle.
+ * @real_path       : 'Real' search path, generated by path_resolve_realpath()
+ * @from            : First entry index to consider
+ *
+ * Finds the first entry at or after @from whose path
+ * matches @real_path, as per playlist_path_equal().
+ * An empty search path matches entries without a path.
+ *
+ * Returns: index of the entry, or the size of the
+ * playlist if there is none.
+ **/
+static size_t playlist_find_path(playlist_t *playlist,
+      const char *real_path, size_t from)
+{
+   size_t len   = RBUF_LEN(playlist->entries);
+   size_t found = len;
+
+   if (from >= len)
+      return len;
+
+   if (!playlist_index_ensure(playlist))
+   {
+      for (; from < len; from++)
+         if (playlist_entry_path_matches(playlist, real_path, from))
+            return from;
+      return len;
+   }
+
+   if (string_is_empty(real_path))
+      return playlist_index_probe(playlist, real_path,
+            playlist_index_hash("", 0, 0), from, found);
+
+   found = playlist_index_probe(playlist, real_path,
+         playlist_index_hash(real_path, strlen(real_path), 0),
+         from, found);
+
+#ifdef RARCH_INTERNAL
+   if (playlist->config.fuzzy_archive_match)
+#endif
+   {
+      /* Archive path matching [archive_path][delimiter][rom_file]
+       * entries, or the other way around */
+      const char *delim = NULL;
+
+      if (path_is_compressed_file(real_path))
+         found = playlist_index_probe(playlist, real_path,
+               playlist_index_hash(real_path, strlen(real_path),
+                     PLAYLIST_INDEX_ARCHIVE_SEED),
+               from, found);
+      else if ((delim = path_get_archive_delim(real_path)))
+         found = playlist_index_probe(playlist, real_path,
+               playlist_index_hash(real_path, delim - real_path, 0),
+               from, found);
+   }
+
+   return found;
+}
+
 uint32_t playlist_get_size(playlist_t *playlist)
 {
    if (!playlist)
@@ -386,33 +774,42 @@ void playlist_get_index(playlist_t *playlist,
    *entry = &playlist->entries[idx];
 }
 
+/* Frees a string of the playlist or of one of its
+ * entries, unless it points into the binary copy of
+ * the playlist file */
+static void playlist_free_string(const playlist_t *playlist, char *s)
+{
+   if (!s)
+      return;
+
+   if (     ((uintptr_t)s >= (uintptr_t)playlist->bin_data)
+         && ((uintptr_t)s <  (uintptr_t)playlist->bin_data + playlist->bin_size))
+      return;
+
+   free(s);
+}
+
 /**
  * playlist_free_entry:
+ * @playlist            : Playlist handle.
  * @entry               : Playlist entry handle.
  *
  * Frees playlist entry.
  **/
-static void playlist_free_entry(struct playlist_entry *entry)
+static void playlist_free_entry(playlist_t *playlist,
+      struct playlist_entry *entry)
 {
    if (!entry)
       return;
 
-   if (entry->path)
-      free(entry->path);
-   if (entry->label)
-      free(entry->label);
-   if (entry->core_path)
-      free(entry->core_path);
-   if (entry->core_name)
-      free(entry->core_name);
-   if (entry->db_name)
-      free(entry->db_name);
-   if (entry->crc32)
-      free(entry->crc32);
-   if (entry->subsystem_ident)
-      free(entry->subsystem_ident);
-   if (entry->subsystem_name)
-      free(entry->subsystem_name);
+   playlist_free_string(playlist, entry->path);
+   playlist_free_string(playlist, entry->label);
+   playlist_free_string(playlist, entry->core_path);
+   playlist_free_string(playlist, entry->core_name);
+   playlist_free_string(playlist, entry->db_name);
+   playlist_free_string(playlist, entry->crc32);
+   playlist_free_string(playlist, entry->subsystem_ident);
+   playlist_free_string(playlist, entry->subsystem_name);
    if (entry->runtime_str)
       free(entry->runtime_str);
    if (entry->last_played_str)
@@ -466,13 +863,14 @@ void playlist_delete_index(playlist_t *playlist,
    /* Free unwanted entry */
    entry_to_delete = (struct playlist_entry *)(playlist->entries + idx);
    if (entry_to_delete)
-      playlist_free_entry(entry_to_delete);
+      playlist_free_entry(playlist, entry_to_delete);
 
    /* Shift remaining entries to fill the gap */
    memmove(playlist->entries + idx, playlist->entries + idx + 1,
          (len - 1 - idx) * sizeof(struct playlist_entry));
 
    RBUF_RESIZE(playlist->entries, len - 1);
+   playlist_index_remove(playlist, idx, true);
 
    playlist->modified = true;
 }
@@ -500,20 +898,17 @@ void playlist_delete_by_path(playlist_t *playlist,
    strlcpy(real_search_path, search_path, sizeof(real_search_path));
    path_resolve_realpath(real_search_path, sizeof(real_search_path), true);
 
-   while (i < RBUF_LEN(playlist->entries))
-   {
-      if (!playlist_path_equal(real_search_path, playlist->entries[i].path,
-            &playlist->config))
-      {
-         i++;
-         continue;
-      }
+   if (string_is_empty(real_search_path))
+      return;
 
+   while ((i = playlist_find_path(playlist, real_search_path, i))
+         < RBUF_LEN(playlist->entries))
+   {
       /* Paths are equal - delete entry */
       playlist_delete_index(playlist, i);
 
       /* Entries are shifted up by the delete
-       * operation - *do not* increment i */
+       * operation - search again from i */
    }
 }
 
@@ -521,7 +916,7 @@ void playlist_get_index_by_path(playlist_t *playlist,
       const char *search_path,
       const struct playlist_entry **entry)
 {
-   size_t i, len;
+   size_t i;
    char real_search_path[PATH_MAX_LENGTH];
 
    real_search_path[0] = '\0';
@@ -533,22 +928,18 @@ void playlist_get_index_by_path(playlist_t *playlist,
    strlcpy(real_search_path, search_path, sizeof(real_search_path));
    path_resolve_realpath(real_search_path, sizeof(real_search_path), true);
 
-   for (i = 0, len = RBUF_LEN(playlist->entries); i < len; i++)
-   {
-      if (!playlist_path_equal(real_search_path, playlist->entries[i].path,
-               &playlist->config))
-         continue;
+   if (string_is_empty(real_search_path))
+      return;
 
-      *entry = &playlist->entries[i];
+   i = playlist_find_path(playlist, real_search_path, 0);
 
-      break;
-   }
+   if (i < RBUF_LEN(playlist->entries))
+      *entry = &playlist->entries[i];
 }
 
 bool playlist_entry_exists(playlist_t *playlist,
       const char *path)
 {
-   size_t i, len;
    char real_search_path[PATH_MAX_LENGTH];
 
    real_search_path[0] = '\0';
@@ -560,14 +951,11 @@ bool playlist_entry_exists(playlist_t *playlist,
    strlcpy(real_search_path, path, sizeof(real_search_path));
    path_resolve_realpath(real_search_path, sizeof(real_search_path), true);
 
-   for (i = 0, len = RBUF_LEN(playlist->entries); i < len; i++)
-   {
-      if (playlist_path_equal(real_search_path, playlist->entries[i].path,
-               &playlist->config))
-         return true;
-   }
+   if (string_is_empty(real_search_path))
+      return false;
 
-   return false;
+   return playlist_find_path(playlist, real_search_path, 0)
+         < RBUF_LEN(playlist->entries);
 }
 
 void playlist_update(playlist_t *playlist, size_t idx,
@@ -582,24 +970,24 @@ void playlist_update(playlist_t *playlist, size_t idx,
 
    if (update_entry->path && (update_entry->path != entry->path))
    {
-      if (entry->path)
-         free(entry->path);
+      playlist_free_string(playlist, entry->path);
       entry->path        = strdup(update_entry->path);
       playlist->modified = true;
+
+      playlist_index_remove(playlist, idx, false);
+      playlist_index_add(playlist, idx);
    }
 
    if (update_entry->label && (update_entry->label != entry->label))
    {
-      if (entry->label)
-         free(entry->label);
+      playlist_free_string(playlist, entry->label);
       entry->label       = strdup(update_entry->label);
       playlist->modified = true;
    }
 
    if (update_entry->core_path && (update_entry->core_path != entry->core_path))
    {
-      if (entry->core_path)
-         free(entry->core_path);
+      playlist_free_string(playlist, entry->core_path);
       entry->core_path   = NULL;
       entry->core_path   = strdup(update_entry->core_path);
       playlist->modified = true;
@@ -607,24 +995,21 @@ void playlist_update(playlist_t *playlist, size_t idx,
 
    if (update_entry->core_name && (update_entry->core_name != entry->core_name))
    {
-      if (entry->core_name)
-         free(entry->core_name);
+      playlist_free_string(playlist, entry->core_name);
       entry->core_name   = strdup(update_entry->core_name);
       playlist->modified = true;
    }
 
    if (update_entry->db_name && (update_entry->db_name != entry->db_name))
    {
-      if (entry->db_name)
-         free(entry->db_name);
+      playlist_free_string(playlist, entry->db_name);
       entry->db_name     = strdup(update_entry->db_name);
       playlist->modified = true;
    }
 
    if (update_entry->crc32 && (update_entry->crc32 != entry->crc32))
    {
-      if (entry->crc32)
-         free(entry->crc32);
+      playlist_free_string(playlist, entry->crc32);
       entry->crc32       = strdup(update_entry->crc32);
       playlist->modified = true;
    }
@@ -643,17 +1028,18 @@ void playlist_update_runtime(playlist_t *playlist, size_t idx,
 
    if (update_entry->path && (update_entry->path != entry->path))
    {
-      if (entry->path)
-         free(entry->path);
+      playlist_free_string(playlist, entry->path);
       entry->path        = NULL;
       entry->path        = strdup(update_entry->path);
       playlist->modified = playlist->modified || register_update;
+
+      playlist_index_remove(playlist, idx, false);
+      playlist_index_add(playlist, idx);
    }
 
    if (update_entry->core_path && (update_entry->core_path != entry->core_path))
    {
-      if (entry->core_path)
-         free(entry->core_path);
+      playlist_free_string(playlist, entry->core_path);
       entry->core_path   = NULL;
       entry->core_path   = strdup(update_entry->core_path);
       playlist->modified = playlist->modified || register_update;
@@ -778,19 +1164,13 @@ bool playlist_push_runtime(playlist_t *playlist,
    }
 
    len = RBUF_LEN(playlist->entries);
-   for (i = 0; i < len; i++)
+   for (i = playlist_find_path(playlist, real_path, 0); i < len;
+        i = playlist_find_path(playlist, real_path, i + 1))
    {
       struct playlist_entry tmp;
-      const char *entry_path = playlist->entries[i].path;
-      bool equal_path        =
-         (string_is_empty(real_path) && string_is_empty(entry_path)) ||
-         playlist_path_equal(real_path, entry_path, &playlist->config);
 
       /* Core name can have changed while still being the same core.
        * Differentiate based on the core path only. */
-      if (!equal_path)
-         continue;
-
       if (!playlist_core_path_equal(real_core_path, playlist->entries[i].core_path, &playlist->config))
          continue;
 
@@ -804,6 +1184,7 @@ bool playlist_push_runtime(playlist_t *playlist,
       memmove(playlist->entries + 1, playlist->entries,
             i * sizeof(struct playlist_entry));
       playlist->entries[0] = tmp;
+      playlist_index_move_to_top(playlist, i);
 
       goto success;
    }
@@ -814,7 +1195,8 @@ bool playlist_push_runtime(playlist_t *playlist,
    if (len == playlist->config.capacity)
    {
       struct playlist_entry *last_entry = &playlist->entries[len - 1];
-      playlist_free_entry(last_entry);
+      playlist_free_entry(playlist, last_entry);
+      playlist_index_remove(playlist, len - 1, false);
       len--;
    }
    else
@@ -829,6 +1211,8 @@ bool playlist_push_runtime(playlist_t *playlist,
    {
       memmove(playlist->entries + 1, playlist->entries,
             len * sizeof(struct playlist_entry));
+      /* Every indexed entry moved down by one */
+      playlist->index_offset++;
 
       playlist->entries[0].path            = NULL;
       playlist->entries[0].core_path       = NULL;
@@ -856,6 +1240,8 @@ bool playlist_push_runtime(playlist_t *playlist,
          playlist->entries[0].runtime_str     = strdup(entry->runtime_str);
       if (!string_is_empty(entry->last_played_str))
          playlist->entries[0].last_played_str = strdup(entry->last_played_str);
+
+      playlist_index_add(playlist, 0);
    }
 
 success:
@@ -982,19 +1368,13 @@ bool playlist_push(playlist_t *playlist,
    }
 
    len = RBUF_LEN(playlist->entries);
-   for (i = 0; i < len; i++)
+   for (i = playlist_find_path(playlist, real_path, 0); i < len;
+        i = playlist_find_path(playlist, real_path, i + 1))
    {
       struct playlist_entry tmp;
-      const char *entry_path = playlist->entries[i].path;
-      bool equal_path        =
-         (string_is_empty(real_path) && string_is_empty(entry_path)) ||
-         playlist_path_equal(real_path, entry_path, &playlist->config);
 
       /* Core name can have changed while still being the same core.
        * Differentiate based on the core path only. */
-      if (!equal_path)
-         continue;
-
       if (!playlist_core_path_equal(real_core_path, playlist->entries[i].core_path, &playlist->config))
          continue;
 
@@ -1003,180 +1383,1066 @@ bool playlist_push(playlist_t *playlist,
             && !string_is_equal(playlist->entries[i].subsystem_ident, entry->subsystem_ident))
          continue;
 
-      if (      string_is_empty(entry->subsystem_ident)
-            && !string_is_empty(playlist->entries[i].subsystem_ident))
-         continue;
+      if (      string_is_empty(entry->subsystem_ident)
+            && !string_is_empty(playlist->entries[i].subsystem_ident))
+         continue;
+
+      if (    !string_is_empty(entry->subsystem_ident)
+            && string_is_empty(playlist->entries[i].subsystem_ident))
+         continue;
+
+      if (     !string_is_empty(entry->subsystem_name)
+            && !string_is_empty(playlist->entries[i].subsystem_name)
+            && !string_is_equal(playlist->entries[i].subsystem_name, entry->subsystem_name))
+         continue;
+
+      if (      string_is_empty(entry->subsystem_name)
+            && !string_is_empty(playlist->entries[i].subsystem_name))
+         continue;
+
+      if (     !string_is_empty(entry->subsystem_name)
+            &&  string_is_empty(playlist->entries[i].subsystem_name))
+         continue;
+
+      if (entry->subsystem_roms)
+      {
+         unsigned j;
+         const struct string_list *roms = playlist->entries[i].subsystem_roms;
+         bool                   unequal = false;
+
+         if (entry->subsystem_roms->size != roms->size)
+            continue;
+
+         for (j = 0; j < entry->subsystem_roms->size; j++)
+         {
+            char real_rom_path[PATH_MAX_LENGTH];
+
+            real_rom_path[0] = '\0';
+
+            if (!string_is_empty(entry->subsystem_roms->elems[j].data))
+            {
+               strlcpy(real_rom_path, entry->subsystem_roms->elems[j].data, sizeof(real_rom_path));
+               path_resolve_realpath(real_rom_path, sizeof(real_rom_path), true);
+            }
+
+            if (!playlist_path_equal(real_rom_path, roms->elems[j].data,
+                     &playlist->config))
+            {
+               unequal = true;
+               break;
+            }
+         }
+
+         if (unequal)
+            continue;
+      }
+
+      /* If content was previously loaded via file browser
+       * or command line, certain entry values will be missing.
+       * If we are now loading the same content from a playlist,
+       * fill in any blanks */
+      if (!playlist->entries[i].label && !string_is_empty(entry->label))
+      {
+         playlist->entries[i].label   = strdup(entry->label);
+         entry_updated                = true;
+      }
+      if (!playlist->entries[i].crc32 && !string_is_empty(entry->crc32))
+      {
+         playlist->entries[i].crc32   = strdup(entry->crc32);
+         entry_updated                = true;
+      }
+      if (!playlist->entries[i].db_name && !string_is_empty(entry->db_name))
+      {
+         playlist->entries[i].db_name = strdup(entry->db_name);
+         entry_updated                = true;
+      }
+
+      /* If top entry, we don't want to push a new entry since
+       * the top and the entry to be pushed are the same. */
+      if (i == 0)
+      {
+         if (entry_updated)
+            goto success;
+
+         return false;
+      }
+
+      /* Seen it before, bump to top. */
+      tmp = playlist->entries[i];
+      memmove(playlist->entries + 1, playlist->entries,
+            i * sizeof(struct playlist_entry));
+      playlist->entries[0] = tmp;
+      playlist_index_move_to_top(playlist, i);
+
+      goto success;
+   }
+
+   if (playlist->config.capacity == 0)
+      return false;
+
+   if (len == playlist->config.capacity)
+   {
+      struct playlist_entry *last_entry = &playlist->entries[len - 1];
+      playlist_free_entry(playlist, last_entry);
+      playlist_index_remove(playlist, len - 1, false);
+      len--;
+   }
+   else
+   {
+      /* Allocate memory to fit one more item and resize the buffer */
+      if (!RBUF_TRYFIT(playlist->entries, len + 1))
+         return false; /* out of memory */
+      RBUF_RESIZE(playlist->entries, len + 1);
+   }
+
+   if (playlist->entries)
+   {
+      memmove(playlist->entries + 1, playlist->entries,
+            len * sizeof(struct playlist_entry));
+      /* Every indexed entry moved down by one */
+      playlist->index_offset++;
+
+      playlist->entries[0].path               = NULL;
+      playlist->entries[0].label              = NULL;
+      playlist->entries[0].core_path          = NULL;
+      playlist->entries[0].core_name          = NULL;
+      playlist->entries[0].db_name            = NULL;
+      playlist->entries[0].crc32              = NULL;
+      playlist->entries[0].subsystem_ident    = NULL;
+      playlist->entries[0].subsystem_name     = NULL;
+      playlist->entries[0].runtime_str        = NULL;
+      playlist->entries[0].last_played_str    = NULL;
+      playlist->entries[0].subsystem_roms     = NULL;
+      playlist->entries[0].runtime_status     = PLAYLIST_RUNTIME_UNKNOWN;
+      playlist->entries[0].runtime_hours      = 0;
+      playlist->entries[0].runtime_minutes    = 0;
+      playlist->entries[0].runtime_seconds    = 0;
+      playlist->entries[0].last_played_year   = 0;
+      playlist->entries[0].last_played_month  = 0;
+      playlist->entries[0].last_played_day    = 0;
+      playlist->entries[0].last_played_hour   = 0;
+      playlist->entries[0].last_played_minute = 0;
+      playlist->entries[0].last_played_second = 0;
+      if (!string_is_empty(real_path))
+         playlist->entries[0].path            = strdup(real_path);
+      if (!string_is_empty(entry->label))
+         playlist->entries[0].label           = strdup(entry->label);
+      if (!string_is_empty(real_core_path))
+         playlist->entries[0].core_path       = strdup(real_core_path);
+      if (!string_is_empty(core_name))
+         playlist->entries[0].core_name       = strdup(core_name);
+      if (!string_is_empty(entry->db_name))
+         playlist->entries[0].db_name         = strdup(entry->db_name);
+      if (!string_is_empty(entry->crc32))
+         playlist->entries[0].crc32           = strdup(entry->crc32);
+      if (!string_is_empty(entry->subsystem_ident))
+         playlist->entries[0].subsystem_ident = strdup(entry->subsystem_ident);
+      if (!string_is_empty(entry->subsystem_name))
+         playlist->entries[0].subsystem_name  = strdup(entry->subsystem_name);
+
+      if (entry->subsystem_roms)
+      {
+         union string_list_elem_attr attributes = {0};
+
+         playlist->entries[0].subsystem_roms    = string_list_new();
+
+         for (i = 0; i < entry->subsystem_roms->size; i++)
+            string_list_append(playlist->entries[0].subsystem_roms, entry->subsystem_roms->elems[i].data, attributes);
+      }
+
+      playlist_index_add(playlist, 0);
+   }
+
+success:
+   playlist->modified = true;
+
+   return true;
+}
+
+/* Journal
+ *
+ * Rewriting a whole playlist each time content is launched is
+ * slow on SD cards and network drives, so the operations made
+ * through command_playlist_push_write(),
+ * command_playlist_update_write() and
+ * command_playlist_delete_write() are appended to a journal
+ * next to the playlist file instead, and replayed when the
+ * playlist is loaded. playlist_write_file() compacts the
+ * journal into the playlist file: when history playlists are
+ * closed at exit, whenever the playlist is written for another
+ * reason, and once the journal holds
+ * PLAYLIST_JOURNAL_MAX_RECORDS records.
+ *
+ * Each record is a line of tab separated fields, the first of
+ * which is the operation:
+ *   P path label core_path core_name crc32 db_name
+ *     subsystem_ident subsystem_name [subsystem_rom...]
+ *   U index entry_path entry_core_path
+ *     path label core_path core_name db_name crc32
+ *   D index entry_path entry_core_path
+ * entry_path and entry_core_path identify the entry that index
+ * referred to when the record was written; records that no
+ * longer match are skipped. Tabs, line breaks and backslashes
+ * are escaped, and empty fields stand for absent values. */
+
+#define PLAYLIST_JOURNAL_MAX_RECORDS 64
+#define PLAYLIST_JOURNAL_PUSH_FIELDS 9
+#define PLAYLIST_JOURNAL_MAX_FIELDS  (PLAYLIST_JOURNAL_PUSH_FIELDS + 32)
+
+static bool playlist_journal_get_path(playlist_t *playlist,
+      char *s, size_t len)
+{
+   if (string_is_empty(playlist->config.path))
+      return false;
+
+   strlcpy(s, playlist->config.path, len);
+   strlcat(s, FILE_PATH_JOURNAL_EXTENSION, len);
+   return true;
+}
+
+/* Called once the playlist file holds every journaled operation */
+static void playlist_journal_delete(playlist_t *playlist)
+{
+   char journal_path[PATH_MAX_LENGTH];
+
+   if (!playlist->journal_records)
+      return;
+
+   if (playlist_journal_get_path(playlist,
+            journal_path, sizeof(journal_path)))
+      filestream_delete(journal_path);
+
+   playlist->journal_records = 0;
+}
+
+/* The journal can only be used while the playlist file, with
+ * the journal replayed on top, matches the playlist in memory.
+ * A journal is never started without a playlist file, see
+ * playlist_journal_replay() */
+static bool playlist_journal_is_usable(playlist_t *playlist)
+{
+   return !playlist->modified
+#if defined(HAVE_ZLIB)
+       && (playlist->compressed == playlist->config.compress)
+#endif
+       && (playlist->old_format == playlist->config.old_format)
+       && (playlist->journal_records < PLAYLIST_JOURNAL_MAX_RECORDS)
+       && !string_is_empty(playlist->config.path)
+       && path_is_valid(playlist->config.path);
+}
+
+/**
+ * playlist_journal_append:
+ * @playlist        : Playlist handle.
+ * @fields          : Record fields. NULL fields are left empty.
+ * @num_fields      : Number of fields.
+ *
+ * Appends a record to the journal and syncs it to disk
+ * (see filestream_sync()): records are written when
+ * content is launched, and devices running RetroArch are
+ * often switched off without shutting down.
+ *
+ * Returns: true on success. On failure, the playlist
+ * must be written in full instead.
+ **/
+static bool playlist_journal_append(playlist_t *playlist,
+      const char **fields, size_t num_fields)
+{
+   size_t i;
+   char *s;
+   char *record;
+   int64_t record_len;
+   RFILE *file       = NULL;
+   size_t size       = 1;
+   bool success      = false;
+   char journal_path[PATH_MAX_LENGTH];
+
+   if (!playlist_journal_get_path(playlist,
+            journal_path, sizeof(journal_path)))
+      return false;
+
+   /* Worst case, every character is escaped */
+   for (i = 0; i < num_fields; i++)
+      size += (fields[i] ? strlen(fields[i]) * 2 : 0) + 1;
+
+   if (!(record = (char*)malloc(size)))
+      return false;
+
+   for (i = 0, s = record; i < num_fields; i++)
+   {
+      const char *c = fields[i];
+
+      if (i > 0)
+         *s++ = '\t';
+
+      for (; c && *c; c++)
+      {
+         switch (*c)
+         {
+            case '\\':
+               *s++ = '\\';
+               *s++ = '\\';
+               break;
+            case '\t':
+               *s++ = '\\';
+               *s++ = 't';
+               break;
+            case '\n':
+               *s++ = '\\';
+               *s++ = 'n';
+               break;
+            case '\r':
+               *s++ = '\\';
+               *s++ = 'r';
+               break;
+            default:
+               *s++ = *c;
+               break;
+         }
+      }
+   }
+   *s++       = '\n';
+   record_len = s - record;
+
+   /* Append, creating the journal if needed */
+   if (!(file = filestream_open(journal_path,
+               RETRO_VFS_FILE_ACCESS_WRITE
+             | RETRO_VFS_FILE_ACCESS_UPDATE_EXISTING,
+               RETRO_VFS_FILE_ACCESS_HINT_NONE)))
+      file = filestream_open(journal_path,
+            RETRO_VFS_FILE_ACCESS_WRITE,
+            RETRO_VFS_FILE_ACCESS_HINT_NONE);
+
+   if (file)
+   {
+      success = filestream_seek(file, 0, RETRO_VFS_SEEK_POSITION_END) >= 0
+         && filestream_write(file, record, record_len) == record_len
+         && filestream_sync(file) == 0;
+      filestream_close(file);
+   }
+
+   free(record);
+
+   /* Counted even on failure, so that the full write
+    * that follows drops any partly written record */
+   playlist->journal_records++;
+
+   return success;
+}
+
+/* Splits a record into fields, unescaping them in place.
+ * Returns the number of fields, or 0 if there are too many. */
+static size_t playlist_journal_split(char *line,
+      char **fields, size_t max_fields)
+{
+   char *in          = line;
+   char *out         = line;
+   size_t num_fields = 0;
+
+   fields[num_fields++] = out;
+
+   for (; *in; in++)
+   {
+      if (*in == '\t')
+      {
+         *out++ = '\0';
+         if (num_fields == max_fields)
+            return 0;
+         fields[num_fields++] = out;
+      }
+      else if (*in == '\\' && in[1])
+      {
+         switch (*++in)
+         {
+            case 't':
+               *out++ = '\t';
+               break;
+            case 'n':
+               *out++ = '\n';
+               break;
+            case 'r':
+               *out++ = '\r';
+               break;
+            default:
+               *out++ = *in;
+               break;
+         }
+      }
+      else
+         *out++ = *in;
+   }
+
+   *out = '\0';
+   return num_fields;
+}
+
+static bool playlist_journal_entry_matches(playlist_t *playlist,
+      size_t idx, const char *path, const char *core_path)
+{
+   const struct playlist_entry *entry = NULL;
+
+   if (idx >= RBUF_LEN(playlist->entries))
+      return false;
+
+   entry = &playlist->entries[idx];
+
+   return (string_is_empty(path)
+         ? string_is_empty(entry->path)
+         : string_is_equal(entry->path, path))
+       && (string_is_empty(core_path)
+         ? string_is_empty(entry->core_path)
+         : string_is_equal(entry->core_path, core_path));
+}
+
+static bool playlist_journal_apply(playlist_t *playlist,
+      char **fields, size_t num_fields)
+{
+   size_t i;
+   size_t idx;
+
+   for (i = 1; i < num_fields; i++)
+      if (!*fields[i])
+         fields[i] = NULL;
+
+   switch (fields[0][0])
+   {
+      case 'P':
+         {
+            struct playlist_entry entry = {0};
+
+            if (num_fields < PLAYLIST_JOURNAL_PUSH_FIELDS)
+               return false;
+
+            entry.path            = fields[1];
+            entry.label           = fields[2];
+            entry.core_path       = fields[3];
+            entry.core_name       = fields[4];
+            entry.crc32           = fields[5];
+            entry.db_name         = fields[6];
+            entry.subsystem_ident = fields[7];
+            entry.subsystem_name  = fields[8];
+
+            if (num_fields > PLAYLIST_JOURNAL_PUSH_FIELDS)
+            {
+               union string_list_elem_attr attr;
+
+               attr.i = 0;
+
+               if (!(entry.subsystem_roms = string_list_new()))
+                  return false;
+
+               for (i = PLAYLIST_JOURNAL_PUSH_FIELDS; i < num_fields; i++)
+                  string_list_append(entry.subsystem_roms,
+                        fields[i] ? fields[i] : "", attr);
+            }
+
+            playlist_push(playlist, &entry);
+            string_list_free(entry.subsystem_roms);
+         }
+         return true;
+      case 'U':
+         {
+            struct playlist_entry entry = {0};
+
+            if (num_fields != 10 || !fields[1])
+               return false;
+
+            idx = (size_t)strtoul(fields[1], NULL, 10);
+
+            if (!playlist_journal_entry_matches(playlist, idx,
+                     fields[2], fields[3]))
+               return false;
+
+            entry.path      = fields[4];
+            entry.label     = fields[5];
+            entry.core_path = fields[6];
+            entry.core_name = fields[7];
+            entry.db_name   = fields[8];
+            entry.crc32     = fields[9];
+
+            playlist_update(playlist, idx, &entry);
+         }
+         return true;
+      case 'D':
+         if (num_fields != 4 || !fields[1])
+            return false;
+
+         idx = (size_t)strtoul(fields[1], NULL, 10);
+
+         if (!playlist_journal_entry_matches(playlist, idx,
+                  fields[2], fields[3]))
+            return false;
+
+         playlist_delete_index(playlist, idx);
+         return true;
+      default:
+         break;
+   }
+
+   return false;
+}
+
+/**
+ * playlist_journal_replay:
+ * @playlist        : Playlist handle, just read from its file.
+ *
+ * Applies the records of the playlist's journal, if any.
+ *
+ * Returns: false if a record was cut short, in which case the
+ * playlist has to be written before anything is appended.
+ **/
+static bool playlist_journal_replay(playlist_t *playlist)
+{
+   char *line;
+   char *end;
+   void *buf       = NULL;
+   int64_t len     = 0;
+   bool complete   = true;
+   char journal_path[PATH_MAX_LENGTH];
+
+   if (!playlist_journal_get_path(playlist,
+            journal_path, sizeof(journal_path)) ||
+       !path_is_valid(journal_path))
+      return true;
+
+   /* A journal left behind by a playlist file that was
+    * deleted would bring back the entries it held */
+   if (!path_is_valid(playlist->config.path))
+   {
+      filestream_delete(journal_path);
+      return true;
+   }
+
+   if (!filestream_read_file(journal_path, &buf, &len))
+      return true;
+
+   for (line = (char*)buf, end = line + len; line < end; )
+   {
+      char *fields[PLAYLIST_JOURNAL_MAX_FIELDS];
+      size_t num_fields;
+      char *eol = (char*)memchr(line, '\n', end - line);
+
+      playlist->journal_records++;
+
+      if (!eol)
+      {
+         complete = false;
+         break;
+      }
+
+      *eol       = '\0';
+      num_fields = playlist_journal_split(line, fields,
+            PLAYLIST_JOURNAL_MAX_FIELDS);
+
+      if (!num_fields ||
+          !playlist_journal_apply(playlist, fields, num_fields))
+         RARCH_WARN("[Playlist]: Skipped journal record %u: %s\n",
+               playlist->journal_records, journal_path);
+
+      line = eol + 1;
+   }
+
+   free(buf);
+
+   /* Replaying marks the playlist as modified,
+    * but it still matches the files on disk */
+   playlist->modified = false;
+
+   return complete;
+}
+
+#ifdef HAVE_MMAP
+/* Binary copy of the playlist file
+ *
+ * Parsing a large JSON playlist and allocating every string
+ * of every entry takes a noticeable amount of time, so a
+ * binary copy of the playlist is kept next to the file and
+ * mapped in its place when it is up to date. Entry strings
+ * point straight into the mapping, which stays in place until
+ * playlist_free(). The playlist file remains the reference:
+ * the copy is only used while the size, the modification time
+ * and a CRC32 of the first PLAYLIST_BIN_HEAD_SIZE bytes of the
+ * file match the ones recorded in it, and is rewritten
+ * whenever the file is written or had to be parsed. The
+ * modification time includes nanoseconds where the platform
+ * provides them; the CRC32 catches files replaced within the
+ * same second on file systems that do not.
+ *
+ * Layout, in native byte order:
+ * > playlist_bin_header_t
+ * > playlist_bin_entry_t, 'num_entries' times
+ * > String pool of 'pool_size' bytes, starting with a NUL
+ * Strings are stored as offsets into the pool, 0 standing for
+ * NULL. The subsystem ROMs of an entry are stored one after
+ * the other. */
+
+#define PLAYLIST_BIN_MAGIC      0x4C505241 /* "ARPL" */
+#define PLAYLIST_BIN_VERSION    2
+#define PLAYLIST_BIN_HEAD_SIZE  4096
+#define PLAYLIST_BIN_OLD_FORMAT (1 << 0)
+#define PLAYLIST_BIN_COMPRESSED (1 << 1)
+
+enum playlist_bin_string
+{
+   PLAYLIST_BIN_PATH = 0,
+   PLAYLIST_BIN_LABEL,
+   PLAYLIST_BIN_CORE_PATH,
+   PLAYLIST_BIN_CORE_NAME,
+   PLAYLIST_BIN_CRC32,
+   PLAYLIST_BIN_DB_NAME,
+   PLAYLIST_BIN_SUBSYSTEM_IDENT,
+   PLAYLIST_BIN_SUBSYSTEM_NAME,
+   PLAYLIST_BIN_STRINGS
+};
+
+typedef struct
+{
+   uint32_t magic;
+   uint32_t version;
+   /* Copies written by a build with another
+    * layout of these structs are ignored */
+   uint32_t header_size;
+   uint32_t entry_size;
+   uint64_t file_size;
+   int64_t  file_mtime;
+   int64_t  file_mtime_nsec;
+   uint32_t file_head_crc;
+   uint32_t num_entries;
+   uint32_t pool_size;
+   uint32_t default_core_path;
+   uint32_t default_core_name;
+   uint32_t base_content_directory;
+   uint32_t label_display_mode;
+   uint32_t right_thumbnail_mode;
+   uint32_t left_thumbnail_mode;
+   uint32_t sort_mode;
+   uint32_t flags;
+} playlist_bin_header_t;
+
+typedef struct
+{
+   uint32_t strings[PLAYLIST_BIN_STRINGS];
+   uint32_t subsystem_roms;
+   uint32_t num_subsystem_roms;
+   uint32_t runtime_hours;
+   uint32_t runtime_minutes;
+   uint32_t runtime_seconds;
+   uint32_t last_played_year;
+   uint32_t last_played_month;
+   uint32_t last_played_day;
+   uint32_t last_played_hour;
+   uint32_t last_played_minute;
+   uint32_t last_played_second;
+} playlist_bin_entry_t;
+
+static bool playlist_bin_get_path(playlist_t *playlist,
+      char *s, size_t len)
+{
+   if (string_is_empty(playlist->config.path))
+      return false;
+
+   strlcpy(s, playlist->config.path, len);
+   strlcat(s, FILE_PATH_PLAYLIST_BINARY_EXTENSION, len);
+   return true;
+}
+
+/* Fills in the file_* fields of 'stamp' from
+ * the playlist file */
+static bool playlist_bin_stat_file(playlist_t *playlist,
+      playlist_bin_header_t *stamp)
+{
+   int fd;
+   ssize_t len;
+   struct stat st;
+   uint8_t head[PLAYLIST_BIN_HEAD_SIZE];
+
+   if ((fd = open(playlist->config.path, O_RDONLY)) < 0)
+      return false;
+
+   if (     fstat(fd, &st) != 0
+         || (len = read(fd, head, sizeof(head))) < 0)
+   {
+      close(fd);
+      return false;
+   }
+
+   close(fd);
+
+   stamp->file_size       = (uint64_t)st.st_size;
+   stamp->file_mtime      = (int64_t)st.st_mtime;
+#if defined(__APPLE__)
+   stamp->file_mtime_nsec = (int64_t)st.st_mtimespec.tv_nsec;
+#elif defined(__linux__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
+   stamp->file_mtime_nsec = (int64_t)st.st_mtim.tv_nsec;
+#else
+   stamp->file_mtime_nsec = 0;
+#endif
+   stamp->file_head_crc   = encoding_crc32(0, head, (size_t)len);
+   return true;
+}
+
+/* Offsets past the end of the pool read as NULL. The
+ * pool ends with a NUL, so no string can run past it */
+static char *playlist_bin_string(char *pool,
+      uint32_t pool_size, uint32_t offset)
+{
+   if (!offset || offset >= pool_size)
+      return NULL;
+   return pool + offset;
+}
+
+static size_t playlist_bin_string_size(const char *s)
+{
+   return s ? strlen(s) + 1 : 0;
+}
+
+static uint32_t playlist_bin_add_string(char *pool,
+      size_t *pool_pos, const char *s)
+{
+   size_t offset = *pool_pos;
+   size_t len;
 
-      if (    !string_is_empty(entry->subsystem_ident)
-            && string_is_empty(playlist->entries[i].subsystem_ident))
-         continue;
+   if (!s)
+      return 0;
 
-      if (     !string_is_empty(entry->subsystem_name)
-            && !string_is_empty(playlist->entries[i].subsystem_name)
-            && !string_is_equal(playlist->entries[i].subsystem_name, entry->subsystem_name))
-         continue;
+   len        = strlen(s) + 1;
+   memcpy(pool + offset, s, len);
+   *pool_pos += len;
+   return (uint32_t)offset;
+}
 
-      if (      string_is_empty(entry->subsystem_name)
-            && !string_is_empty(playlist->entries[i].subsystem_name))
-         continue;
+/* Called once the playlist matches the playlist file */
+static void playlist_bin_write(playlist_t *playlist)
+{
+   size_t i, j, len, pool_size, pool_pos, total;
+   playlist_bin_header_t stamp;
+   char bin_path[PATH_MAX_LENGTH];
+   char tmp_path[PATH_MAX_LENGTH];
+   playlist_bin_header_t *header = NULL;
+   playlist_bin_entry_t *records = NULL;
+   uint8_t *buf                  = NULL;
+   char *pool                    = NULL;
+
+   if (   !playlist_bin_get_path(playlist, bin_path, sizeof(bin_path))
+       || !playlist_bin_stat_file(playlist, &stamp))
+      return;
 
-      if (     !string_is_empty(entry->subsystem_name)
-            &&  string_is_empty(playlist->entries[i].subsystem_name))
-         continue;
+   len       = RBUF_LEN(playlist->entries);
+   pool_size = 1
+      + playlist_bin_string_size(playlist->default_core_path)
+      + playlist_bin_string_size(playlist->default_core_name)
+      + playlist_bin_string_size(playlist->base_content_directory);
 
-      if (entry->subsystem_roms)
-      {
-         unsigned j;
-         const struct string_list *roms = playlist->entries[i].subsystem_roms;
-         bool                   unequal = false;
+   for (i = 0; i < len; i++)
+   {
+      const struct playlist_entry *entry = &playlist->entries[i];
 
-         if (entry->subsystem_roms->size != roms->size)
-            continue;
+      pool_size += playlist_bin_string_size(entry->path)
+         + playlist_bin_string_size(entry->label)
+         + playlist_bin_string_size(entry->core_path)
+         + playlist_bin_string_size(entry->core_name)
+         + playlist_bin_string_size(entry->crc32)
+         + playlist_bin_string_size(entry->db_name)
+         + playlist_bin_string_size(entry->subsystem_ident)
+         + playlist_bin_string_size(entry->subsystem_name);
 
+      if (entry->subsystem_roms)
          for (j = 0; j < entry->subsystem_roms->size; j++)
-         {
-            char real_rom_path[PATH_MAX_LENGTH];
-
-            real_rom_path[0] = '\0';
+            pool_size += playlist_bin_string_size(
+                  entry->subsystem_roms->elems[j].data);
+   }
 
-            if (!string_is_empty(entry->subsystem_roms->elems[j].data))
-            {
-               strlcpy(real_rom_path, entry->subsystem_roms->elems[j].data, sizeof(real_rom_path));
-               path_resolve_realpath(real_rom_path, sizeof(real_rom_path), true);
-            }
+   if (pool_size > UINT32_MAX)
+      return;
 
-            if (!playlist_path_equal(real_rom_path, roms->elems[j].data,
-                     &playlist->config))
-            {
-               unequal = true;
-               break;
-            }
-         }
+   total = sizeof(*header) + len * sizeof(*records) + pool_size;
 
-         if (unequal)
-            continue;
-      }
+   if (!(buf = (uint8_t*)calloc(1, total)))
+      return;
 
-      /* If content was previously loaded via file browser
-       * or command line, certain entry values will be missing.
-       * If we are now loading the same content from a playlist,
-       * fill in any blanks */
-      if (!playlist->entries[i].label && !string_is_empty(entry->label))
-      {
-         playlist->entries[i].label   = strdup(entry->label);
-         entry_updated                = true;
-      }
-      if (!playlist->entries[i].crc32 && !string_is_empty(entry->crc32))
-      {
-         playlist->entries[i].crc32   = strdup(entry->crc32);
-         entry_updated                = true;
-      }
-      if (!playlist->entries[i].db_name && !string_is_empty(entry->db_name))
-      {
-         playlist->entries[i].db_name = strdup(entry->db_name);
-         entry_updated                = true;
-      }
+   header   = (playlist_bin_header_t*)buf;
+   records  = (playlist_bin_entry_t*)(buf + sizeof(*header));
+   pool     = (char*)(records + len);
+   pool_pos = 1;
+
+   header->magic                  = PLAYLIST_BIN_MAGIC;
+   header->version                = PLAYLIST_BIN_VERSION;
+   header->header_size            = sizeof(*header);
+   header->entry_size             = sizeof(*records);
+   header->file_size              = stamp.file_size;
+   header->file_mtime             = stamp.file_mtime;
+   header->file_mtime_nsec        = stamp.file_mtime_nsec;
+   header->file_head_crc          = stamp.file_head_crc;
+   header->num_entries            = (uint32_t)len;
+   header->pool_size              = (uint32_t)pool_size;
+   header->default_core_path      = playlist_bin_add_string(pool,
+         &pool_pos, playlist->default_core_path);
+   header->default_core_name      = playlist_bin_add_string(pool,
+         &pool_pos, playlist->default_core_name);
+   header->base_content_directory = playlist_bin_add_string(pool,
+         &pool_pos, playlist->base_content_directory);
+   header->label_display_mode     = playlist->label_display_mode;
+   header->right_thumbnail_mode   = playlist->right_thumbnail_mode;
+   header->left_thumbnail_mode    = playlist->left_thumbnail_mode;
+   header->sort_mode              = playlist->sort_mode;
+   header->flags                  =
+           (playlist->old_format ? PLAYLIST_BIN_OLD_FORMAT : 0)
+         | (playlist->compressed ? PLAYLIST_BIN_COMPRESSED : 0);
 
-      /* If top entry, we don't want to push a new entry since
-       * the top and the entry to be pushed are the same. */
-      if (i == 0)
+   for (i = 0; i < len; i++)
+   {
+      const struct playlist_entry *entry = &playlist->entries[i];
+      playlist_bin_entry_t *record       = &records[i];
+
+      record->strings[PLAYLIST_BIN_PATH]            =
+         playlist_bin_add_string(pool, &pool_pos, entry->path);
+      record->strings[PLAYLIST_BIN_LABEL]           =
+         playlist_bin_add_string(pool, &pool_pos, entry->label);
+      record->strings[PLAYLIST_BIN_CORE_PATH]       =
+         playlist_bin_add_string(pool, &pool_pos, entry->core_path);
+      record->strings[PLAYLIST_BIN_CORE_NAME]       =
+         playlist_bin_add_string(pool, &pool_pos, entry->core_name);
+      record->strings[PLAYLIST_BIN_CRC32]           =
+         playlist_bin_add_string(pool, &pool_pos, entry->crc32);
+      record->strings[PLAYLIST_BIN_DB_NAME]         =
+         playlist_bin_add_string(pool, &pool_pos, entry->db_name);
+      record->strings[PLAYLIST_BIN_SUBSYSTEM_IDENT] =
+         playlist_bin_add_string(pool, &pool_pos, entry->subsystem_ident);
+      record->strings[PLAYLIST_BIN_SUBSYSTEM_NAME]  =
+         playlist_bin_add_string(pool, &pool_pos, entry->subsystem_name);
+
+      if (entry->subsystem_roms && entry->subsystem_roms->size)
       {
-         if (entry_updated)
-            goto success;
+         record->num_subsystem_roms = (uint32_t)entry->subsystem_roms->size;
+         record->subsystem_roms     = (uint32_t)pool_pos;
 
-         return false;
+         for (j = 0; j < entry->subsystem_roms->size; j++)
+         {
+            const char *rom = entry->subsystem_roms->elems[j].data;
+            playlist_bin_add_string(pool, &pool_pos, rom ? rom : "");
+         }
       }
 
-      /* Seen it before, bump to top. */
-      tmp = playlist->entries[i];
-      memmove(playlist->entries + 1, playlist->entries,
-            i * sizeof(struct playlist_entry));
-      playlist->entries[0] = tmp;
+      record->runtime_hours      = entry->runtime_hours;
+      record->runtime_minutes    = entry->runtime_minutes;
+      record->runtime_seconds    = entry->runtime_seconds;
+      record->last_played_year   = entry->last_played_year;
+      record->last_played_month  = entry->last_played_month;
+      record->last_played_day    = entry->last_played_day;
+      record->last_played_hour   = entry->last_played_hour;
+      record->last_played_minute = entry->last_played_minute;
+      record->last_played_second = entry->last_played_second;
+   }
 
-      goto success;
+   /* Replace the previous copy in one step: it may still
+    * be mapped, and truncating a mapped file would crash
+    * whoever reads from it */
+   strlcpy(tmp_path, bin_path, sizeof(tmp_path));
+   strlcat(tmp_path, ".tmp", sizeof(tmp_path));
+
+   if (filestream_write_file(tmp_path, buf, (int64_t)total))
+   {
+      if (filestream_rename(tmp_path, bin_path) != 0)
+         filestream_delete(tmp_path);
    }
 
-   if (playlist->config.capacity == 0)
+   free(buf);
+}
+
+/* Maps the binary copy of the playlist file in place of
+ * parsing the file. Returns false if the copy is missing,
+ * outdated or invalid, leaving the playlist untouched */
+static bool playlist_bin_read(playlist_t *playlist)
+{
+   size_t i, j, len;
+   int fd;
+   struct stat st;
+   playlist_bin_header_t stamp;
+   char bin_path[PATH_MAX_LENGTH];
+   uint8_t *data                        = NULL;
+   const playlist_bin_header_t *header  = NULL;
+   const playlist_bin_entry_t *records  = NULL;
+   char *pool                           = NULL;
+   uint32_t pool_size                   = 0;
+
+   if (   !playlist_bin_get_path(playlist, bin_path, sizeof(bin_path))
+       || !playlist_bin_stat_file(playlist, &stamp))
       return false;
 
-   if (len == playlist->config.capacity)
+   if ((fd = open(bin_path, O_RDONLY)) < 0)
+      return false;
+
+   if (     fstat(fd, &st) != 0
+         || (uint64_t)st.st_size < sizeof(*header)
+         || (uint64_t)st.st_size > SIZE_MAX)
    {
-      struct playlist_entry *last_entry = &playlist->entries[len - 1];
-      playlist_free_entry(last_entry);
-      len--;
+      close(fd);
+      return false;
    }
-   else
+
+   /* Private writable mapping: entry strings are not
+    * const, and must never change the file */
+   data = (uint8_t*)mmap(NULL, (size_t)st.st_size,
+         PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+   close(fd);
+
+   if (data == (uint8_t*)MAP_FAILED)
+      return false;
+
+   header = (const playlist_bin_header_t*)data;
+
+   if (     header->magic           != PLAYLIST_BIN_MAGIC
+         || header->version         != PLAYLIST_BIN_VERSION
+         || header->header_size     != sizeof(*header)
+         || header->entry_size      != sizeof(*records)
+         || header->file_size       != stamp.file_size
+         || header->file_mtime      != stamp.file_mtime
+         || header->file_mtime_nsec != stamp.file_mtime_nsec
+         || header->file_head_crc   != stamp.file_head_crc
+         || header->pool_size       == 0
+         || (uint64_t)st.st_size != sizeof(*header)
+            + (uint64_t)header->num_entries * sizeof(*records)
+            + header->pool_size)
+      goto error;
+
+   records   = (const playlist_bin_entry_t*)(data + sizeof(*header));
+   pool      = (char*)(records + header->num_entries);
+   pool_size = header->pool_size;
+
+   if (pool[pool_size - 1] != '\0')
+      goto error;
+
+   len = header->num_entries;
+
+   if (len > playlist->config.capacity)
    {
-      /* Allocate memory to fit one more item and resize the buffer */
-      if (!RBUF_TRYFIT(playlist->entries, len + 1))
-         return false; /* out of memory */
-      RBUF_RESIZE(playlist->entries, len + 1);
+      /* Same as parsing the file: excess entries are
+       * discarded, and the file has to be rewritten */
+      RARCH_WARN("Playlist contains more entries than current playlist capacity. Excess entries will be discarded.\n");
+      len                = playlist->config.capacity;
+      playlist->modified = true;
    }
 
-   if (playlist->entries)
-   {
-      memmove(playlist->entries + 1, playlist->entries,
-            len * sizeof(struct playlist_entry));
+   if (!RBUF_TRYFIT(playlist->entries, len))
+      goto error;
+   RBUF_RESIZE(playlist->entries, len);
 
-      playlist->entries[0].path               = NULL;
-      playlist->entries[0].label              = NULL;
-      playlist->entries[0].core_path          = NULL;
-      playlist->entries[0].core_name          = NULL;
-      playlist->entries[0].db_name            = NULL;
-      playlist->entries[0].crc32              = NULL;
-      playlist->entries[0].subsystem_ident    = NULL;
-      playlist->entries[0].subsystem_name     = NULL;
-      playlist->entries[0].runtime_str        = NULL;
-      playlist->entries[0].last_played_str    = NULL;
-      playlist->entries[0].subsystem_roms     = NULL;
-      playlist->entries[0].runtime_status     = PLAYLIST_RUNTIME_UNKNOWN;
-      playlist->entries[0].runtime_hours      = 0;
-      playlist->entries[0].runtime_minutes    = 0;
-      playlist->entries[0].runtime_seconds    = 0;
-      playlist->entries[0].last_played_year   = 0;
-      playlist->entries[0].last_played_month  = 0;
-      playlist->entries[0].last_played_day    = 0;
-      playlist->entries[0].last_played_hour   = 0;
-      playlist->entries[0].last_played_minute = 0;
-      playlist->entries[0].last_played_second = 0;
-      if (!string_is_empty(real_path))
-         playlist->entries[0].path            = strdup(real_path);
-      if (!string_is_empty(entry->label))
-         playlist->entries[0].label           = strdup(entry->label);
-      if (!string_is_empty(real_core_path))
-         playlist->entries[0].core_path       = strdup(real_core_path);
-      if (!string_is_empty(core_name))
-         playlist->entries[0].core_name       = strdup(core_name);
-      if (!string_is_empty(entry->db_name))
-         playlist->entries[0].db_name         = strdup(entry->db_name);
-      if (!string_is_empty(entry->crc32))
-         playlist->entries[0].crc32           = strdup(entry->crc32);
-      if (!string_is_empty(entry->subsystem_ident))
-         playlist->entries[0].subsystem_ident = strdup(entry->subsystem_ident);
-      if (!string_is_empty(entry->subsystem_name))
-         playlist->entries[0].subsystem_name  = strdup(entry->subsystem_name);
+   playlist->bin_data = data;
+   playlist->bin_size = (size_t)st.st_size;
 
-      if (entry->subsystem_roms)
+   for (i = 0; i < len; i++)
+   {
+      struct playlist_entry *entry       = &playlist->entries[i];
+      const playlist_bin_entry_t *record = &records[i];
+
+      memset(entry, 0, sizeof(*entry));
+
+      entry->path            = playlist_bin_string(pool, pool_size,
+            record->strings[PLAYLIST_BIN_PATH]);
+      entry->label           = playlist_bin_string(pool, pool_size,
+            record->strings[PLAYLIST_BIN_LABEL]);
+      entry->core_path       = playlist_bin_string(pool, pool_size,
+            record->strings[PLAYLIST_BIN_CORE_PATH]);
+      entry->core_name       = playlist_bin_string(pool, pool_size,
+            record->strings[PLAYLIST_BIN_CORE_NAME]);
+      entry->crc32           = playlist_bin_string(pool, pool_size,
+            record->strings[PLAYLIST_BIN_CRC32]);
+      entry->db_name         = playlist_bin_string(pool, pool_size,
+            record->strings[PLAYLIST_BIN_DB_NAME]);
+      entry->subsystem_ident = playlist_bin_string(pool, pool_size,
+            record->strings[PLAYLIST_BIN_SUBSYSTEM_IDENT]);
+      entry->subsystem_name  = playlist_bin_string(pool, pool_size,
+            record->strings[PLAYLIST_BIN_SUBSYSTEM_NAME]);
+
+      entry->runtime_hours      = record->runtime_hours;
+      entry->runtime_minutes    = record->runtime_minutes;
+      entry->runtime_seconds    = record->runtime_seconds;
+      entry->last_played_year   = record->last_played_year;
+      entry->last_played_month  = record->last_played_month;
+      entry->last_played_day    = record->last_played_day;
+      entry->last_played_hour   = record->last_played_hour;
+      entry->last_played_minute = record->last_played_minute;
+      entry->last_played_second = record->last_played_second;
+
+      /* Subsystem ROM lists are rare, and string
+       * lists own their strings: copy them */
+      if (record->num_subsystem_roms)
       {
-         union string_list_elem_attr attributes = {0};
+         union string_list_elem_attr attr = {0};
+         uint32_t offset                  = record->subsystem_roms;
 
-         playlist->entries[0].subsystem_roms    = string_list_new();
+         if (!(entry->subsystem_roms = string_list_new()))
+         {
+            RBUF_RESIZE(playlist->entries, i + 1);
+            goto error;
+         }
 
-         for (i = 0; i < entry->subsystem_roms->size; i++)
-            string_list_append(playlist->entries[0].subsystem_roms, entry->subsystem_roms->elems[i].data, attributes);
+         for (j = 0; j < record->num_subsystem_roms; j++)
+         {
+            const char *rom = playlist_bin_string(pool, pool_size, offset);
+
+            if (!rom)
+               break;
+
+            if (*rom)
+               string_list_append(entry->subsystem_roms, rom, attr);
+            offset += (uint32_t)strlen(rom) + 1;
+         }
       }
    }
 
-success:
-   playlist->modified = true;
+   playlist->default_core_path      = playlist_bin_string(pool, pool_size,
+         header->default_core_path);
+   playlist->default_core_name      = playlist_bin_string(pool, pool_size,
+         header->default_core_name);
+   playlist->base_content_directory = playlist_bin_string(pool, pool_size,
+         header->base_content_directory);
+   playlist->label_display_mode     =
+      (enum playlist_label_display_mode)header->label_display_mode;
+   playlist->right_thumbnail_mode   =
+      (enum playlist_thumbnail_mode)header->right_thumbnail_mode;
+   playlist->left_thumbnail_mode    =
+      (enum playlist_thumbnail_mode)header->left_thumbnail_mode;
+   playlist->sort_mode              =
+      (enum playlist_sort_mode)header->sort_mode;
+   playlist->old_format             =
+      (header->flags & PLAYLIST_BIN_OLD_FORMAT) ? true : false;
+   playlist->compressed             =
+      (header->flags & PLAYLIST_BIN_COMPRESSED) ? true : false;
 
    return true;
+
+error:
+   for (i = 0, len = RBUF_LEN(playlist->entries); i < len; i++)
+      playlist_free_entry(playlist, &playlist->entries[i]);
+   RBUF_FREE(playlist->entries);
+   playlist->modified = false;
+   playlist->bin_data = NULL;
+   playlist->bin_size = 0;
+   munmap(data, (size_t)st.st_size);
+   return false;
+}
+
+static void playlist_bin_unmap(playlist_t *playlist)
+{
+   if (!playlist->bin_data)
+      return;
+
+   munmap(playlist->bin_data, playlist->bin_size);
+   playlist->bin_data = NULL;
+   playlist->bin_size = 0;
 }
+#else
+static void playlist_bin_write(playlist_t *playlist) { }
+static bool playlist_bin_read(playlist_t *playlist) { return false; }
+static void playlist_bin_unmap(playlist_t *playlist) { }
+#endif
 
 void playlist_write_runtime_file(playlist_t *playlist)
 {
    size_t i, len;
    intfstream_t *file  = NULL;
+   bool written        = false;
    rjsonwriter_t* writer;
 
    if (!playlist || !playlist->modified)
@@ -1326,11 +2592,35 @@ void playlist_write_runtime_file(playlist_t *playlist)
    playlist->modified        = false;
    playlist->old_format      = false;
    playlist->compressed      = false;
+   written                   = true;
 
    RARCH_LOG("[Playlist]: Written to playlist file: %s\n", playlist->config.path);
 end:
    intfstream_close(file);
    free(file);
+
+   if (written)
+      playlist_bin_write(playlist);
+}
+
+void playlist_delete_file(const char *path)
+{
+   char sidecar_path[PATH_MAX_LENGTH];
+
+   if (string_is_empty(path))
+      return;
+
+   strlcpy(sidecar_path, path, sizeof(sidecar_path));
+   strlcat(sidecar_path, FILE_PATH_JOURNAL_EXTENSION, sizeof(sidecar_path));
+   if (path_is_valid(sidecar_path))
+      filestream_delete(sidecar_path);
+
+   strlcpy(sidecar_path, path, sizeof(sidecar_path));
+   strlcat(sidecar_path, FILE_PATH_PLAYLIST_BINARY_EXTENSION, sizeof(sidecar_path));
+   if (path_is_valid(sidecar_path))
+      filestream_delete(sidecar_path);
+
+   filestream_delete(path);
 }
 
 void playlist_write_file(playlist_t *playlist)
@@ -1338,6 +2628,7 @@ void playlist_write_file(playlist_t *playlist)
    size_t i, len;
    intfstream_t *file = NULL;
    bool compressed    = false;
+   bool written       = false;
 
    /* Playlist will be written if any of the
     * following are true:
@@ -1345,9 +2636,11 @@ void playlist_write_file(playlist_t *playlist)
     * > Current playlist format (old/new) does not
     *   match requested
     * > Current playlist compression status does
-    *   not match requested */
+    *   not match requested
+    * > Journal has not been compacted into the file */
    if (!playlist ||
        !(playlist->modified ||
+        playlist->journal_records ||
 #if defined(HAVE_ZLIB)
         (playlist->compressed != playlist->config.compress) ||
 #endif
@@ -1635,11 +2928,18 @@ void playlist_write_file(playlist_t *playlist)
 
    playlist->modified   = false;
    playlist->compressed = compressed;
+   playlist_journal_delete(playlist);
+   written              = true;
 
    RARCH_LOG("[Playlist]: Written to playlist file: %s\n", playlist->config.path);
 end:
    intfstream_close(file);
    free(file);
+
+   /* The file has to be closed first, so that
+    * its final size and time get recorded */
+   if (written)
+      playlist_bin_write(playlist);
 }
 
 /**
@@ -1655,16 +2955,13 @@ void playlist_free(playlist_t *playlist)
    if (!playlist)
       return;
 
-   if (playlist->default_core_path)
-      free(playlist->default_core_path);
+   playlist_free_string(playlist, playlist->default_core_path);
    playlist->default_core_path = NULL;
 
-   if (playlist->default_core_name)
-      free(playlist->default_core_name);
+   playlist_free_string(playlist, playlist->default_core_name);
    playlist->default_core_name = NULL;
 
-   if (playlist->base_content_directory)
-      free(playlist->base_content_directory);
+   playlist_free_string(playlist, playlist->base_content_directory);
    playlist->base_content_directory = NULL;
 
    if (playlist->entries)
@@ -1674,12 +2971,17 @@ void playlist_free(playlist_t *playlist)
          struct playlist_entry *entry = &playlist->entries[i];
 
          if (entry)
-            playlist_free_entry(entry);
+            playlist_free_entry(playlist, entry);
       }
 
       RBUF_FREE(playlist->entries);
    }
 
+   playlist_index_free(playlist);
+
+   /* Entry strings may point into it */
+   playlist_bin_unmap(playlist);
+
    free(playlist);
 }
 
@@ -1700,9 +3002,10 @@ void playlist_clear(playlist_t *playlist)
       struct playlist_entry *entry = &playlist->entries[i];
 
       if (entry)
-         playlist_free_entry(entry);
+         playlist_free_entry(playlist, entry);
    }
    RBUF_CLEAR(playlist->entries);
+   playlist_index_free(playlist);
 }
 
 /**
@@ -2046,17 +3349,22 @@ static bool playlist_read_file(playlist_t *playlist)
 {
    unsigned i;
    int test_char;
-   bool res = true;
+   bool res           = true;
+   bool parsed        = false;
+   intfstream_t *file = NULL;
+
+   if (playlist_bin_read(playlist))
+      return true;
 
 #if defined(HAVE_ZLIB)
       /* Always use RZIP interface when reading playlists
        * > this will automatically handle uncompressed
        *   data */
-   intfstream_t *file   = intfstream_open_rzip_file(
+   file = intfstream_open_rzip_file(
          playlist->config.path,
          RETRO_VFS_FILE_ACCESS_READ);
 #else
-   intfstream_t *file   = intfstream_open_file(
+   file = intfstream_open_file(
          playlist->config.path,
          RETRO_VFS_FILE_ACCESS_READ,
          RETRO_VFS_FILE_ACCESS_HINT_NONE);
@@ -2128,7 +3436,9 @@ static bool playlist_read_file(playlist_t *playlist)
             JSONStartArrayHandler,
             JSONEndArrayHandler,
             NULL, NULL) /* unused boolean/null handlers */
-            != RJSON_DONE)
+            == RJSON_DONE)
+         parsed = true;
+      else
       {
          if (context.out_of_memory)
          {
@@ -2348,6 +3658,12 @@ static bool playlist_read_file(playlist_t *playlist)
 end:
    intfstream_close(file);
    free(file);
+
+   /* Spare the next load the parsing, unless
+    * the playlist differs from the file */
+   if (parsed && !playlist->modified)
+      playlist_bin_write(playlist);
+
    return res;
 }
 
@@ -2408,6 +3724,15 @@ playlist_t *playlist_init(const playlist_config_t *config)
    playlist->default_core_path      = NULL;
    playlist->base_content_directory = NULL;
    playlist->entries                = NULL;
+   playlist->index                  = NULL;
+   playlist->index_size             = 0;
+   playlist->index_used             = 0;
+   playlist->index_live             = 0;
+   playlist->index_offset           = 0;
+   playlist->index_valid            = false;
+   playlist->journal_records        = 0;
+   playlist->bin_data               = NULL;
+   playlist->bin_size               = 0;
    playlist->label_display_mode     = LABEL_DISPLAY_MODE_DEFAULT;
    playlist->right_thumbnail_mode   = PLAYLIST_THUMBNAIL_MODE_DEFAULT;
    playlist->left_thumbnail_mode    = PLAYLIST_THUMBNAIL_MODE_DEFAULT;
@@ -2421,6 +3746,15 @@ playlist_t *playlist_init(const playlist_config_t *config)
    if (!playlist_read_file(playlist))
       goto error;
 
+   /* Apply the operations journaled since it was written.
+    * A record cut short has to be dropped before more
+    * records can be appended */
+   if (!playlist_journal_replay(playlist))
+   {
+      playlist->modified = true;
+      playlist_write_file(playlist);
+   }
+
    /* Try auto-fixing paths if enabled, and playlist
     * base content directory is different */
    if (config->autofix_paths && !string_is_equal(playlist->base_content_directory, config->base_content_directory))
@@ -2444,7 +3778,7 @@ playlist_t *playlist_init(const playlist_config_t *config)
                playlist->base_content_directory, playlist->config.base_content_directory,
                sizeof(tmp_entry_path));
 
-            free(entry->path);
+            playlist_free_string(playlist, entry->path);
             entry->path = strdup(tmp_entry_path);
 
             /* Fix subsystem roms paths*/
@@ -2478,8 +3812,7 @@ playlist_t *playlist_init(const playlist_config_t *config)
       }
 
       /* Update playlist base content directory*/
-      if (playlist->base_content_directory)
-         free(playlist->base_content_directory);
+      playlist_free_string(playlist, playlist->base_content_directory);
       playlist->base_content_directory = strdup(playlist->config.base_content_directory);
 
       /* Save playlist */
@@ -2585,17 +3918,57 @@ void playlist_qsort(playlist_t *playlist)
    qsort(playlist->entries, RBUF_LEN(playlist->entries),
          sizeof(struct playlist_entry),
          (int (*)(const void *, const void *))playlist_qsort_func);
+
+   /* Rebuilt on next lookup */
+   playlist_index_free(playlist);
 }
 
 void command_playlist_push_write(
       playlist_t *playlist,
       const struct playlist_entry *entry)
 {
-   if (!playlist)
+   size_t i;
+   const char *fields[PLAYLIST_JOURNAL_MAX_FIELDS];
+   size_t num_roms = 0;
+   bool journal    = false;
+
+   if (!playlist || !entry)
       return;
 
-   if (playlist_push(playlist, entry))
-      playlist_write_file(playlist);
+   if (entry->subsystem_roms)
+      num_roms = entry->subsystem_roms->size;
+
+   journal = playlist_journal_is_usable(playlist) &&
+      (num_roms <= PLAYLIST_JOURNAL_MAX_FIELDS - PLAYLIST_JOURNAL_PUSH_FIELDS);
+
+   if (!playlist_push(playlist, entry))
+      return;
+
+   if (journal)
+   {
+      fields[0] = "P";
+      fields[1] = entry->path;
+      fields[2] = entry->label;
+      fields[3] = entry->core_path;
+      fields[4] = entry->core_name;
+      fields[5] = entry->crc32;
+      fields[6] = entry->db_name;
+      fields[7] = entry->subsystem_ident;
+      fields[8] = entry->subsystem_name;
+
+      for (i = 0; i < num_roms; i++)
+         fields[PLAYLIST_JOURNAL_PUSH_FIELDS + i] =
+            entry->subsystem_roms->elems[i].data;
+
+      if (playlist_journal_append(playlist, fields,
+               PLAYLIST_JOURNAL_PUSH_FIELDS + num_roms))
+      {
+         playlist->modified = false;
+         return;
+      }
+   }
+
+   playlist_write_file(playlist);
 }
 
 void command_playlist_update_write(
@@ -2603,16 +3976,88 @@ void command_playlist_update_write(
       size_t idx,
       const struct playlist_entry *entry)
 {
-   playlist_t *playlist = plist ? plist : playlist_get_cached();
+   const char *fields[10];
+   char idx_str[32];
+   char *entry_path      = NULL;
+   char *entry_core_path = NULL;
+   bool journal          = false;
+   bool journaled        = false;
+   playlist_t *playlist  = plist ? plist : playlist_get_cached();
 
-   if (!playlist)
+   if (!playlist || idx >= RBUF_LEN(playlist->entries))
       return;
 
+   /* The entry's path and core path change on update, so
+    * they are kept to identify the entry in the record */
+   if ((journal = playlist_journal_is_usable(playlist)))
+   {
+      if (playlist->entries[idx].path)
+         entry_path      = strdup(playlist->entries[idx].path);
+      if (playlist->entries[idx].core_path)
+         entry_core_path = strdup(playlist->entries[idx].core_path);
+   }
+
    playlist_update(
          playlist,
          idx,
          entry);
 
+   if (journal && playlist->modified)
+   {
+      snprintf(idx_str, sizeof(idx_str), "%u", (unsigned)idx);
+
+      fields[0] = "U";
+      fields[1] = idx_str;
+      fields[2] = entry_path;
+      fields[3] = entry_core_path;
+      fields[4] = entry->path;
+      fields[5] = entry->label;
+      fields[6] = entry->core_path;
+      fields[7] = entry->core_name;
+      fields[8] = entry->db_name;
+      fields[9] = entry->crc32;
+
+      journaled = playlist_journal_append(playlist, fields, 10);
+   }
+
+   free(entry_path);
+   free(entry_core_path);
+
+   /* Nothing is written if the update changed nothing */
+   if (journal && (journaled || !playlist->modified))
+      playlist->modified = false;
+   else
+      playlist_write_file(playlist);
+}
+
+void command_playlist_delete_write(
+      playlist_t *playlist,
+      size_t idx)
+{
+   const char *fields[4];
+   char idx_str[32];
+
+   if (!playlist || idx >= RBUF_LEN(playlist->entries))
+      return;
+
+   if (playlist_journal_is_usable(playlist))
+   {
+      snprintf(idx_str, sizeof(idx_str), "%u", (unsigned)idx);
+
+      fields[0] = "D";
+      fields[1] = idx_str;
+      fields[2] = playlist->entries[idx].path;
+      fields[3] = playlist->entries[idx].core_path;
+
+      if (playlist_journal_append(playlist, fields, 4))
+      {
+         playlist_delete_index(playlist, idx);
+         playlist->modified = false;
+         return;
+      }
+   }
+
+   playlist_delete_index(playlist, idx);
    playlist_write_file(playlist);
 }
 
@@ -2776,8 +4221,7 @@ void playlist_set_default_core_path(playlist_t *playlist, const char *core_path)
 
    if (!string_is_equal(playlist->default_core_path, real_core_path))
    {
-      if (playlist->default_core_path)
-         free(playlist->default_core_path);
+      playlist_free_string(playlist, playlist->default_core_path);
       playlist->default_core_path = strdup(real_core_path);
       playlist->modified = true;
    }
@@ -2791,8 +4235,7 @@ void playlist_set_default_core_name(
 
    if (!string_is_equal(playlist->default_core_name, core_name))
    {
-      if (playlist->default_core_name)
-         free(playlist->default_core_name);
+      playlist_free_string(playlist, playlist->default_core_name);
       playlist->default_core_name = strdup(core_name);
       playlist->modified = true;
    }
@@ -275,6 +275,11 @@ void playlist_write_file(playlist_t *playlist);
 
 void playlist_write_runtime_file(playlist_t *playlist);
 
+/* Deletes a playlist file, along with the journal
+ * and binary copy kept next to it. The journal goes
+ * first, so that it never outlives the file */
+void playlist_delete_file(const char *path);
+
 void playlist_qsort(playlist_t *playlist);
 
 void playlist_free_cached(void);
@@ -291,6 +296,10 @@ playlist_t *playlist_get_cached(void);
  *   are always kept synced with user settings */
 bool playlist_init_cached(const playlist_config_t *config);
 
+/* Modify a playlist and save the change. Where possible,
+ * the change is appended to the playlist's journal instead
+ * of rewriting the whole file; the journal is compacted
+ * into the file by playlist_write_file() */
 void command_playlist_push_write(
       playlist_t *playlist,
       const struct playlist_entry *entry);
@@ -300,6 +309,10 @@ void command_playlist_update_write(
       size_t idx,
       const struct playlist_entry *entry);
 
+void command_playlist_delete_write(
+      playlist_t *playlist,
+      size_t idx);
+
 /* Returns true if specified playlist index matches
  * specified content/core paths */
 bool playlist_index_is_valid(playlist_t *playlist, size_t idx,
@@ -73,6 +73,8 @@
 #include <retro_timers.h>
 #include <encodings/utf.h>
 #include <time/rtime.h>
+#include <time/rsleep.h>
+#include <time/rtrace.h>
 
 #include <gfx/scaler/pixconv.h>
 #include <gfx/scaler/scaler.h>
@@ -99,6 +101,7 @@
 #include <streams/interface_stream.h>
 #include <file/file_path.h>
 #include <retro_assert.h>
+#include <retro_endianness.h>
 #include <retro_miscellaneous.h>
 #include <queues/message_queue.h>
 #include <queues/task_queue.h>
@@ -106,6 +109,9 @@
 #ifdef HAVE_NETWORKING
 #include <net/net_http.h>
 #endif
+#ifdef HAVE_ZLIB
+#include <file/archive_file.h>
+#endif
 
 #ifdef WIIU
 #include <wiiu/os/energy.h>
@@ -142,6 +148,12 @@
 #ifdef HAVE_NETWORKING
 #include <net/net_compat.h>
 #include <net/net_socket.h>
+#if defined(HAVE_NETWORK_CMD) && (defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__))
+#define HAVE_COMMAND_UNIX_SOCKET
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
 #endif
 
 #include <audio/audio_resampler.h>
@@ -3507,7 +3519,11 @@ void menu_driver_frame(bool menu_is_alive, video_frame_info_t *video_info)
 {
    struct rarch_state   *p_rarch  = &rarch_st;
    if (menu_is_alive && p_rarch->menu_driver_ctx->frame)
+   {
       p_rarch->menu_driver_ctx->frame(p_rarch->menu_userdata, video_info);
+      /* Submit any remaining batched draws */
+      gfx_display_batch_flush();
+   }
 }
 
 /* Time format strings with AM-PM designation require special
@@ -7887,6 +7903,239 @@ static void retro_perf_log(void)
    log_counters(p_rarch->perf_counters_libretro, p_rarch->perf_ptr_libretro);
 }
 
+/* Benchmark mode (--benchmark) */
+
+static const char *benchmark_section_names[BENCHMARK_LAST] = {
+   "core_run",
+   "video_driver_frame",
+   "audio_driver_flush",
+   "input_driver_poll",
+   "runahead",
+   "rewind",
+   "task_queue_check",
+   "input_state",
+   "input_state_uncached"
+};
+
+/* Sections are also recorded as trace slices when
+ * frame tracing is on */
+static void benchmark_begin(struct rarch_state *p_rarch,
+      enum benchmark_section section)
+{
+   rarch_benchmark_t *bench = p_rarch->benchmark;
+
+   RTRACE_BEGIN(benchmark_section_names[section]);
+
+   if (!bench)
+      return;
+
+   if (bench->depth < BENCHMARK_MAX_DEPTH)
+   {
+      bench->stack_section[bench->depth] = (uint8_t)section;
+      bench->stack_start[bench->depth]   = cpu_features_get_time_usec();
+      bench->stack_child[bench->depth]   = 0;
+   }
+
+   bench->depth++;
+}
+
+static void benchmark_end(struct rarch_state *p_rarch,
+      enum benchmark_section section)
+{
+   unsigned depth;
+   retro_time_t elapsed;
+   rarch_benchmark_t *bench = p_rarch->benchmark;
+
+   RTRACE_END(benchmark_section_names[section]);
+
+   if (!bench || !bench->depth)
+      return;
+
+   depth = --bench->depth;
+
+   if (depth >= BENCHMARK_MAX_DEPTH)
+      return;
+
+   elapsed = cpu_features_get_time_usec() - bench->stack_start[depth];
+
+   /* Nothing is accounted until the first frame starts */
+   if (bench->frame_start)
+   {
+      section                  = (enum benchmark_section)
+         bench->stack_section[depth];
+      bench->total[section]   += elapsed - bench->stack_child[depth];
+      bench->calls[section]++;
+   }
+
+   if (depth > 0)
+      bench->stack_child[depth - 1] += elapsed;
+}
+
+/* Called once per core frame; records the time since
+ * the previous one */
+static void benchmark_frame(struct rarch_state *p_rarch,
+      retro_time_t current_time)
+{
+   rarch_benchmark_t *bench = p_rarch->benchmark;
+
+   RTRACE_INSTANT("frame");
+
+   if (!bench)
+      return;
+
+   if (bench->frame_start)
+   {
+      if (bench->frames == bench->capacity)
+      {
+         size_t capacity            = bench->capacity
+            ? bench->capacity * 2 : 1024;
+         retro_time_t *frame_times  = (retro_time_t*)realloc(
+               bench->frame_times, capacity * sizeof(*frame_times));
+
+         if (!frame_times)
+            return;
+
+         bench->frame_times         = frame_times;
+         bench->capacity            = capacity;
+      }
+
+      bench->frame_times[bench->frames++] = current_time - bench->frame_start;
+   }
+
+   bench->frame_start = current_time;
+}
+
+static int benchmark_time_cmp(const void *a, const void *b)
+{
+   retro_time_t x = *(const retro_time_t*)a;
+   retro_time_t y = *(const retro_time_t*)b;
+   return (x > y) - (x < y);
+}
+
+static void benchmark_free(struct rarch_state *p_rarch)
+{
+   if (!p_rarch->benchmark)
+      return;
+
+   free(p_rarch->benchmark->frame_times);
+   free(p_rarch->benchmark);
+   p_rarch->benchmark = NULL;
+}
+
+static void benchmark_report(struct rarch_state *p_rarch)
+{
+   size_t i;
+   retro_time_t wall        = 0;
+   retro_time_t accounted   = 0;
+   rarch_benchmark_t *bench = p_rarch->benchmark;
+   size_t frames            = bench ? bench->frames : 0;
+
+   if (!frames)
+   {
+      fprintf(stdout, "[Benchmark]: No frames were run.\n");
+      return;
+   }
+
+   for (i = 0; i < frames; i++)
+      wall += bench->frame_times[i];
+
+   qsort(bench->frame_times, frames, sizeof(*bench->frame_times),
+         benchmark_time_cmp);
+
+   fprintf(stdout, "[Benchmark]: %u frames in %.3f s, %.2f fps\n",
+         (unsigned)frames, wall / 1000000.0,
+         wall ? (1000000.0 * frames) / wall : 0.0);
+   fprintf(stdout, "[Benchmark]: Frame time (ms): "
+         "min %.3f, p50 %.3f, p90 %.3f, p99 %.3f, max %.3f\n",
+         bench->frame_times[0]                        / 1000.0,
+         bench->frame_times[(frames - 1) * 50  / 100] / 1000.0,
+         bench->frame_times[(frames - 1) * 90  / 100] / 1000.0,
+         bench->frame_times[(frames - 1) * 99  / 100] / 1000.0,
+         bench->frame_times[frames - 1]               / 1000.0);
+   fprintf(stdout, "[Benchmark]: %-20s %12s %10s %7s %10s\n",
+         "Section", "Total (ms)", "ms/frame", "%", "Calls");
+
+   for (i = 0; i < BENCHMARK_LAST; i++)
+   {
+      if (!bench->calls[i])
+         continue;
+
+      accounted += bench->total[i];
+
+      fprintf(stdout, "[Benchmark]: %-20s %12.3f %10.4f %6.2f%% %10" PRIu64 "\n",
+            benchmark_section_names[i],
+            bench->total[i] / 1000.0,
+            bench->total[i] / 1000.0 / frames,
+            wall ? (100.0 * bench->total[i]) / wall : 0.0,
+            bench->calls[i]);
+   }
+
+   /* Frontend work outside the timed sections (runloop
+    * bookkeeping, menu/overlay checks, netplay, cheats...) */
+   if (wall > accounted)
+      fprintf(stdout, "[Benchmark]: %-20s %12.3f %10.4f %6.2f%%\n",
+            "other",
+            (wall - accounted) / 1000.0,
+            (wall - accounted) / 1000.0 / frames,
+            (100.0 * (wall - accounted)) / wall);
+
+   fflush(stdout);
+}
+
+/* Frame tracing (see libretro-common/time/rtrace.c) */
+
+static void retroarch_frame_trace_init(settings_t *settings)
+{
+   if (!settings->bools.frame_trace_enable)
+   {
+      /* The rings are kept (and only freed on exit) since
+       * other threads may still be writing to them */
+      rtrace_set_paused(true);
+      return;
+   }
+
+   if (rtrace_is_initialized())
+      rtrace_set_paused(false);
+   else if (rtrace_init(0))
+   {
+      rtrace_thread_name("main");
+      RARCH_LOG("[Trace]: Frame tracing enabled.\n");
+   }
+   else
+      RARCH_ERR("[Trace]: Failed to initialize frame tracing.\n");
+}
+
+static bool retroarch_frame_trace_save(settings_t *settings,
+      char *path, size_t len)
+{
+   char file_name[64];
+   const char *log_dir = settings->paths.log_dir;
+
+   file_name[0]        = '\0';
+
+   fill_str_dated_filename(file_name, "trace", "json", sizeof(file_name));
+
+   if (!string_is_empty(log_dir))
+   {
+      if (!path_is_directory(log_dir))
+         path_mkdir(log_dir);
+      fill_pathname_join(path, log_dir, file_name, len);
+   }
+   else
+      strlcpy(path, file_name, len);
+
+   if (!rtrace_dump(path))
+   {
+      RARCH_ERR("[Trace]: %s \"%s\".\n",
+            msg_hash_to_str(MSG_FRAME_TRACE_SAVE_FAILED), path);
+      return false;
+   }
+
+   RARCH_LOG("[Trace]: %s \"%s\".\n",
+         msg_hash_to_str(MSG_FRAME_TRACE_SAVED), path);
+   return true;
+}
+
 struct retro_perf_counter **retro_get_perf_counter_rarch(void)
 {
    struct rarch_state *p_rarch = &rarch_st;
@@ -9983,6 +10232,226 @@ static bool command_get_config_param(const char* arg)
    return true;
 }
 
+/* Task finder that counts the tasks and never matches */
+static bool command_metrics_count_task(retro_task_t *task, void *data)
+{
+   (*(unsigned*)data)++;
+   return false;
+}
+
+static void command_metrics_gather(struct rarch_state *p_rarch,
+      rarch_metrics_t *metrics)
+{
+   task_finder_data_t find_data;
+   unsigned tasks                = 0;
+   retro_time_t *times           = NULL;
+   /* Until the ring wraps, only its start is filled */
+   unsigned samples              = (unsigned)MIN(
+         p_rarch->video_driver_frame_time_count,
+         MEASURE_FRAME_TIME_SAMPLES_COUNT);
+
+   memset(metrics, 0, sizeof(*metrics));
+
+   metrics->frames               = p_rarch->video_driver_frame_count;
+   metrics->audio_underruns      = p_rarch->audio_driver_underruns;
+   metrics->audio_rate_ratio     = 1000000;
+
+   if (samples && (times = (retro_time_t*)
+            malloc(samples * sizeof(*times))))
+   {
+      unsigned i;
+      retro_time_t accum         = 0;
+
+      memcpy(times, p_rarch->video_driver_frame_time_samples,
+            samples * sizeof(*times));
+      for (i = 0; i < samples; i++)
+         accum += times[i];
+      qsort(times, samples, sizeof(*times), benchmark_time_cmp);
+
+      metrics->frame_time_samples = samples;
+      metrics->frame_time_avg     = (uint32_t)(accum / samples);
+      metrics->frame_time_p50     = (uint32_t)times[(samples * 50) / 100];
+      metrics->frame_time_p90     = (uint32_t)times[(samples * 90) / 100];
+      metrics->frame_time_p99     = (uint32_t)times[(samples * 99) / 100];
+      metrics->frame_time_max     = (uint32_t)times[samples - 1];
+      free(times);
+   }
+
+   if (     p_rarch->audio_driver_control
+         && p_rarch->audio_driver_buffer_size
+         && p_rarch->current_audio->write_avail)
+   {
+      size_t avail = p_rarch->current_audio->write_avail(
+            p_rarch->audio_driver_context_audio_data);
+
+      if (avail > p_rarch->audio_driver_buffer_size)
+         avail     = p_rarch->audio_driver_buffer_size;
+      metrics->audio_fill       = (uint32_t)(
+            (uint64_t)(p_rarch->audio_driver_buffer_size - avail) * 10000
+            / p_rarch->audio_driver_buffer_size);
+   }
+
+   if (p_rarch->audio_source_ratio_original > 0.0)
+      metrics->audio_rate_ratio = (uint32_t)(1000000.0
+            * p_rarch->audio_source_ratio_current
+            / p_rarch->audio_source_ratio_original + 0.5);
+
+#ifdef HAVE_REWIND
+   if (p_rarch->rewind_st.state)
+   {
+      unsigned entries          = 0;
+      size_t bytes              = 0;
+
+      state_manager_capacity(p_rarch->rewind_st.state,
+            &entries, &bytes, NULL);
+      metrics->rewind_used      = bytes;
+      metrics->rewind_capacity  = p_rarch->rewind_st.state->capacity;
+      metrics->rewind_entries   = entries;
+   }
+#endif
+
+#ifdef HAVE_RUNAHEAD
+   metrics->runahead_rollbacks  = p_rarch->runahead_rollbacks;
+   if (p_rarch->preempt)
+      metrics->preempt_rollbacks = p_rarch->preempt->rollbacks;
+#endif
+
+   find_data.func               = command_metrics_count_task;
+   find_data.userdata           = &tasks;
+   task_queue_find(&find_data);
+   metrics->task_queue_depth    = tasks;
+}
+
+static void command_metrics_put32(uint8_t **buf, uint32_t val)
+{
+   val = swap_if_big32(val);
+   memcpy(*buf, &val, sizeof(val));
+   *buf += sizeof(val);
+}
+
+static void command_metrics_put64(uint8_t **buf, uint64_t val)
+{
+   val = swap_if_big64(val);
+   memcpy(*buf, &val, sizeof(val));
+   *buf += sizeof(val);
+}
+
+/**
+ * command_metrics_format:
+ * @binary                : write the binary layout described
+ *                          next to rarch_metrics_t instead of JSON.
+ * @s                     : reply buffer, at least 1024 bytes.
+ *
+ * Returns: length of the reply written to @s.
+ **/
+static size_t command_metrics_format(struct rarch_state *p_rarch,
+      bool binary, char *s, size_t len)
+{
+   rarch_metrics_t metrics;
+
+   command_metrics_gather(p_rarch, &metrics);
+
+   if (binary)
+   {
+      uint8_t *out = (uint8_t*)s;
+
+      memcpy(out, METRICS_MAGIC, 4);
+      out         += 4;
+      /* Version and payload size */
+      command_metrics_put32(&out, METRICS_VERSION
+            | ((6 * sizeof(uint64_t) + 10 * sizeof(uint32_t)) << 16));
+      command_metrics_put64(&out, metrics.frames);
+      command_metrics_put64(&out, metrics.audio_underruns);
+      command_metrics_put64(&out, metrics.rewind_used);
+      command_metrics_put64(&out, metrics.rewind_capacity);
+      command_metrics_put64(&out, metrics.runahead_rollbacks);
+      command_metrics_put64(&out, metrics.preempt_rollbacks);
+      command_metrics_put32(&out, metrics.frame_time_samples);
+      command_metrics_put32(&out, metrics.frame_time_avg);
+      command_metrics_put32(&out, metrics.frame_time_p50);
+      command_metrics_put32(&out, metrics.frame_time_p90);
+      command_metrics_put32(&out, metrics.frame_time_p99);
+      command_metrics_put32(&out, metrics.frame_time_max);
+      command_metrics_put32(&out, metrics.audio_fill);
+      command_metrics_put32(&out, metrics.audio_rate_ratio);
+      command_metrics_put32(&out, metrics.rewind_entries);
+      command_metrics_put32(&out, metrics.task_queue_depth);
+
+      return out - (uint8_t*)s;
+   }
+
+   return snprintf(s, len,
+         "GET_METRICS {\"frames\":%" PRIu64 ","
+         "\"frame_time_us\":{\"samples\":%u,\"avg\":%u,"
+         "\"p50\":%u,\"p90\":%u,\"p99\":%u,\"max\":%u},"
+         "\"audio\":{\"fill\":%.2f,\"underruns\":%" PRIu64 ","
+         "\"rate_ratio\":%.6f},"
+         "\"rewind\":{\"used\":%" PRIu64 ",\"capacity\":%" PRIu64 ","
+         "\"entries\":%u},"
+         "\"runahead_rollbacks\":%" PRIu64 ","
+         "\"preempt_rollbacks\":%" PRIu64 ","
+         "\"task_queue_depth\":%u}\n",
+         metrics.frames,
+         metrics.frame_time_samples, metrics.frame_time_avg,
+         metrics.frame_time_p50, metrics.frame_time_p90,
+         metrics.frame_time_p99, metrics.frame_time_max,
+         metrics.audio_fill / 100.0, metrics.audio_underruns,
+         metrics.audio_rate_ratio / 1000000.0,
+         metrics.rewind_used, metrics.rewind_capacity,
+         metrics.rewind_entries,
+         metrics.runahead_rollbacks,
+         metrics.preempt_rollbacks,
+         metrics.task_queue_depth);
+}
+
+static bool command_metrics_is_binary(const char *arg)
+{
+   while (*arg == ' ')
+      arg++;
+   return string_starts_with(arg, "BINARY")
+      || string_starts_with(arg, "binary");
+}
+
+static bool command_get_metrics(const char* arg)
+{
+   char reply[1024];
+   struct rarch_state *p_rarch = &rarch_st;
+   size_t len                  = command_metrics_format(p_rarch,
+         command_metrics_is_binary(arg), reply, sizeof(reply));
+
+   command_reply(p_rarch, reply, len);
+   return true;
+}
+
+#ifdef HAVE_NETWORK_CMD
+/* Only one subscriber is kept: the last one to ask */
+static bool command_subscribe_metrics(const char* arg)
+{
+   char *end                   = NULL;
+   struct rarch_state *p_rarch = &rarch_st;
+   unsigned long interval_ms   = strtoul(arg, &end, 10);
+
+   if (end == arg || p_rarch->lastcmd_source != CMD_NETWORK)
+      return false;
+
+   if (!interval_ms)
+   {
+      p_rarch->metrics_push_interval = 0;
+      return true;
+   }
+
+   memcpy(&p_rarch->metrics_net_target, &p_rarch->lastcmd_net_source,
+         sizeof(p_rarch->metrics_net_target));
+   p_rarch->metrics_net_target_len   = p_rarch->lastcmd_net_source_len;
+   p_rarch->metrics_net_fd           = p_rarch->lastcmd_net_fd;
+   p_rarch->metrics_push_interval    = (retro_time_t)interval_ms * 1000;
+   p_rarch->metrics_push_last        = 0;
+   p_rarch->metrics_push_binary      = command_metrics_is_binary(end);
+
+   return true;
+}
+#endif
+
 #if defined(HAVE_CHEEVOS)
 static bool command_read_ram(const char *arg)
 {
@@ -10045,6 +10514,514 @@ static bool command_write_ram(const char *arg)
 }
 #endif
 
+/* Bulk memory replies are far larger than the commands asking
+ * for them, so they are only sent to peers on this machine: a
+ * spoofed UDP source address would otherwise turn the command
+ * port into a traffic amplifier */
+static bool command_source_is_local(struct rarch_state *p_rarch)
+{
+#ifdef HAVE_NETWORK_CMD
+   const struct sockaddr_storage *src = &p_rarch->lastcmd_net_source;
+
+   if (p_rarch->lastcmd_source != CMD_NETWORK)
+      return true;
+
+   switch (src->ss_family)
+   {
+#ifdef HAVE_COMMAND_UNIX_SOCKET
+      case AF_UNIX:
+         return true;
+#endif
+      case AF_INET:
+         return (ntohl(((const struct sockaddr_in*)src)->sin_addr.s_addr)
+               >> 24) == 127;
+#if defined(AF_INET6) && !defined(HAVE_SOCKET_LEGACY)
+      case AF_INET6:
+      {
+         const struct in6_addr *addr =
+            &((const struct sockaddr_in6*)src)->sin6_addr;
+
+         return IN6_IS_ADDR_LOOPBACK(addr)
+            || (IN6_IS_ADDR_V4MAPPED(addr) && addr->s6_addr[12] == 127);
+      }
+#endif
+      default:
+         break;
+   }
+
+   return false;
+#else
+   return true;
+#endif
+}
+
+/**
+ * command_memory_get_pointer:
+ * @address               : address in the core's memory map, or an
+ *                          offset into its system RAM if it has none.
+ * @avail                 : set to the number of bytes, starting at
+ *                          @address, that are stored consecutively.
+ *
+ * Translates an emulated address the way libretro.h describes
+ * for memory descriptors.
+ *
+ * Returns: pointer to the byte at @address, or NULL if unmapped.
+ **/
+static uint8_t *command_memory_get_pointer(struct rarch_state *p_rarch,
+      size_t address, size_t *avail)
+{
+   unsigned i;
+   const rarch_memory_map_t *mmaps = &p_rarch->runloop_system.mmaps;
+
+   if (!p_rarch->current_core.game_loaded)
+      return NULL;
+
+   if (!mmaps->num_descriptors)
+   {
+      retro_ctx_memory_info_t mem_info;
+
+      mem_info.id = RETRO_MEMORY_SYSTEM_RAM;
+      if (     !core_get_memory(&mem_info)
+            || !mem_info.data
+            || address >= mem_info.size)
+         return NULL;
+
+      *avail = mem_info.size - address;
+      return (uint8_t*)mem_info.data + address;
+   }
+
+   for (i = 0; i < mmaps->num_descriptors; i++)
+   {
+      size_t offset, bits;
+      const rarch_memory_descriptor_t *desc = &mmaps->descriptors[i];
+
+      if (((desc->core.start ^ address) & desc->core.select) != 0)
+         continue;
+
+      /* The first descriptor to claim an address applies */
+      if (!desc->core.ptr)
+         return NULL;
+
+      offset = mmap_reduce(address & ~desc->core.select,
+            desc->core.disconnect) & desc->disconnect_mask;
+      while (offset >= desc->core.len)
+         offset &= ~mmap_highest_bit(offset);
+
+      /* Following addresses stay consecutive in memory until
+       * a selected or disconnected address bit changes */
+      *avail = desc->core.len - offset;
+      bits   = desc->core.select | desc->core.disconnect;
+      if (bits)
+      {
+         size_t step = bits & ~(bits - 1);
+         size_t left = step - (address & (step - 1));
+
+         if (left < *avail)
+            *avail = left;
+      }
+
+      return (uint8_t*)desc->core.ptr + desc->core.offset + offset;
+   }
+
+   return NULL;
+}
+
+/* Copies up to @len bytes of emulated memory, stopping at
+ * the first unmapped address. Returns the bytes copied. */
+static size_t command_memory_copy(struct rarch_state *p_rarch,
+      size_t address, uint8_t *dst, size_t len)
+{
+   size_t done = 0;
+
+   while (done < len)
+   {
+      size_t avail       = 0;
+      const uint8_t *src = command_memory_get_pointer(p_rarch,
+            address + done, &avail);
+
+      if (!src)
+         break;
+      if (avail > len - done)
+         avail = len - done;
+
+      memcpy(dst + done, src, avail);
+      done += avail;
+   }
+
+   return done;
+}
+
+static void command_memory_write_header(struct rarch_state *p_rarch,
+      uint8_t *buf, enum command_memory_packet type, uint8_t flags,
+      uint16_t id, size_t address, size_t size)
+{
+   uint16_t id_le      = swap_if_big16(id);
+   uint32_t frame_le   = swap_if_big32(
+         (uint32_t)p_rarch->video_driver_frame_count);
+   uint64_t address_le = swap_if_big64((uint64_t)address);
+   uint32_t size_le    = swap_if_big32((uint32_t)size);
+
+   memcpy(buf, COMMAND_MEMORY_MAGIC, 4);
+   buf[4]              = (uint8_t)type;
+   buf[5]              = flags;
+   memcpy(buf + 6,  &id_le,      sizeof(id_le));
+   memcpy(buf + 8,  &frame_le,   sizeof(frame_le));
+   memcpy(buf + 12, &address_le, sizeof(address_le));
+   memcpy(buf + 20, &size_le,    sizeof(size_le));
+}
+
+static bool command_read_memory_binary(const char *arg)
+{
+   char *end                   = NULL;
+   uint8_t *packet             = NULL;
+   size_t done                 = 0;
+   struct rarch_state *p_rarch = &rarch_st;
+   size_t address              = strtoul(arg, &end, 16);
+   size_t len                  = strtoul(end, &end, 10);
+
+   if (end == arg)
+      return false;
+
+   if (!command_source_is_local(p_rarch))
+   {
+      RARCH_WARN("[Command]: READ_CORE_MEMORY_BINARY is only accepted from local peers.\n");
+      return false;
+   }
+
+   if (len > COMMAND_MEMORY_MAX_READ)
+      len = COMMAND_MEMORY_MAX_READ;
+
+   if (!(packet = (uint8_t*)malloc(
+               COMMAND_MEMORY_HEADER_SIZE + COMMAND_MEMORY_MAX_PAYLOAD)))
+      return false;
+
+   /* Large reads are split over several packets; a short
+    * one flagged as unmapped ends the reply early */
+   do
+   {
+      size_t chunk  = MIN(len - done, COMMAND_MEMORY_MAX_PAYLOAD);
+      size_t copied = command_memory_copy(p_rarch, address + done,
+            packet + COMMAND_MEMORY_HEADER_SIZE, chunk);
+      uint8_t flags = copied < chunk ? COMMAND_MEMORY_FLAG_UNMAPPED : 0;
+
+      command_memory_write_header(p_rarch, packet,
+            COMMAND_MEMORY_PACKET_READ, flags, 0, address + done, copied);
+      command_reply(p_rarch, (const char*)packet,
+            COMMAND_MEMORY_HEADER_SIZE + copied);
+
+      done += copied;
+      if (flags)
+         break;
+   } while (done < len);
+
+   free(packet);
+   return true;
+}
+
+#ifdef HAVE_NETWORK_CMD
+static void command_memory_send(struct rarch_state *p_rarch,
+      const command_memory_subscription_t *sub, size_t len)
+{
+   sendto(sub->fd, (const char*)p_rarch->memory_sub_packet, len, 0,
+         (const struct sockaddr*)&sub->target, sub->target_len);
+}
+
+static void command_memory_push_full(struct rarch_state *p_rarch,
+      const command_memory_subscription_t *sub, size_t copied)
+{
+   size_t done = 0;
+
+   do
+   {
+      size_t chunk  = MIN(copied - done, COMMAND_MEMORY_MAX_PAYLOAD);
+      uint8_t flags = (done + chunk == copied && copied < sub->len)
+         ? COMMAND_MEMORY_FLAG_UNMAPPED : 0;
+
+      command_memory_write_header(p_rarch, p_rarch->memory_sub_packet,
+            COMMAND_MEMORY_PACKET_FULL, flags, sub->id,
+            sub->address + done, chunk);
+      memcpy(p_rarch->memory_sub_packet + COMMAND_MEMORY_HEADER_SIZE,
+            p_rarch->memory_sub_scratch + done, chunk);
+      command_memory_send(p_rarch, sub, COMMAND_MEMORY_HEADER_SIZE + chunk);
+
+      done += chunk;
+   } while (done < copied);
+}
+
+static void command_memory_push_delta(struct rarch_state *p_rarch,
+      const command_memory_subscription_t *sub)
+{
+   /* Unchanged gaps shorter than a run header are cheaper to
+    * send as part of the surrounding run */
+   const size_t run_header     = sizeof(uint32_t) + sizeof(uint16_t);
+   const size_t run_max        = COMMAND_MEMORY_MAX_PAYLOAD - run_header;
+   const uint8_t *cur          = p_rarch->memory_sub_scratch;
+   const uint8_t *old          = sub->shadow;
+   uint8_t *payload            = p_rarch->memory_sub_packet
+      + COMMAND_MEMORY_HEADER_SIZE;
+   size_t payload_len          = 0;
+   size_t pos                  = 0;
+
+   while (pos < sub->len)
+   {
+      size_t start, end;
+      uint32_t offset_le;
+      uint16_t size_le;
+
+      while (pos + 64 <= sub->len && !memcmp(cur + pos, old + pos, 64))
+         pos += 64;
+      while (pos < sub->len && cur[pos] == old[pos])
+         pos++;
+      if (pos >= sub->len)
+         break;
+
+      start = pos;
+      end   = pos + 1;
+
+      while (end < sub->len && end - start < run_max)
+      {
+         size_t gap = end;
+
+         if (cur[end] != old[end])
+         {
+            end++;
+            continue;
+         }
+
+         while (gap < sub->len && gap - end < run_header
+               && cur[gap] == old[gap])
+            gap++;
+
+         if (gap >= sub->len || gap - end >= run_header
+               || gap - start >= run_max)
+            break;
+         end = gap;
+      }
+
+      if (payload_len + run_header + (end - start) > COMMAND_MEMORY_MAX_PAYLOAD)
+      {
+         command_memory_write_header(p_rarch, p_rarch->memory_sub_packet,
+               COMMAND_MEMORY_PACKET_DELTA, 0, sub->id,
+               sub->address, payload_len);
+         command_memory_send(p_rarch, sub,
+               COMMAND_MEMORY_HEADER_SIZE + payload_len);
+         payload_len = 0;
+      }
+
+      offset_le = swap_if_big32((uint32_t)start);
+      size_le   = swap_if_big16((uint16_t)(end - start));
+      memcpy(payload + payload_len, &offset_le, sizeof(offset_le));
+      memcpy(payload + payload_len + sizeof(offset_le),
+            &size_le, sizeof(size_le));
+      memcpy(payload + payload_len + run_header, cur + start, end - start);
+      payload_len += run_header + (end - start);
+      pos          = end;
+   }
+
+   if (payload_len)
+   {
+      command_memory_write_header(p_rarch, p_rarch->memory_sub_packet,
+            COMMAND_MEMORY_PACKET_DELTA, 0, sub->id,
+            sub->address, payload_len);
+      command_memory_send(p_rarch, sub,
+            COMMAND_MEMORY_HEADER_SIZE + payload_len);
+   }
+}
+
+/* Called for every command received: keeps the subscriptions
+ * of its sender alive */
+static void command_memory_touch(struct rarch_state *p_rarch)
+{
+   unsigned i;
+   retro_time_t now = 0;
+
+   for (i = 0; i < p_rarch->memory_sub_count; i++)
+   {
+      command_memory_subscription_t *sub = &p_rarch->memory_subs[i];
+
+      if (     sub->fd         != p_rarch->lastcmd_net_fd
+            || sub->target_len != p_rarch->lastcmd_net_source_len
+            || memcmp(&sub->target, &p_rarch->lastcmd_net_source,
+               sub->target_len))
+         continue;
+
+      if (!now)
+         now = cpu_features_get_time_usec();
+      sub->last_seen = now;
+   }
+}
+
+static void command_memory_unsubscribe(struct rarch_state *p_rarch,
+      unsigned index)
+{
+   free(p_rarch->memory_subs[index].shadow);
+
+   p_rarch->memory_sub_count--;
+   if (index != p_rarch->memory_sub_count)
+      p_rarch->memory_subs[index] =
+         p_rarch->memory_subs[p_rarch->memory_sub_count];
+
+   if (!p_rarch->memory_sub_count)
+   {
+      free(p_rarch->memory_sub_packet);
+      free(p_rarch->memory_sub_scratch);
+      p_rarch->memory_sub_packet       = NULL;
+      p_rarch->memory_sub_scratch      = NULL;
+      p_rarch->memory_sub_scratch_size = 0;
+   }
+}
+
+/* Sends every subscription that is due this frame. Delta
+ * subscriptions send nothing while their memory is unchanged,
+ * and no subscription sends anything while its first address
+ * is unmapped (e.g. before content is loaded). */
+static void command_memory_push(struct rarch_state *p_rarch)
+{
+   unsigned i;
+   retro_time_t now = cpu_features_get_time_usec();
+
+   /* Backwards, as dropping a subscription moves the last
+    * one into its slot */
+   for (i = p_rarch->memory_sub_count; i-- > 0; )
+   {
+      size_t copied;
+      command_memory_subscription_t *sub = &p_rarch->memory_subs[i];
+
+      if (now - sub->last_seen > COMMAND_MEMORY_SUBSCRIPTION_TIMEOUT)
+      {
+         RARCH_LOG("[Command]: Dropping core memory subscription %u, "
+               "its peer went quiet.\n", (unsigned)sub->id);
+         command_memory_unsubscribe(p_rarch, i);
+         continue;
+      }
+
+      if (--sub->countdown)
+         continue;
+      sub->countdown = sub->interval;
+
+      copied         = command_memory_copy(p_rarch, sub->address,
+            p_rarch->memory_sub_scratch, sub->len);
+
+      if (!copied)
+      {
+         sub->shadow_valid = false;
+         continue;
+      }
+
+      if (sub->delta && sub->shadow_valid && copied == sub->len)
+         command_memory_push_delta(p_rarch, sub);
+      else
+         command_memory_push_full(p_rarch, sub, copied);
+
+      if (sub->delta)
+      {
+         memcpy(sub->shadow, p_rarch->memory_sub_scratch, copied);
+         sub->shadow_valid = copied == sub->len;
+      }
+   }
+}
+
+static void command_memory_unsubscribe_all(struct rarch_state *p_rarch)
+{
+   while (p_rarch->memory_sub_count)
+      command_memory_unsubscribe(p_rarch, p_rarch->memory_sub_count - 1);
+}
+
+static bool command_subscribe_memory(const char *arg)
+{
+   char reply[64];
+   char *end                          = NULL;
+   command_memory_subscription_t *sub = NULL;
+   struct rarch_state *p_rarch        = &rarch_st;
+   size_t address                     = strtoul(arg, &end, 16);
+   size_t len                         = strtoul(end, &end, 10);
+   unsigned interval                  = (unsigned)strtoul(end, &end, 10);
+   bool delta                         = false;
+
+   while (*end == ' ')
+      end++;
+   delta = string_starts_with(end, "DELTA")
+      || string_starts_with(end, "delta");
+
+   if (     p_rarch->lastcmd_source != CMD_NETWORK
+         || !command_source_is_local(p_rarch)
+         || p_rarch->memory_sub_count >= COMMAND_MEMORY_MAX_SUBSCRIPTIONS
+         || !len || len > COMMAND_MEMORY_MAX_SUBSCRIPTION
+         || !interval)
+      goto error;
+
+   if (!p_rarch->memory_sub_packet
+         && !(p_rarch->memory_sub_packet = (uint8_t*)malloc(
+               COMMAND_MEMORY_HEADER_SIZE + COMMAND_MEMORY_MAX_PAYLOAD)))
+      goto error;
+
+   if (len > p_rarch->memory_sub_scratch_size)
+   {
+      uint8_t *scratch = (uint8_t*)realloc(p_rarch->memory_sub_scratch, len);
+
+      if (!scratch)
+         goto error;
+      p_rarch->memory_sub_scratch      = scratch;
+      p_rarch->memory_sub_scratch_size = len;
+   }
+
+   sub                = &p_rarch->memory_subs[p_rarch->memory_sub_count];
+   memset(sub, 0, sizeof(*sub));
+
+   if (delta && !(sub->shadow = (uint8_t*)malloc(len)))
+      goto error;
+
+   if (!++p_rarch->memory_sub_next_id)
+      p_rarch->memory_sub_next_id = 1;
+
+   memcpy(&sub->target, &p_rarch->lastcmd_net_source, sizeof(sub->target));
+   sub->target_len    = p_rarch->lastcmd_net_source_len;
+   sub->fd            = p_rarch->lastcmd_net_fd;
+   sub->address       = address;
+   sub->len           = len;
+   sub->interval      = interval;
+   sub->countdown     = 1;
+   sub->last_seen     = cpu_features_get_time_usec();
+   sub->id            = p_rarch->memory_sub_next_id;
+   sub->delta         = delta;
+   p_rarch->memory_sub_count++;
+
+   snprintf(reply, sizeof(reply), "SUBSCRIBE_CORE_MEMORY %u\n",
+         (unsigned)sub->id);
+   command_reply(p_rarch, reply, strlen(reply));
+   return true;
+
+error:
+   command_reply(p_rarch, "SUBSCRIBE_CORE_MEMORY -1\n",
+         STRLEN_CONST("SUBSCRIBE_CORE_MEMORY -1\n"));
+   return false;
+}
+
+static bool command_unsubscribe_memory(const char *arg)
+{
+   unsigned i;
+   struct rarch_state *p_rarch = &rarch_st;
+   unsigned long id            = strtoul(arg, NULL, 10);
+
+   if (string_starts_with(arg, "ALL") || string_starts_with(arg, "all"))
+   {
+      command_memory_unsubscribe_all(p_rarch);
+      return true;
+   }
+
+   for (i = 0; i < p_rarch->memory_sub_count; i++)
+   {
+      if (p_rarch->memory_subs[i].id == id)
+      {
+         command_memory_unsubscribe(p_rarch, i);
+         return true;
+      }
+   }
+
+   return false;
+}
+#endif
+
 #ifdef HAVE_NETWORK_CMD
 static bool command_get_arg(const char *tok,
       const char **arg, unsigned *index)
@@ -10075,7 +11052,7 @@ static bool command_get_arg(const char *tok,
             return false;
 
          if (arg)
-            *arg = argument + 1;
+            *arg = *argument ? argument + 1 : argument;
 
          if (index)
             *index = i;
@@ -10121,6 +11098,69 @@ error:
    return false;
 }
 
+#ifdef HAVE_COMMAND_UNIX_SOCKET
+/* Local clients must bind their own socket to a path
+ * to receive replies */
+static bool command_unix_init(command_t *handle, const char *path)
+{
+   struct stat st;
+   struct sockaddr_un addr;
+   int fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+
+   RARCH_LOG("[Command]: Bringing up command interface on %s.\n", path);
+
+   if (fd < 0)
+      return false;
+
+   memset(&addr, 0, sizeof(addr));
+   addr.sun_family = AF_UNIX;
+   strlcpy(addr.sun_path, path, sizeof(addr.sun_path));
+
+   if (lstat(path, &st) == 0)
+   {
+      bool in_use = false;
+      int probe   = -1;
+
+      if (!S_ISSOCK(st.st_mode))
+      {
+         RARCH_ERR("[Command]: %s exists and is not a socket.\n", path);
+         socket_close(fd);
+         return false;
+      }
+
+      /* Only a socket left behind by an instance that did
+       * not exit cleanly refuses connections */
+      if ((probe = socket(AF_UNIX, SOCK_DGRAM, 0)) >= 0)
+      {
+         in_use = connect(probe, (struct sockaddr*)&addr, sizeof(addr)) == 0;
+         socket_close(probe);
+      }
+
+      if (in_use)
+      {
+         RARCH_ERR("[Command]: %s is in use by another instance.\n", path);
+         socket_close(fd);
+         return false;
+      }
+
+      unlink(path);
+   }
+
+   if (     !socket_nonblock(fd)
+         || bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0)
+   {
+      RARCH_ERR("%s.\n",
+            msg_hash_to_str(MSG_FAILED_TO_BIND_SOCKET));
+      socket_close(fd);
+      return false;
+   }
+
+   handle->unix_fd = fd;
+   strlcpy(handle->unix_path, path, sizeof(handle->unix_path));
+   return true;
+}
+#endif
+
 static bool command_verify(const char *cmd)
 {
    unsigned i;
@@ -10231,23 +11271,20 @@ static void command_parse_msg(
    p_rarch->lastcmd_source = CMD_NONE;
 }
 
-static void command_network_poll(
+static void command_network_poll_fd(
       struct rarch_state *p_rarch,
-      command_t *handle)
+      command_t *handle, int fd)
 {
    fd_set fds;
    struct timeval       tmp_tv = {0};
 
-   if (handle->net_fd < 0)
-      return;
-
    FD_ZERO(&fds);
-   FD_SET(handle->net_fd, &fds);
+   FD_SET(fd, &fds);
 
-   if (socket_select(handle->net_fd + 1, &fds, NULL, NULL, &tmp_tv) <= 0)
+   if (socket_select(fd + 1, &fds, NULL, NULL, &tmp_tv) <= 0)
       return;
 
-   if (!FD_ISSET(handle->net_fd, &fds))
+   if (!FD_ISSET(fd, &fds))
       return;
 
    for (;;)
@@ -10257,9 +11294,9 @@ static void command_network_poll(
 
       buf[0] = '\0';
 
-      p_rarch->lastcmd_net_fd         = handle->net_fd;
+      p_rarch->lastcmd_net_fd         = fd;
       p_rarch->lastcmd_net_source_len = sizeof(p_rarch->lastcmd_net_source);
-      ret                             = recvfrom(handle->net_fd, buf,
+      ret                             = recvfrom(fd, buf,
             sizeof(buf) - 1, 0,
             (struct sockaddr*)&p_rarch->lastcmd_net_source,
             &p_rarch->lastcmd_net_source_len);
@@ -10269,9 +11306,41 @@ static void command_network_poll(
 
       buf[ret] = '\0';
 
+      command_memory_touch(p_rarch);
       command_parse_msg(p_rarch, handle, buf, CMD_NETWORK);
    }
 }
+
+static void command_network_poll(
+      struct rarch_state *p_rarch,
+      command_t *handle)
+{
+#ifdef HAVE_COMMAND_UNIX_SOCKET
+   if (handle->unix_fd >= 0)
+      command_network_poll_fd(p_rarch, handle, handle->unix_fd);
+#endif
+
+   if (handle->net_fd >= 0)
+      command_network_poll_fd(p_rarch, handle, handle->net_fd);
+
+   if (p_rarch->metrics_push_interval)
+   {
+      retro_time_t now = cpu_features_get_time_usec();
+
+      if (now - p_rarch->metrics_push_last
+            >= p_rarch->metrics_push_interval)
+      {
+         char msg[1024];
+         size_t len                 = command_metrics_format(p_rarch,
+               p_rarch->metrics_push_binary, msg, sizeof(msg));
+
+         p_rarch->metrics_push_last = now;
+         sendto(p_rarch->metrics_net_fd, msg, len, 0,
+               (struct sockaddr*)&p_rarch->metrics_net_target,
+               p_rarch->metrics_net_target_len);
+      }
+   }
+}
 #endif
 
 static bool command_free(command_t *handle)
@@ -10280,6 +11349,13 @@ static bool command_free(command_t *handle)
    if (handle && handle->net_fd >= 0)
       socket_close(handle->net_fd);
 #endif
+#ifdef HAVE_COMMAND_UNIX_SOCKET
+   if (handle && handle->unix_fd >= 0)
+   {
+      socket_close(handle->unix_fd);
+      unlink(handle->unix_path);
+   }
+#endif
 
    free(handle);
 
@@ -10350,13 +11426,21 @@ static bool command_network_new(
       command_t *handle,
       bool stdin_enable,
       bool network_enable,
-      uint16_t port)
+      uint16_t port,
+      const char *unix_path)
 {
 #ifdef HAVE_NETWORK_CMD
    handle->net_fd = -1;
    if (network_enable && !command_network_init(handle, port))
       goto error;
 #endif
+#ifdef HAVE_COMMAND_UNIX_SOCKET
+   handle->unix_fd = -1;
+   if (     network_enable
+         && !string_is_empty(unix_path)
+         && !command_unix_init(handle, unix_path))
+      goto error;
+#endif
 
 #ifdef HAVE_STDIN_CMD
    handle->stdin_enable = stdin_enable;
@@ -11853,6 +12937,15 @@ static void command_event_deinit_core(
 
    video_driver_set_cached_frame_ptr(NULL);
 
+   if (p_rarch->frame_limit_jitter.count)
+   {
+      char jitter[1024];
+      rsleep_jitter_to_string(&p_rarch->frame_limit_jitter,
+            jitter, sizeof(jitter));
+      RARCH_LOG("[Frame Limiter]: Wake-up error: %s", jitter);
+      rsleep_jitter_reset(&p_rarch->frame_limit_jitter);
+   }
+
    if (p_rarch->current_core.inited)
    {
       RARCH_LOG("[CORE]: Unloading core..\n");
@@ -12966,6 +14059,7 @@ static void runahead_clear_variables(struct rarch_state *p_rarch)
    p_rarch->runahead_video_driver_is_active   = true;
    p_rarch->runahead_available                = true;
    p_rarch->runahead_secondary_core_available = true;
+   p_rarch->runahead_thread_available         = true;
    p_rarch->runahead_force_input_dirty        = true;
    p_rarch->runahead_last_frame_count         = 0;
 }
@@ -13041,6 +14135,30 @@ bool command_event(enum event_command cmd, void *data)
          bsv_movie_check(p_rarch);
 #endif
          break;
+      case CMD_EVENT_FRAME_TRACE_INIT:
+         retroarch_frame_trace_init(settings);
+         break;
+      case CMD_EVENT_FRAME_TRACE_SAVE:
+         {
+            char msg[PATH_MAX_LENGTH + 64];
+            char path[PATH_MAX_LENGTH];
+
+            path[0] = msg[0] = '\0';
+
+            if (!rtrace_is_initialized() || !rtrace_active)
+               strlcpy(msg, msg_hash_to_str(MSG_FRAME_TRACE_DISABLED),
+                     sizeof(msg));
+            else if (retroarch_frame_trace_save(settings, path, sizeof(path)))
+               snprintf(msg, sizeof(msg), "%s \"%s\".",
+                     msg_hash_to_str(MSG_FRAME_TRACE_SAVED), path);
+            else
+               snprintf(msg, sizeof(msg), "%s \"%s\".",
+                     msg_hash_to_str(MSG_FRAME_TRACE_SAVE_FAILED), path);
+
+            runloop_msg_queue_push(msg, 1, 180, true, NULL,
+                  MESSAGE_QUEUE_ICON_DEFAULT, MESSAGE_QUEUE_CATEGORY_INFO);
+         }
+         break;
       case CMD_EVENT_AI_SERVICE_TOGGLE:
       {
 #ifdef HAVE_TRANSLATE
@@ -14782,6 +15900,20 @@ void main_exit(void *args)
    if (p_rarch->runloop_perfcnt_enable)
       rarch_perf_log(p_rarch);
 
+   if (p_rarch->benchmark)
+   {
+      benchmark_report(p_rarch);
+      benchmark_free(p_rarch);
+   }
+
+   if (rtrace_is_initialized() && rtrace_active)
+   {
+      char path[PATH_MAX_LENGTH];
+      path[0] = '\0';
+      retroarch_frame_trace_save(p_rarch->configuration_settings,
+            path, sizeof(path));
+   }
+
 #if defined(HAVE_LOGGER) && !defined(ANDROID)
    logger_shutdown();
 #endif
@@ -14806,6 +15938,8 @@ void main_exit(void *args)
    rarch_ctl(RARCH_CTL_STATE_FREE,  NULL);
    global_free(p_rarch);
    task_queue_deinit();
+   /* Only once no thread can record events any more */
+   rtrace_deinit();
 
    if (p_rarch->configuration_settings)
       free(p_rarch->configuration_settings);
@@ -14820,6 +15954,12 @@ void main_exit(void *args)
    frontend_driver_free();
 
    rtime_deinit();
+#ifdef HAVE_NETWORKING
+   net_http_pool_deinit();
+#endif
+#ifdef HAVE_ZLIB
+   file_archive_zip_index_cache_deinit();
+#endif
 
 #if defined(ANDROID)
    play_feature_delivery_deinit();
@@ -14851,6 +15991,7 @@ int rarch_main(int argc, char *argv[], void *data)
    p_rarch->runahead_video_driver_is_active                      = true;
    p_rarch->runahead_available                                   = true;
    p_rarch->runahead_secondary_core_available                    = true;
+   p_rarch->runahead_thread_available                            = true;
    p_rarch->runahead_force_input_dirty                           = true;
 #endif
 #if defined(_WIN32) && !defined(_XBOX) && !defined(__WINRT__)
@@ -14862,6 +16003,12 @@ int rarch_main(int argc, char *argv[], void *data)
 #endif
 
    rtime_init();
+#ifdef HAVE_NETWORKING
+   net_http_pool_init();
+#endif
+#ifdef HAVE_ZLIB
+   file_archive_zip_index_cache_init();
+#endif
 
 #if defined(ANDROID)
    play_feature_delivery_init();
@@ -14928,7 +16075,9 @@ int rarch_main(int argc, char *argv[], void *data)
 #endif
       ret = runloop_iterate();
 
+      benchmark_begin(p_rarch, BENCHMARK_TASKS);
       task_queue_check();
+      benchmark_end(p_rarch, BENCHMARK_TASKS);
 
 #ifdef HAVE_QT
       app_exit = ui_companion_qt.application->exiting;
@@ -16148,6 +17297,8 @@ static void core_performance_counter_start(
    struct rarch_state *p_rarch = &rarch_st;
    bool runloop_perfcnt_enable = p_rarch->runloop_perfcnt_enable;
 
+   RTRACE_BEGIN(perf->ident);
+
    if (runloop_perfcnt_enable)
    {
       perf->call_cnt++;
@@ -16162,6 +17313,8 @@ static void core_performance_counter_stop(struct retro_perf_counter *perf)
 
    if (runloop_perfcnt_enable)
       perf->total += cpu_features_get_perf_counter() - perf->start;
+
+   RTRACE_END(perf->ident);
 }
 
 static size_t mmap_add_bits_down(size_t n)
@@ -16459,7 +17612,7 @@ static const char *hw_render_context_name(enum retro_hw_context_type type, int m
 }
 
 /**
- * rarch_environment_cb:
+ * rarch_environment_handler:
  * @cmd                          : Identifier of command.
  * @data                         : Pointer to data.
  *
@@ -16468,7 +17621,7 @@ static const char *hw_render_context_name(enum retro_hw_context_type type, int m
  * Returns: true (1) if environment callback command could
  * be performed, otherwise false (0).
  **/
-static bool rarch_environment_cb(unsigned cmd, void *data)
+static bool rarch_environment_handler(unsigned cmd, void *data)
 {
    unsigned p;
    struct rarch_state *p_rarch  = &rarch_st;
@@ -17851,6 +19004,148 @@ static bool rarch_environment_cb(unsigned cmd, void *data)
    return true;
 }
 
+#if defined(HAVE_RUNAHEAD) && defined(HAVE_DYNAMIC) && defined(HAVE_THREADS)
+/* While run-ahead drives the secondary core instance from
+ * a worker thread, environment calls of both instances run
+ * concurrently; they are serialized, since the handler reads
+ * and writes shared state (core options, pending variable
+ * updates...).
+ * Returns true if the lock was taken by this call */
+static uintptr_t runahead_env_owner(runahead_thread_t *rt)
+{
+   uintptr_t owner;
+
+   slock_lock(rt->lock);
+   owner         = rt->env_owner;
+   slock_unlock(rt->lock);
+
+   return owner;
+}
+
+static void runahead_env_set_owner(runahead_thread_t *rt, uintptr_t owner)
+{
+   slock_lock(rt->lock);
+   rt->env_owner = owner;
+   slock_unlock(rt->lock);
+}
+
+static bool runahead_env_lock(struct rarch_state *p_rarch)
+{
+   uintptr_t self;
+   runahead_thread_t *rt = p_rarch->runahead_thread;
+
+   if (!rt)
+      return false;
+
+   /* Environment calls may nest (e.g. the handler
+    * reaching the secondary instance) */
+   self = sthread_get_current_thread_id();
+   if (runahead_env_owner(rt) == self)
+      return false;
+
+   slock_lock(rt->env_lock);
+   runahead_env_set_owner(rt, self);
+   return true;
+}
+
+static void runahead_env_unlock(struct rarch_state *p_rarch, bool locked)
+{
+   runahead_thread_t *rt = p_rarch->runahead_thread;
+
+   /* If the handler tore down the worker, the
+    * lock has been released already */
+   if (     !locked
+         || !rt
+         || runahead_env_owner(rt) != sthread_get_current_thread_id())
+      return;
+
+   runahead_env_set_owner(rt, 0);
+   slock_unlock(rt->env_lock);
+}
+
+/* Environment calls of the secondary instance that reach
+ * the video/audio drivers or the graphics context must not
+ * run on the worker thread, as the main instance may be
+ * using them at the same time. Calls that only repeat what
+ * the main instance reports are recorded and replayed by
+ * runahead_thread_replay_env(); the others are refused.
+ * Returns true if the call was handled here */
+static bool runahead_env_worker_call(runahead_thread_t *rt,
+      unsigned cmd, void *data, bool *result)
+{
+   switch (cmd)
+   {
+      case RETRO_ENVIRONMENT_SET_SYSTEM_AV_INFO:
+         if (!data)
+            return false;
+         rt->deferred_av_info  = *(const struct retro_system_av_info*)data;
+         rt->deferred         |= RUNAHEAD_DEFER_AV_INFO;
+         /* Supersedes any geometry recorded before it */
+         rt->deferred         &= ~RUNAHEAD_DEFER_GEOMETRY;
+         *result               = true;
+         return true;
+      case RETRO_ENVIRONMENT_SET_GEOMETRY:
+         if (!data)
+            return false;
+         rt->deferred_geometry = *(const struct retro_game_geometry*)data;
+         rt->deferred         |= RUNAHEAD_DEFER_GEOMETRY;
+         *result               = true;
+         return true;
+      case RETRO_ENVIRONMENT_SET_ROTATION:
+         if (!data)
+            return false;
+         rt->deferred_rotation = *(const unsigned*)data;
+         rt->deferred         |= RUNAHEAD_DEFER_ROTATION;
+         *result               = true;
+         return true;
+      case RETRO_ENVIRONMENT_SHUTDOWN:
+         rt->deferred         |= RUNAHEAD_DEFER_SHUTDOWN;
+         *result               = true;
+         return true;
+      case RETRO_ENVIRONMENT_SET_MESSAGE:
+      case RETRO_ENVIRONMENT_SET_MESSAGE_EXT:
+         /* The main instance shows the same messages */
+         *result               = true;
+         return true;
+      case RETRO_ENVIRONMENT_GET_CURRENT_SOFTWARE_FRAMEBUFFER:
+      case RETRO_ENVIRONMENT_GET_HW_RENDER_INTERFACE:
+      case RETRO_ENVIRONMENT_SET_HW_RENDER:
+      case RETRO_ENVIRONMENT_SET_HW_RENDER | RETRO_ENVIRONMENT_EXPERIMENTAL:
+      case RETRO_ENVIRONMENT_SET_HW_SHARED_CONTEXT:
+         *result               = false;
+         return true;
+      default:
+         break;
+   }
+
+   return false;
+}
+#endif
+
+/**
+ * rarch_environment_cb:
+ * @cmd                          : Identifier of command.
+ * @data                         : Pointer to data.
+ *
+ * Environment callback of the main core instance.
+ *
+ * Returns: true (1) if environment callback command could
+ * be performed, otherwise false (0).
+ **/
+static bool rarch_environment_cb(unsigned cmd, void *data)
+{
+#if defined(HAVE_RUNAHEAD) && defined(HAVE_DYNAMIC) && defined(HAVE_THREADS)
+   struct rarch_state *p_rarch = &rarch_st;
+   bool locked                 = runahead_env_lock(p_rarch);
+   bool ret                    = rarch_environment_handler(cmd, data);
+
+   runahead_env_unlock(p_rarch, locked);
+   return ret;
+#else
+   return rarch_environment_handler(cmd, data);
+#endif
+}
+
 #ifdef HAVE_DYNAMIC
 /**
  * libretro_get_environment_info:
@@ -18363,6 +19658,10 @@ static void secondary_core_destroy(struct rarch_state *p_rarch)
    if (!p_rarch || !p_rarch->secondary_lib_handle)
       return;
 
+#if defined(HAVE_DYNAMIC) && defined(HAVE_THREADS)
+   runahead_thread_free(p_rarch);
+#endif
+
    /* unload game from core */
    if (p_rarch->secondary_core.retro_unload_game)
       p_rarch->secondary_core.retro_unload_game();
@@ -18586,9 +19885,38 @@ end:
 static bool rarch_environment_secondary_core_hook(
       unsigned cmd, void *data)
 {
+   bool result;
    struct rarch_state *p_rarch = &rarch_st;
-   bool                 result = rarch_environment_cb(cmd, data);
+#if defined(HAVE_DYNAMIC) && defined(HAVE_THREADS)
+   /* The worker thread calls in while the main
+    * instance runs */
+   bool locked                 = runahead_env_lock(p_rarch);
+
+   if (     p_rarch->runahead_thread
+         && p_rarch->runahead_thread->running
+         && runahead_env_worker_call(p_rarch->runahead_thread,
+            cmd, data, &result))
+   {
+      runahead_env_unlock(p_rarch, locked);
+      return result;
+   }
+#endif
 
+   result                      = rarch_environment_handler(cmd, data);
+
+#if defined(HAVE_DYNAMIC) && defined(HAVE_THREADS)
+   /* The worker thread never outputs audio, and only
+    * presents the last frame of each job */
+   if (     cmd == RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE
+         && p_rarch->runahead_thread
+         && p_rarch->runahead_thread->running)
+   {
+      if (data)
+         *(int*)data = (p_rarch->runahead_thread->capturing ? 1 : 0) | 8;
+      result = true;
+   }
+   else
+#endif
    if (p_rarch->has_variable_update)
    {
       if (cmd == RETRO_ENVIRONMENT_GET_VARIABLE_UPDATE)
@@ -18596,11 +19924,15 @@ static bool rarch_environment_secondary_core_hook(
          bool *bool_p                 = (bool*)data;
          *bool_p                      = true;
          p_rarch->has_variable_update = false;
-         return true;
+         result                       = true;
       }
       else if (cmd == RETRO_ENVIRONMENT_GET_VARIABLE)
          p_rarch->has_variable_update = false;
    }
+
+#if defined(HAVE_DYNAMIC) && defined(HAVE_THREADS)
+   runahead_env_unlock(p_rarch, locked);
+#endif
    return result;
 }
 
@@ -18723,7 +20055,9 @@ static bool secondary_core_run_use_last_input(struct rarch_state *p_rarch)
    p_rarch->secondary_core.retro_set_input_poll(p_rarch->secondary_callbacks.poll_cb);
    p_rarch->secondary_core.retro_set_input_state(p_rarch->secondary_callbacks.state_cb);
 
+   benchmark_begin(p_rarch, BENCHMARK_CORE_RUN);
    p_rarch->secondary_core.retro_run();
+   benchmark_end(p_rarch, BENCHMARK_CORE_RUN);
 
    p_rarch->secondary_callbacks.poll_cb  = old_poll_function;
    p_rarch->secondary_callbacks.state_cb = old_input_function;
@@ -21660,11 +22994,12 @@ float input_sensor_get_input(unsigned port, unsigned id)
 }
 
 /**
- * input_poll:
+ * input_driver_poll_devices:
  *
- * Input polling callback function.
+ * Polls the input drivers and updates the turbo, remap,
+ * overlay and remote states.
  **/
-static void input_driver_poll(void)
+static void input_driver_poll_devices(void)
 {
    size_t i, j;
    rarch_joypad_info_t joypad_info[MAX_USERS];
@@ -22053,6 +23388,24 @@ static void input_driver_poll(void)
 #endif
 }
 
+/**
+ * input_driver_poll:
+ *
+ * Input polling callback function. Wraps input_driver_poll_devices()
+ * so that benchmark mode can time it, and invalidates the input
+ * snapshot.
+ **/
+static void input_driver_poll(void)
+{
+   struct rarch_state *p_rarch = &rarch_st;
+
+   benchmark_begin(p_rarch, BENCHMARK_INPUT_POLL);
+   input_driver_poll_devices();
+   memset(p_rarch->input_snapshot.valid, 0,
+         sizeof(p_rarch->input_snapshot.valid));
+   benchmark_end(p_rarch, BENCHMARK_INPUT_POLL);
+}
+
 static int16_t input_state_device(
       struct rarch_state *p_rarch,
       int16_t ret,
@@ -22436,22 +23789,23 @@ static int16_t input_state_device(
 }
 
 /**
- * input_state:
+ * input_state_resolve:
  * @port                 : user number.
- * @device               : device identifier of user.
+ * @device               : device identifier of user, without subclass.
  * @idx                  : index value of user.
  * @id                   : identifier of key pressed by user.
  *
- * Input state callback function.
+ * Queries the input drivers and applies binds, remaps, turbo
+ * and the overlay to the result.
  *
- * Returns: Non-zero if the given key (identified by @id)
- * was pressed by the user (assigned to @port).
+ * Returns: the state input_state() reports to the core.
  **/
-static int16_t input_state(unsigned port, unsigned device,
+static int16_t input_state_resolve(
+      struct rarch_state *p_rarch,
+      unsigned port, unsigned device,
       unsigned idx, unsigned id)
 {
    rarch_joypad_info_t joypad_info;
-   struct rarch_state *p_rarch = &rarch_st;
    settings_t *settings        = p_rarch->configuration_settings;
    int16_t result              = 0;
    int16_t ret                 = 0;
@@ -22467,23 +23821,6 @@ static int16_t input_state(unsigned port, unsigned device,
    joypad_info.joy_idx         = settings->uints.input_joypad_map[port];
    joypad_info.auto_binds      = input_autoconf_binds[joypad_info.joy_idx];
 
-#ifdef HAVE_BSV_MOVIE
-   if (BSV_MOVIE_IS_PLAYBACK_ON())
-   {
-      int16_t bsv_result;
-      if (intfstream_read(p_rarch->bsv_movie_state_handle->file, &bsv_result, 2) == 2)
-      {
-#ifdef HAVE_CHEEVOS
-         rcheevos_pause_hardcore();
-#endif
-         return swap_if_big16(bsv_result);
-      }
-
-      p_rarch->bsv_movie_state.movie_end = true;
-   }
-#endif
-
-   device &= RETRO_DEVICE_MASK;
    ret     = input_state_wrap(
          p_rarch,
          p_rarch->current_input_data,
@@ -22535,24 +23872,120 @@ static int16_t input_state(unsigned port, unsigned device,
       }
    }
 
-   if (     (p_rarch->input_driver_flushing_input == 0)
-         && !p_rarch->input_driver_block_libretro_input)
+   if (  (device == RETRO_DEVICE_JOYPAD) &&
+         (id == RETRO_DEVICE_ID_JOYPAD_MASK))
    {
-      if (  (device == RETRO_DEVICE_JOYPAD) &&
-            (id == RETRO_DEVICE_ID_JOYPAD_MASK))
+      unsigned i;
+
+      for (i = 0; i < RARCH_FIRST_CUSTOM_BIND; i++)
+         if (input_state_device(p_rarch, ret, port, device, idx, i, true))
+            result |= (1 << i);
+   }
+   else
+      result = input_state_device(p_rarch, ret, port, device, idx, id, false);
+
+   return result;
+}
+
+/**
+ * input_state_cached:
+ * @port                 : user number.
+ * @device               : device identifier of user, without subclass.
+ * @idx                  : index value of user.
+ * @id                   : identifier of key pressed by user.
+ *
+ * Serves joypad buttons and analog sticks from the input
+ * snapshot, resolving them on the first query after each
+ * poll, so that cores querying every button individually
+ * do not repeat the bind and remap logic. Anything else is
+ * resolved on every call.
+ *
+ * Returns: the state input_state() reports to the core.
+ **/
+static int16_t input_state_cached(
+      struct rarch_state *p_rarch,
+      unsigned port, unsigned device,
+      unsigned idx, unsigned id)
+{
+   input_snapshot_t *snapshot = &p_rarch->input_snapshot;
+
+   if (     (port < MAX_USERS)
+         && (device == RETRO_DEVICE_JOYPAD)
+         && (     (id < RARCH_FIRST_CUSTOM_BIND)
+               || (id == RETRO_DEVICE_ID_JOYPAD_MASK)))
+   {
+      if (!(snapshot->valid[port] & INPUT_SNAPSHOT_BUTTONS))
       {
-         unsigned i;
+         snapshot->buttons[port] = input_state_resolve(p_rarch,
+               port, device, 0, RETRO_DEVICE_ID_JOYPAD_MASK);
+         snapshot->valid[port]  |= INPUT_SNAPSHOT_BUTTONS;
+      }
 
-         {
-            for (i = 0; i < RARCH_FIRST_CUSTOM_BIND; i++)
-               if (input_state_device(p_rarch, ret, port, device, idx, i, true))
-                  result |= (1 << i);
-         }
+      if (id == RETRO_DEVICE_ID_JOYPAD_MASK)
+         return snapshot->buttons[port];
+      return (snapshot->buttons[port] >> id) & 1;
+   }
+
+   if (     (port < MAX_USERS)
+         && (device == RETRO_DEVICE_ANALOG)
+         && (idx < 2)
+         && (id  < 2))
+   {
+      unsigned axis = (idx * 2) + id;
+
+      if (!(snapshot->valid[port] & INPUT_SNAPSHOT_ANALOG(axis)))
+      {
+         snapshot->analog[port][axis] = input_state_resolve(p_rarch,
+               port, device, idx, id);
+         snapshot->valid[port]       |= INPUT_SNAPSHOT_ANALOG(axis);
       }
-      else
-         result = input_state_device(p_rarch, ret, port, device, idx, id, false);
+
+      return snapshot->analog[port][axis];
    }
 
+   return input_state_resolve(p_rarch, port, device, idx, id);
+}
+
+/**
+ * input_state:
+ * @port                 : user number.
+ * @device               : device identifier of user.
+ * @idx                  : index value of user.
+ * @id                   : identifier of key pressed by user.
+ *
+ * Input state callback function.
+ *
+ * Returns: Non-zero if the given key (identified by @id)
+ * was pressed by the user (assigned to @port).
+ **/
+static int16_t input_state(unsigned port, unsigned device,
+      unsigned idx, unsigned id)
+{
+   struct rarch_state *p_rarch = &rarch_st;
+   int16_t result              = 0;
+
+#ifdef HAVE_BSV_MOVIE
+   if (BSV_MOVIE_IS_PLAYBACK_ON())
+   {
+      int16_t bsv_result;
+      if (intfstream_read(p_rarch->bsv_movie_state_handle->file, &bsv_result, 2) == 2)
+      {
+#ifdef HAVE_CHEEVOS
+         rcheevos_pause_hardcore();
+#endif
+         return swap_if_big16(bsv_result);
+      }
+
+      p_rarch->bsv_movie_state.movie_end = true;
+   }
+#endif
+
+   device &= RETRO_DEVICE_MASK;
+
+   if (     (p_rarch->input_driver_flushing_input == 0)
+         && !p_rarch->input_driver_block_libretro_input)
+      result = input_state_cached(p_rarch, port, device, idx, id);
+
 #ifdef HAVE_BSV_MOVIE
    if (BSV_MOVIE_IS_PLAYBACK_OFF())
    {
@@ -22564,6 +23997,54 @@ static int16_t input_state(unsigned port, unsigned device,
    return result;
 }
 
+/**
+ * benchmark_input_storm:
+ *
+ * Queries every joypad button and analog stick axis of every
+ * user one at a time, as cores that do not use
+ * RETRO_DEVICE_ID_JOYPAD_MASK do, several times over as cores
+ * reading the pads on every controller latch do. Done once
+ * through the input snapshot, invalidated first as a poll
+ * would, and once resolving each query from scratch.
+ **/
+static void benchmark_input_storm(struct rarch_state *p_rarch)
+{
+   unsigned round, port, id;
+   unsigned max_users = MIN(p_rarch->input_driver_max_users, MAX_USERS);
+
+   benchmark_begin(p_rarch, BENCHMARK_INPUT_STATE);
+   memset(p_rarch->input_snapshot.valid, 0,
+         sizeof(p_rarch->input_snapshot.valid));
+   for (round = 0; round < BENCHMARK_INPUT_ROUNDS; round++)
+   {
+      for (port = 0; port < max_users; port++)
+      {
+         for (id = 0; id < RARCH_FIRST_CUSTOM_BIND; id++)
+            input_state_cached(p_rarch, port,
+                  RETRO_DEVICE_JOYPAD, 0, id);
+         for (id = 0; id < 4; id++)
+            input_state_cached(p_rarch, port,
+                  RETRO_DEVICE_ANALOG, id >> 1, id & 1);
+      }
+   }
+   benchmark_end(p_rarch, BENCHMARK_INPUT_STATE);
+
+   benchmark_begin(p_rarch, BENCHMARK_INPUT_RESOLVE);
+   for (round = 0; round < BENCHMARK_INPUT_ROUNDS; round++)
+   {
+      for (port = 0; port < max_users; port++)
+      {
+         for (id = 0; id < RARCH_FIRST_CUSTOM_BIND; id++)
+            input_state_resolve(p_rarch, port,
+                  RETRO_DEVICE_JOYPAD, 0, id);
+         for (id = 0; id < 4; id++)
+            input_state_resolve(p_rarch, port,
+                  RETRO_DEVICE_ANALOG, id >> 1, id & 1);
+      }
+   }
+   benchmark_end(p_rarch, BENCHMARK_INPUT_RESOLVE);
+}
+
 static int16_t input_joypad_axis(
       struct rarch_state *p_rarch,
       const input_device_driver_t *drv,
@@ -24497,7 +25978,8 @@ static bool input_driver_init_command(struct rarch_state *p_rarch)
                p_rarch->input_driver_command,
                input_stdin_cmd_enable && !grab_stdin,
                input_network_cmd_enable,
-               network_cmd_port))
+               network_cmd_port,
+               settings->paths.network_cmd_unix_path))
          return true;
 
    RARCH_ERR("Failed to initialize command interface.\n");
@@ -24506,6 +25988,11 @@ static bool input_driver_init_command(struct rarch_state *p_rarch)
 
 static void input_driver_deinit_command(struct rarch_state *p_rarch)
 {
+#ifdef HAVE_NETWORK_CMD
+   /* Their sockets are about to be closed */
+   command_memory_unsubscribe_all(p_rarch);
+   p_rarch->metrics_push_interval = 0;
+#endif
    if (p_rarch->input_driver_command)
       command_free(p_rarch->input_driver_command);
    p_rarch->input_driver_command = NULL;
@@ -27638,6 +29125,8 @@ static void audio_driver_flush(
          (audio_fastforward_mute && is_fastmotion)) ?
                0.0f : p_rarch->audio_driver_volume_gain;
 
+   benchmark_begin(p_rarch, BENCHMARK_AUDIO_FLUSH);
+
    src_data.data_out                 = NULL;
    src_data.output_frames            = 0;
 
@@ -27690,6 +29179,10 @@ static void audio_driver_flush(
 
       p_rarch->audio_driver_free_samples_buf
          [write_idx]                        = avail;
+      /* The driver drained the whole buffer since
+       * the last write, so it ran out of samples */
+      if (avail >= (int)p_rarch->audio_driver_buffer_size)
+         p_rarch->audio_driver_underruns++;
       p_rarch->audio_source_ratio_current   =
          p_rarch->audio_source_ratio_original * adjust;
 
@@ -27772,6 +29265,8 @@ static void audio_driver_flush(
                output_data, output_frames * 2) < 0)
          p_rarch->audio_driver_active = false;
    }
+
+   benchmark_end(p_rarch, BENCHMARK_AUDIO_FLUSH);
 }
 
 /**
@@ -30861,6 +32356,8 @@ static void video_driver_frame(const void *data, unsigned width,
    if (!video_driver_active)
       return;
 
+   benchmark_begin(p_rarch, BENCHMARK_VIDEO_FRAME);
+
    new_time                     = cpu_features_get_time_usec();
 
    if (data)
@@ -31160,7 +32657,7 @@ static void video_driver_frame(const void *data, unsigned width,
       snprintf(video_info.stat_text,
             sizeof(video_info.stat_text),
             "Video Statistics:\n -Frame rate: %6.2f fps\n -Frame time: %6.2f ms\n -Frame time deviation: %.3f %%\n"
-            " -Frame count: %" PRIu64"\n -Viewport: %d x %d x %3.2f\n"
+            " -Frame count: %" PRIu64"\n -Viewport: %d x %d x %3.2f\n -Menu draw calls: %u\n"
             "Audio Statistics:\n -Average buffer saturation: %.2f %%\n -Standard deviation: %.2f %%\n -Time spent close to underrun: %.2f %%\n -Time spent close to blocking: %.2f %%\n -Sample count: %d\n"
             "Core Geometry:\n -Size: %u x %u\n -Max Size: %u x %u\n -Aspect: %3.2f\nCore Timing:\n -FPS: %3.2f\n -Sample Rate: %6.2f\n",
             last_fps,
@@ -31170,6 +32667,7 @@ static void video_driver_frame(const void *data, unsigned width,
             video_info.width,
             video_info.height,
             video_info.refresh_rate,
+            gfx_display_get_draw_calls(),
             audio_stats.average_buffer_saturation,
             audio_stats.std_deviation_percentage,
             audio_stats.close_to_underrun,
@@ -31183,6 +32681,41 @@ static void video_driver_frame(const void *data, unsigned width,
             av_info->timing.fps,
             av_info->timing.sample_rate);
 
+      if (p_rarch->frame_limit_jitter.count)
+      {
+         char limiter_text[96];
+         snprintf(limiter_text, sizeof(limiter_text),
+               "Frame Limiter:\n -Wake-up error: %u us avg, %u us max\n",
+               (unsigned)(p_rarch->frame_limit_jitter.total_usec
+                  / (int64_t)p_rarch->frame_limit_jitter.count),
+               (unsigned)p_rarch->frame_limit_jitter.max_usec);
+         strlcat(video_info.stat_text, limiter_text,
+               sizeof(video_info.stat_text));
+      }
+
+      if (settings->bools.video_frame_delay_auto)
+      {
+         char delay_text[64];
+         snprintf(delay_text, sizeof(delay_text),
+               "Frame Delay:\n -Automatic: %u ms\n",
+               p_rarch->video_frame_delay_effective);
+         strlcat(video_info.stat_text, delay_text,
+               sizeof(video_info.stat_text));
+      }
+
+#ifdef HAVE_RUNAHEAD
+      if (p_rarch->preempt)
+      {
+         char preempt_text[128];
+         snprintf(preempt_text, sizeof(preempt_text),
+               "Preemptive Frames:\n -Rollbacks: %u/s\n -Replayed frames: %u/s\n",
+               p_rarch->preempt->rollbacks_per_sec,
+               p_rarch->preempt->replayed_frames_per_sec);
+         strlcat(video_info.stat_text, preempt_text,
+               sizeof(video_info.stat_text));
+      }
+#endif
+
       /* TODO/FIXME - add OSD chat text here */
    }
 
@@ -31194,6 +32727,8 @@ static void video_driver_frame(const void *data, unsigned width,
 
    p_rarch->video_driver_frame_count++;
 
+   gfx_display_frame_end();
+
    /* Display the status text, with a higher priority. */
    if (     video_info.fps_show
          || video_info.framecount_show
@@ -31251,6 +32786,8 @@ static void video_driver_frame(const void *data, unsigned width,
    }
    else if (!video_info.crt_switch_resolution)
       p_rarch->video_driver_crt_switching_active = false;
+
+   benchmark_end(p_rarch, BENCHMARK_VIDEO_FRAME);
 }
 
 void crt_switch_driver_reinit(void)
@@ -32933,20 +34470,18 @@ static void input_state_set_last(unsigned port, unsigned device,
    element->state[id] = value;
 }
 
-static int16_t input_state_get_last(unsigned port,
-      unsigned device, unsigned index, unsigned id)
+static int16_t input_state_list_get(const my_list *list,
+      unsigned port, unsigned device, unsigned index, unsigned id)
 {
    unsigned i;
-   struct rarch_state      *p_rarch = &rarch_st;
 
-   if (!p_rarch->input_state_list)
+   if (!list)
       return 0;
 
    /* find list item */
-   for (i = 0; i < (unsigned)p_rarch->input_state_list->size; i++)
+   for (i = 0; i < (unsigned)list->size; i++)
    {
-      input_list_element *element =
-         (input_list_element*)p_rarch->input_state_list->data[i];
+      input_list_element *element = (input_list_element*)list->data[i];
 
       if (  (element->port   == port)   &&
             (element->device == device) &&
@@ -32960,6 +34495,14 @@ static int16_t input_state_get_last(unsigned port,
    return 0;
 }
 
+static int16_t input_state_get_last(unsigned port,
+      unsigned device, unsigned index, unsigned id)
+{
+   struct rarch_state      *p_rarch = &rarch_st;
+   return input_state_list_get(p_rarch->input_state_list,
+         port, device, index, id);
+}
+
 static int16_t input_state_with_logging(unsigned port,
       unsigned device, unsigned index, unsigned id)
 {
@@ -33115,8 +34658,28 @@ static void runahead_remove_hooks(struct rarch_state *p_rarch)
    remove_input_state_hook(p_rarch);
 }
 
+static void preempt_free(struct rarch_state *p_rarch)
+{
+   unsigned i;
+   preempt_t *preempt = p_rarch->preempt;
+
+   if (!preempt)
+      return;
+
+   if (preempt->rollbacks)
+      RARCH_LOG("[Preemptive Frames]: %" PRIu64 " rollbacks, %" PRIu64 " replayed frames.\n",
+            preempt->rollbacks, preempt->replayed_frames);
+
+   for (i = 0; i < PREEMPT_MAX_FRAMES; i++)
+      free(preempt->buffer[i]);
+   free(preempt);
+
+   p_rarch->preempt = NULL;
+}
+
 static void runahead_destroy(struct rarch_state *p_rarch)
 {
+   preempt_free(p_rarch);
    mylist_destroy(&p_rarch->runahead_save_state_list);
    runahead_remove_hooks(p_rarch);
    runahead_clear_variables(p_rarch);
@@ -33239,6 +34802,8 @@ static bool runahead_load_state(struct rarch_state *p_rarch)
 
    if (!okay)
       runahead_error(p_rarch);
+   else
+      p_rarch->runahead_rollbacks++;
 
    return okay;
 }
@@ -33263,6 +34828,7 @@ static bool runahead_load_state_secondary(struct rarch_state *p_rarch)
       return false;
    }
 
+   p_rarch->runahead_rollbacks++;
    return true;
 }
 #endif
@@ -33279,7 +34845,9 @@ static bool runahead_core_run_use_last_input(struct rarch_state *p_rarch)
    p_rarch->current_core.retro_set_input_poll(cbs->poll_cb);
    p_rarch->current_core.retro_set_input_state(cbs->state_cb);
 
+   benchmark_begin(p_rarch, BENCHMARK_CORE_RUN);
    p_rarch->current_core.retro_run();
+   benchmark_end(p_rarch, BENCHMARK_CORE_RUN);
 
    cbs->poll_cb                           = old_poll_function;
    cbs->state_cb                          = old_input_function;
@@ -33290,9 +34858,388 @@ static bool runahead_core_run_use_last_input(struct rarch_state *p_rarch)
    return true;
 }
 
+#if defined(HAVE_DYNAMIC) && defined(HAVE_THREADS)
+/* Threaded secondary instance
+ *
+ * The secondary core is driven by a worker thread. While
+ * input stays the same, the worker runs the speculative
+ * frame in parallel with the main instance; the main thread
+ * only blocks on it when input changed and the secondary
+ * instance has to be resynchronised from a savestate. */
+
+static void runahead_thread_video_cb(const void *data, unsigned width,
+      unsigned height, size_t pitch)
+{
+   struct rarch_state *p_rarch = &rarch_st;
+   runahead_thread_t *rt       = p_rarch->runahead_thread;
+   size_t size                 = pitch * height;
+
+   if (!rt->capturing)
+      return;
+
+   rt->frame_dupe              = false;
+   rt->frame_hw                = false;
+
+   if (!data)
+   {
+      rt->frame_dupe           = true;
+      return;
+   }
+
+   if (data == RETRO_HW_FRAME_BUFFER_VALID)
+   {
+      rt->frame_hw             = true;
+      return;
+   }
+
+   if (size > rt->frame_capacity)
+   {
+      void *frame              = realloc(rt->frame, size);
+      if (!frame)
+      {
+         rt->frame_dupe        = true;
+         return;
+      }
+      rt->frame                = frame;
+      rt->frame_capacity       = size;
+   }
+
+   memcpy(rt->frame, data, size);
+   rt->frame_width             = width;
+   rt->frame_height            = height;
+   rt->frame_pitch             = pitch;
+}
+
+static void runahead_thread_audio_sample_cb(int16_t left, int16_t right) { }
+
+static size_t runahead_thread_audio_batch_cb(
+      const int16_t *data, size_t frames)
+{
+   return frames;
+}
+
+static int16_t runahead_thread_input_state_cb(unsigned port,
+      unsigned device, unsigned index, unsigned id)
+{
+   struct rarch_state *p_rarch = &rarch_st;
+   return input_state_list_get(p_rarch->runahead_thread->input_state_list,
+         port, device, index, id);
+}
+
+static void runahead_thread_entry(void *data)
+{
+   struct rarch_state *p_rarch = &rarch_st;
+   runahead_thread_t *rt       = (runahead_thread_t*)data;
+
+   slock_lock(rt->lock);
+
+   for (;;)
+   {
+      int i, frames;
+      bool capture;
+
+      while (!rt->frames_to_run && !rt->quit)
+         scond_wait(rt->cond, rt->lock);
+
+      if (rt->quit)
+         break;
+
+      frames      = rt->frames_to_run;
+      capture     = rt->capture;
+      rt->running = true;
+      slock_unlock(rt->lock);
+
+      if (rtrace_active)
+         rtrace_thread_name("runahead");
+
+      for (i = 0; i < frames; i++)
+      {
+         rt->capturing = capture && (i == frames - 1);
+         RTRACE_BEGIN("secondary_core_run");
+         p_rarch->secondary_core.retro_run();
+         RTRACE_END("secondary_core_run");
+      }
+      rt->capturing = false;
+
+      slock_lock(rt->lock);
+      rt->running       = false;
+      rt->frames_to_run = 0;
+      scond_signal(rt->cond);
+   }
+
+   slock_unlock(rt->lock);
+}
+
+/* Copies the input logged by the main instance, so that the
+ * worker reads a stable set while the main instance logs the
+ * next frame's input */
+static void runahead_thread_snapshot_input(
+      struct rarch_state *p_rarch, runahead_thread_t *rt)
+{
+   int i;
+   my_list *src = p_rarch->input_state_list;
+
+   if (!src)
+   {
+      mylist_resize(rt->input_state_list, 0, false);
+      return;
+   }
+
+   mylist_resize(rt->input_state_list, src->size, true);
+
+   for (i = 0; i < src->size; i++)
+   {
+      input_list_element *from = (input_list_element*)src->data[i];
+      input_list_element *to   = (input_list_element*)
+         rt->input_state_list->data[i];
+
+      input_list_element_realloc(to, from->state_size);
+      to->port                 = from->port;
+      to->device               = from->device;
+      to->index                = from->index;
+      memcpy(to->state, from->state, from->state_size * sizeof(int16_t));
+      if (to->state_size > from->state_size)
+         memset(&to->state[from->state_size], 0,
+               (to->state_size - from->state_size) * sizeof(int16_t));
+   }
+}
+
+static void runahead_thread_run(runahead_thread_t *rt,
+      int frames, bool capture)
+{
+   slock_lock(rt->lock);
+   rt->frames_to_run = frames;
+   rt->capture       = capture;
+   scond_signal(rt->cond);
+   slock_unlock(rt->lock);
+}
+
+static void runahead_thread_wait(runahead_thread_t *rt)
+{
+   slock_lock(rt->lock);
+   while (rt->frames_to_run)
+      scond_wait(rt->cond, rt->lock);
+   slock_unlock(rt->lock);
+}
+
+static void runahead_thread_free(struct rarch_state *p_rarch)
+{
+   runahead_thread_t *rt = p_rarch->runahead_thread;
+
+   if (!rt)
+      return;
+
+   /* When torn down from within an environment call,
+    * the worker may be waiting for the environment
+    * lock held by this thread */
+   if (runahead_env_owner(rt) == sthread_get_current_thread_id())
+   {
+      runahead_env_set_owner(rt, 0);
+      slock_unlock(rt->env_lock);
+   }
+
+   if (rt->thread)
+   {
+      slock_lock(rt->lock);
+      rt->quit = true;
+      scond_signal(rt->cond);
+      slock_unlock(rt->lock);
+      sthread_join(rt->thread);
+   }
+
+   /* Hand the secondary instance back to the serial code path */
+   if (p_rarch->secondary_lib_handle)
+   {
+      p_rarch->secondary_core.retro_set_video_refresh(p_rarch->secondary_callbacks.frame_cb);
+      p_rarch->secondary_core.retro_set_audio_sample(p_rarch->secondary_callbacks.sample_cb);
+      p_rarch->secondary_core.retro_set_audio_sample_batch(p_rarch->secondary_callbacks.sample_batch_cb);
+      p_rarch->secondary_core.retro_set_input_state(p_rarch->secondary_callbacks.state_cb);
+      p_rarch->secondary_core.retro_set_input_poll(p_rarch->secondary_callbacks.poll_cb);
+   }
+
+   scond_free(rt->cond);
+   slock_free(rt->lock);
+   slock_free(rt->env_lock);
+   mylist_destroy(&rt->input_state_list);
+   free(rt->frame);
+   free(rt);
+
+   p_rarch->runahead_thread = NULL;
+}
+
+static bool runahead_thread_init(struct rarch_state *p_rarch)
+{
+   runahead_thread_t *rt = (runahead_thread_t*)
+      calloc(1, sizeof(*rt));
+
+   if (!rt)
+      return false;
+
+   p_rarch->runahead_thread = rt;
+
+   mylist_create(&rt->input_state_list, 16,
+         input_list_element_constructor,
+         input_list_element_destructor);
+
+   rt->lock     = slock_new();
+   rt->cond     = scond_new();
+   rt->env_lock = slock_new();
+
+   if (!rt->lock || !rt->cond || !rt->env_lock)
+      goto error;
+
+   p_rarch->secondary_core.retro_set_video_refresh(runahead_thread_video_cb);
+   p_rarch->secondary_core.retro_set_audio_sample(runahead_thread_audio_sample_cb);
+   p_rarch->secondary_core.retro_set_audio_sample_batch(runahead_thread_audio_batch_cb);
+   p_rarch->secondary_core.retro_set_input_state(runahead_thread_input_state_cb);
+   p_rarch->secondary_core.retro_set_input_poll(secondary_core_input_poll_null);
+
+   rt->thread = sthread_create(runahead_thread_entry, rt);
+
+   if (!rt->thread)
+      goto error;
+
+   return true;
+
+error:
+   runahead_thread_free(p_rarch);
+   return false;
+}
+
+/* Replays, on the main thread, the environment calls the
+ * worker recorded during its last job */
+static void runahead_thread_replay_env(struct rarch_state *p_rarch)
+{
+   struct retro_system_av_info av_info;
+   struct retro_game_geometry geometry;
+   unsigned rotation;
+   unsigned deferred;
+   runahead_thread_t *rt = p_rarch->runahead_thread;
+
+   if (!rt || !rt->deferred)
+      return;
+
+   /* The handlers may reinitialize the drivers,
+    * so work from copies */
+   av_info      = rt->deferred_av_info;
+   geometry     = rt->deferred_geometry;
+   rotation     = rt->deferred_rotation;
+   deferred     = rt->deferred;
+   rt->deferred = 0;
+
+   if (deferred & RUNAHEAD_DEFER_AV_INFO)
+      rarch_environment_secondary_core_hook(
+            RETRO_ENVIRONMENT_SET_SYSTEM_AV_INFO, &av_info);
+   if (deferred & RUNAHEAD_DEFER_GEOMETRY)
+      rarch_environment_secondary_core_hook(
+            RETRO_ENVIRONMENT_SET_GEOMETRY, &geometry);
+   if (deferred & RUNAHEAD_DEFER_ROTATION)
+      rarch_environment_secondary_core_hook(
+            RETRO_ENVIRONMENT_SET_ROTATION, &rotation);
+   if (deferred & RUNAHEAD_DEFER_SHUTDOWN)
+      rarch_environment_secondary_core_hook(
+            RETRO_ENVIRONMENT_SHUTDOWN, NULL);
+}
+
+/* Secondary instance frame for the threaded code path.
+ * Returns false if the caller should fall back to the
+ * serial code path. */
+static bool runahead_thread_frame(struct rarch_state *p_rarch,
+      int runahead_count)
+{
+   runahead_thread_t *rt = p_rarch->runahead_thread;
+   bool speculative      = false;
+
+   if (!rt)
+   {
+      /* HW rendered cores need their context on the main thread */
+      if (  !p_rarch->runahead_thread_available
+          || p_rarch->hw_render.context_type != RETRO_HW_CONTEXT_NONE
+          || !runahead_thread_init(p_rarch))
+      {
+         p_rarch->runahead_thread_available = false;
+         return false;
+      }
+      rt = p_rarch->runahead_thread;
+   }
+
+   /* Assume input does not change this frame: the secondary
+    * instance advances one frame with last frame's input
+    * while the main instance runs */
+   if (!p_rarch->runahead_force_input_dirty)
+   {
+      runahead_thread_snapshot_input(p_rarch, rt);
+      runahead_thread_run(rt, 1, true);
+      speculative = true;
+   }
+
+   /* run main core with video suspended */
+   p_rarch->video_driver_active     = false;
+   core_run();
+   RUNAHEAD_RESUME_VIDEO();
+
+   if (speculative)
+      runahead_thread_wait(rt);
+
+   if (     p_rarch->input_is_dirty
+         || p_rarch->runahead_force_input_dirty)
+   {
+      p_rarch->input_is_dirty       = false;
+
+      /* On failure, keep the resync pending so that it
+       * is retried next frame, and repeat the last frame */
+      if (!runahead_save_state(p_rarch))
+      {
+         runloop_msg_queue_push(msg_hash_to_str(MSG_RUNAHEAD_FAILED_TO_SAVE_STATE), 0, 3 * 60, true, NULL, MESSAGE_QUEUE_ICON_DEFAULT, MESSAGE_QUEUE_CATEGORY_INFO);
+         p_rarch->runahead_force_input_dirty = true;
+         video_driver_frame(NULL, 0, 0, 0);
+         return true;
+      }
+
+      if (!runahead_load_state_secondary(p_rarch))
+      {
+         runloop_msg_queue_push(msg_hash_to_str(MSG_RUNAHEAD_FAILED_TO_LOAD_STATE), 0, 3 * 60, true, NULL, MESSAGE_QUEUE_ICON_DEFAULT, MESSAGE_QUEUE_CATEGORY_INFO);
+         p_rarch->runahead_force_input_dirty = true;
+         video_driver_frame(NULL, 0, 0, 0);
+         return true;
+      }
+
+      runahead_thread_snapshot_input(p_rarch, rt);
+      runahead_thread_run(rt, runahead_count, true);
+      runahead_thread_wait(rt);
+   }
+
+   runahead_thread_replay_env(p_rarch);
+
+   /* A replayed call may have torn down the worker */
+   if (!(rt = p_rarch->runahead_thread))
+   {
+      p_rarch->runahead_force_input_dirty = true;
+      video_driver_frame(NULL, 0, 0, 0);
+      return true;
+   }
+
+   if (rt->frame_hw)
+   {
+      /* Core switched to a HW framebuffer; give up on threading */
+      runahead_thread_free(p_rarch);
+      p_rarch->runahead_thread_available  = false;
+      p_rarch->runahead_force_input_dirty = true;
+      video_driver_frame(NULL, 0, 0, 0);
+      return true;
+   }
+
+   p_rarch->runahead_force_input_dirty = false;
+   video_driver_frame(rt->frame_dupe ? NULL : rt->frame,
+         rt->frame_width, rt->frame_height, rt->frame_pitch);
+   return true;
+}
+#endif
+
 static void do_runahead(
       struct rarch_state *p_rarch,
-      int runahead_count, bool use_secondary)
+      int runahead_count, bool use_secondary,
+      bool use_thread)
 {
    int frame_number        = 0;
    bool last_frame         = false;
@@ -33385,6 +35332,16 @@ static void do_runahead(
          goto force_input_dirty;
       }
 
+#ifdef HAVE_THREADS
+      /* Clears runahead_force_input_dirty itself once
+       * the secondary instance is in sync */
+      if (use_thread && runahead_thread_frame(p_rarch, runahead_count))
+         return;
+
+      if (p_rarch->runahead_thread)
+         runahead_thread_free(p_rarch);
+#endif
+
       /* run main core with video suspended */
       p_rarch->video_driver_active     = false;
       core_run();
@@ -33432,6 +35389,295 @@ force_input_dirty:
    core_run();
    p_rarch->runahead_force_input_dirty   = true;
 }
+
+/* Preemptive Frames */
+
+/* Input state callback of the core while preemptive frames
+ * are on. Logs every distinct query, like
+ * input_state_with_logging, so that whatever device the core
+ * reads (joypad, mouse, keyboard, lightgun, pointer...) is
+ * watched for changes. Only new queries are stored: the
+ * values of known ones are updated by preempt_input_changed */
+static int16_t preempt_input_state(unsigned port,
+      unsigned device, unsigned index, unsigned id)
+{
+   unsigned i;
+   struct rarch_state *p_rarch = &rarch_st;
+   preempt_t *preempt          = p_rarch->preempt;
+   int16_t result              = input_state(port, device, index, id);
+
+   if (!preempt)
+      return result;
+
+   for (i = 0; i < preempt->num_queries; i++)
+   {
+      const preempt_query_t *query = &preempt->queries[i];
+
+      if (     query->id     == id
+            && query->port   == port
+            && query->device == device
+            && query->index  == index)
+         return result;
+   }
+
+   if (preempt->num_queries < PREEMPT_MAX_QUERIES)
+   {
+      preempt_query_t *query = &preempt->queries[preempt->num_queries++];
+
+      query->port            = port;
+      query->device          = device;
+      query->index           = index;
+      query->id              = id;
+      query->value           = result;
+   }
+   else if (!preempt->queries_full)
+   {
+      preempt->queries_full  = true;
+      RARCH_WARN("[Preemptive Frames]: Core reads more than %u inputs, "
+            "changes to the others will not roll back.\n",
+            PREEMPT_MAX_QUERIES);
+   }
+
+   return result;
+}
+
+/* Polls input for the whole frame and reports whether any
+ * input the core has read differs from the one the frames
+ * in the ring were produced with. The stored input is only
+ * updated once the ring is full, so that a change made while
+ * it fills up still rolls back the frames produced before */
+static bool preempt_input_changed(struct rarch_state *p_rarch,
+      preempt_t *preempt)
+{
+   unsigned i;
+   bool changed = false;
+   bool update  = preempt->filled == preempt->frames;
+
+   input_driver_poll();
+
+   for (i = 0; i < preempt->num_queries; i++)
+   {
+      preempt_query_t *query = &preempt->queries[i];
+      int16_t value          = input_state(query->port,
+            query->device, query->index, query->id);
+
+      if (value != query->value)
+      {
+         changed             = true;
+         if (update)
+            query->value     = value;
+      }
+   }
+
+   return changed;
+}
+
+static preempt_t *preempt_new(struct rarch_state *p_rarch,
+      unsigned frames)
+{
+   unsigned i;
+   retro_ctx_size_info_t info;
+   preempt_t *preempt              = NULL;
+
+   p_rarch->request_fast_savestate = true;
+   core_serialize_size(&info);
+   p_rarch->request_fast_savestate = false;
+
+   if (!info.size)
+      return NULL;
+
+   if (!(preempt = (preempt_t*)calloc(1, sizeof(*preempt))))
+      return NULL;
+
+   preempt->state_size             = info.size;
+   preempt->frames                 = frames;
+   preempt->stats_time             = cpu_features_get_time_usec();
+
+   for (i = 0; i < frames; i++)
+   {
+      if (!(preempt->buffer[i] = malloc(info.size)))
+      {
+         p_rarch->preempt          = preempt;
+         preempt_free(p_rarch);
+         return NULL;
+      }
+   }
+
+   return preempt;
+}
+
+static bool preempt_save_state(struct rarch_state *p_rarch,
+      preempt_t *preempt, unsigned slot)
+{
+   bool okay;
+   retro_ctx_serialize_info_t serialize_info;
+
+   serialize_info.data             = preempt->buffer[slot];
+   serialize_info.data_const       = preempt->buffer[slot];
+   serialize_info.size             = preempt->state_size;
+
+   p_rarch->request_fast_savestate = true;
+   okay                            = core_serialize(&serialize_info);
+   p_rarch->request_fast_savestate = false;
+
+   return okay;
+}
+
+static bool preempt_load_state(struct rarch_state *p_rarch,
+      preempt_t *preempt, unsigned slot)
+{
+   bool okay;
+   bool last_dirty                 = p_rarch->input_is_dirty;
+
+   p_rarch->request_fast_savestate = true;
+   /* Bypass core_unserialize, like runahead_load_state */
+   okay                            = p_rarch->current_core.retro_unserialize(
+         preempt->buffer[slot], preempt->state_size);
+   p_rarch->request_fast_savestate = false;
+   p_rarch->input_is_dirty         = last_dirty;
+
+   return okay;
+}
+
+static void preempt_update_stats(preempt_t *preempt)
+{
+   retro_time_t now    = cpu_features_get_time_usec();
+   retro_time_t window = now - preempt->stats_time;
+
+   if (window < 1000000)
+      return;
+
+   preempt->rollbacks_per_sec       = (unsigned)
+      (((uint64_t)preempt->window_rollbacks       * 1000000) / window);
+   preempt->replayed_frames_per_sec = (unsigned)
+      (((uint64_t)preempt->window_replayed_frames * 1000000) / window);
+   preempt->window_rollbacks        = 0;
+   preempt->window_replayed_frames  = 0;
+   preempt->stats_time              = now;
+}
+
+/* Alternative to do_runahead: instead of saving and loading
+ * a state every frame, a savestate is taken before each frame
+ * and kept in a ring of 'frames' entries. Only when input
+ * changes is the oldest one loaded and the frames since then
+ * replayed with the new input, which makes the input appear
+ * to have happened 'frames' frames earlier. */
+static void do_preemptive_frames(struct rarch_state *p_rarch,
+      unsigned frames)
+{
+   unsigned i;
+   bool rollback;
+   preempt_t *preempt           = p_rarch->preempt;
+   struct retro_callbacks *cbs  = &p_rarch->retro_ctx;
+
+   if (!p_rarch->runahead_available)
+      goto run_core;
+
+#ifdef HAVE_BSV_MOVIE
+   /* Movies record/replay every input query */
+   if (p_rarch->bsv_movie_state_handle)
+      goto run_core;
+#endif
+
+   if (frames > PREEMPT_MAX_FRAMES)
+      frames = PREEMPT_MAX_FRAMES;
+
+   if (preempt && preempt->frames != frames)
+   {
+      preempt_free(p_rarch);
+      preempt = NULL;
+   }
+
+   if (!preempt)
+   {
+      if (!(preempt = preempt_new(p_rarch, frames)))
+      {
+         settings_t *settings        = p_rarch->configuration_settings;
+         bool runahead_hide_warnings = settings->bools.run_ahead_hide_warnings;
+
+         p_rarch->runahead_available = false;
+         if (!runahead_hide_warnings)
+            runloop_msg_queue_push(msg_hash_to_str(MSG_RUNAHEAD_CORE_DOES_NOT_SUPPORT_SAVESTATES), 0, 2 * 60, true, NULL, MESSAGE_QUEUE_ICON_DEFAULT, MESSAGE_QUEUE_CATEGORY_INFO);
+         goto run_core;
+      }
+
+      p_rarch->preempt            = preempt;
+      /* Reset and state load hooks flag input as dirty,
+       * which invalidates the ring */
+      runahead_add_hooks(p_rarch);
+   }
+
+   if (p_rarch->input_is_dirty)
+   {
+      preempt->filled             = 0;
+      p_rarch->input_is_dirty     = false;
+   }
+
+   rollback = preempt_input_changed(p_rarch, preempt)
+      && preempt->filled == preempt->frames;
+
+   /* Input has been polled above for the whole frame */
+   p_rarch->current_core.retro_set_input_poll(retro_input_poll_null);
+   p_rarch->current_core.retro_set_input_state(preempt_input_state);
+
+   if (rollback)
+   {
+      if (!preempt_load_state(p_rarch, preempt, preempt->ptr))
+         goto error_load;
+
+      for (i = 0; i < preempt->frames; i++)
+      {
+         if (i > 0 && !preempt_save_state(p_rarch, preempt,
+                  (preempt->ptr + i) % preempt->frames))
+            goto error_save;
+
+         p_rarch->video_driver_active = false;
+         p_rarch->audio_suspended     = true;
+         benchmark_begin(p_rarch, BENCHMARK_CORE_RUN);
+         p_rarch->current_core.retro_run();
+         benchmark_end(p_rarch, BENCHMARK_CORE_RUN);
+         p_rarch->audio_suspended     = false;
+         RUNAHEAD_RESUME_VIDEO();
+      }
+
+      preempt->rollbacks++;
+      preempt->window_rollbacks++;
+      preempt->replayed_frames        += preempt->frames;
+      preempt->window_replayed_frames += preempt->frames;
+   }
+
+   if (!preempt_save_state(p_rarch, preempt, preempt->ptr))
+      goto error_save;
+
+   preempt->ptr = (preempt->ptr + 1) % preempt->frames;
+   if (preempt->filled < preempt->frames)
+      preempt->filled++;
+
+   benchmark_begin(p_rarch, BENCHMARK_CORE_RUN);
+   p_rarch->current_core.retro_run();
+   benchmark_end(p_rarch, BENCHMARK_CORE_RUN);
+
+   p_rarch->current_core.retro_set_input_poll(cbs->poll_cb);
+   p_rarch->current_core.retro_set_input_state(cbs->state_cb);
+
+   preempt_update_stats(preempt);
+   return;
+
+error_save:
+   runloop_msg_queue_push(msg_hash_to_str(MSG_RUNAHEAD_FAILED_TO_SAVE_STATE), 0, 3 * 60, true, NULL, MESSAGE_QUEUE_ICON_DEFAULT, MESSAGE_QUEUE_CATEGORY_INFO);
+   goto error;
+error_load:
+   runloop_msg_queue_push(msg_hash_to_str(MSG_RUNAHEAD_FAILED_TO_LOAD_STATE), 0, 3 * 60, true, NULL, MESSAGE_QUEUE_ICON_DEFAULT, MESSAGE_QUEUE_CATEGORY_INFO);
+error:
+   p_rarch->current_core.retro_set_input_poll(cbs->poll_cb);
+   p_rarch->current_core.retro_set_input_state(cbs->state_cb);
+   preempt_free(p_rarch);
+   runahead_error(p_rarch);
+   return;
+
+run_core:
+   core_run();
+}
 #endif
 
 static retro_time_t rarch_core_runtime_tick(
@@ -33651,7 +35897,7 @@ static void retroarch_print_help(const char *arg0)
           "the device (1 to %d).\n", MAX_USERS);
 
    {
-      char buf[2560];
+      char buf[3072];
       buf[0] = '\0';
       strlcpy(buf, "                        Format is PORT:ID, where ID is a number "
             "corresponding to the particular device.\n", sizeof(buf));
@@ -33717,10 +35963,87 @@ static void retroarch_print_help(const char *arg0)
 #endif
       strlcat(buf, "      --load-menu-on-error\n"
             "                        Open menu instead of quitting if specified core or content fails to load.\n", sizeof(buf));
+      strlcat(buf, "      --benchmark       Runs the content with null drivers and no frame limiting,\n"
+            "                        then prints throughput and per-frame timings on exit.\n"
+            "                        Runs for 3600 frames unless --max-frames is given.\n", sizeof(buf));
+      strlcat(buf, "      --benchmark-with=LIST\n"
+            "                        Like --benchmark, also enabling the comma-separated features\n"
+            "                        in LIST: runahead, preempt, rewind, input. 'input' also times a\n"
+            "                        query of every button and stick of every user each frame.\n", sizeof(buf));
       puts(buf);
    }
 }
 
+/**
+ * retroarch_benchmark_setup:
+ * @features             : Comma-separated list of features to
+ *                         enable on top of the benchmark, or NULL.
+ *
+ * Sets up benchmark mode: null video/audio drivers and no
+ * frame limiting of any kind, so that the core runs as fast
+ * as the host allows. Settings are only changed in memory.
+ **/
+static void retroarch_benchmark_setup(
+      struct rarch_state *p_rarch, char *features)
+{
+   char *token              = NULL;
+   char **features_ptr      = &features;
+   settings_t *settings     = p_rarch->configuration_settings;
+
+   if (!p_rarch->benchmark)
+      p_rarch->benchmark    = (rarch_benchmark_t*)
+         calloc(1, sizeof(*p_rarch->benchmark));
+
+   configuration_set_string(settings,
+         settings->arrays.video_driver, "null");
+   configuration_set_string(settings,
+         settings->arrays.audio_driver, "null");
+   configuration_set_bool(settings, settings->bools.video_vsync, false);
+   configuration_set_bool(settings, settings->bools.video_threaded, false);
+   configuration_set_bool(settings, settings->bools.audio_sync, false);
+   configuration_set_bool(settings, settings->bools.vrr_runloop_enable, false);
+   configuration_set_bool(settings,
+         settings->bools.video_frame_delay_auto, false);
+   configuration_set_uint(settings, settings->uints.video_frame_delay, 0);
+   configuration_set_float(settings,
+         settings->floats.fastforward_ratio, 0.0f);
+   /* Never write the overrides above back to the config file */
+   configuration_set_bool(settings,
+         settings->bools.config_save_on_exit, false);
+
+   if (!features)
+      return;
+
+   while ((token = string_tokenize(features_ptr, ",")))
+   {
+      if (string_is_equal(token, "rewind"))
+      {
+         configuration_set_bool(settings,
+               settings->bools.rewind_enable, true);
+      }
+#ifdef HAVE_RUNAHEAD
+      else if (string_is_equal(token, "runahead")
+            || string_is_equal(token, "preempt"))
+      {
+         configuration_set_bool(settings,
+               settings->bools.run_ahead_enabled, true);
+         configuration_set_bool(settings,
+               settings->bools.preemptive_frames_enable,
+               string_is_equal(token, "preempt"));
+         if (!settings->uints.run_ahead_frames)
+            configuration_set_uint(settings,
+                  settings->uints.run_ahead_frames, 1);
+      }
+#endif
+      else if (string_is_equal(token, "input"))
+         p_rarch->benchmark->input_storm = true;
+      else if (!string_is_empty(token))
+         RARCH_WARN("[Benchmark]: Unknown feature \"%s\".\n", token);
+
+      free(token);
+   }
+}
+
 /**
  * retroarch_parse_input_and_config:
  * @argc                 : Count of (commandline) arguments.
@@ -33797,6 +36120,8 @@ static void retroarch_parse_input_and_config(
       { "log-file",           1, NULL, RA_OPT_LOG_FILE },
       { "accessibility",      0, NULL, RA_OPT_ACCESSIBILITY},
       { "load-menu-on-error", 0, NULL, RA_OPT_LOAD_MENU_ON_ERROR },
+      { "benchmark",          0, NULL, RA_OPT_BENCHMARK },
+      { "benchmark-with",     1, NULL, RA_OPT_BENCHMARK_WITH },
       { NULL, 0, NULL, 0 }
    };
 
@@ -34364,6 +36689,11 @@ static void retroarch_parse_input_and_config(
             case RA_OPT_LOAD_MENU_ON_ERROR:
                global->cli_load_menu_on_error = true;
                break;
+            case RA_OPT_BENCHMARK:
+            case RA_OPT_BENCHMARK_WITH:
+               retroarch_benchmark_setup(p_rarch,
+                     c == RA_OPT_BENCHMARK_WITH ? optarg : NULL);
+               break;
             default:
                RARCH_ERR("%s\n", msg_hash_to_str(MSG_ERROR_PARSING_ARGUMENTS));
                retroarch_fail(1, "retroarch_parse_input()");
@@ -34371,6 +36701,9 @@ static void retroarch_parse_input_and_config(
       }
    }
 
+   if (p_rarch->benchmark && !p_rarch->runloop_max_frames)
+      p_rarch->runloop_max_frames = BENCHMARK_DEFAULT_FRAMES;
+
    if (verbosity_is_enabled())
       rarch_log_file_init(
             p_rarch->configuration_settings->bools.log_to_file,
@@ -34603,6 +36936,7 @@ bool retroarch_main_init(int argc, char *argv[])
 
    retroarch_validate_cpu_features();
    retroarch_init_task_queue();
+   command_event(CMD_EVENT_FRAME_TRACE_INIT, NULL);
 
    {
       const char    *fullpath  = path_get(RARCH_PATH_CONTENT);
@@ -36965,6 +39299,9 @@ static enum runloop_state runloop_check_state(
    /* Check if we have pressed the AI Service toggle button */
    HOTKEY_CHECK(RARCH_AI_SERVICE, CMD_EVENT_AI_SERVICE_TOGGLE, true, NULL);
 
+   /* Check if we have pressed the Save Frame Trace button */
+   HOTKEY_CHECK(RARCH_FRAME_TRACE_SAVE, CMD_EVENT_FRAME_TRACE_SAVE, true, NULL);
+
    if (BIT256_GET(current_bits, RARCH_VOLUME_UP))
       command_event(CMD_EVENT_VOLUME_UP, NULL);
    else if (BIT256_GET(current_bits, RARCH_VOLUME_DOWN))
@@ -37197,12 +39534,14 @@ static enum runloop_state runloop_check_state(
 
       s[0]           = '\0';
 
+      benchmark_begin(p_rarch, BENCHMARK_REWIND);
       rewinding      = state_manager_check_rewind(
             &p_rarch->rewind_st,
             BIT256_GET(current_bits, RARCH_REWIND),
             settings->uints.rewind_granularity,
             p_rarch->runloop_paused,
             s, sizeof(s), &t);
+      benchmark_end(p_rarch, BENCHMARK_REWIND);
 
 #if defined(HAVE_GFX_WIDGETS)
       if (widgets_active)
@@ -37360,6 +39699,104 @@ static enum runloop_state runloop_check_state(
    return RUNLOOP_STATE_ITERATE;
 }
 
+/**
+ * video_frame_delay_auto_update:
+ *
+ * Automatic frame delay. Once per window of
+ * FRAME_DELAY_AUTO_WINDOW frame time samples, the window's
+ * 95th percentile is compared with the target frame time:
+ * - above 1.25x the target, frames are missing their
+ *   deadline; the delay is lowered by 1 ms and the value
+ *   that caused the misses is avoided for a while.
+ * - with no miss at all in the window, the delay is raised
+ *   by 1 ms, up to @max_delay.
+ *
+ * Returns: frame delay to apply this frame, in ms.
+ **/
+static unsigned video_frame_delay_auto_update(
+      struct rarch_state *p_rarch, settings_t *settings,
+      unsigned max_delay)
+{
+   unsigned i, j;
+   unsigned misses                    = 0;
+   retro_time_t samples[FRAME_DELAY_AUTO_WINDOW];
+   retro_time_t target, threshold, percentile;
+   uint64_t count                     = p_rarch->video_driver_frame_time_count;
+   float refresh_rate                 = settings->floats.video_refresh_rate;
+   unsigned swap_interval             = settings->uints.video_swap_interval;
+   unsigned delay                     = p_rarch->video_frame_delay_effective;
+
+   /* Counter was reset (menu, fast-forward, states...) */
+   if (count < p_rarch->video_frame_delay_auto_count)
+      p_rarch->video_frame_delay_auto_count = count;
+
+   if (count < p_rarch->video_frame_delay_auto_count
+         + FRAME_DELAY_AUTO_WINDOW)
+      return delay;
+
+   p_rarch->video_frame_delay_auto_count  = count;
+
+   if (settings->bools.video_vsync && refresh_rate > 0.0f)
+      target    = (retro_time_t)(1000000.0f * MAX(swap_interval, 1)
+            / refresh_rate);
+   else if (p_rarch->video_driver_av_info.timing.fps > 0.0)
+      target    = (retro_time_t)(1000000.0
+            / p_rarch->video_driver_av_info.timing.fps);
+   else
+      return delay;
+
+   threshold    = target + target / 4;
+
+   /* Never delay by a whole frame */
+   if (max_delay == 0 || max_delay > 15)
+      max_delay = 15;
+   if (max_delay * 1000 + 1000 > target)
+      max_delay = target > 2000 ? (unsigned)(target / 1000) - 1 : 0;
+
+   /* Insertion sort of the window; it is small */
+   for (i = 0; i < FRAME_DELAY_AUTO_WINDOW; i++)
+   {
+      retro_time_t sample = p_rarch->video_driver_frame_time_samples[
+         (count - 1 - i) & (MEASURE_FRAME_TIME_SAMPLES_COUNT - 1)];
+
+      if (sample > threshold)
+         misses++;
+
+      for (j = i; j > 0 && samples[j - 1] > sample; j--)
+         samples[j] = samples[j - 1];
+      samples[j] = sample;
+   }
+
+   percentile   = samples[(FRAME_DELAY_AUTO_WINDOW * 95) / 100];
+
+   if (p_rarch->video_frame_delay_auto_retry)
+      p_rarch->video_frame_delay_auto_retry--;
+   else
+      p_rarch->video_frame_delay_unsafe = 0;
+
+   if (percentile > threshold)
+   {
+      if (delay > 0)
+      {
+         p_rarch->video_frame_delay_unsafe      = delay;
+         p_rarch->video_frame_delay_auto_retry  = FRAME_DELAY_AUTO_RETRY;
+         delay--;
+      }
+   }
+   else if (!misses
+         && delay < max_delay
+         && (  !p_rarch->video_frame_delay_unsafe
+             || delay + 1 < p_rarch->video_frame_delay_unsafe))
+      delay++;
+
+   if (delay > max_delay)
+      delay = max_delay;
+
+   p_rarch->video_frame_delay_effective = delay;
+
+   return delay;
+}
+
 /**
  * runloop_iterate:
  *
@@ -37496,6 +39933,11 @@ int runloop_iterate(void)
          break;
    }
 
+   benchmark_frame(p_rarch, current_time);
+
+   if (p_rarch->benchmark && p_rarch->benchmark->input_storm)
+      benchmark_input_storm(p_rarch);
+
 #ifdef HAVE_THREADS
    if (p_rarch->runloop_autosave)
       autosave_lock();
@@ -37565,23 +40007,47 @@ int runloop_iterate(void)
       }
    }
 
+   if (settings->bools.video_frame_delay_auto
+         && !p_rarch->input_driver_nonblock_state)
+      video_frame_delay = video_frame_delay_auto_update(
+            p_rarch, settings, video_frame_delay);
+
    if ((video_frame_delay > 0) && !p_rarch->input_driver_nonblock_state)
-      retro_sleep(video_frame_delay);
+   {
+      RTRACE_BEGIN("frame_delay");
+      rsleep_until(cpu_features_get_time_usec() + video_frame_delay * 1000,
+            settings->uints.frame_limit_spin_usec, NULL);
+      RTRACE_END("frame_delay");
+   }
 
    {
 #ifdef HAVE_RUNAHEAD
       unsigned run_ahead_num_frames = settings->uints.run_ahead_frames;
       /* Run Ahead Feature replaces the call to core_run in this loop */
       bool want_runahead            = settings->bools.run_ahead_enabled && run_ahead_num_frames > 0;
+      bool want_preempt             = false;
 #ifdef HAVE_NETWORKING
       want_runahead                 = want_runahead && !netplay_driver_ctl(RARCH_NETPLAY_CTL_IS_ENABLED, NULL);
 #endif
+      /* Preemptive Frames replaces Run Ahead */
+      want_preempt                  = want_runahead && settings->bools.preemptive_frames_enable;
 
-      if (want_runahead)
-         do_runahead(
-               p_rarch,
-               run_ahead_num_frames,
-               settings->bools.run_ahead_secondary_instance);
+      if (p_rarch->preempt && !want_preempt)
+         preempt_free(p_rarch);
+
+      if (want_preempt || want_runahead)
+      {
+         benchmark_begin(p_rarch, BENCHMARK_RUNAHEAD);
+         if (want_preempt)
+            do_preemptive_frames(p_rarch, run_ahead_num_frames);
+         else
+            do_runahead(
+                  p_rarch,
+                  run_ahead_num_frames,
+                  settings->bools.run_ahead_secondary_instance,
+                  settings->bools.run_ahead_secondary_threaded);
+         benchmark_end(p_rarch, BENCHMARK_RUNAHEAD);
+      }
       else
 #endif
          core_run();
@@ -37599,6 +40065,10 @@ int runloop_iterate(void)
 #ifdef HAVE_CHEATS
    cheat_manager_apply_retro_cheats();
 #endif
+#if defined(HAVE_COMMAND) && defined(HAVE_NETWORK_CMD)
+   if (p_rarch->memory_sub_count)
+      command_memory_push(p_rarch);
+#endif
 #ifdef HAVE_DISCORD
    if (discord_is_inited && discord_st->ready)
       discord_update(DISCORD_PRESENCE_GAME);
@@ -37694,22 +40164,23 @@ end:
    }
 
    {
-      retro_time_t to_sleep_ms  = (
-            (p_rarch->frame_limit_last_time + p_rarch->frame_limit_minimum_time)
-            - cpu_features_get_time_usec()) / 1000;
+      retro_time_t deadline = p_rarch->frame_limit_last_time
+         + p_rarch->frame_limit_minimum_time;
 
-      if (to_sleep_ms > 0)
+      if (deadline > cpu_features_get_time_usec())
       {
-         unsigned               sleep_ms = (unsigned)to_sleep_ms;
-
          /* Combat jitter a bit. */
-         p_rarch->frame_limit_last_time += p_rarch->frame_limit_minimum_time;
+         p_rarch->frame_limit_last_time = deadline;
 
-         if (sleep_ms > 0)
 #if defined(HAVE_COCOATOUCH)
-            if (!p_rarch->main_ui_companion_is_on_foreground)
+         if (!p_rarch->main_ui_companion_is_on_foreground)
 #endif
-               retro_sleep(sleep_ms);
+         {
+            RTRACE_BEGIN("frame_limit");
+            rsleep_until(deadline, settings->uints.frame_limit_spin_usec,
+                  &p_rarch->frame_limit_jitter);
+            RTRACE_END("frame_limit");
+         }
          return 1;
       }
    }
@@ -38214,6 +40685,8 @@ bool core_run(void)
    }
 #endif
 
+   benchmark_begin(p_rarch, BENCHMARK_CORE_RUN);
+
    if (early_polling)
       input_driver_poll();
    else if (late_polling)
@@ -38224,6 +40697,8 @@ bool core_run(void)
    if (late_polling && !current_core->input_polled)
       input_driver_poll();
 
+   benchmark_end(p_rarch, BENCHMARK_CORE_RUN);
+
 #ifdef HAVE_NETWORKING
    netplay_driver_ctl(RARCH_NETPLAY_CTL_POST_FRAME, NULL);
 #endif
@@ -76,6 +76,11 @@
 
 #define MEASURE_FRAME_TIME_SAMPLES_COUNT (2 * 1024)
 
+/* Automatic frame delay: frame time samples per adjustment,
+ * and adjustments before retrying a delay that missed frames */
+#define FRAME_DELAY_AUTO_WINDOW 32
+#define FRAME_DELAY_AUTO_RETRY  30
+
 #define TIME_TO_FPS(last_time, new_time, frames) ((1000000.0f * (frames)) / ((new_time) - (last_time)))
 
 #define AUDIO_BUFFER_FREE_SAMPLES_COUNT (8 * 1024)
@@ -1275,7 +1280,9 @@ enum
    RA_OPT_MAX_FRAMES_SCREENSHOT_PATH,
    RA_OPT_SET_SHADER,
    RA_OPT_ACCESSIBILITY,
-   RA_OPT_LOAD_MENU_ON_ERROR
+   RA_OPT_LOAD_MENU_ON_ERROR,
+   RA_OPT_BENCHMARK,
+   RA_OPT_BENCHMARK_WITH
 };
 
 enum  runloop_state
@@ -1438,6 +1445,127 @@ typedef struct my_list_t
    int size;
 } my_list;
 
+#ifdef HAVE_RUNAHEAD
+/* Same upper bound as the 'Run-Ahead Frames' setting */
+#define PREEMPT_MAX_FRAMES 12
+/* Distinct input_state queries watched for changes */
+#define PREEMPT_MAX_QUERIES 512
+
+/* An input_state query made by the core, and its result
+ * in the frames held by the ring */
+typedef struct preempt_query
+{
+   unsigned port;
+   unsigned device;
+   unsigned index;
+   unsigned id;
+   int16_t value;
+} preempt_query_t;
+
+/* Preemptive frames: ring of the savestates taken before
+ * each of the last 'frames' frames, plus the input those
+ * frames were produced with */
+typedef struct preempt
+{
+   void *buffer[PREEMPT_MAX_FRAMES];
+   preempt_query_t queries[PREEMPT_MAX_QUERIES];
+   size_t state_size;
+   retro_time_t stats_time;         /* Start of the current stats window */
+   uint64_t rollbacks;
+   uint64_t replayed_frames;
+   unsigned window_rollbacks;
+   unsigned window_replayed_frames;
+   unsigned rollbacks_per_sec;
+   unsigned replayed_frames_per_sec;
+   unsigned num_queries;
+   uint8_t frames;                  /* Ring size */
+   uint8_t ptr;                     /* Oldest savestate */
+   uint8_t filled;                  /* Number of usable savestates */
+   bool queries_full;               /* Some queries are not watched */
+} preempt_t;
+#endif
+
+#if defined(HAVE_RUNAHEAD) && defined(HAVE_THREADS)
+/* Environment calls of the secondary instance that reach
+ * the drivers; the worker thread records them, and the
+ * main thread replays them once the job is done */
+enum runahead_deferred_env
+{
+   RUNAHEAD_DEFER_AV_INFO  = (1 << 0),
+   RUNAHEAD_DEFER_GEOMETRY = (1 << 1),
+   RUNAHEAD_DEFER_ROTATION = (1 << 2),
+   RUNAHEAD_DEFER_SHUTDOWN = (1 << 3)
+};
+
+/* Runs the secondary run-ahead core instance on its own
+ * thread. Its output goes to a private frame buffer, and
+ * its input comes from a snapshot, so that the main thread
+ * is free to run the primary instance meanwhile */
+typedef struct runahead_thread
+{
+   my_list *input_state_list;    /* Input snapshot used by jobs */
+   sthread_t *thread;
+   slock_t *lock;
+   scond_t *cond;
+   slock_t *env_lock;            /* Serializes environment calls */
+   uintptr_t env_owner;          /* Thread holding env_lock, under 'lock' */
+   void *frame;                  /* Last software frame captured */
+   struct retro_system_av_info deferred_av_info;
+   struct retro_game_geometry deferred_geometry;
+   unsigned deferred_rotation;
+   unsigned deferred;            /* RUNAHEAD_DEFER_* flags */
+   size_t frame_capacity;
+   size_t frame_pitch;
+   unsigned frame_width;
+   unsigned frame_height;
+   int frames_to_run;            /* Pending job, 0 when idle */
+   bool capture;                 /* Keep the job's last frame */
+   bool capturing;               /* Worker is on the last frame */
+   bool running;                 /* Worker is inside retro_run */
+   bool frame_dupe;
+   bool frame_hw;                /* Core rendered with a HW context */
+   bool quit;
+} runahead_thread_t;
+#endif
+
+/* Parts of a frame timed in benchmark mode. Time spent in a
+ * nested section (e.g. video_driver_frame called by the core
+ * from inside core_run) only counts against the inner one */
+enum benchmark_section
+{
+   BENCHMARK_CORE_RUN = 0,
+   BENCHMARK_VIDEO_FRAME,
+   BENCHMARK_AUDIO_FLUSH,
+   BENCHMARK_INPUT_POLL,
+   BENCHMARK_RUNAHEAD,
+   BENCHMARK_REWIND,
+   BENCHMARK_TASKS,
+   BENCHMARK_INPUT_STATE,
+   BENCHMARK_INPUT_RESOLVE,
+   BENCHMARK_LAST
+};
+
+#define BENCHMARK_MAX_DEPTH      8
+#define BENCHMARK_DEFAULT_FRAMES 3600
+/* Times every button and stick of every user is queried
+ * per poll by --benchmark-with=input */
+#define BENCHMARK_INPUT_ROUNDS   4
+
+typedef struct rarch_benchmark
+{
+   retro_time_t *frame_times;
+   retro_time_t total[BENCHMARK_LAST];         /* Exclusive time */
+   retro_time_t stack_start[BENCHMARK_MAX_DEPTH];
+   retro_time_t stack_child[BENCHMARK_MAX_DEPTH];
+   uint64_t calls[BENCHMARK_LAST];
+   retro_time_t frame_start;                   /* 0 until the first frame */
+   size_t frames;
+   size_t capacity;
+   unsigned depth;
+   uint8_t stack_section[BENCHMARK_MAX_DEPTH];
+   bool input_storm;
+} rarch_benchmark_t;
+
 #ifdef HAVE_OVERLAY
 typedef struct input_overlay_state
 {
@@ -1482,6 +1610,85 @@ struct cmd_action_map
    bool (*action)(const char *arg);
    const char *arg_desc;
 };
+
+/* Binary GET_METRICS replies start with this magic, a
+ * uint16_t version and a uint16_t payload size, followed
+ * by the fields of rarch_metrics_t in order, little-endian
+ * and without padding */
+#define METRICS_MAGIC   "RAMT"
+#define METRICS_VERSION 1
+
+/* Binary core memory packets start with this magic, then:
+ *   uint8_t  type (enum command_memory_packet)
+ *   uint8_t  flags (COMMAND_MEMORY_FLAG_*)
+ *   uint16_t subscription id, 0 for one-off reads
+ *   uint32_t frame count (low 32 bits)
+ *   uint64_t address of the first byte
+ *   uint32_t payload size
+ * all little-endian. READ and FULL payloads are the memory
+ * itself; DELTA payloads are runs of changed bytes, each a
+ * uint32_t offset from the address, a uint16_t size and
+ * the bytes. */
+#define COMMAND_MEMORY_MAGIC              "RMEM"
+#define COMMAND_MEMORY_HEADER_SIZE        24
+/* Largest payload sent in a single datagram */
+#define COMMAND_MEMORY_MAX_PAYLOAD        60000
+#define COMMAND_MEMORY_MAX_SUBSCRIPTIONS  16
+#define COMMAND_MEMORY_MAX_SUBSCRIPTION   (1 << 20)
+/* Longer one-off reads are cut short */
+#define COMMAND_MEMORY_MAX_READ           (1 << 20)
+/* Subscriptions are dropped once their peer has sent no
+ * command for this long (in usec); any command, such as
+ * VERSION, keeps them alive */
+#define COMMAND_MEMORY_SUBSCRIPTION_TIMEOUT (5 * 1000000)
+
+/* The read stopped at an unmapped address */
+#define COMMAND_MEMORY_FLAG_UNMAPPED      (1 << 0)
+
+enum command_memory_packet
+{
+   COMMAND_MEMORY_PACKET_READ = 1,
+   COMMAND_MEMORY_PACKET_FULL,
+   COMMAND_MEMORY_PACKET_DELTA
+};
+
+#ifdef HAVE_NETWORK_CMD
+typedef struct command_memory_subscription
+{
+   struct sockaddr_storage target;  /* int64_t alignment */
+   uint8_t *shadow;                 /* Last contents pushed, for deltas */
+   retro_time_t last_seen;          /* Last command from the peer */
+   size_t address;
+   size_t len;
+   socklen_t target_len;
+   int fd;
+   unsigned interval;               /* In frames */
+   unsigned countdown;
+   uint16_t id;
+   bool delta;
+   bool shadow_valid;
+} command_memory_subscription_t;
+#endif
+
+typedef struct rarch_metrics
+{
+   uint64_t frames;
+   uint64_t audio_underruns;
+   uint64_t rewind_used;              /* Bytes */
+   uint64_t rewind_capacity;          /* Bytes */
+   uint64_t runahead_rollbacks;
+   uint64_t preempt_rollbacks;
+   uint32_t frame_time_samples;
+   uint32_t frame_time_avg;           /* Frame times are in usec */
+   uint32_t frame_time_p50;
+   uint32_t frame_time_p90;
+   uint32_t frame_time_p99;
+   uint32_t frame_time_max;
+   uint32_t audio_fill;               /* 1/10000ths of the buffer */
+   uint32_t audio_rate_ratio;         /* Rate control adjustment, 1/1000000ths */
+   uint32_t rewind_entries;
+   uint32_t task_queue_depth;
+} rarch_metrics_t;
 #endif
 
 struct command
@@ -1492,6 +1699,10 @@ struct command
 #ifdef HAVE_NETWORK_CMD
    int net_fd;
 #endif
+#ifdef HAVE_COMMAND_UNIX_SOCKET
+   int unix_fd;
+   char unix_path[108];             /* Size of sockaddr_un.sun_path */
+#endif
 #ifdef HAVE_STDIN_CMD
    char stdin_buf[STDIN_BUF_SIZE];
 #endif
@@ -1530,6 +1741,22 @@ struct turbo_buttons
    bool mode1_enable[MAX_USERS];
 };
 
+#define INPUT_SNAPSHOT_BUTTONS    (1 << 0)
+#define INPUT_SNAPSHOT_ANALOG(i)  (1 << (1 + (i)))
+
+typedef struct input_snapshot input_snapshot_t;
+
+/* Joypad and analog stick state of each user, resolved
+ * through binds, remaps, turbo and the overlay on the
+ * first query after a poll and served from here until
+ * the next poll. */
+struct input_snapshot
+{
+   int16_t analog[MAX_USERS][4];
+   int16_t buttons[MAX_USERS];
+   uint8_t valid[MAX_USERS];
+};
+
 struct input_keyboard_line
 {
    char *buffer;
@@ -1696,6 +1923,10 @@ struct rarch_state
 
    retro_time_t frame_limit_minimum_time;
    retro_time_t frame_limit_last_time;
+#if defined(HAVE_COMMAND) && defined(HAVE_NETWORK_CMD)
+   retro_time_t metrics_push_interval;          /* 0 when nobody subscribed */
+   retro_time_t metrics_push_last;
+#endif
    retro_time_t libretro_core_runtime_last;
    retro_time_t libretro_core_runtime_usec;
    retro_time_t video_driver_frame_time_samples[
@@ -1719,6 +1950,12 @@ struct rarch_state
 #if defined(HAVE_COMMAND)
 #ifdef HAVE_NETWORK_CMD
    struct sockaddr_storage lastcmd_net_source;  /* int64_t alignment */
+   struct sockaddr_storage metrics_net_target;  /* int64_t alignment */
+   command_memory_subscription_t memory_subs[
+      COMMAND_MEMORY_MAX_SUBSCRIPTIONS];         /* int64_t alignment */
+   uint8_t *memory_sub_packet;
+   uint8_t *memory_sub_scratch;                 /* Current contents */
+   size_t memory_sub_scratch_size;
 #endif
 #endif
 #ifdef HAVE_GFX_WIDGETS
@@ -1735,13 +1972,17 @@ struct rarch_state
 #endif
 
    uint64_t audio_driver_free_samples_count;
+   uint64_t audio_driver_underruns;
 
 #ifdef HAVE_RUNAHEAD
    uint64_t runahead_last_frame_count;
+   uint64_t runahead_rollbacks;
 #endif
 
    uint64_t video_driver_frame_time_count;
    uint64_t video_driver_frame_count;
+   uint64_t video_frame_delay_auto_count;
+   rsleep_jitter_t frame_limit_jitter;        /* uint64_t alignment */
    struct retro_camera_callback camera_cb;    /* uint64_t alignment */
    gfx_animation_t anim;                      /* uint64_t alignment */
    gfx_thumbnail_state_t gfx_thumb_state;     /* uint64_t alignment */
@@ -1940,9 +2181,14 @@ struct rarch_state
 #ifdef HAVE_DYNAMIC
    dylib_t lib_handle;                                   /* ptr alignment */
 #endif
+   rarch_benchmark_t *benchmark;                         /* ptr alignment */
 #if defined(HAVE_RUNAHEAD)
+   preempt_t *preempt;                                   /* ptr alignment */
 #if defined(HAVE_DYNAMIC) || defined(HAVE_DYLIB)
    dylib_t secondary_lib_handle;                         /* ptr alignment */
+#ifdef HAVE_THREADS
+   runahead_thread_t *runahead_thread;                   /* ptr alignment */
+#endif
 #endif
 #endif
 
@@ -1983,6 +2229,7 @@ struct rarch_state
 #if defined(HAVE_COMMAND)
 #ifdef HAVE_NETWORK_CMD
    int lastcmd_net_fd;
+   int metrics_net_fd;
 #endif
 #endif
 
@@ -2013,6 +2260,9 @@ struct rarch_state
 #endif
    unsigned runloop_pending_windowed_scale;
    unsigned runloop_max_frames;
+   unsigned video_frame_delay_effective;
+   unsigned video_frame_delay_unsafe;
+   unsigned video_frame_delay_auto_retry;
    unsigned runloop_audio_latency;
    unsigned fastforward_after_frames;
 
@@ -2085,6 +2335,7 @@ struct rarch_state
    menu_input_pointer_hw_state_t menu_input_pointer_hw_state;  
                                                 /* int16_t alignment */
 #endif
+   input_snapshot_t input_snapshot;             /* int16_t alignment */
 
 #ifdef HAVE_MENU
    unsigned char menu_keyboard_key_state[RETROK_LAST];
@@ -2102,6 +2353,9 @@ struct rarch_state
 #if defined(HAVE_COMMAND)
 #ifdef HAVE_NETWORK_CMD
    socklen_t lastcmd_net_source_len;            /* uint32_t alignment */
+   socklen_t metrics_net_target_len;            /* uint32_t alignment */
+   unsigned memory_sub_count;
+   uint16_t memory_sub_next_id;
 #endif
 #endif
    retro_bits_t has_set_libretro_device;        /* uint32_t alignment */
@@ -2330,8 +2584,12 @@ struct rarch_state
    bool runahead_video_driver_is_active;
    bool runahead_available;
    bool runahead_secondary_core_available;
+   bool runahead_thread_available;
    bool runahead_force_input_dirty;
 #endif
+#if defined(HAVE_COMMAND) && defined(HAVE_NETWORK_CMD)
+   bool metrics_push_binary;
+#endif
 
 #ifdef HAVE_AUDIOMIXER
    bool audio_driver_mixer_mute_enable;
@@ -2484,6 +2742,7 @@ static const struct input_bind_map input_config_bind_map[RARCH_BIND_LIST_END_NUL
       DECLARE_META_BIND(2, streaming_toggle,      RARCH_STREAMING_TOGGLE,      MENU_ENUM_LABEL_VALUE_INPUT_META_STREAMING_TOGGLE),
       DECLARE_META_BIND(2, runahead_toggle,       RARCH_RUNAHEAD_TOGGLE,       MENU_ENUM_LABEL_VALUE_INPUT_META_RUNAHEAD_TOGGLE),
       DECLARE_META_BIND(2, ai_service,            RARCH_AI_SERVICE,            MENU_ENUM_LABEL_VALUE_INPUT_META_AI_SERVICE),
+      DECLARE_META_BIND(2, frame_trace_save,      RARCH_FRAME_TRACE_SAVE,      MENU_ENUM_LABEL_VALUE_INPUT_META_FRAME_TRACE_SAVE),
 };
 
 /* TODO/FIXME - turn these into static global variable */
@@ -2662,6 +2921,13 @@ static bool command_version(const char* arg);
 static bool command_get_status(const char* arg);
 static bool command_get_config_param(const char* arg);
 static bool command_show_osd_msg(const char* arg);
+static bool command_get_metrics(const char* arg);
+static bool command_read_memory_binary(const char *arg);
+#ifdef HAVE_NETWORK_CMD
+static bool command_subscribe_metrics(const char* arg);
+static bool command_subscribe_memory(const char *arg);
+static bool command_unsubscribe_memory(const char *arg);
+#endif
 #ifdef HAVE_CHEEVOS
 static bool command_read_ram(const char *arg);
 static bool command_write_ram(const char *arg);
@@ -2675,6 +2941,13 @@ static const struct cmd_action_map action_map[] = {
    { "GET_STATUS",       command_get_status,       "No argument" },
    { "GET_CONFIG_PARAM", command_get_config_param, "<param name>" },
    { "SHOW_MSG",         command_show_osd_msg,     "No argument" },
+   { "GET_METRICS",      command_get_metrics,      "[JSON|BINARY]" },
+   { "READ_CORE_MEMORY_BINARY", command_read_memory_binary, "<address> <number of bytes>" },
+#ifdef HAVE_NETWORK_CMD
+   { "SUBSCRIBE_METRICS", command_subscribe_metrics, "<interval in ms, 0 to stop> [JSON|BINARY]" },
+   { "SUBSCRIBE_CORE_MEMORY", command_subscribe_memory, "<address> <number of bytes> <every N frames> [DELTA]" },
+   { "UNSUBSCRIBE_CORE_MEMORY", command_unsubscribe_memory, "<subscription id|ALL>" },
+#endif
 #if defined(HAVE_CHEEVOS)
    { "READ_CORE_RAM",   command_read_ram,    "<address> <number of bytes>" },
    { "WRITE_CORE_RAM",  command_write_ram,   "<address> <byte1> <byte2> ..." },
@@ -2730,6 +3003,7 @@ static const struct cmd_map map[] = {
    { "MENU_A",                 RETRO_DEVICE_ID_JOYPAD_A },
    { "MENU_B",                 RETRO_DEVICE_ID_JOYPAD_B },
    { "AI_SERVICE",             RARCH_AI_SERVICE },
+   { "FRAME_TRACE_SAVE",       RARCH_FRAME_TRACE_SAVE },
 };
 #endif
 
@@ -62,6 +62,9 @@ static void rarch_init_core_options(
 #if defined(HAVE_DYNAMIC) || defined(HAVE_DYLIB)
 static bool secondary_core_create(struct rarch_state *p_rarch);
 #endif
+#if defined(HAVE_DYNAMIC) && defined(HAVE_THREADS)
+static void runahead_thread_free(struct rarch_state *p_rarch);
+#endif
 static int16_t input_state_get_last(unsigned port,
       unsigned device, unsigned index, unsigned id);
 #endif
@@ -120,6 +123,9 @@ static void audio_mixer_menu_stop_cb(
       audio_mixer_sound_t *sound, unsigned reason);
 #endif
 
+static size_t mmap_reduce(size_t addr, size_t mask);
+static size_t mmap_highest_bit(size_t n);
+
 static void video_driver_gpu_record_deinit(struct rarch_state *p_rarch);
 static retro_proc_address_t video_driver_get_proc_address(const char *sym);
 static uintptr_t video_driver_get_current_framebuffer(void);
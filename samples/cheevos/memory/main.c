@@ -0,0 +1,450 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2020 - The RetroArch team
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Evaluates a set of achievements against a simulated
+ * PlayStation memory map, once with the old linear region
+ * walk and once with rcheevos_memory_read(), and reports
+ * the cost of rc_runtime_do_frame() per frame for each.
+ *
+ * The core's RAM is exposed through a memory map split
+ * into the given number of descriptors, each backed by its
+ * own allocation so that every descriptor becomes a
+ * separate region, as with cores that map memory in
+ * several blocks.
+ *
+ * Achievement files contain one trigger definition per
+ * line; lines starting with '#' are ignored. When no file
+ * is given, achievements with random conditions are
+ * generated instead. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+
+#include <boolean.h>
+
+#include "../../../core.h"
+#include "../../../retroarch.h"
+#include "../../../cheevos/cheevos_memory.h"
+#include "../../../deps/rcheevos/include/rcheevos.h"
+#include "../../../deps/rcheevos/include/rconsoles.h"
+
+#define RAM_SIZE              0x200000
+#define SYNTHETIC_CONDITIONS  4
+#define FRAMES                2000
+#define WRITES_PER_FRAME      256
+#define RAW_READS             10000000
+#define PASSES                3
+
+static rarch_system_info_t system_info;
+static rcheevos_memory_regions_t memory;
+static uint8_t *blocks[MAX_MEMORY_REGIONS];
+static unsigned peeks;
+
+static uint64_t get_time_usec(void)
+{
+#if defined(CLOCK_MONOTONIC)
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#else
+   return (uint64_t)clock() * 1000000 / CLOCKS_PER_SEC;
+#endif
+}
+
+/* Frontend functions used by cheevos_memory.c */
+
+bool core_get_memory(retro_ctx_memory_info_t *info)
+{
+   info->data = NULL;
+   info->size = 0;
+   return true;
+}
+
+rarch_system_info_t *runloop_get_system_info(void)
+{
+   return &system_info;
+}
+
+void RARCH_LOG(const char *fmt, ...)
+{
+   (void)fmt;
+}
+
+void RARCH_ERR(const char *fmt, ...)
+{
+   va_list ap;
+   va_start(ap, fmt);
+   vfprintf(stderr, fmt, ap);
+   va_end(ap);
+}
+
+/* The lookup rcheevos_peek() used before the page table */
+static uint8_t *linear_find(unsigned address)
+{
+   unsigned i;
+
+   for (i = 0; i < memory.count; ++i)
+   {
+      const size_t size = memory.size[i];
+      if (address < size)
+      {
+         if (!memory.data[i])
+            break;
+
+         return &memory.data[i][address];
+      }
+
+      address -= size;
+   }
+
+   return NULL;
+}
+
+static unsigned linear_peek(unsigned address, unsigned num_bytes, void *ud)
+{
+   uint8_t *data = linear_find(address);
+
+   peeks++;
+
+   if (data)
+   {
+      switch (num_bytes)
+      {
+         case 4:
+            return ((unsigned)data[3] << 24) | (data[2] << 16) |
+                   (data[1] <<  8) | (data[0]);
+         case 3:
+            return (data[2] << 16) | (data[1] << 8) | (data[0]);
+         case 2:
+            return (data[1] << 8)  | (data[0]);
+         case 1:
+            return data[0];
+      }
+   }
+
+   return 0;
+}
+
+static unsigned paged_peek(unsigned address, unsigned num_bytes, void *ud)
+{
+   unsigned value;
+
+   peeks++;
+
+   if (rcheevos_memory_read(&memory, address, num_bytes, &value))
+      return value;
+
+   return 0;
+}
+
+static void event_handler(const rc_runtime_event_t *runtime_event)
+{
+   (void)runtime_event;
+}
+
+static bool memory_map_init(unsigned num_blocks)
+{
+   unsigned i;
+   size_t block_size = RAM_SIZE / num_blocks;
+   rarch_memory_descriptor_t *descriptors = (rarch_memory_descriptor_t*)
+      calloc(num_blocks, sizeof(*descriptors));
+
+   if (!descriptors)
+      return false;
+
+   for (i = 0; i < num_blocks; i++)
+   {
+      /* padded, as the linear lookup reads up to three bytes
+       * past the end of a block for values straddling two */
+      if (!(blocks[i] = (uint8_t*)calloc(1, block_size + 3)))
+         return false;
+
+      descriptors[i].core.ptr   = blocks[i];
+      descriptors[i].core.start = i * block_size;
+      descriptors[i].core.len   = block_size;
+   }
+
+   system_info.mmaps.descriptors     = descriptors;
+   system_info.mmaps.num_descriptors = num_blocks;
+
+   return rcheevos_memory_init(&memory, RC_CONSOLE_PLAYSTATION);
+}
+
+static bool load_achievements(rc_runtime_t *runtime, const char *path,
+      unsigned *count)
+{
+   char line[4096];
+   FILE *fp = fopen(path, "r");
+
+   *count   = 0;
+
+   if (!fp)
+      return false;
+
+   while (fgets(line, sizeof(line), fp))
+   {
+      line[strcspn(line, "\r\n")] = '\0';
+
+      if (line[0] == '#' || line[0] == '\0')
+         continue;
+
+      if (rc_runtime_activate_achievement(runtime, *count + 1, line, NULL, 0) == RC_OK)
+         (*count)++;
+      else
+         fprintf(stderr, "[WARN]: Skipping invalid trigger: %s\n", line);
+   }
+
+   fclose(fp);
+   return true;
+}
+
+static void synthesize_achievements(rc_runtime_t *runtime, unsigned count)
+{
+   unsigned i, j;
+   static const char *sizes[] = { "0xH", "0x", "0xX", "0xW" };
+
+   srand(1);
+
+   for (i = 0; i < count; i++)
+   {
+      char memaddr[256];
+      size_t len = 0;
+
+      /* most achievements watch a handful of variables
+       * clustered in one area of RAM */
+      unsigned base = (unsigned)(((uint64_t)rand() * (RAM_SIZE - 0x100))
+            / ((uint64_t)RAND_MAX + 1));
+
+      for (j = 0; j < SYNTHETIC_CONDITIONS; j++)
+      {
+         unsigned address = base + (rand() & 0xFF);
+
+         if (j > 0)
+            memaddr[len++] = '_';
+
+         len += snprintf(memaddr + len, sizeof(memaddr) - len,
+               "%s%06x%s%u", sizes[rand() & 3], address,
+               (j & 1) ? "!=" : ">", (unsigned)(rand() & 0xFF));
+      }
+
+      rc_runtime_activate_achievement(runtime, i + 1, memaddr, NULL, 0);
+   }
+}
+
+static uint64_t run_frames(rc_runtime_t *runtime, rc_peek_t peek,
+      unsigned num_blocks)
+{
+   unsigned i, j;
+   uint64_t elapsed     = 0;
+   size_t block_size    = RAM_SIZE / num_blocks;
+
+   srand(2);
+   rc_runtime_reset(runtime);
+
+   for (i = 0; i < FRAMES; i++)
+   {
+      uint64_t start;
+
+      /* the core modifies some memory between frames */
+      for (j = 0; j < WRITES_PER_FRAME; j++)
+      {
+         unsigned address = (unsigned)(((uint64_t)rand() * RAM_SIZE)
+               / ((uint64_t)RAND_MAX + 1));
+         blocks[address / block_size][address % block_size] = (uint8_t)rand();
+      }
+
+      start    = get_time_usec();
+      rc_runtime_do_frame(runtime, event_handler, peek, NULL, NULL);
+      elapsed += get_time_usec() - start;
+   }
+
+   return elapsed;
+}
+
+/* Times the lookups alone, without the rest of the runtime */
+static uint64_t run_reads(rc_peek_t peek, unsigned *checksum)
+{
+   unsigned i;
+   static const unsigned sizes[] = { 1, 2, 4, 1 };
+   uint32_t seed    = 4;
+   unsigned sum     = 0;
+   uint64_t start   = get_time_usec();
+
+   for (i = 0; i < RAW_READS; i++)
+   {
+      seed = seed * 1103515245 + 12345;
+      sum += peek((seed >> 8) % (RAM_SIZE - 4), sizes[i & 3], NULL);
+   }
+
+   *checksum = sum;
+   return get_time_usec() - start;
+}
+
+static bool verify_read(unsigned address, unsigned num_bytes)
+{
+   unsigned j;
+   uint8_t *data     = linear_find(address);
+   bool found        = (data != NULL);
+   unsigned expected = 0;
+   unsigned value    = 0;
+
+   /* both lookups must agree on every byte, including
+    * values that straddle a region boundary */
+   for (j = 0; j < num_bytes; j++)
+   {
+      if ((data = linear_find(address + j)))
+         expected |= (unsigned)data[0] << (j * 8);
+   }
+
+   if (rcheevos_memory_read(&memory, address, num_bytes, &value) != found
+         || (found && value != expected))
+   {
+      printf("[ERROR]: Read of %u bytes at $%08X returned %08X, expected %08X\n",
+            num_bytes, address, value, found ? expected : 0);
+      return false;
+   }
+
+   return true;
+}
+
+static bool verify(void)
+{
+   unsigned i, j;
+   /* reads at the end of RAM and past it, including addresses
+    * where address + num_bytes wraps around to zero */
+   static const unsigned edges[] = {
+      RAM_SIZE - 4, RAM_SIZE - 3, RAM_SIZE - 1, RAM_SIZE,
+      RAM_SIZE + 1, 0x7FFFFFFF, 0xFFFFFFF0, 0xFFFFFFFD,
+      0xFFFFFFFE, 0xFFFFFFFF
+   };
+
+   for (i = 0; i < sizeof(edges) / sizeof(edges[0]); i++)
+   {
+      for (j = 1; j <= 4; j++)
+      {
+         if (!verify_read(edges[i], j))
+            return false;
+      }
+   }
+
+   srand(3);
+
+   for (i = 0; i < 1000000; i++)
+   {
+      unsigned address   = (unsigned)(((uint64_t)rand() * (RAM_SIZE - 4))
+            / ((uint64_t)RAND_MAX + 1));
+
+      if (!verify_read(address, (rand() & 3) + 1))
+         return false;
+   }
+
+   return true;
+}
+
+int main(int argc, char *argv[])
+{
+   rc_runtime_t runtime;
+   unsigned count;
+   unsigned peeks_per_frame;
+   uint64_t time_linear, time_paged;
+   uint64_t reads_linear, reads_paged;
+   unsigned sum_linear, sum_paged;
+   unsigned pass;
+   const char *path    = (argc > 1 && strcmp(argv[1], "-")) ? argv[1] : NULL;
+   unsigned num_blocks = (argc > 2) ? (unsigned)atoi(argv[2]) : 16;
+   count               = (argc > 3) ? (unsigned)atoi(argv[3]) : 2000;
+
+   if (argc > 1 && !strcmp(argv[1], "-h"))
+   {
+      printf("Usage: %s [achievements.txt|-] [memory blocks] [synthetic achievements]\n", argv[0]);
+      return 1;
+   }
+
+   if (num_blocks < 1 || num_blocks > MAX_MEMORY_REGIONS
+         || (RAM_SIZE % num_blocks) != 0)
+   {
+      printf("[ERROR]: Memory blocks must divide 0x%X and be at most %u\n",
+            RAM_SIZE, MAX_MEMORY_REGIONS);
+      return 1;
+   }
+
+   if (!memory_map_init(num_blocks))
+   {
+      printf("[ERROR]: Failed to initialize memory regions\n");
+      return 1;
+   }
+
+   rc_runtime_init(&runtime);
+
+   if (path)
+   {
+      if (!load_achievements(&runtime, path, &count))
+      {
+         printf("[ERROR]: Failed to read %s\n", path);
+         return 1;
+      }
+   }
+   else
+      synthesize_achievements(&runtime, count);
+
+   printf("%u regions, %u translated pages, %u achievements (%s)\n",
+         memory.count, (unsigned)memory.page_count, count,
+         path ? path : "synthetic");
+
+   if (!verify())
+      return 1;
+
+   /* alternate the passes and keep the best of each to
+    * smooth out frequency scaling and cache warm-up */
+   time_linear = time_paged = (uint64_t)-1;
+
+   for (pass = 0; pass < PASSES; pass++)
+   {
+      uint64_t elapsed;
+
+      peeks   = 0;
+      elapsed = run_frames(&runtime, linear_peek, num_blocks);
+      if (elapsed < time_linear)
+         time_linear = elapsed;
+      peeks_per_frame = peeks / FRAMES;
+
+      elapsed = run_frames(&runtime, paged_peek, num_blocks);
+      if (elapsed < time_paged)
+         time_paged = elapsed;
+   }
+
+   /* the sums are only printed to keep the reads from being
+    * optimized out; they differ when a value straddles two
+    * blocks, as the linear lookup reads past the end of the
+    * first one */
+   reads_linear = run_reads(linear_peek, &sum_linear);
+   reads_paged  = run_reads(paged_peek, &sum_paged);
+
+   printf("Linear lookup:    %8.2f ns/read (%08X)\n",
+         reads_linear * 1000.0 / RAW_READS, sum_linear);
+   printf("Page table:       %8.2f ns/read (%08X)\n",
+         reads_paged * 1000.0 / RAW_READS, sum_paged);
+   printf("Peeks per frame:  %8u\n", peeks_per_frame);
+   printf("Linear lookup:    %8.2f us/frame\n", (double)time_linear / FRAMES);
+   printf("Page table:       %8.2f us/frame\n", (double)time_paged / FRAMES);
+   printf("[SUCCESS]: Reads match\n");
+
+   rc_runtime_destroy(&runtime);
+   rcheevos_memory_destroy(&memory);
+   return 0;
+}
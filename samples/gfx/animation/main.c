@@ -0,0 +1,334 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2020 - The RetroArch team
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Times gfx_animation_push(), gfx_animation_update() and
+ * gfx_animation_kill_by_tag() with the given numbers of
+ * running tweens (1000 and 10000 by default), using a mix
+ * of easing types and four tweens per tag, as menu drivers
+ * do when animating entries.
+ *
+ * Also checks that every tween reaches its target value
+ * and fires its callback exactly once, including tweens
+ * pushed from inside callbacks while the tween arrays
+ * cannot grow (gfx_animation.o is built with realloc()
+ * routed through bench_realloc(), see Makefile). */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <boolean.h>
+#include <array/rbuf.h>
+
+#include "../../../gfx/gfx_animation.h"
+
+#define FRAMES         1000
+#define FRAME_TIME_US  16667
+#define TWEENS_PER_TAG 4
+#define PUSHED_IN_CB   64
+
+static gfx_animation_t anim_st;
+static bool fail_realloc;
+static unsigned errors;
+
+static float *subjects;
+static float *targets;
+static unsigned *fired;
+
+static uint64_t get_time_usec(void)
+{
+#if defined(CLOCK_MONOTONIC)
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#else
+   return (uint64_t)clock() * 1000000 / CLOCKS_PER_SEC;
+#endif
+}
+
+/* Frontend functions used by gfx_animation.c */
+
+gfx_animation_t *anim_get_ptr(void)
+{
+   return &anim_st;
+}
+
+int font_driver_get_message_width(void *font_data,
+      const char *msg, unsigned len, float scale)
+{
+   return (int)len * 8;
+}
+
+int font_driver_get_line_height(void *font_data, float scale)
+{
+   return 16;
+}
+
+void *bench_realloc(void *ptr, size_t size)
+{
+   if (fail_realloc)
+      return NULL;
+   return realloc(ptr, size);
+}
+
+static void error(const char *msg, unsigned index)
+{
+   if (errors++ < 10)
+      printf("[ERROR]: %s (tween %u)\n", msg, index);
+}
+
+static void tween_done(void *userdata)
+{
+   unsigned index = (unsigned)(uintptr_t)userdata;
+
+   fired[index]++;
+
+   if (subjects[index] != targets[index])
+      error("Tween completed before reaching its target", index);
+}
+
+static bool push_tween(unsigned index, float duration, uintptr_t tag)
+{
+   gfx_animation_ctx_entry_t entry;
+
+   subjects[index]    = 0.0f;
+   targets[index]     = (float)(index % 97) + 1.0f;
+   fired[index]       = 0;
+
+   entry.subject      = &subjects[index];
+   entry.target_value = targets[index];
+   entry.duration     = duration;
+   entry.easing_enum  = (enum gfx_animation_easing_type)(index % EASING_LAST);
+   entry.tag          = tag;
+   entry.cb           = tween_done;
+   entry.userdata     = (void*)(uintptr_t)index;
+
+   return gfx_animation_push(&entry);
+}
+
+static bool alloc_tweens(unsigned count)
+{
+   free(subjects);
+   free(targets);
+   free(fired);
+
+   subjects = (float*)calloc(count, sizeof(*subjects));
+   targets  = (float*)calloc(count, sizeof(*targets));
+   fired    = (unsigned*)calloc(count, sizeof(*fired));
+
+   return subjects && targets && fired;
+}
+
+/* Runs updates until no tween is left, returning
+ * the number of frames taken */
+static unsigned run_until_idle(retro_time_t *now, unsigned max_frames)
+{
+   unsigned frames = 0;
+
+   while (frames < max_frames)
+   {
+      *now += FRAME_TIME_US;
+      frames++;
+      if (!gfx_animation_update(&anim_st, *now, false, 1.0f, 1920, 1080))
+         break;
+   }
+
+   return frames;
+}
+
+static void bench(unsigned count)
+{
+   unsigned i;
+   uint64_t start, t_push, t_update, t_kill;
+   retro_time_t now = 1000000;
+   unsigned tags    = (count + TWEENS_PER_TAG - 1) / TWEENS_PER_TAG;
+
+   if (!alloc_tweens(count))
+   {
+      error("Out of memory", 0);
+      return;
+   }
+
+   gfx_animation_update(&anim_st, now, false, 1.0f, 1920, 1080);
+
+   /* Long-running tweens, so that all of them stay
+    * active for the whole update benchmark */
+   start = get_time_usec();
+   for (i = 0; i < count; i++)
+      push_tween(i, 1000000.0f, i % tags + 1);
+   t_push = get_time_usec() - start;
+
+   start = get_time_usec();
+   for (i = 0; i < FRAMES; i++)
+   {
+      now += FRAME_TIME_US;
+      gfx_animation_update(&anim_st, now, false, 1.0f, 1920, 1080);
+   }
+   t_update = get_time_usec() - start;
+
+   start = get_time_usec();
+   for (i = 0; i < tags; i++)
+   {
+      uintptr_t tag = i + 1;
+      gfx_animation_kill_by_tag(&tag);
+   }
+   t_kill = get_time_usec() - start;
+
+   if (run_until_idle(&now, 1) != 1 || anim_st.tweens.size)
+      error("Tweens left after killing every tag", 0);
+
+   for (i = 0; i < count; i++)
+   {
+      if (fired[i])
+         error("Callback fired for a killed tween", i);
+   }
+
+   /* Short tweens of varying length, which must all
+    * complete, in any order */
+   for (i = 0; i < count; i++)
+      push_tween(i, 50.0f + (float)(i % 451), i % tags + 1);
+
+   run_until_idle(&now, 1000);
+
+   for (i = 0; i < count; i++)
+   {
+      if (fired[i] != 1)
+         error("Callback did not fire exactly once", i);
+   }
+
+   printf("%6u tweens: push %8.2f us, update %8.2f us/frame, kill %u tags %8.2f us\n",
+         count, (double)t_push, (double)t_update / FRAMES, tags, (double)t_kill);
+
+   gfx_animation_deinit(&anim_st);
+}
+
+/* Completion callback that pushes more tweens while the
+ * update is running, then makes the tween arrays unable
+ * to grow, so that they have to stay pending */
+static void push_from_callback(void *userdata)
+{
+   unsigned i;
+
+   for (i = 1; i <= PUSHED_IN_CB; i++)
+      push_tween(i, 100.0f, i);
+
+   fail_realloc = true;
+}
+
+static void test_append_failure(void)
+{
+   unsigned i;
+   gfx_animation_ctx_entry_t entry;
+   retro_time_t now  = 1000000;
+   unsigned filler   = 0;
+   unsigned count    = PUSHED_IN_CB + 1;
+   float *filler_sub = NULL;
+
+   if (!alloc_tweens(count))
+   {
+      error("Out of memory", 0);
+      return;
+   }
+
+   gfx_animation_update(&anim_st, now, false, 1.0f, 1920, 1080);
+
+   /* Tween 0 completes on the next frame */
+   subjects[0]        = 0.0f;
+   targets[0]         = 1.0f;
+   entry.subject      = &subjects[0];
+   entry.target_value = 1.0f;
+   entry.duration     = 1.0f;
+   entry.easing_enum  = EASING_LINEAR;
+   entry.tag          = 0;
+   entry.cb           = push_from_callback;
+   entry.userdata     = NULL;
+   gfx_animation_push(&entry);
+
+   /* Fill the tween arrays to capacity with tweens that
+    * outlive the test */
+   filler_sub = (float*)calloc(anim_st.tweens.capacity, sizeof(*filler_sub));
+   while (filler_sub && anim_st.tweens.size < anim_st.tweens.capacity)
+   {
+      entry.subject      = &filler_sub[filler++];
+      entry.target_value = 1.0f;
+      entry.duration     = 1000000.0f;
+      entry.tag          = (uintptr_t)-1;
+      entry.cb           = NULL;
+      gfx_animation_push(&entry);
+   }
+
+   now += FRAME_TIME_US;
+   gfx_animation_update(&anim_st, now, false, 1.0f, 1920, 1080);
+
+   if (RBUF_LEN(anim_st.pending) == 0)
+      error("Allocation failure was not exercised", 0);
+
+   fail_realloc = false;
+
+   /* Tweens that could not be merged must still run,
+    * fire their callbacks and be killable */
+   for (i = 0; i < 100; i++)
+   {
+      now += FRAME_TIME_US;
+      gfx_animation_update(&anim_st, now, false, 1.0f, 1920, 1080);
+   }
+
+   for (i = 1; i <= PUSHED_IN_CB; i++)
+   {
+      if (fired[i] != 1)
+         error("Tween pushed from a callback was lost", i);
+   }
+
+   gfx_animation_deinit(&anim_st);
+   free(filler_sub);
+}
+
+int main(int argc, char *argv[])
+{
+   int i;
+
+   if (argc > 1 && !strcmp(argv[1], "-h"))
+   {
+      printf("Usage: %s [tween count ...]\n", argv[0]);
+      return 1;
+   }
+
+   if (argc > 1)
+   {
+      for (i = 1; i < argc; i++)
+         bench((unsigned)strtoul(argv[i], NULL, 10));
+   }
+   else
+   {
+      bench(1000);
+      bench(10000);
+   }
+
+   test_append_failure();
+
+   free(subjects);
+   free(targets);
+   free(fired);
+
+   if (errors)
+   {
+      printf("[ERROR]: %u errors\n", errors);
+      return 1;
+   }
+
+   printf("[SUCCESS]: All tweens completed\n");
+   return 0;
+}
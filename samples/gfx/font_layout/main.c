@@ -0,0 +1,367 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2020 - The RetroArch team
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Times font_driver_render_msg() laying out screens of
+ * CJK and RTL (Arabic) menu strings with the stb-unicode
+ * glyph renderer, in the way the raster font drivers do
+ * (one get_glyph() per character, atlas upload when a
+ * glyph was added).
+ *
+ * RTL strings are measured twice:
+ * - 'cached': the same 16 strings every frame, so that
+ *   they are reshaped once and then served by the shaped
+ *   message cache
+ * - 'uncached': 16 strings per frame taken in turn from a
+ *   set larger than the cache, so that every call has to
+ *   reshape its string, as every call did before the cache
+ *   was added
+ * The laid out width of each string must be the same with
+ * and without the cache.
+ *
+ * For every glyph miss, the number of atlas bytes sent by
+ * a driver that uploads the whole atlas is compared with
+ * the number sent when only the modified rows are uploaded
+ * (gl, gl1 and glcore drivers). */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <boolean.h>
+#include <encodings/utf.h>
+
+#include "../../../gfx/font_driver.h"
+
+#define FRAMES          1000
+#define SCREEN_STRINGS  16
+#define UNCACHED_COUNT  128
+#define CJK_GLYPHS      1500
+#define CJK_FIRST       0x4E00
+#define GLYPHS_PER_LINE 16
+
+typedef struct
+{
+   const font_renderer_driver_t *font_driver;
+   void *font_data;
+   struct font_atlas *atlas;
+   int width;
+   unsigned uploads;
+   uint64_t full_bytes;
+   uint64_t dirty_bytes;
+} layout_t;
+
+static const char *cjk_strings[] = {
+   "加载内容",
+   "在线更新",
+   "设置",
+   "信息",
+   "配置文件",
+   "帮助",
+   "最近的历史记录",
+   "收藏夹",
+   "コンテンツをロード",
+   "オンラインアップデーター",
+   "設定",
+   "終了",
+   "콘텐츠 불러오기",
+   "온라인 업데이트",
+   "설정",
+   "정보"
+};
+
+static const char *rtl_strings[] = {
+   "تحميل المحتوى",
+   "المحدث عبر الإنترنت",
+   "الإعدادات",
+   "معلومات",
+   "ملفات التكوين",
+   "مساعدة",
+   "السجل",
+   "المفضلة",
+   "الصور",
+   "الموسيقى",
+   "الفيديو",
+   "الشبكة",
+   "استيراد المحتوى",
+   "قوائم التشغيل",
+   "المستكشف",
+   "الخروج"
+};
+
+static layout_t layout;
+static unsigned errors;
+
+static char rtl_set[UNCACHED_COUNT][128];
+static int rtl_width[UNCACHED_COUNT];
+static char cjk_lines[CJK_GLYPHS / GLYPHS_PER_LINE][GLYPHS_PER_LINE * 3 + 1];
+
+static uint64_t get_time_usec(void)
+{
+#if defined(CLOCK_MONOTONIC)
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#else
+   return (uint64_t)clock() * 1000000 / CLOCKS_PER_SEC;
+#endif
+}
+
+/* Frontend functions used by font_driver.c */
+
+void RARCH_LOG(const char *fmt, ...) { }
+void RARCH_ERR(const char *fmt, ...) { }
+void gfx_display_batch_flush(void) { }
+
+static void *bitmap_init(const char *font_path, float font_size)
+{
+   return NULL;
+}
+
+font_renderer_driver_t bitmap_font_renderer = {
+   bitmap_init,
+   NULL,
+   NULL,
+   NULL,
+   NULL,
+   "bitmap",
+   NULL
+};
+
+/* Lays out msg on one line, as the raster font
+ * drivers do before emitting vertices */
+static void layout_render_msg(void *userdata,
+      void *data, const char *msg,
+      const struct font_params *params)
+{
+   layout_t *l = (layout_t*)data;
+
+   l->width    = 0;
+
+   while (*msg)
+   {
+      unsigned code                  = utf8_walk(&msg);
+      const struct font_glyph *glyph = l->font_driver->get_glyph(
+            l->font_data, code);
+
+      if (!glyph)
+         glyph = l->font_driver->get_glyph(l->font_data, '?');
+      if (!glyph)
+         continue;
+
+      l->width += glyph->advance_x;
+   }
+
+   if (l->atlas->dirty)
+   {
+      unsigned rows = l->atlas->height;
+
+      if (l->atlas->dirty_y_end > l->atlas->dirty_y_start)
+         rows = l->atlas->dirty_y_end - l->atlas->dirty_y_start;
+
+      l->uploads++;
+      l->full_bytes  += (uint64_t)l->atlas->width * l->atlas->height;
+      l->dirty_bytes += (uint64_t)l->atlas->width * rows;
+      l->atlas->dirty = false;
+   }
+}
+
+static font_renderer_t layout_renderer = {
+   NULL,
+   NULL,
+   layout_render_msg,
+   "layout",
+   NULL,
+   NULL,
+   NULL,
+   NULL,
+   NULL
+};
+
+static font_data_t layout_font = {
+   &layout_renderer,
+   &layout,
+   NULL,
+   0.0f
+};
+
+static int render(const char *msg)
+{
+   font_driver_render_msg(NULL, msg, NULL, &layout_font);
+   return layout.width;
+}
+
+static size_t utf8_put(char *s, uint32_t c)
+{
+   if (c < 0x800)
+   {
+      s[0] = (char)(0xC0 | (c >> 6));
+      s[1] = (char)(0x80 | (c & 0x3F));
+      return 2;
+   }
+
+   s[0] = (char)(0xE0 | (c >> 12));
+   s[1] = (char)(0x80 | ((c >> 6) & 0x3F));
+   s[2] = (char)(0x80 | (c & 0x3F));
+   return 3;
+}
+
+static void init_strings(void)
+{
+   unsigned i, j;
+
+   for (i = 0; i < UNCACHED_COUNT; i++)
+      snprintf(rtl_set[i], sizeof(rtl_set[i]), "%s %u",
+            rtl_strings[i % SCREEN_STRINGS], i);
+
+   for (i = 0; i < CJK_GLYPHS / GLYPHS_PER_LINE; i++)
+   {
+      char *s = cjk_lines[i];
+
+      for (j = 0; j < GLYPHS_PER_LINE; j++)
+         s += utf8_put(s, CJK_FIRST + i * GLYPHS_PER_LINE + j);
+      *s = '\0';
+   }
+}
+
+static void report(const char *name, uint64_t usec,
+      unsigned uploads, uint64_t full_bytes, uint64_t dirty_bytes)
+{
+   printf("%-28s %8.2f us/frame, %5u atlas uploads, "
+         "%8.1f KiB/frame full atlas, %8.1f KiB/frame dirty rows\n",
+         name, (double)usec / FRAMES, uploads,
+         (double)full_bytes  / FRAMES / 1024.0,
+         (double)dirty_bytes / FRAMES / 1024.0);
+}
+
+static void bench(const char *name, unsigned mode)
+{
+   unsigned f, i;
+   uint64_t start, t;
+   unsigned uploads     = layout.uploads;
+   uint64_t full_bytes  = layout.full_bytes;
+   uint64_t dirty_bytes = layout.dirty_bytes;
+
+   start = get_time_usec();
+
+   for (f = 0; f < FRAMES; f++)
+   {
+      for (i = 0; i < SCREEN_STRINGS; i++)
+      {
+         switch (mode)
+         {
+            case 0:
+               render(cjk_strings[i]);
+               break;
+            case 1:
+               {
+                  int width = render(rtl_set[i]);
+                  if (width != rtl_width[i])
+                     errors++;
+               }
+               break;
+            case 2:
+               {
+                  unsigned idx = (f * SCREEN_STRINGS + i) % UNCACHED_COUNT;
+                  int width    = render(rtl_set[idx]);
+                  if (width != rtl_width[idx])
+                     errors++;
+               }
+               break;
+            case 3:
+               render(cjk_lines[(f * SCREEN_STRINGS + i)
+                     % (CJK_GLYPHS / GLYPHS_PER_LINE)]);
+               break;
+         }
+      }
+   }
+
+   t = get_time_usec() - start;
+
+   report(name, t, layout.uploads - uploads,
+         layout.full_bytes - full_bytes,
+         layout.dirty_bytes - dirty_bytes);
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned i;
+   const char *font_path = NULL;
+   float font_size       = 24.0f;
+
+   if (argc > 1 && !strcmp(argv[1], "-h"))
+   {
+      printf("Usage: %s [font.ttf] [font size]\n", argv[0]);
+      return 1;
+   }
+
+   if (argc > 1)
+      font_path = argv[1];
+   else
+      font_path = stb_unicode_font_renderer.get_default_font();
+
+   if (argc > 2)
+      font_size = (float)atof(argv[2]);
+
+   if (!font_path)
+   {
+      printf("[ERROR]: No font found, pass a TrueType font path\n");
+      return 1;
+   }
+
+   layout.font_driver = &stb_unicode_font_renderer;
+   layout.font_data   = layout.font_driver->init(font_path, font_size);
+
+   if (!layout.font_data)
+   {
+      printf("[ERROR]: Could not load font %s\n", font_path);
+      return 1;
+   }
+
+   layout.atlas        = layout.font_driver->get_atlas(layout.font_data);
+   layout.atlas->dirty = false;
+   layout_font.size    = font_size;
+
+   printf("Font %s, size %.0f, atlas %ux%u\n", font_path,
+         font_size, layout.atlas->width, layout.atlas->height);
+
+   init_strings();
+
+   /* Reference widths, each string being reshaped
+    * while no other string is cached */
+   for (i = 0; i < UNCACHED_COUNT; i++)
+   {
+      font_driver_free_osd();
+      rtl_width[i] = render(rtl_set[i]);
+   }
+   font_driver_free_osd();
+
+   bench("CJK strings", 0);
+   bench("RTL strings, cached", 1);
+   bench("RTL strings, uncached", 2);
+   bench("CJK, 1500 distinct glyphs", 3);
+
+   layout.font_driver->free(layout.font_data);
+   font_driver_free_osd();
+
+   if (errors)
+   {
+      printf("[ERROR]: %u strings laid out differently when cached\n", errors);
+      return 1;
+   }
+
+   printf("[SUCCESS]: Cached and reshaped strings have the same layout\n");
+   return 0;
+}
@@ -0,0 +1,366 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2020 - The RetroArch team
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Writes a playlist with the given number of entries and
+ * times loading it by parsing the playlist file and from
+ * its binary copy, checking that both loads give back the
+ * playlist that was written, that the binary copy is not
+ * used once the file changed, even when its size and
+ * modification time stay the same, that a playlist loaded
+ * from the binary copy can be modified and written, and
+ * that deleting the playlist deletes its binary copy. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <boolean.h>
+#include <compat/strl.h>
+#include <retro_miscellaneous.h>
+#include <file/file_path.h>
+#include <streams/file_stream.h>
+#include <string/stdstring.h>
+#include <lists/string_list.h>
+
+#include "../../../playlist.h"
+#include "../../../core_info.h"
+#include "../../../verbosity.h"
+#include "../../../file_path_special.h"
+
+#define DEFAULT_ENTRIES 10000
+#define LOADS           20
+#define CORE_PATH       "/usr/lib/libretro/dummy_libretro.so"
+
+static unsigned errors;
+
+static uint64_t get_time_usec(void)
+{
+#if defined(CLOCK_MONOTONIC)
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#else
+   return (uint64_t)clock() * 1000000 / CLOCKS_PER_SEC;
+#endif
+}
+
+/* Frontend functions used by playlist.c */
+
+bool core_info_find(core_info_ctx_find_t *info)
+{
+   return false;
+}
+
+bool core_info_core_file_id_is_equal(const char *core_path_a,
+      const char *core_path_b)
+{
+   return false;
+}
+
+void RARCH_LOG(const char *fmt, ...)
+{
+   (void)fmt;
+}
+
+void RARCH_WARN(const char *fmt, ...)
+{
+   (void)fmt;
+}
+
+void RARCH_ERR(const char *fmt, ...)
+{
+   va_list ap;
+   va_start(ap, fmt);
+   vfprintf(stderr, fmt, ap);
+   va_end(ap);
+}
+
+static void check(bool condition, const char *what, unsigned idx)
+{
+   if (condition)
+      return;
+
+   if (errors++ < 10)
+      printf("[ERROR]: %s (entry %u)\n", what, idx);
+}
+
+static bool push(playlist_t *playlist, const char *dir, unsigned id)
+{
+   char path[PATH_MAX_LENGTH];
+   char label[64];
+   char crc32[16];
+   struct playlist_entry entry  = {0};
+   struct string_list *roms     = NULL;
+   bool ret;
+
+   snprintf(path,  sizeof(path),  "%s/playlist_load_%07u.bin", dir, id);
+   snprintf(label, sizeof(label), "Game %u (Disc \"%u\")", id, id % 4);
+   snprintf(crc32, sizeof(crc32), "%08X|crc", id * 2654435761u);
+
+   entry.path      = path;
+   entry.label     = label;
+   entry.core_path = (char*)CORE_PATH;
+   entry.core_name = (char*)"Dummy";
+   entry.crc32     = crc32;
+   entry.db_name   = (char*)"Dummy - Console.lpl";
+
+   /* Some entries use a subsystem */
+   if (!(id % 100))
+   {
+      union string_list_elem_attr attr = {0};
+
+      roms = string_list_new();
+      string_list_append(roms, path, attr);
+      string_list_append(roms, "/tmp/playlist_load_slot.bin", attr);
+
+      entry.subsystem_ident = (char*)"sgb";
+      entry.subsystem_name  = (char*)"Super Game Boy";
+      entry.subsystem_roms  = roms;
+   }
+
+   ret = playlist_push(playlist, &entry);
+
+   if (roms)
+      string_list_free(roms);
+
+   return ret;
+}
+
+/* Empty strings are not written, and read back as NULL */
+static bool same(const char *a, const char *b)
+{
+   return string_is_equal(a ? a : "", b ? b : "");
+}
+
+static void compare(playlist_t *a, playlist_t *b)
+{
+   size_t i;
+
+   check(playlist_size(a) == playlist_size(b), "Wrong size", 0);
+   check(same(playlist_get_default_core_path(a),
+            playlist_get_default_core_path(b)), "Wrong default core", 0);
+
+   for (i = 0; i < playlist_size(a) && i < playlist_size(b); i++)
+   {
+      size_t j;
+      const struct playlist_entry *x = NULL;
+      const struct playlist_entry *y = NULL;
+
+      playlist_get_index(a, i, &x);
+      playlist_get_index(b, i, &y);
+
+      check(same(x->path,      y->path),      "Wrong path",      (unsigned)i);
+      check(same(x->label,     y->label),     "Wrong label",     (unsigned)i);
+      check(same(x->core_path, y->core_path), "Wrong core path", (unsigned)i);
+      check(same(x->core_name, y->core_name), "Wrong core name", (unsigned)i);
+      check(same(x->crc32,     y->crc32),     "Wrong crc32",     (unsigned)i);
+      check(same(x->db_name,   y->db_name),   "Wrong db name",   (unsigned)i);
+      check(same(x->subsystem_ident, y->subsystem_ident),
+            "Wrong subsystem", (unsigned)i);
+      check(same(x->subsystem_name, y->subsystem_name),
+            "Wrong subsystem name", (unsigned)i);
+      check(!x->subsystem_roms == !y->subsystem_roms,
+            "Wrong subsystem ROMs", (unsigned)i);
+
+      if (x->subsystem_roms && y->subsystem_roms)
+      {
+         check(x->subsystem_roms->size == y->subsystem_roms->size,
+               "Wrong number of subsystem ROMs", (unsigned)i);
+         for (j = 0; j < x->subsystem_roms->size
+               && j < y->subsystem_roms->size; j++)
+            check(same(x->subsystem_roms->elems[j].data,
+                     y->subsystem_roms->elems[j].data),
+                  "Wrong subsystem ROM", (unsigned)i);
+      }
+   }
+}
+
+/* Renames the first game in the playlist file to
+ * "Gamf ...", then restores the modification time */
+static bool edit_keeping_stamp(const char *path)
+{
+   struct stat st;
+   struct timespec times[2];
+   void *buf   = NULL;
+   int64_t len = 0;
+   char *label = NULL;
+   bool ret    = false;
+
+   if (     stat(path, &st) != 0
+         || !filestream_read_file(path, &buf, &len))
+      return false;
+
+   if ((label = strstr((char*)buf, "\"Game ")))
+   {
+      label[4] = 'f';
+      times[0] = st.st_atim;
+      times[1] = st.st_mtim;
+      ret      = filestream_write_file(path, buf, len)
+         && utimensat(AT_FDCWD, path, times, 0) == 0;
+   }
+
+   free(buf);
+   return ret;
+}
+
+static bool has_label_prefix(playlist_t *playlist, const char *prefix)
+{
+   size_t i;
+
+   for (i = 0; i < playlist_size(playlist); i++)
+   {
+      const struct playlist_entry *entry = NULL;
+
+      playlist_get_index(playlist, i, &entry);
+      if (entry->label && string_starts_with(entry->label, prefix))
+         return true;
+   }
+
+   return false;
+}
+
+static void report(const char *what, unsigned count, uint64_t usec)
+{
+   printf("%-36s %4u loads %10.2f ms %10.3f ms/load\n",
+         what, count, usec / 1000.0, usec / 1000.0 / count);
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned i;
+   uint64_t start;
+   playlist_config_t config;
+   struct playlist_entry update = {0};
+   void *old_bin                = NULL;
+   int64_t old_bin_size         = 0;
+   char bin_path[PATH_MAX_LENGTH];
+   unsigned entries      = (argc > 1) ? (unsigned)atoi(argv[1]) : DEFAULT_ENTRIES;
+   const char *dir       = (argc > 2) ? argv[2] : "/tmp";
+   playlist_t *written   = NULL;
+   playlist_t *loaded    = NULL;
+
+   if (!entries)
+   {
+      printf("Usage: %s [entries] [dir]\n", argv[0]);
+      return 1;
+   }
+
+   memset(&config, 0, sizeof(config));
+   config.capacity            = entries;
+   config.fuzzy_archive_match = true;
+   snprintf(config.path, sizeof(config.path),
+         "%s/playlist_load_bench.lpl", dir);
+   strlcpy(bin_path, config.path, sizeof(bin_path));
+   strlcat(bin_path, FILE_PATH_PLAYLIST_BINARY_EXTENSION, sizeof(bin_path));
+
+   filestream_delete(config.path);
+   filestream_delete(bin_path);
+
+   if (!(written = playlist_init(&config)))
+   {
+      printf("[ERROR]: Failed to create playlist\n");
+      return 1;
+   }
+
+   for (i = 0; i < entries; i++)
+      check(push(written, dir, i), "Push failed", i);
+   playlist_set_default_core_path(written, CORE_PATH);
+   playlist_set_default_core_name(written, "Dummy");
+   playlist_write_file(written);
+
+   check(path_is_valid(bin_path), "No binary copy written", 0);
+
+   /* Parse the playlist file. This writes the binary
+    * copy again, as the first load of a playlist does */
+   start = get_time_usec();
+   for (i = 0; i < LOADS; i++)
+   {
+      filestream_delete(bin_path);
+      loaded = playlist_init(&config);
+      if (i == LOADS - 1)
+         compare(written, loaded);
+      playlist_free(loaded);
+   }
+   report("Parse playlist file", LOADS, get_time_usec() - start);
+
+   start = get_time_usec();
+   for (i = 0; i < LOADS; i++)
+   {
+      loaded = playlist_init(&config);
+      if (i == LOADS - 1)
+         compare(written, loaded);
+      playlist_free(loaded);
+   }
+   report("Map binary copy", LOADS, get_time_usec() - start);
+
+   /* Modify and write a playlist loaded from the binary copy */
+   filestream_read_file(bin_path, &old_bin, &old_bin_size);
+   update.label = (char*)"Renamed";
+
+   loaded = playlist_init(&config);
+   playlist_update(loaded, 0, &update);
+   playlist_delete_index(loaded, 1);
+   playlist_set_default_core_path(loaded, "/usr/lib/libretro/other_libretro.so");
+   playlist_write_file(loaded);
+   playlist_free(loaded);
+
+   playlist_update(written, 0, &update);
+   playlist_delete_index(written, 1);
+   playlist_set_default_core_path(written, "/usr/lib/libretro/other_libretro.so");
+
+   loaded = playlist_init(&config);
+   compare(written, loaded);
+   playlist_free(loaded);
+
+   /* A binary copy that does not match the
+    * playlist file any more must be ignored */
+   if (old_bin)
+   {
+      filestream_write_file(bin_path, old_bin, old_bin_size);
+      free(old_bin);
+   }
+
+   loaded = playlist_init(&config);
+   compare(written, loaded);
+   playlist_free(loaded);
+
+   /* Nor one recorded for a file that changed without
+    * changing size or modification time */
+   check(edit_keeping_stamp(config.path), "Failed to edit playlist file", 0);
+
+   loaded = playlist_init(&config);
+   check(has_label_prefix(loaded, "Gamf "),
+         "Binary copy used for an edited playlist file", 0);
+   playlist_free(loaded);
+
+   playlist_free(written);
+
+   playlist_delete_file(config.path);
+   check(!path_is_valid(config.path) && !path_is_valid(bin_path),
+         "Playlist file or binary copy left after deletion", 0);
+
+   if (errors)
+   {
+      printf("[ERROR]: %u checks failed\n", errors);
+      return 1;
+   }
+
+   printf("[SUCCESS]: All checks passed\n");
+   return 0;
+}
@@ -0,0 +1,258 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2020 - The RetroArch team
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Fills a playlist with the given number of entries and
+ * times pushing new content, looking up and re-pushing
+ * (bumping) existing content, pushing into a full playlist
+ * and deleting by path, checking the result of each
+ * operation against the expected playlist contents.
+ *
+ * Content paths do not need to exist; they are placed in
+ * the given directory (the system temporary directory by
+ * default), so that resolving them costs about as much as
+ * resolving real content paths. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+
+#include <boolean.h>
+#include <compat/strl.h>
+#include <retro_miscellaneous.h>
+
+#include "../../../playlist.h"
+#include "../../../core_info.h"
+#include "../../../verbosity.h"
+
+#define DEFAULT_ENTRIES 50000
+#define OPERATIONS      1000
+#define CORE_PATH       "/usr/lib/libretro/dummy_libretro.so"
+
+static char content_dir[PATH_MAX_LENGTH];
+static unsigned errors;
+
+static uint64_t get_time_usec(void)
+{
+#if defined(CLOCK_MONOTONIC)
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#else
+   return (uint64_t)clock() * 1000000 / CLOCKS_PER_SEC;
+#endif
+}
+
+/* Frontend functions used by playlist.c */
+
+bool core_info_find(core_info_ctx_find_t *info)
+{
+   return false;
+}
+
+bool core_info_core_file_id_is_equal(const char *core_path_a,
+      const char *core_path_b)
+{
+   return false;
+}
+
+void RARCH_LOG(const char *fmt, ...)
+{
+   (void)fmt;
+}
+
+void RARCH_WARN(const char *fmt, ...)
+{
+   (void)fmt;
+}
+
+void RARCH_ERR(const char *fmt, ...)
+{
+   va_list ap;
+   va_start(ap, fmt);
+   vfprintf(stderr, fmt, ap);
+   va_end(ap);
+}
+
+static void content_path(char *s, size_t len, unsigned id)
+{
+   snprintf(s, len, "%s/playlist_push_%07u.bin", content_dir, id);
+}
+
+static bool push(playlist_t *playlist, const char *path)
+{
+   struct playlist_entry entry = {0};
+
+   entry.path      = (char*)path;
+   entry.label     = (char*)"label";
+   entry.core_path = (char*)CORE_PATH;
+   entry.core_name = (char*)"Dummy";
+
+   return playlist_push(playlist, &entry);
+}
+
+static void check(bool condition, const char *what, const char *path)
+{
+   if (condition)
+      return;
+
+   if (errors++ < 10)
+      printf("[ERROR]: %s: %s\n", what, path);
+}
+
+static bool top_is(playlist_t *playlist, const char *path)
+{
+   const struct playlist_entry *entry = NULL;
+
+   playlist_get_index(playlist, 0, &entry);
+   return entry && entry->path && !strcmp(entry->path, path);
+}
+
+static void report(const char *what, unsigned count, uint64_t usec)
+{
+   printf("%-28s %8u ops %10.2f ms %10.3f us/op\n",
+         what, count, usec / 1000.0, (double)usec / count);
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned i;
+   uint64_t start;
+   char path[PATH_MAX_LENGTH];
+   playlist_config_t config;
+   unsigned entries      = (argc > 1) ? (unsigned)atoi(argv[1]) : DEFAULT_ENTRIES;
+   unsigned next_id      = 0;
+   playlist_t *playlist  = NULL;
+
+   strlcpy(content_dir, (argc > 2) ? argv[2] : "/tmp", sizeof(content_dir));
+
+   if (!entries)
+   {
+      printf("Usage: %s [entries] [content dir]\n", argv[0]);
+      return 1;
+   }
+
+   memset(&config, 0, sizeof(config));
+   config.capacity            = entries;
+   config.fuzzy_archive_match = true;
+   /* Not written, only sets where it would go */
+   snprintf(config.path, sizeof(config.path),
+         "%s/playlist_push_bench.lpl", content_dir);
+
+   if (!(playlist = playlist_init(&config)))
+   {
+      printf("[ERROR]: Failed to create playlist\n");
+      return 1;
+   }
+
+   srand(1);
+
+   /* Push unique entries until the playlist is full */
+   start = get_time_usec();
+   for (; next_id < entries; next_id++)
+   {
+      content_path(path, sizeof(path), next_id);
+      check(push(playlist, path), "Push failed", path);
+   }
+   report("Push new", entries, get_time_usec() - start);
+   check(playlist_size(playlist) == entries, "Wrong size", "after fill");
+
+   /* Look up random existing and missing entries */
+   start = get_time_usec();
+   for (i = 0; i < OPERATIONS; i++)
+   {
+      unsigned id = (unsigned)rand() % (entries * 2);
+      content_path(path, sizeof(path), id);
+      check(playlist_entry_exists(playlist, path) == (id < entries),
+            "Wrong lookup result", path);
+   }
+   report("Entry exists", OPERATIONS, get_time_usec() - start);
+
+   start = get_time_usec();
+   for (i = 0; i < OPERATIONS; i++)
+   {
+      const struct playlist_entry *entry = NULL;
+      content_path(path, sizeof(path), (unsigned)rand() % entries);
+      playlist_get_index_by_path(playlist, path, &entry);
+      check(entry && !strcmp(entry->path, path), "Wrong entry", path);
+   }
+   report("Get index by path", OPERATIONS, get_time_usec() - start);
+
+   /* Re-push existing entries, which moves them to the top */
+   start = get_time_usec();
+   for (i = 0; i < OPERATIONS; i++)
+   {
+      content_path(path, sizeof(path), (unsigned)rand() % entries);
+      push(playlist, path);
+      check(top_is(playlist, path), "Not bumped to top", path);
+   }
+   report("Push existing (bump)", OPERATIONS, get_time_usec() - start);
+   check(playlist_size(playlist) == entries, "Wrong size", "after bump");
+
+   /* Push new entries into the full playlist, evicting
+    * the least recently pushed ones */
+   start = get_time_usec();
+   for (i = 0; i < OPERATIONS; i++, next_id++)
+   {
+      const struct playlist_entry *last = NULL;
+      char evicted[PATH_MAX_LENGTH];
+
+      playlist_get_index(playlist, entries - 1, &last);
+      strlcpy(evicted, last->path, sizeof(evicted));
+
+      content_path(path, sizeof(path), next_id);
+      push(playlist, path);
+      check(top_is(playlist, path), "Not pushed to top", path);
+      check(!playlist_entry_exists(playlist, evicted),
+            "Evicted entry still found", evicted);
+   }
+   report("Push new (evict)", OPERATIONS, get_time_usec() - start);
+   check(playlist_size(playlist) == entries, "Wrong size", "after evict");
+
+   /* Delete entries, searching for each one */
+   start = get_time_usec();
+   for (i = 0; i < OPERATIONS && playlist_size(playlist); i++)
+   {
+      const struct playlist_entry *entry = NULL;
+      playlist_get_index(playlist,
+            (unsigned)rand() % playlist_size(playlist), &entry);
+      strlcpy(path, entry->path, sizeof(path));
+      playlist_delete_by_path(playlist, path);
+      check(!playlist_entry_exists(playlist, path),
+            "Deleted entry still found", path);
+   }
+   report("Delete by path", i, get_time_usec() - start);
+
+   /* An archive path matches entries inside the archive */
+   snprintf(path, sizeof(path), "%s/playlist_push.zip#game.bin", content_dir);
+   push(playlist, path);
+   snprintf(path, sizeof(path), "%s/playlist_push.zip", content_dir);
+   check(playlist_entry_exists(playlist, path),
+         "Archive path does not match entry in archive", path);
+   check(!push(playlist, path),
+         "Archive path pushed next to entry in archive", path);
+
+   playlist_free(playlist);
+
+   if (errors)
+   {
+      printf("[ERROR]: %u checks failed\n", errors);
+      return 1;
+   }
+
+   printf("[SUCCESS]: All checks passed\n");
+   return 0;
+}
@@ -0,0 +1,459 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2020 - The RetroArch team
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Builds large synthetic BPS, UPS and IPS patches along
+ * with the content they should produce, and times applying
+ * them through patch_content(), checking the result. The
+ * BPS patches mix all four actions, including target copies
+ * that overlap their own output. Corrupt patches must leave
+ * the content alone. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+
+#include <boolean.h>
+#include <retro_miscellaneous.h>
+#include <file/file_path.h>
+#include <streams/file_stream.h>
+#include <encodings/crc32.h>
+
+#include "../../../msg_hash.h"
+#include "../../../verbosity.h"
+#include "../../../tasks/tasks_internal.h"
+
+#define DEFAULT_SIZE_MB 64
+#define RUNS            5
+
+static unsigned errors;
+
+static uint64_t get_time_usec(void)
+{
+#if defined(CLOCK_MONOTONIC)
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#else
+   return (uint64_t)clock() * 1000000 / CLOCKS_PER_SEC;
+#endif
+}
+
+/* Frontend functions used by task_patch.c */
+
+const char *msg_hash_to_str(enum msg_hash_enums msg)
+{
+   return "";
+}
+
+void RARCH_LOG(const char *fmt, ...)
+{
+   (void)fmt;
+}
+
+void RARCH_WARN(const char *fmt, ...)
+{
+   (void)fmt;
+}
+
+void RARCH_ERR(const char *fmt, ...)
+{
+   (void)fmt;
+}
+
+static uint64_t rand_state = 1;
+
+static uint32_t next_rand(void)
+{
+   rand_state = rand_state * 6364136223846793005ULL + 1442695040888963407ULL;
+   return (uint32_t)(rand_state >> 32);
+}
+
+/* Random data with repeats, like content has */
+static void fill_data(uint8_t *data, size_t len)
+{
+   size_t i;
+
+   for (i = 0; i < len; i++)
+      data[i] = (next_rand() % 4) ? (uint8_t)next_rand() : 0;
+}
+
+struct patch_writer
+{
+   uint8_t *data;
+   size_t len;
+   size_t cap;
+};
+
+static void put_byte(struct patch_writer *w, uint8_t b)
+{
+   if (w->len == w->cap)
+   {
+      w->cap  = w->cap ? w->cap * 2 : 65536;
+      w->data = (uint8_t*)realloc(w->data, w->cap);
+   }
+   w->data[w->len++] = b;
+}
+
+static void put_bytes(struct patch_writer *w, const uint8_t *data, size_t len)
+{
+   while (len--)
+      put_byte(w, *data++);
+}
+
+static void put_le32(struct patch_writer *w, uint32_t value)
+{
+   unsigned i;
+   for (i = 0; i < 32; i += 8)
+      put_byte(w, (uint8_t)(value >> i));
+}
+
+/* Variable length numbers of BPS and UPS */
+static void put_number(struct patch_writer *w, uint64_t value)
+{
+   for (;;)
+   {
+      uint8_t x = value & 0x7f;
+      value   >>= 7;
+      if (!value)
+      {
+         put_byte(w, 0x80 | x);
+         break;
+      }
+      put_byte(w, x);
+      value--;
+   }
+}
+
+static void put_signed(struct patch_writer *w, int64_t value)
+{
+   put_number(w, value < 0
+         ? ((uint64_t)-value << 1) | 1 : (uint64_t)value << 1);
+}
+
+/* Writes a BPS patch turning 'source' into a target of
+ * 'target_len' bytes, which is built at the same time
+ * by copying byte by byte */
+static void make_bps(struct patch_writer *w,
+      const uint8_t *source, size_t source_len,
+      uint8_t *target, size_t target_len)
+{
+   size_t out            = 0;
+   int64_t source_offset = 0;
+   int64_t target_offset = 0;
+
+   put_bytes(w, (const uint8_t*)"BPS1", 4);
+   put_number(w, source_len);
+   put_number(w, target_len);
+   put_number(w, 0);
+
+   while (out < target_len)
+   {
+      size_t i;
+      size_t length   = 1 + next_rand() % 65536;
+      unsigned action = next_rand() % 8;
+
+      if (length > target_len - out)
+         length = target_len - out;
+
+      /* Mostly unchanged content */
+      if (action < 4 && out + length <= source_len)
+      {
+         put_number(w, (length - 1) << 2 | 0);
+         for (i = 0; i < length; i++, out++)
+            target[out] = source[out];
+      }
+      else if (action < 5 || out == 0)
+      {
+         length = MIN(length, 512);
+         put_number(w, (length - 1) << 2 | 1);
+         for (i = 0; i < length; i++, out++)
+         {
+            target[out] = (uint8_t)next_rand();
+            put_byte(w, target[out]);
+         }
+      }
+      else if (action < 7)
+      {
+         int64_t offset = next_rand() % (source_len - MIN(length, source_len));
+
+         length = MIN(length, source_len);
+         put_number(w, (length - 1) << 2 | 2);
+         put_signed(w, offset - source_offset);
+         for (i = 0; i < length; i++, out++)
+            target[out] = source[offset + i];
+         source_offset = offset + length;
+      }
+      else
+      {
+         /* Runs repeating the last few bytes half of
+          * the time, copies from further back otherwise */
+         int64_t offset = (next_rand() % 2)
+            ? (int64_t)out - 1 - next_rand() % MIN(out, 4)
+            : (int64_t)(next_rand() % out);
+
+         put_number(w, (length - 1) << 2 | 3);
+         put_signed(w, offset - target_offset);
+         for (i = 0; i < length; i++, out++)
+            target[out] = target[offset + i];
+         target_offset = offset + length;
+      }
+   }
+
+   put_le32(w, encoding_crc32(0, source, source_len));
+   put_le32(w, encoding_crc32(0, target, target_len));
+   put_le32(w, encoding_crc32(0, w->data, w->len));
+}
+
+/* Writes a UPS patch from 'source' to 'target' */
+static void make_ups(struct patch_writer *w,
+      const uint8_t *source, size_t source_len,
+      const uint8_t *target, size_t target_len)
+{
+   size_t i      = 0;
+   size_t max    = MAX(source_len, target_len);
+
+   put_bytes(w, (const uint8_t*)"UPS1", 4);
+   put_number(w, source_len);
+   put_number(w, target_len);
+
+   while (i < max)
+   {
+      size_t skip = 0;
+
+      for (; i < max; i++, skip++)
+      {
+         uint8_t s = i < source_len ? source[i] : 0;
+         uint8_t t = i < target_len ? target[i] : 0;
+         if (s != t)
+            break;
+      }
+
+      if (i == max)
+         break;
+
+      put_number(w, skip);
+
+      for (; i < max; i++)
+      {
+         uint8_t s = i < source_len ? source[i] : 0;
+         uint8_t t = i < target_len ? target[i] : 0;
+         if (s == t)
+            break;
+         put_byte(w, s ^ t);
+      }
+
+      put_byte(w, 0);
+      i++;
+   }
+
+   put_le32(w, encoding_crc32(0, source, source_len));
+   put_le32(w, encoding_crc32(0, target, target_len));
+   put_le32(w, encoding_crc32(0, w->data, w->len));
+}
+
+/* Writes an IPS patch of random copy and RLE records
+ * (IPS only reaches the first 16 MB), applying them
+ * to 'target' as well */
+static void make_ips(struct patch_writer *w,
+      uint8_t *target, size_t target_len, unsigned records)
+{
+   unsigned r;
+
+   put_bytes(w, (const uint8_t*)"PATCH", 5);
+
+   for (r = 0; r < records; r++)
+   {
+      size_t i;
+      uint32_t address = next_rand() % (MIN(target_len, 0xFFFFFF) - 0x10000);
+      unsigned length  = 1 + next_rand() % 0xFFFF;
+
+      /* Would read as the end of the patch */
+      if (address == 0x454f46)
+         address++;
+
+      put_byte(w, address >> 16);
+      put_byte(w, address >> 8);
+      put_byte(w, address);
+
+      if (next_rand() % 2)
+      {
+         length = MIN(length, 1024);
+         put_byte(w, length >> 8);
+         put_byte(w, length);
+         for (i = 0; i < length; i++)
+         {
+            target[address + i] = (uint8_t)next_rand();
+            put_byte(w, target[address + i]);
+         }
+      }
+      else
+      {
+         uint8_t value = (uint8_t)next_rand();
+         put_byte(w, 0);
+         put_byte(w, 0);
+         put_byte(w, length >> 8);
+         put_byte(w, length);
+         put_byte(w, value);
+         memset(target + address, value, length);
+      }
+   }
+
+   put_bytes(w, (const uint8_t*)"EOF", 3);
+}
+
+/* Applies the patch 'runs' times and checks the result */
+static void run(const char *name, const char *dir, unsigned type,
+      const struct patch_writer *w,
+      uint8_t *source, size_t source_len,
+      const uint8_t *expected, size_t expected_len)
+{
+   unsigned i;
+   char path[PATH_MAX_LENGTH];
+   uint64_t best   = (uint64_t)-1;
+
+   fill_pathname_join(path, dir, name, sizeof(path));
+
+   if (!filestream_write_file(path, w->data, w->len))
+   {
+      printf("[ERROR]: Failed to write %s\n", path);
+      errors++;
+      return;
+   }
+
+   for (i = 0; i < RUNS; i++)
+   {
+      uint64_t start;
+      uint8_t *buf = source;
+      ssize_t size = (ssize_t)source_len;
+
+      start        = get_time_usec();
+      patch_content(false, false, false,
+            type == 0 ? path : NULL,
+            type == 1 ? path : NULL,
+            type == 2 ? path : NULL,
+            &buf, &size);
+      start        = get_time_usec() - start;
+
+      if (start < best)
+         best = start;
+
+      if (     buf == source
+            || (size_t)size != expected_len
+            || memcmp(buf, expected, expected_len))
+      {
+         printf("[ERROR]: %s gave the wrong content\n", name);
+         errors++;
+      }
+
+      if (buf != source)
+         free(buf);
+   }
+
+   printf("%s: %u kB patch, %u kB content: %.2f ms\n", name,
+         (unsigned)(w->len / 1024), (unsigned)(expected_len / 1024),
+         best / 1000.0);
+
+   /* Corrupt patches must not change the content */
+   for (i = 0; i < 3; i++)
+   {
+      struct patch_writer bad = *w;
+      uint8_t *buf            = source;
+      ssize_t size            = (ssize_t)source_len;
+      size_t pos              = 5 + next_rand() % (w->len - 5);
+      uint8_t saved           = w->data[pos];
+
+      bad.data[pos]          ^= 0x01 << (next_rand() % 8);
+
+      filestream_write_file(path, bad.data, bad.len);
+      bad.data[pos]           = saved;
+
+      patch_content(false, false, false,
+            type == 0 ? path : NULL,
+            type == 1 ? path : NULL,
+            type == 2 ? path : NULL,
+            &buf, &size);
+
+      if (buf != source)
+      {
+         /* IPS patches have no checksum */
+         if (type != 0)
+         {
+            printf("[ERROR]: corrupt %s was applied\n", name);
+            errors++;
+         }
+         free(buf);
+      }
+   }
+
+   filestream_delete(path);
+}
+
+int main(int argc, char *argv[])
+{
+   struct patch_writer bps   = {0};
+   struct patch_writer ups   = {0};
+   struct patch_writer ips   = {0};
+   const char *dir           = (argc > 1) ? argv[1] : "/tmp";
+   size_t size               = (size_t)((argc > 2)
+         ? atoi(argv[2]) : DEFAULT_SIZE_MB) * 1024 * 1024;
+   size_t ups_size           = size + 1024 * 1024;
+   uint8_t *source           = (uint8_t*)malloc(size);
+   uint8_t *target           = (uint8_t*)malloc(ups_size);
+   size_t i;
+
+   if (!source || !target || size < 16 * 1024 * 1024)
+   {
+      printf("Usage: %s [directory] [content size in MB, at least 16]\n",
+            argv[0]);
+      return 1;
+   }
+
+   fill_data(source, size);
+
+   make_bps(&bps, source, size, target, size);
+   run("patch_bench.bps", dir, 1, &bps, source, size, target, size);
+
+   /* A hack: scattered changes and an extended end */
+   memcpy(target, source, size);
+   fill_data(target + size, ups_size - size);
+   for (i = 0; i < 20000; i++)
+   {
+      size_t pos = next_rand() % (size - 256);
+      fill_data(target + pos, 1 + next_rand() % 256);
+   }
+   make_ups(&ups, source, size, target, ups_size);
+   run("patch_bench.ups", dir, 2, &ups, source, size, target, ups_size);
+
+   memcpy(target, source, size);
+   make_ips(&ips, target, size, 20000);
+   run("patch_bench.ips", dir, 0, &ips, source, size, target, size);
+
+   free(bps.data);
+   free(ups.data);
+   free(ips.data);
+   free(source);
+   free(target);
+
+   if (errors)
+   {
+      printf("[ERROR]: %u checks failed\n", errors);
+      return 1;
+   }
+
+   printf("[SUCCESS]: All patches applied\n");
+   return 0;
+}
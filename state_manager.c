@@ -550,8 +550,7 @@ recheckcapacity:;
    state->entries++;
 }
 
-#if 0
-static void state_manager_capacity(state_manager_t *state,
+void state_manager_capacity(state_manager_t *state,
       unsigned *entries, size_t *bytes, bool *full)
 {
    size_t headpos   = state->head - state->data;
@@ -566,7 +565,6 @@ static void state_manager_capacity(state_manager_t *state,
    if (full)
       *full         = remaining <= state->maxcompsize * 2;
 }
-#endif
 
 void state_manager_event_init(
       struct state_manager_rewind_state *rewind_st,
@@ -71,6 +71,19 @@ void state_manager_event_deinit(
 void state_manager_event_init(struct state_manager_rewind_state *rewind_st,
       unsigned rewind_buffer_size);
 
+/**
+ * state_manager_capacity:
+ * @state                : rewind buffer.
+ * @entries              : number of states held, or NULL.
+ * @bytes                : bytes in use, or NULL.
+ * @full                 : whether the next state will evict
+ *                         the oldest ones, or NULL.
+ *
+ * Reports how much of the rewind buffer is in use.
+ **/
+void state_manager_capacity(state_manager_t *state,
+      unsigned *entries, size_t *bytes, bool *full);
+
 /**
  * check_rewind:
  * @pressed              : was rewind key pressed or held?
@@ -49,6 +49,17 @@
 #include "../config.h"
 #endif
 
+#ifdef HAVE_MMAP
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#endif
+
 #include <boolean.h>
 
 #include <encodings/crc32.h>
@@ -469,6 +480,85 @@ void task_push_cdrom_dump(const char *drive)
 }
 #endif
 
+#ifdef HAVE_MMAP
+/* Maps the content file in place of reading it. The
+ * mapping is private: its pages are shared with the page
+ * cache, and so with other instances loading the same
+ * file, until a core writes to them. As with
+ * filestream_read_file(), the data is followed by a NUL
+ * byte, from an anonymous page if the file ends on a
+ * page boundary.
+ *
+ * This bypasses the VFS on purpose: its own mapping
+ * (RETRO_VFS_FILE_ACCESS_HINT_FREQUENT_ACCESS) only serves
+ * filestream_read() copies. Paths that only the VFS can
+ * open (cdrom://) fail open() here and are read instead.
+ *
+ * While mapped, truncating the file in place makes any
+ * access past its new end raise SIGBUS; replacing it
+ * (rename) is safe, as the mapping keeps the old file.
+ * The mapping is only held until retro_load_game()
+ * returns, see content_file_init().
+ *
+ * Returns: size of the mapping, or 0 if the file has to
+ * be read instead. */
+static size_t content_file_map(const char *path, void **buf, int64_t *length)
+{
+   int fd;
+   struct stat st;
+   size_t map_size;
+   uint8_t *data  = NULL;
+   long page_size = sysconf(_SC_PAGESIZE);
+
+   if (page_size <= 0 || (fd = open(path, O_RDONLY)) < 0)
+      return 0;
+
+   if (     fstat(fd, &st) != 0
+         || !S_ISREG(st.st_mode)
+         || st.st_size <= 0
+         || (uint64_t)st.st_size >= SIZE_MAX - (size_t)page_size)
+   {
+      close(fd);
+      return 0;
+   }
+
+   map_size = ((size_t)st.st_size / page_size + 1) * page_size;
+   data     = (uint8_t*)mmap(NULL, map_size, PROT_READ | PROT_WRITE,
+         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+   if (     data != (uint8_t*)MAP_FAILED
+         && mmap(data, (size_t)st.st_size, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED)
+   {
+      munmap(data, map_size);
+      data = (uint8_t*)MAP_FAILED;
+   }
+
+   close(fd);
+
+   if (data == (uint8_t*)MAP_FAILED)
+      return 0;
+
+   *buf    = data;
+   *length = (int64_t)st.st_size;
+
+   return map_size;
+}
+#endif
+
+/* Frees content loaded by load_content_into_memory() */
+static void content_file_free(void *data, size_t mapped_size)
+{
+#ifdef HAVE_MMAP
+   if (mapped_size)
+   {
+      munmap(data, mapped_size);
+      return;
+   }
+#endif
+   free(data);
+}
+
 static int64_t content_file_read(const char *path, void **buf, int64_t *length)
 {
 #ifdef HAVE_COMPRESSION
@@ -659,10 +749,14 @@ static bool content_load(content_ctx_info_t *info,
  * @path         : buffer of the content file.
  * @buf          : size   of the content file.
  * @length       : size of the content file that has been read from.
+ * @mapped_size  : size of the mapping of the content file, 0 if
+ *                 it was read into a buffer.
  *
  * Read the content file. If read into memory, also performs soft patching
  * (see patch_content function) in case soft patching has not been
- * blocked by the enduser.
+ * blocked by the enduser. Files outside of archives are mapped
+ * rather than read where possible; patched content always ends up
+ * in a buffer of its own.
  *
  * Returns: true if successful, false on error.
  **/
@@ -670,18 +764,28 @@ static bool load_content_into_memory(
       content_information_ctx_t *content_ctx,
       content_state_t *p_content,
       unsigned i, const char *path, void **buf,
-      int64_t *length)
+      int64_t *length, size_t *mapped_size)
 {
    uint8_t *ret_buf           = NULL;
 
    RARCH_LOG("[CONTENT LOAD]: %s: %s.\n",
          msg_hash_to_str(MSG_LOADING_CONTENT_FILE), path);
 
-   if (!content_file_read(path, (void**) &ret_buf, length))
+   *mapped_size               = 0;
+
+#ifdef HAVE_MMAP
+   if (!path_contains_compressed_file(path))
+      *mapped_size = content_file_map(path, (void**)&ret_buf, length);
+#endif
+
+   if (!*mapped_size && !content_file_read(path, (void**) &ret_buf, length))
       return false;
 
    if (*length < 0)
+   {
+      content_file_free(ret_buf, *mapped_size);
       return false;
+   }
 
    if (i == 0)
    {
@@ -691,7 +795,8 @@ static bool load_content_into_memory(
       if (type == RARCH_CONTENT_NONE)
       {
 #ifdef HAVE_PATCH
-         bool has_patch = false;
+         bool has_patch       = false;
+         uint8_t *content_buf = ret_buf;
 
          /* First content file is significant, attempt to do patching,
           * CRC checking, etc. */
@@ -708,6 +813,13 @@ static bool load_content_into_memory(
                   (uint8_t**)&ret_buf,
                   (void*)length);
 
+         /* Patching leaves the unpatched content to us */
+         if (ret_buf != content_buf)
+         {
+            content_file_free(content_buf, *mapped_size);
+            *mapped_size = 0;
+         }
+
          if (has_patch)
          {
             p_content->rom_crc = encoding_crc32(0, ret_buf, (size_t)*length);
@@ -881,7 +993,8 @@ static bool content_file_load(
       enum msg_hash_enums *error_enum,
       char **error_string,
       const struct retro_subsystem_info *special,
-      struct string_list *additional_path_allocs
+      struct string_list *additional_path_allocs,
+      size_t *mapped_sizes
       )
 {
    unsigned i;
@@ -918,7 +1031,8 @@ static bool content_file_load(
 
          if (!load_content_into_memory(
                   content_ctx, p_content,
-                  i, path, (void**)&info[i].data, &len))
+                  i, path, (void**)&info[i].data, &len,
+                  &mapped_sizes[i]))
          {
             char msg[1024];
             msg[0]          = '\0';
@@ -1198,6 +1312,7 @@ static bool content_file_init(
 {
    union string_list_elem_attr attr;
    struct retro_game_info               *info = NULL;
+   size_t                       *mapped_sizes = NULL;
    bool subsystem_path_is_empty               = path_is_empty(RARCH_PATH_SUBSYSTEM);
    bool ret                                   = subsystem_path_is_empty;
    const struct retro_subsystem_info *special =
@@ -1214,10 +1329,14 @@ static bool content_file_init(
 #endif
 
    if (content->size > 0)
+   {
       info                   = (struct retro_game_info*)
          calloc(content->size, sizeof(*info));
+      mapped_sizes           = (size_t*)
+         calloc(content->size, sizeof(*mapped_sizes));
+   }
 
-   if (info)
+   if (info && mapped_sizes)
    {
       unsigned i;
       struct string_list additional_path_allocs;
@@ -1227,19 +1346,26 @@ static bool content_file_init(
          ret = content_file_load(info, p_content,
                content, content_ctx, error_enum,
                error_string,
-               special, &additional_path_allocs);
+               special, &additional_path_allocs, mapped_sizes);
          string_list_deinitialize(&additional_path_allocs);
       }
 
       for (i = 0; i < content->size; i++)
-         free((void*)info[i].data);
+         content_file_free((void*)info[i].data, mapped_sizes[i]);
 
       free(info);
+      free(mapped_sizes);
    }
-   else if (!special)
+   else
    {
-      *error_enum   = MSG_ERROR_LIBRETRO_CORE_REQUIRES_CONTENT;
-      return false;
+      free(info);
+      free(mapped_sizes);
+
+      if (!special)
+      {
+         *error_enum   = MSG_ERROR_LIBRETRO_CORE_REQUIRES_CONTENT;
+         return false;
+      }
    }
 
    return ret;
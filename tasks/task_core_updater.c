@@ -27,6 +27,9 @@
 #include <net/net_http.h>
 #include <streams/interface_stream.h>
 #include <streams/file_stream.h>
+#if defined(HAVE_COMPRESSION) && defined(HAVE_ZLIB)
+#include <streams/zip_stream.h>
+#endif
 
 #include "task_file_transfer.h"
 #include "tasks_internal.h"
@@ -91,6 +94,9 @@ typedef struct core_updater_download_handle
    retro_task_t *http_task;
    retro_task_t *decompress_task;
    retro_task_t *backup_task;
+#if defined(HAVE_COMPRESSION) && defined(HAVE_ZLIB)
+   zipstream_t *zip_stream;
+#endif
    size_t auto_backup_history_size;
    uint32_t local_crc;
    uint32_t remote_crc;
@@ -550,6 +556,27 @@ static void cb_decompress_task_core_updater_download(
       RARCH_ERR("[core updater] %s", err);
 }
 
+#if defined(HAVE_COMPRESSION) && defined(HAVE_ZLIB)
+static bool cb_http_task_core_updater_download_body(
+      void *user_data, const uint8_t *data, size_t len)
+{
+   file_transfer_t *transf                         = (file_transfer_t*)user_data;
+   core_updater_download_handle_t *download_handle = NULL;
+
+   if (transf)
+      download_handle = (core_updater_download_handle_t*)transf->user_data;
+
+   /* Extract core while it downloads
+    * NOTE: If this fails, the core is extracted from
+    * the downloaded archive once the transfer ends,
+    * so the transfer always continues */
+   if (download_handle && download_handle->zip_stream)
+      zipstream_write(download_handle->zip_stream, data, len);
+
+   return true;
+}
+#endif
+
 void cb_http_task_core_updater_download(
       retro_task_t *task, void *task_data,
       void *user_data, const char *err)
@@ -561,14 +588,14 @@ void cb_http_task_core_updater_download(
 
    output_dir[0] = '\0';
 
-   if (!data || !transf)
-      goto finish;
-
-   if (!data->data || string_is_empty(transf->path))
+   if (!transf)
       goto finish;
 
    download_handle = (core_updater_download_handle_t*)transf->user_data;
 
+   if (!data || !data->data || string_is_empty(transf->path))
+      goto finish;
+
    if (!download_handle)
       goto finish;
 
@@ -581,6 +608,19 @@ void cb_http_task_core_updater_download(
    download_handle->http_task_complete       = true;
    download_handle->decompress_task_complete = true;
 
+#if defined(HAVE_COMPRESSION) && defined(HAVE_ZLIB)
+   /* If core was extracted while it downloaded,
+    * there is nothing left to do */
+   if (download_handle->zip_stream)
+   {
+      if (zipstream_is_done(download_handle->zip_stream))
+         goto finish;
+
+      RARCH_WARN("[core updater] Failed to extract '%s' while downloading, "
+            "extracting downloaded file instead\n", transf->path);
+   }
+#endif
+
    /* Create output directory, if required */
    strlcpy(output_dir, transf->path, sizeof(output_dir));
    path_basedir_wrapper(output_dir);
@@ -644,6 +684,14 @@ finish:
       RARCH_ERR("[core updater] Download of '%s' failed: %s\n",
             (transf ? transf->path: "unknown"), err);
 
+#if defined(HAVE_COMPRESSION) && defined(HAVE_ZLIB)
+   if (download_handle && download_handle->zip_stream)
+   {
+      zipstream_free(download_handle->zip_stream);
+      download_handle->zip_stream = NULL;
+   }
+#endif
+
    if (data)
    {
       if (data->data)
@@ -826,10 +874,43 @@ static void task_core_updater_download_handler(retro_task_t *task)
 
             transf->user_data = (void*)download_handle;
 
+#if defined(HAVE_COMPRESSION) && defined(HAVE_ZLIB)
+            /* If core is a zip archive, extract it while
+             * it downloads, instead of writing the archive
+             * to disk and extracting it afterwards */
+            if (string_is_equal_noncase(
+                     path_get_extension(transf->path), "zip"))
+            {
+               char output_dir[PATH_MAX_LENGTH];
+
+               output_dir[0] = '\0';
+
+               strlcpy(output_dir, transf->path, sizeof(output_dir));
+               path_basedir_wrapper(output_dir);
+
+               download_handle->zip_stream = zipstream_new(output_dir);
+            }
+
             /* Push HTTP transfer task */
-            download_handle->http_task = (retro_task_t*)task_push_http_transfer_file(
-                  download_handle->remote_core_path, true, NULL,
-                  cb_http_task_core_updater_download, transf);
+            if (download_handle->zip_stream)
+            {
+               download_handle->http_task = (retro_task_t*)
+                     task_push_http_transfer_file_stream(
+                           download_handle->remote_core_path, true, NULL,
+                           cb_http_task_core_updater_download_body,
+                           cb_http_task_core_updater_download, transf);
+
+               if (!download_handle->http_task)
+               {
+                  zipstream_free(download_handle->zip_stream);
+                  download_handle->zip_stream = NULL;
+               }
+            }
+            else
+#endif
+               download_handle->http_task = (retro_task_t*)task_push_http_transfer_file(
+                     download_handle->remote_core_path, true, NULL,
+                     cb_http_task_core_updater_download, transf);
 
             /* Update task title */
             task_free_title(task);
@@ -1089,6 +1170,9 @@ void *task_push_core_updater_download(
    download_handle->decompress_task_complete = false;
    download_handle->backup_enabled           = false;
    download_handle->backup_task              = NULL;
+#if defined(HAVE_COMPRESSION) && defined(HAVE_ZLIB)
+   download_handle->zip_stream               = NULL;
+#endif
    download_handle->status                   = CORE_UPDATER_DOWNLOAD_BEGIN;
 
    /* Concurrent downloads of the same file are not allowed */
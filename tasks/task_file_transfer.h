@@ -78,9 +78,22 @@ typedef struct
    char path[PATH_MAX_LENGTH];
 } file_transfer_t;
 
+/* Receives each part of the body of an HTTP transfer
+ * as it arrives; 'user_data' is the user data of the
+ * transfer task. Returning false fails the transfer */
+typedef bool (*http_body_cb_t)(void *user_data,
+      const uint8_t *data, size_t len);
+
 void* task_push_http_transfer_file(const char* url, bool mute, const char* type,
       retro_task_callback_t cb, file_transfer_t* transfer_data);
 
+/* Same as task_push_http_transfer_file(), but also hands
+ * the body to 'body_cb' while it downloads. The complete
+ * body is still passed to 'cb' when the transfer ends */
+void* task_push_http_transfer_file_stream(const char* url, bool mute,
+      const char* type, http_body_cb_t body_cb,
+      retro_task_callback_t cb, file_transfer_t* transfer_data);
+
 RETRO_END_DECLS
 
 #endif
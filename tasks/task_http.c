@@ -23,6 +23,7 @@
 #include <retro_timers.h>
 
 #ifdef RARCH_INTERNAL
+#include "../configuration.h"
 #include "../gfx/video_display_server.h"
 #endif
 #include "task_file_transfer.h"
@@ -47,12 +48,16 @@ struct http_handle
 {
    struct http_t *handle;
    transfer_cb_t  cb;
+   http_body_cb_t body_cb;
+   size_t body_len;
    struct
    {
       struct http_connection_t *handle;
       transfer_cb_t  cb;
    } connection;
    unsigned status;
+   unsigned max_transfers;
+   bool active;
    bool error;
    char connection_elem[255];
    char connection_url[255];
@@ -61,6 +66,11 @@ struct http_handle
 typedef struct http_transfer_info http_transfer_info_t;
 typedef struct http_handle http_handle_t;
 
+/* Number of transfers that are connected. Only
+ * accessed by task handlers, which all run on the
+ * same thread */
+static unsigned task_http_active_transfers = 0;
+
 static int task_http_con_iterate_transfer(http_handle_t *http)
 {
    if (!net_http_connection_iterate(http->connection.handle))
@@ -107,6 +117,30 @@ static int cb_http_conn_default(void *data_, size_t len)
    return 0;
 }
 
+/* Hands the part of the body received since the
+ * last update to the body callback, if there is one */
+static bool task_http_iterate_body(retro_task_t *task,
+      http_handle_t *http)
+{
+   size_t len    = 0;
+   uint8_t *data = NULL;
+
+   if (!http->body_cb)
+      return true;
+
+   data = net_http_data_received(http->handle, &len);
+
+   if (!data || len <= http->body_len)
+      return true;
+
+   if (!http->body_cb(task->user_data,
+            data + http->body_len, len - http->body_len))
+      return false;
+
+   http->body_len = len;
+   return true;
+}
+
 /**
  * task_http_iterate_transfer:
  *
@@ -119,12 +153,21 @@ static int task_http_iterate_transfer(retro_task_t *task)
 {
    http_handle_t *http  = (http_handle_t*)task->state;
    size_t pos  = 0, tot = 0;
+   bool done   = false;
 
    /* FIXME: This wouldn't be needed if we could wait for a timeout */
    if (task_queue_is_threaded())
       retro_sleep(1);
 
-   if (!net_http_update(http->handle, &pos, &tot))
+   done = net_http_update(http->handle, &pos, &tot);
+
+   if (!task_http_iterate_body(task, http))
+   {
+      http->error = true;
+      return 0;
+   }
+
+   if (!done)
    {
       if (tot == 0)
          task_set_progress(task, -1);
@@ -151,6 +194,13 @@ static void task_http_transfer_handler(retro_task_t *task)
    switch (http->status)
    {
       case HTTP_STATUS_CONNECTION_TRANSFER_PARSE:
+         /* Wait for a running transfer to finish
+          * before connecting */
+         if (     http->max_transfers
+               && task_http_active_transfers >= http->max_transfers)
+            return;
+         http->active = true;
+         task_http_active_transfers++;
          task_http_conn_iterate_transfer_parse(http);
          http->status = HTTP_STATUS_TRANSFER;
          break;
@@ -175,6 +225,9 @@ static void task_http_transfer_handler(retro_task_t *task)
 task_finished:
    task_set_finished(task, true);
 
+   if (http->active)
+      task_http_active_transfers--;
+
    if (http->handle)
    {
       size_t len = 0;
@@ -183,7 +236,9 @@ task_finished:
       if (tmp && http->cb)
          http->cb(tmp, len);
 
-      if (net_http_error(http->handle) || task_get_cancelled(task))
+      if (     http->error
+            || net_http_error(http->handle)
+            || task_get_cancelled(task))
       {
          tmp = (char*)net_http_data(http->handle, &len, true);
 
@@ -254,11 +309,15 @@ static void http_transfer_progress_cb(retro_task_t *task)
 static void* task_push_http_transfer_generic(
       struct http_connection_t *conn,
       const char *url, bool mute, const char *type,
+      http_body_cb_t body_cb,
       retro_task_callback_t cb, void *user_data)
 {
    task_finder_data_t find_data;
    retro_task_t  *t        = NULL;
    http_handle_t *http     = NULL;
+#ifdef RARCH_INTERNAL
+   settings_t *settings    = config_get_ptr();
+#endif
 
    find_data.func          = task_http_finder;
    find_data.userdata      = (void*)url;
@@ -286,7 +345,15 @@ static void* task_push_http_transfer_generic(
    http->connection_url[0]   = '\0';
    http->handle              = NULL;
    http->cb                  = NULL;
+   http->body_cb             = body_cb;
+   http->body_len            = 0;
    http->status              = 0;
+#ifdef RARCH_INTERNAL
+   http->max_transfers       = settings->uints.network_http_max_transfers;
+#else
+   http->max_transfers       = 0;
+#endif
+   http->active              = false;
    http->error               = false;
 
    if (type)
@@ -330,11 +397,11 @@ void* task_push_http_transfer(const char *url, bool mute,
 
    return task_push_http_transfer_generic(
          net_http_connection_new(url, "GET", NULL),
-         url, mute, type, cb, user_data);
+         url, mute, type, NULL, cb, user_data);
 }
 
-void* task_push_http_transfer_file(const char* url, bool mute,
-      const char* type,
+static void* task_push_http_transfer_file_generic(const char* url,
+      bool mute, const char* type, http_body_cb_t body_cb,
       retro_task_callback_t cb, file_transfer_t* transfer_data)
 {
    const char *s   = NULL;
@@ -346,7 +413,7 @@ void* task_push_http_transfer_file(const char* url, bool mute,
 
    t = (retro_task_t*)task_push_http_transfer_generic(
          net_http_connection_new(url, "GET", NULL),
-         url, mute, type, cb, transfer_data);
+         url, mute, type, body_cb, cb, transfer_data);
 
    if (!t)
       return NULL;
@@ -369,6 +436,22 @@ void* task_push_http_transfer_file(const char* url, bool mute,
    return t;
 }
 
+void* task_push_http_transfer_file(const char* url, bool mute,
+      const char* type,
+      retro_task_callback_t cb, file_transfer_t* transfer_data)
+{
+   return task_push_http_transfer_file_generic(url, mute, type,
+         NULL, cb, transfer_data);
+}
+
+void* task_push_http_transfer_file_stream(const char* url, bool mute,
+      const char* type, http_body_cb_t body_cb,
+      retro_task_callback_t cb, file_transfer_t* transfer_data)
+{
+   return task_push_http_transfer_file_generic(url, mute, type,
+         body_cb, cb, transfer_data);
+}
+
 void* task_push_http_transfer_with_user_agent(const char *url, bool mute,
    const char *type, const char* user_agent,
    retro_task_callback_t cb, void *user_data)
@@ -386,7 +469,7 @@ void* task_push_http_transfer_with_user_agent(const char *url, bool mute,
       net_http_connection_set_user_agent(conn, user_agent);
 
    /* assert: task_push_http_transfer_generic will free conn on failure */
-   return task_push_http_transfer_generic(conn, url, mute, type, cb, user_data);
+   return task_push_http_transfer_generic(conn, url, mute, type, NULL, cb, user_data);
 }
 
 void* task_push_http_post_transfer(const char *url,
@@ -397,7 +480,7 @@ void* task_push_http_post_transfer(const char *url,
       return NULL;
    return task_push_http_transfer_generic(
          net_http_connection_new(url, "POST", post_data),
-         url, mute, type, cb, user_data);
+         url, mute, type, NULL, cb, user_data);
 }
 
 void* task_push_http_post_transfer_with_user_agent(const char *url,
@@ -418,7 +501,7 @@ void* task_push_http_post_transfer_with_user_agent(const char *url,
       net_http_connection_set_user_agent(conn, user_agent);
 
    /* assert: task_push_http_transfer_generic will free conn on failure */
-   return task_push_http_transfer_generic(conn, url, mute, type, cb, user_data);
+   return task_push_http_transfer_generic(conn, url, mute, type, NULL, cb, user_data);
 }
 
 task_retriever_info_t *http_task_get_transfer_list(void)
@@ -20,9 +20,11 @@
 /* TODO/FIXME - turn this into actual task */
 
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <boolean.h>
+#include <retro_miscellaneous.h>
 
 #include <compat/msvc.h>
 #include <file/file_path.h>
@@ -31,6 +33,10 @@
 
 #include <encodings/crc32.h>
 
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
 #include "../msg_hash.h"
 #include "../verbosity.h"
 
@@ -69,12 +75,7 @@ struct bps_data
    size_t modify_offset;
    size_t source_offset;
    size_t target_offset;
-   size_t source_relative_offset;
-   size_t target_relative_offset;
    size_t output_offset;
-   uint32_t modify_checksum;
-   uint32_t source_checksum;
-   uint32_t target_checksum;
 };
 
 struct ups_data
@@ -82,49 +83,114 @@ struct ups_data
    const uint8_t *patch_data;
    const uint8_t *source_data;
    uint8_t *target_data;
-   unsigned patch_length;
-   unsigned source_length;
-   unsigned target_length;
-   unsigned patch_offset;
-   unsigned source_offset;
-   unsigned target_offset;
-   unsigned patch_checksum;
-   unsigned source_checksum;
-   unsigned target_checksum;
+   size_t patch_length;
+   size_t source_length;
+   size_t target_length;
+   size_t patch_offset;
+   size_t source_offset;
+   size_t target_offset;
 };
 
+/* CRC32 of a buffer, computed on a thread of its
+ * own while the patch is being applied */
+struct patch_crc
+{
+   const uint8_t *data;
+   size_t length;
+   uint32_t crc;
+#ifdef HAVE_THREADS
+   sthread_t *thread;
+#endif
+};
+
+/* Smaller buffers are not worth a thread */
+#define PATCH_CRC_THREAD_MIN_SIZE (1024 * 1024)
+
 typedef enum patch_error (*patch_func_t)(const uint8_t*, uint64_t,
       const uint8_t*, uint64_t, uint8_t**, uint64_t*);
 
-static uint8_t bps_read(struct bps_data *bps)
+static void patch_crc_run(void *data)
+{
+   struct patch_crc *job = (struct patch_crc*)data;
+   job->crc              = encoding_crc32(0, job->data, job->length);
+}
+
+static void patch_crc_start(struct patch_crc *job,
+      const uint8_t *data, size_t length)
+{
+   job->data   = data;
+   job->length = length;
+   job->crc    = 0;
+#ifdef HAVE_THREADS
+   job->thread = NULL;
+
+   if (     length >= PATCH_CRC_THREAD_MIN_SIZE
+         && (job->thread = sthread_create(patch_crc_run, job)))
+      return;
+#endif
+   patch_crc_run(job);
+}
+
+static uint32_t patch_crc_finish(struct patch_crc *job)
+{
+#ifdef HAVE_THREADS
+   if (job->thread)
+   {
+      sthread_join(job->thread);
+      job->thread = NULL;
+   }
+#endif
+   return job->crc;
+}
+
+static uint32_t patch_read_le32(const uint8_t *data)
 {
-   uint8_t data         = bps->modify_data[bps->modify_offset++];
-   bps->modify_checksum = ~(encoding_crc32(
-         ~bps->modify_checksum, &data, 1));
-   return data;
+   return  (uint32_t)data[0]
+         | ((uint32_t)data[1] << 8)
+         | ((uint32_t)data[2] << 16)
+         | ((uint32_t)data[3] << 24);
 }
 
-static uint64_t bps_decode(struct bps_data *bps)
+/* Numbers are read up to the 12 byte footer
+ * of the patch, which holds the checksums */
+static bool bps_decode(struct bps_data *bps, uint64_t *value)
 {
    uint64_t data = 0, shift = 1;
+   size_t end    = bps->modify_length - 12;
 
-   for (;;)
+   while (bps->modify_offset < end)
    {
-      uint8_t x  = bps_read(bps);
+      uint8_t x  = bps->modify_data[bps->modify_offset++];
       data      += (x & 0x7f) * shift;
       if (x & 0x80)
+      {
+         *value = data;
+         return true;
+      }
+      if (shift > ((uint64_t)1 << 56))
          break;
       shift    <<= 7;
       data      += shift;
    }
 
-   return data;
+   return false;
 }
 
-static void bps_write(struct bps_data *bps, uint8_t data)
+/* Copies from earlier in the target. Where the copy
+ * overlaps its own output, it repeats the bytes between
+ * 'from' and 'to', which is done in runs that double in
+ * length instead of byte by byte. */
+static void bps_copy_target(uint8_t *target,
+      size_t from, size_t to, size_t length)
 {
-   bps->target_data[bps->output_offset++] = data;
-   bps->target_checksum = ~(encoding_crc32(~bps->target_checksum, &data, 1));
+   while (length)
+   {
+      size_t run = MIN(length, to - from);
+
+      memcpy(target + to, target + from, run);
+      to     += run;
+      length -= run;
+   }
 }
 
 static enum patch_error bps_apply_patch(
@@ -132,47 +198,45 @@ static enum patch_error bps_apply_patch(
       const uint8_t *source_data, uint64_t source_length,
       uint8_t **target_data, uint64_t *target_length)
 {
-   size_t i;
    struct bps_data bps;
-   uint32_t checksum               = 0;
-   size_t modify_source_size       = 0;
-   size_t modify_target_size       = 0;
-   size_t modify_markup_size       = 0;
+   struct patch_crc source_crc;
+   struct patch_crc modify_crc;
+   size_t end;
+   uint32_t target_checksum        = 0;
+   uint64_t modify_source_size     = 0;
+   uint64_t modify_target_size     = 0;
+   uint64_t modify_markup_size     = 0;
    uint32_t modify_source_checksum = 0;
    uint32_t modify_target_checksum = 0;
    uint32_t modify_modify_checksum = 0;
+   enum patch_error err            = PATCH_SUCCESS;
 
    if (modify_length < 19)
       return PATCH_PATCH_TOO_SMALL;
 
+   if (memcmp(modify_data, "BPS1", 4))
+      return PATCH_PATCH_INVALID_HEADER;
+
    bps.modify_data            = modify_data;
    bps.source_data            = source_data;
    bps.target_data            = *target_data;
-   bps.modify_length          = modify_length;
-   bps.source_length          = source_length;
-   bps.target_length          = *target_length;
-   bps.modify_offset          = 0;
+   bps.modify_length          = (size_t)modify_length;
+   bps.source_length          = (size_t)source_length;
+   bps.target_length          = (size_t)*target_length;
+   bps.modify_offset          = 4;
    bps.source_offset          = 0;
    bps.target_offset          = 0;
-   bps.modify_checksum        = ~0;
-   bps.source_checksum        = 0;
-   bps.target_checksum        = ~0;
-   bps.source_relative_offset = 0;
-   bps.target_relative_offset = 0;
    bps.output_offset          = 0;
+   end                        = bps.modify_length - 12;
 
-   if (  (bps_read(&bps) != 'B') ||
-         (bps_read(&bps) != 'P') ||
-         (bps_read(&bps) != 'S') ||
-         (bps_read(&bps) != '1'))
-      return PATCH_PATCH_INVALID_HEADER;
-
-   modify_source_size  = bps_decode(&bps);
-   modify_target_size  = bps_decode(&bps);
-   modify_markup_size  = bps_decode(&bps);
+   if (     !bps_decode(&bps, &modify_source_size)
+         || !bps_decode(&bps, &modify_target_size)
+         || !bps_decode(&bps, &modify_markup_size)
+         || modify_markup_size > end - bps.modify_offset
+         || modify_target_size > SIZE_MAX)
+      return PATCH_PATCH_INVALID;
 
-   for (i = 0; i < modify_markup_size; i++)
-      bps_read(&bps);
+   bps.modify_offset += (size_t)modify_markup_size;
 
    if (modify_source_size > bps.source_length)
       return PATCH_SOURCE_TOO_SMALL;
@@ -187,137 +251,205 @@ static enum patch_error bps_apply_patch(
       free(*target_data);
       bps.target_data   = prov;
       *target_data      = prov;
-      bps.target_length = modify_target_size;
+      bps.target_length = (size_t)modify_target_size;
    }
 
-   while (bps.modify_offset < bps.modify_length - 12)
+   /* The patch itself is checked without its own checksum */
+   patch_crc_start(&source_crc, bps.source_data, bps.source_length);
+   patch_crc_start(&modify_crc, bps.modify_data, bps.modify_length - 4);
+
+   while (bps.modify_offset < end)
    {
-      size_t length = bps_decode(&bps);
-      unsigned mode = length & 3;
+      uint64_t data;
+      size_t length;
+      unsigned mode;
+
+      if (!bps_decode(&bps, &data))
+      {
+         err = PATCH_PATCH_INVALID;
+         break;
+      }
 
-      length = (length >> 2) + 1;
+      mode   = data & 3;
+      data   = (data >> 2) + 1;
+
+      if (data > modify_target_size - bps.output_offset)
+      {
+         err = PATCH_PATCH_INVALID;
+         break;
+      }
+
+      length = (size_t)data;
 
       switch (mode)
       {
          case SOURCE_READ:
-            while (length--)
-               bps_write(&bps, bps.source_data[bps.output_offset]);
+            if (     bps.output_offset > bps.source_length
+                  || length > bps.source_length - bps.output_offset)
+               err = PATCH_PATCH_INVALID;
+            else
+               memcpy(bps.target_data + bps.output_offset,
+                     bps.source_data + bps.output_offset, length);
             break;
 
          case TARGET_READ:
-            while (length--)
-               bps_write(&bps, bps_read(&bps));
+            if (length > end - bps.modify_offset)
+               err = PATCH_PATCH_INVALID;
+            else
+            {
+               memcpy(bps.target_data + bps.output_offset,
+                     bps.modify_data + bps.modify_offset, length);
+               bps.modify_offset += length;
+            }
             break;
 
          case SOURCE_COPY:
          case TARGET_COPY:
          {
-            int    offset = (int)bps_decode(&bps);
-            bool negative = offset & 1;
-
-            offset >>= 1;
+            uint64_t offset;
+            size_t *copy_offset = (mode == SOURCE_COPY)
+               ? &bps.source_offset : &bps.target_offset;
+            /* Target copies may not read what is not written yet */
+            size_t copy_limit   = (mode == SOURCE_COPY)
+               ? bps.source_length : bps.output_offset;
+
+            if (!bps_decode(&bps, &offset))
+            {
+               err = PATCH_PATCH_INVALID;
+               break;
+            }
 
-            if (negative)
-               offset = -offset;
+            if (offset & 1)
+            {
+               if ((offset >> 1) > *copy_offset)
+               {
+                  err = PATCH_PATCH_INVALID;
+                  break;
+               }
+               *copy_offset -= (size_t)(offset >> 1);
+            }
+            else
+            {
+               if ((offset >> 1) > copy_limit - MIN(*copy_offset, copy_limit))
+               {
+                  err = PATCH_PATCH_INVALID;
+                  break;
+               }
+               *copy_offset += (size_t)(offset >> 1);
+            }
 
             if (mode == SOURCE_COPY)
             {
-               bps.source_offset += offset;
-               while (length--)
-                  bps_write(&bps, bps.source_data[bps.source_offset++]);
+               if (     *copy_offset > copy_limit
+                     || length > copy_limit - *copy_offset)
+               {
+                  err = PATCH_PATCH_INVALID;
+                  break;
+               }
+               memcpy(bps.target_data + bps.output_offset,
+                     bps.source_data + *copy_offset, length);
             }
             else
             {
-               bps.target_offset += offset;
-               while (length--)
-                  bps_write(&bps, bps.target_data[bps.target_offset++]);
-               break;
+               if (*copy_offset >= copy_limit)
+               {
+                  err = PATCH_PATCH_INVALID;
+                  break;
+               }
+               bps_copy_target(bps.target_data, *copy_offset,
+                     bps.output_offset, length);
             }
+
+            *copy_offset += length;
             break;
          }
       }
+
+      if (err != PATCH_SUCCESS)
+         break;
+
+      bps.output_offset += length;
    }
 
-   for (i = 0; i < 32; i += 8)
-      modify_source_checksum |= bps_read(&bps) << i;
-   for (i = 0; i < 32; i += 8)
-      modify_target_checksum |= bps_read(&bps) << i;
+   modify_source_checksum = patch_read_le32(bps.modify_data + end);
+   modify_target_checksum = patch_read_le32(bps.modify_data + end + 4);
+   modify_modify_checksum = patch_read_le32(bps.modify_data + end + 8);
 
-   checksum = ~bps.modify_checksum;
-   for (i = 0; i < 32; i += 8)
-      modify_modify_checksum |= bps_read(&bps) << i;
+   if (err == PATCH_SUCCESS)
+      target_checksum     = encoding_crc32(0,
+            bps.target_data, bps.output_offset);
 
-   bps.source_checksum = encoding_crc32(0,
-         bps.source_data, bps.source_length);
-   bps.target_checksum = ~bps.target_checksum;
+   /* Always wait for the threads */
+   if (     patch_crc_finish(&source_crc) != modify_source_checksum
+         && err == PATCH_SUCCESS)
+      err = PATCH_SOURCE_CHECKSUM_INVALID;
 
-   if (bps.source_checksum != modify_source_checksum)
-      return PATCH_SOURCE_CHECKSUM_INVALID;
+   if (     patch_crc_finish(&modify_crc) != modify_modify_checksum
+         && err == PATCH_SUCCESS)
+      err = PATCH_PATCH_CHECKSUM_INVALID;
 
-   if (bps.target_checksum != modify_target_checksum)
-      return PATCH_TARGET_CHECKSUM_INVALID;
+   if (err != PATCH_SUCCESS)
+      return err;
 
-   if (checksum != modify_modify_checksum)
-      return PATCH_PATCH_CHECKSUM_INVALID;
+   if (     bps.output_offset != modify_target_size
+         || target_checksum   != modify_target_checksum)
+      return PATCH_TARGET_CHECKSUM_INVALID;
 
    *target_length = modify_target_size;
 
    return PATCH_SUCCESS;
 }
 
-static uint8_t ups_patch_read(struct ups_data *data)
+/* Numbers are read up to the 12 byte footer
+ * of the patch, which holds the checksums */
+static bool ups_decode(struct ups_data *data, uint64_t *value)
 {
-   if (data && data->patch_offset < data->patch_length)
-   {
-      uint8_t n = data->patch_data[data->patch_offset++];
-      data->patch_checksum =
-         ~(encoding_crc32(~data->patch_checksum, &n, 1));
-      return n;
-   }
-   return 0x00;
-}
+   uint64_t offset = 0, shift = 1;
+   size_t end      = data->patch_length - 12;
 
-static uint8_t ups_source_read(struct ups_data *data)
-{
-   if (data && data->source_offset < data->source_length)
+   while (data->patch_offset < end)
    {
-      uint8_t n = data->source_data[data->source_offset++];
-      data->source_checksum =
-         ~(encoding_crc32(~data->source_checksum, &n, 1));
-      return n;
-   }
-   return 0x00;
-}
-
-static void ups_target_write(struct ups_data *data, uint8_t n)
-{
+      uint8_t x = data->patch_data[data->patch_offset++];
+      offset   += (x & 0x7f) * shift;
 
-   if (data && data->target_offset < data->target_length)
-   {
-      data->target_data[data->target_offset] = n;
-      data->target_checksum =
-         ~(encoding_crc32(~data->target_checksum, &n, 1));
+      if (x & 0x80)
+      {
+         *value = offset;
+         return true;
+      }
+      if (shift > ((uint64_t)1 << 56))
+         break;
+      shift <<= 7;
+      offset += shift;
    }
 
-   if (data)
-      data->target_offset++;
+   return false;
 }
 
-static uint64_t ups_decode(struct ups_data *data)
+/* Copies 'length' bytes of the source to the target.
+ * The source reads as zeroes past its end, and bytes
+ * past the end of the target are dropped. */
+static void ups_copy(struct ups_data *data, size_t length)
 {
-   uint64_t offset = 0, shift = 1;
+   size_t source_left = data->source_length - data->source_offset;
+   size_t target_left = (data->target_offset < data->target_length)
+      ? data->target_length - data->target_offset : 0;
+   size_t from_source = MIN(length, source_left);
+   size_t to_target   = MIN(length, target_left);
 
-   for (;;)
-   {
-      uint8_t x = ups_patch_read(data);
-      offset   += (x & 0x7f) * shift;
+   if (from_source > to_target)
+      from_source = to_target;
 
-      if (x & 0x80)
-         break;
-      shift <<= 7;
-      offset += shift;
+   if (to_target)
+   {
+      memcpy(data->target_data + data->target_offset,
+            data->source_data + data->source_offset, from_source);
+      memset(data->target_data + data->target_offset + from_source,
+            0, to_target - from_source);
    }
-   return offset;
+
+   data->source_offset += MIN(length, source_left);
+   data->target_offset += length;
 }
 
 static enum patch_error ups_apply_patch(
@@ -325,42 +457,42 @@ static enum patch_error ups_apply_patch(
       const uint8_t *sourcedata, uint64_t sourcelength,
       uint8_t **targetdata, uint64_t *targetlength)
 {
-   size_t i;
+   size_t end;
    struct ups_data data;
-   unsigned source_read_length;
-   unsigned target_read_length;
-   uint32_t patch_result_checksum = 0;
+   struct patch_crc source_crc;
+   struct patch_crc patch_crc;
+   uint64_t source_read_length;
+   uint64_t target_read_length;
+   uint32_t source_checksum;
+   uint32_t target_checksum       = 0;
    uint32_t patch_read_checksum   = 0;
    uint32_t source_read_checksum  = 0;
    uint32_t target_read_checksum  = 0;
+   bool valid                     = true;
 
    data.patch_data      = patchdata;
    data.source_data     = sourcedata;
    data.target_data     = *targetdata;
-   data.patch_length    = (unsigned)patchlength;
-   data.source_length   = (unsigned)sourcelength;
-   data.target_length   = (unsigned)*targetlength;
-   data.patch_offset    = 0;
+   data.patch_length    = (size_t)patchlength;
+   data.source_length   = (size_t)sourcelength;
+   data.target_length   = (size_t)*targetlength;
+   data.patch_offset    = 4;
    data.source_offset   = 0;
    data.target_offset   = 0;
-   data.patch_checksum  = ~0;
-   data.source_checksum = ~0;
-   data.target_checksum = ~0;
 
    if (data.patch_length < 18)
       return PATCH_PATCH_INVALID;
 
-   if (
-         (ups_patch_read(&data) != 'U') ||
-         (ups_patch_read(&data) != 'P') ||
-         (ups_patch_read(&data) != 'S') ||
-         (ups_patch_read(&data) != '1')
-      )
+   if (memcmp(patchdata, "UPS1", 4))
       return PATCH_PATCH_INVALID;
 
-   source_read_length = (unsigned)ups_decode(&data);
-   target_read_length = (unsigned)ups_decode(&data);
+   end = data.patch_length - 12;
+
+   if (     !ups_decode(&data, &source_read_length)
+         || !ups_decode(&data, &target_read_length))
+      return PATCH_PATCH_INVALID;
 
+   /* Patches apply both ways */
    if (     (data.source_length != source_read_length)
          && (data.source_length != target_read_length))
       return PATCH_SOURCE_INVALID;
@@ -368,6 +500,9 @@ static enum patch_error ups_apply_patch(
    *targetlength = (data.source_length == source_read_length ?
          target_read_length : source_read_length);
 
+   if (*targetlength > SIZE_MAX)
+      return PATCH_TARGET_ALLOC_FAILED;
+
    if (data.target_length < *targetlength)
    {
       uint8_t *prov=(uint8_t*)malloc((size_t)*targetlength);
@@ -378,56 +513,74 @@ static enum patch_error ups_apply_patch(
       data.target_data = prov;
    }
 
-   data.target_length = (unsigned)*targetlength;
-   
-   while (data.patch_offset < data.patch_length - 12)
+   data.target_length = (size_t)*targetlength;
+
+   /* The patch itself is checked without its own checksum */
+   patch_crc_start(&source_crc, data.source_data, data.source_length);
+   patch_crc_start(&patch_crc, data.patch_data, data.patch_length - 4);
+
+   while (data.patch_offset < end)
    {
-      unsigned length = (unsigned)ups_decode(&data);
-      while (length--)
-         ups_target_write(&data, ups_source_read(&data));
+      uint64_t length;
+
+      if (     !ups_decode(&data, &length)
+            || length > SIZE_MAX - data.target_offset)
+      {
+         valid = false;
+         break;
+      }
 
+      ups_copy(&data, (size_t)length);
+
+      /* Bytes that differ, up to and including a 0 */
       for (;;)
       {
-         uint8_t patch_xor = ups_patch_read(&data);
-         ups_target_write(&data, patch_xor ^ ups_source_read(&data));
+         uint8_t patch_xor = (data.patch_offset < end)
+            ? data.patch_data[data.patch_offset++] : 0;
+         uint8_t source    = (data.source_offset < data.source_length)
+            ? data.source_data[data.source_offset++] : 0;
+
+         if (data.target_offset < data.target_length)
+            data.target_data[data.target_offset] = patch_xor ^ source;
+         data.target_offset++;
+
          if (patch_xor == 0)
             break;
       }
    }
 
-   while (data.source_offset < data.source_length)
-      ups_target_write(&data, ups_source_read(&data));
-   while (data.target_offset < data.target_length)
-      ups_target_write(&data, ups_source_read(&data));
+   /* The rest of the target is the rest of the source */
+   if (valid && data.target_offset < data.target_length)
+      ups_copy(&data, data.target_length - data.target_offset);
 
-   for (i = 0; i < 4; i++)
-      source_read_checksum |= ups_patch_read(&data) << (i * 8);
-   for (i = 0; i < 4; i++)
-      target_read_checksum |= ups_patch_read(&data) << (i * 8);
+   source_read_checksum  = patch_read_le32(data.patch_data + end);
+   target_read_checksum  = patch_read_le32(data.patch_data + end + 4);
+   patch_read_checksum   = patch_read_le32(data.patch_data + end + 8);
 
-   patch_result_checksum = ~data.patch_checksum;
-   data.source_checksum  = ~data.source_checksum;
-   data.target_checksum  = ~data.target_checksum;
+   if (valid)
+      target_checksum    = encoding_crc32(0,
+            data.target_data, data.target_length);
 
-   for (i = 0; i < 4; i++)
-      patch_read_checksum |= ups_patch_read(&data) << (i * 8);
+   /* Always wait for the threads */
+   source_checksum       = patch_crc_finish(&source_crc);
 
-   if (patch_result_checksum != patch_read_checksum)
+   if (     patch_crc_finish(&patch_crc) != patch_read_checksum
+         || !valid)
       return PATCH_PATCH_INVALID;
 
-   if (     data.source_checksum == source_read_checksum
-         && data.source_length   == source_read_length)
+   if (     source_checksum    == source_read_checksum
+         && data.source_length == source_read_length)
    {
-      if (     data.target_checksum == target_read_checksum
-            && data.target_length   == target_read_length)
+      if (     target_checksum    == target_read_checksum
+            && data.target_length == target_read_length)
          return PATCH_SUCCESS;
       return PATCH_TARGET_INVALID;
    }
-   else if (data.source_checksum == target_read_checksum
-         && data.source_length   == target_read_length)
+   else if (source_checksum    == target_read_checksum
+         && data.source_length == target_read_length)
    {
-      if (     data.target_checksum == source_read_checksum
-            && data.target_length   == source_read_length)
+      if (     target_checksum    == source_read_checksum
+            && data.target_length == source_read_length)
          return PATCH_SUCCESS;
       return PATCH_TARGET_INVALID;
    }
@@ -441,8 +594,10 @@ static enum patch_error ips_alloc_targetdata(
       uint8_t **targetdata, uint64_t *targetlength)
 {
    uint8_t *prov_alloc;
-   uint32_t offset = 5;
-   *targetlength   = sourcelength;
+   uint64_t offset    = 5;
+   /* Records may write past a truncated end */
+   uint64_t alloc_len = sourcelength;
+   *targetlength      = sourcelength;
 
    for (;;)
    {
@@ -458,25 +613,30 @@ static enum patch_error ips_alloc_targetdata(
 
       if (address == 0x454f46) /* EOF */
       {
-         if (offset == patchlen)
-         {
-            prov_alloc     = (uint8_t*)malloc((size_t)*targetlength);
-            if (!prov_alloc)
-               return PATCH_TARGET_ALLOC_FAILED;
-            free(*targetdata);
-            *targetdata    = prov_alloc;
-            return PATCH_SUCCESS;
-         }
-         else if (offset == patchlen - 3)
+         if (offset == patchlen - 3)
          {
             uint32_t size  = patchdata[offset++] << 16;
             size          |= patchdata[offset++] << 8;
             size          |= patchdata[offset++] << 0;
             *targetlength  = size;
-            prov_alloc     = (uint8_t*)malloc((size_t)*targetlength);
+            if (size > alloc_len)
+               alloc_len   = size;
+         }
+
+         if (offset == patchlen)
+         {
+            if (alloc_len > SIZE_MAX - 1)
+               return PATCH_TARGET_ALLOC_FAILED;
 
+            prov_alloc     = (uint8_t*)malloc((size_t)alloc_len + 1);
             if (!prov_alloc)
                return PATCH_TARGET_ALLOC_FAILED;
+
+            /* Gaps between the source and records are zeroes */
+            if (alloc_len > sourcelength)
+               memset(prov_alloc + sourcelength, 0,
+                     (size_t)(alloc_len - sourcelength));
+
             free(*targetdata);
             *targetdata    = prov_alloc;
             return PATCH_SUCCESS;
@@ -491,14 +651,10 @@ static enum patch_error ips_alloc_targetdata(
 
       if (length) /* Copy */
       {
-         if (offset > patchlen - length)
+         if (length > patchlen - offset)
             break;
 
-         while (length--)
-         {
-            address++;
-            offset++;
-         }
+         offset  += length;
       }
       else /* RLE */
       {
@@ -511,14 +667,13 @@ static enum patch_error ips_alloc_targetdata(
          if (length == 0) /* Illegal */
             break;
 
-         while (length--)
-            address++;
-
          offset++;
       }
 
-      if (address > *targetlength)
-         *targetlength = address;
+      if ((uint64_t)address + length > alloc_len)
+         alloc_len = (uint64_t)address + length;
+      if ((uint64_t)address + length > *targetlength)
+         *targetlength = (uint64_t)address + length;
    }
 
    return PATCH_PATCH_INVALID;
@@ -529,7 +684,7 @@ static enum patch_error ips_apply_patch(
       const uint8_t *sourcedata, uint64_t sourcelength,
       uint8_t **targetdata, uint64_t *targetlength)
 {
-   uint32_t offset = 5;
+   uint64_t offset = 5;
    enum patch_error error_patch = PATCH_UNKNOWN;
    if (  patchlen      < 8   ||
          patchdata[0] != 'P' ||
@@ -539,6 +694,7 @@ static enum patch_error ips_apply_patch(
          patchdata[4] != 'H')
       return PATCH_PATCH_INVALID;
    
+   /* Also checks that every record fits */
    if ((error_patch = ips_alloc_targetdata(
                patchdata, patchlen, sourcelength,
                targetdata, targetlength)) != PATCH_SUCCESS)
@@ -551,56 +707,31 @@ static enum patch_error ips_apply_patch(
       uint32_t address;
       unsigned length;
 
-      if (offset > patchlen - 3)
-         break;
-
       address  = patchdata[offset++] << 16;
       address |= patchdata[offset++] << 8;
       address |= patchdata[offset++] << 0;
 
       if (address == 0x454f46) /* EOF */
       {
-         if (offset == patchlen)
-            return PATCH_SUCCESS;
-
-         if (offset == patchlen - 3)
-         {
-            uint32_t size  = patchdata[offset++] << 16;
-            size          |= patchdata[offset++] << 8;
-            size          |= patchdata[offset++] << 0;
+         if (     offset == patchlen
+               || offset == patchlen - 3)
             return PATCH_SUCCESS;
-         }
       }
 
-      if (offset > patchlen - 2)
-         break;
-
       length  = patchdata[offset++] << 8;
       length |= patchdata[offset++] << 0;
 
       if (length) /* Copy */
       {
-         if (offset > patchlen - length)
-            break;
-
-         while (length--)
-            (*targetdata)[address++] = patchdata[offset++];
+         memcpy(*targetdata + address, patchdata + offset, length);
+         offset += length;
       }
       else /* RLE */
       {
-         if (offset > patchlen - 3)
-            break;
-
          length  = patchdata[offset++] << 8;
          length |= patchdata[offset++] << 0;
 
-         if (length == 0) /* Illegal */
-            break;
-
-         while (length--)
-            (*targetdata)[address++] = patchdata[offset];
-
-         offset++;
+         memset(*targetdata + address, patchdata[offset++], length);
       }
    }
 
@@ -623,16 +754,19 @@ static bool apply_patch_content(uint8_t **buf,
    if ((err = func((const uint8_t*)patch_data, patch_size, ret_buf,
          ret_size, &patched_content, &target_size)) == PATCH_SUCCESS)
    {
-      free(ret_buf);
       *buf  = patched_content;
       *size = target_size;
    }
    else
+   {
+      /* The target may have been allocated already */
+      free(patched_content);
       RARCH_ERR("%s %s: %s #%u\n",
             msg_hash_to_str(MSG_FAILED_TO_PATCH),
             patch_desc,
             msg_hash_to_str(MSG_ERROR),
             (unsigned)err);
+   }
 
    return true;
 }
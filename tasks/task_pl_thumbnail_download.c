@@ -49,6 +49,10 @@ enum pl_thumb_status
    PL_THUMB_END
 };
 
+/* Number of thumbnail transfers kept pending when
+ * there is no limit on concurrent HTTP transfers */
+#define PL_THUMB_MAX_PENDING_TRANSFERS 16
+
 typedef struct pl_thumb_handle
 {
    char *system;
@@ -56,20 +60,24 @@ typedef struct pl_thumb_handle
    char *dir_thumbnails;
    playlist_t *playlist;
    gfx_thumbnail_path_data_t *thumbnail_path_data;
-   retro_task_t *http_task;
 
    playlist_config_t playlist_config; /* size_t alignment */
 
    size_t list_size;
    size_t list_index;
    unsigned type_idx;
+   /* Transfers are pushed by the task handler and
+    * completed by the http task callback; each counter
+    * is only written on one side */
+   unsigned http_tasks_pushed;
+   unsigned http_tasks_complete;
+   unsigned max_pending_transfers;
 
    enum pl_thumb_status status;
 
    bool overwrite;
    bool right_thumbnail_exists;
    bool left_thumbnail_exists;
-   bool http_task_complete;
 } pl_thumb_handle_t;
 
 typedef struct pl_entry_id
@@ -181,20 +189,12 @@ void cb_http_task_download_pl_thumbnail(
    pl_thumb_handle_t *pl_thumb = NULL;
    output_dir[0]               = '\0';
 
-   /* Update pl_thumb task status
-    * > Do this first, to minimise the risk of hanging
-    *   the parent task in the event of an http error */
+   /* Sanity checks... */
    if (!transf)
       goto finish;
 
    pl_thumb = (pl_thumb_handle_t*)transf->user_data;
 
-   if (!pl_thumb)
-      goto finish;
-
-   pl_thumb->http_task_complete = true;
-
-   /* Remaining sanity checks... */
    if (!data)
       goto finish;
 
@@ -236,6 +236,33 @@ finish:
 
    if (transf)
       free(transf);
+
+   /* Update pl_thumb task status
+    * > Done on every path, so that the parent task
+    *   never hangs in the event of an http error */
+   if (pl_thumb)
+      pl_thumb->http_tasks_complete++;
+}
+
+/* Returns the number of thumbnail transfers that
+ * have been pushed but whose callback has not run yet */
+static unsigned pl_thumb_pending_transfers(pl_thumb_handle_t *pl_thumb)
+{
+   return pl_thumb->http_tasks_pushed - pl_thumb->http_tasks_complete;
+}
+
+/* Reads the transfer limit from the settings. Twice
+ * as many transfers as can run are kept pending, so
+ * that the next one is ready to connect as soon as a
+ * running one finishes */
+static unsigned pl_thumb_max_pending_transfers(settings_t *settings)
+{
+   unsigned max_transfers = settings->uints.network_http_max_transfers;
+
+   if (!max_transfers || max_transfers > PL_THUMB_MAX_PENDING_TRANSFERS / 2)
+      return PL_THUMB_MAX_PENDING_TRANSFERS;
+
+   return max_transfers * 2;
 }
 
 /* Download thumbnail of the current type for the current
@@ -262,9 +289,6 @@ static void download_pl_thumbnail(pl_thumb_handle_t *pl_thumb)
          if (!transf)
             return; /* If this happens then everything is broken anyway... */
 
-         /* Initialise http task status */
-         pl_thumb->http_task_complete = false;
-
          transf->enum_idx             = MSG_UNKNOWN;
          transf->path[0]              = '\0';
          /* Initialise file transfer */
@@ -274,13 +298,13 @@ static void download_pl_thumbnail(pl_thumb_handle_t *pl_thumb)
          /* Note: We don't actually care if this fails since that
           * just means the file is missing from the server, so it's
           * not something we can handle here... */
-         pl_thumb->http_task = (retro_task_t*)task_push_http_transfer_file(
-               url, true, NULL, cb_http_task_download_pl_thumbnail, transf);
-
-         /* ...if it does fail, however, we can immediately
-          * signal that the task is 'complete' */
-         if (!pl_thumb->http_task)
-            pl_thumb->http_task_complete = true;
+         if (task_push_http_transfer_file(
+               url, true, NULL, cb_http_task_download_pl_thumbnail, transf))
+            pl_thumb->http_tasks_pushed++;
+         /* ...if it does fail, however, the callback
+          * will never be called */
+         else
+            free(transf);
       }
    }
 }
@@ -403,22 +427,15 @@ static void task_pl_thumbnail_download_handler(retro_task_t *task)
          }
          break;
       case PL_THUMB_ITERATE_TYPE:
-         /* Ensure that we only enqueue one transfer
-          * at a time... */
-
-         /* > If HTTP task is NULL, then it either finished
-          *   or an error occurred - in either case,
-          *   current task is 'complete' */
-         if (!pl_thumb->http_task)
-            pl_thumb->http_task_complete = true;
-
-         /* > Wait for task_push_http_transfer_file()
-          *   callback to trigger */
-         if (!pl_thumb->http_task_complete)
+         /* Keep several transfers pending, so that the
+          * next requests are sent while earlier ones are
+          * still being answered...
+          * > Wait for task_push_http_transfer_file()
+          *   callbacks to trigger once enough are pending */
+         if (pl_thumb_pending_transfers(pl_thumb)
+               >= pl_thumb->max_pending_transfers)
             break;
 
-         pl_thumb->http_task = NULL;
-
          /* Check whether all thumbnail types have been processed */
          if (pl_thumb->type_idx > 3)
          {
@@ -447,6 +464,11 @@ static void task_pl_thumbnail_download_handler(retro_task_t *task)
    
 task_finished:
    
+   /* Pending transfers still refer to the handle,
+    * so wait for their callbacks to trigger */
+   if (pl_thumb && pl_thumb_pending_transfers(pl_thumb))
+      return;
+   
    if (task)
       task_set_finished(task, true);
    
@@ -476,12 +498,13 @@ bool task_push_pl_thumbnail_download(
       const char *dir_thumbnails)
 {
    task_finder_data_t find_data;
+   settings_t *settings          = config_get_ptr();
    const char *playlist_file     = NULL;
    retro_task_t *task            = task_init();
    pl_thumb_handle_t *pl_thumb   = (pl_thumb_handle_t*)calloc(1, sizeof(pl_thumb_handle_t));
    
    /* Sanity check */
-   if (!playlist_config || !task || !pl_thumb)
+   if (!settings || !playlist_config || !task || !pl_thumb)
       goto error;
    
    if (string_is_empty(system) ||
@@ -523,11 +546,13 @@ bool task_push_pl_thumbnail_download(
    pl_thumb->dir_thumbnails      = strdup(dir_thumbnails);
    pl_thumb->playlist            = NULL;
    pl_thumb->thumbnail_path_data = NULL;
-   pl_thumb->http_task           = NULL;
-   pl_thumb->http_task_complete  = false;
    pl_thumb->list_size           = 0;
    pl_thumb->list_index          = 0;
    pl_thumb->type_idx            = 1;
+   pl_thumb->http_tasks_pushed   = 0;
+   pl_thumb->http_tasks_complete = 0;
+   pl_thumb->max_pending_transfers =
+         pl_thumb_max_pending_transfers(settings);
    pl_thumb->overwrite           = false;
    pl_thumb->status              = PL_THUMB_BEGIN;
    
@@ -704,20 +729,10 @@ static void task_pl_entry_thumbnail_download_handler(retro_task_t *task)
          break;
       case PL_THUMB_ITERATE_TYPE:
          {
-            /* Ensure that we only enqueue one transfer
-             * at a time... */
-            
-            /* > If HTTP task is NULL, then it either finished
-             *   or an error occurred - in either case,
-             *   current task is 'complete' */
-            if (!pl_thumb->http_task)
-               pl_thumb->http_task_complete = true;
-            
-            /* > Wait for task_push_http_transfer_file()
-             *   callback to trigger */
-            if (pl_thumb->http_task_complete)
-               pl_thumb->http_task = NULL;
-            else
+            /* Request all thumbnail types at once, unless
+             * transfers are limited to fewer than that */
+            if (pl_thumb_pending_transfers(pl_thumb)
+                  >= pl_thumb->max_pending_transfers)
                break;
             
             /* Check whether all thumbnail types have been processed */
@@ -747,6 +762,11 @@ static void task_pl_entry_thumbnail_download_handler(retro_task_t *task)
    
 task_finished:
    
+   /* Pending transfers still refer to the handle, and
+    * the menu must only be refreshed once they are done */
+   if (pl_thumb && pl_thumb_pending_transfers(pl_thumb))
+      return;
+   
    if (task)
       task_set_finished(task, true);
 }
@@ -853,11 +873,13 @@ bool task_push_pl_entry_thumbnail_download(
    pl_thumb->dir_thumbnails      = strdup(dir_thumbnails);
    pl_thumb->playlist            = NULL;
    pl_thumb->thumbnail_path_data = thumbnail_path_data;
-   pl_thumb->http_task           = NULL;
-   pl_thumb->http_task_complete  = false;
    pl_thumb->list_size           = playlist_size(playlist);
    pl_thumb->list_index          = idx;
    pl_thumb->type_idx            = 1;
+   pl_thumb->http_tasks_pushed   = 0;
+   pl_thumb->http_tasks_complete = 0;
+   pl_thumb->max_pending_transfers =
+         pl_thumb_max_pending_transfers(settings);
    pl_thumb->overwrite           = overwrite;
    pl_thumb->status              = PL_THUMB_BEGIN;
    
@@ -182,6 +182,9 @@ bool task_push_overlay_load_default(
       void *user_data);
 #endif
 
+/* Once a patch is applied, *buf points to a newly
+ * allocated buffer holding the patched content; the
+ * caller still owns the unpatched content. */
 bool patch_content(
       bool is_ips_pref,
       bool is_bps_pref,